@@ -198,6 +198,10 @@ CTX.INPUT['structures'] = """
 CTX.INPUT['common'] = """
  CompactingStringPool.cpp
  CompactingStringStorage.cpp
+ StringStorageStats.cpp
+ PageAllocator.cpp
+ BlockCodec.cpp
+ HyperLogLog.cpp
  FatalException.cpp
  ThreadLocalPool.cpp
  SegvException.cpp
@@ -234,6 +238,7 @@ CTX.INPUT['executors'] = """
  deleteexecutor.cpp
  distinctexecutor.cpp
  executorutil.cpp
+ hashjoinexecutor.cpp
  indexscanexecutor.cpp
  indexcountexecutor.cpp
  tablecountexecutor.cpp
@@ -241,6 +246,7 @@ CTX.INPUT['executors'] = """
  limitexecutor.cpp
  materializeexecutor.cpp
  materializedscanexecutor.cpp
+ mergejoinexecutor.cpp
  nestloopexecutor.cpp
  nestloopindexexecutor.cpp
  orderbyexecutor.cpp
@@ -259,6 +265,7 @@ CTX.INPUT['expressions'] = """
  functionexpression.cpp
  tupleaddressexpression.cpp
  parametervalueexpression.cpp
+ fusedpredicateexpression.cpp
 """
 
 CTX.INPUT['plannodes'] = """
@@ -269,6 +276,7 @@ CTX.INPUT['plannodes'] = """
  aggregatenode.cpp
  deletenode.cpp
  distinctnode.cpp
+ hashjoinnode.cpp
  indexscannode.cpp
  indexcountnode.cpp
  tablecountnode.cpp
@@ -276,6 +284,7 @@ CTX.INPUT['plannodes'] = """
  limitnode.cpp
  materializenode.cpp
  materializedscanplannode.cpp
+ mergejoinnode.cpp
  nestloopindexnode.cpp
  nestloopnode.cpp
  orderbynode.cpp
@@ -294,9 +303,11 @@ CTX.INPUT['indexes'] = """
  tableindex.cpp
  tableindexfactory.cpp
  IndexStats.cpp
+ ParallelIndexBuilder.cpp
 """
 
 CTX.INPUT['storage'] = """
+ ColdBlockCompressor.cpp
  constraintutil.cpp
  CopyOnWriteContext.cpp
  ElasticContext.cpp
@@ -304,11 +315,13 @@ CTX.INPUT['storage'] = """
  ConstraintFailureException.cpp
  TableStreamer.cpp
  ElasticScanner.cpp
+ PaxScanner.cpp
  MaterializedViewMetadata.cpp
  persistenttable.cpp
  PersistentTableStats.cpp
  StreamedTableStats.cpp
  streamedtable.cpp
+ StringDictionary.cpp
  table.cpp
  TableCatalogDelegate.cpp
  tablefactory.cpp
@@ -316,6 +329,7 @@ CTX.INPUT['storage'] = """
  tableutil.cpp
  temptable.cpp
  TempTableLimits.cpp
+ TempTableSpillFile.cpp
  TupleStreamBase.cpp
  ExportTupleStream.cpp
  DRTupleStream.cpp
@@ -391,6 +405,10 @@ if whichtests in ("${eetestsuite}", "common"):
      pool_test
      tabletuple_test
      elastic_hashinator_test
+     page_allocator_test
+     hyperloglog_test
+     nvalue_hash_test
+     string_storage_test
     """
 
 if whichtests in ("${eetestsuite}", "execution"):
@@ -400,6 +418,15 @@ if whichtests in ("${eetestsuite}", "execution"):
      FragmentManagerTest
     """
 
+if whichtests in ("${eetestsuite}", "executors"):
+    CTX.TESTS['executors'] = """
+     HashAggregateExecutorTest
+     HashJoinExecutorTest
+     MergeJoinExecutorTest
+     OrderByExecutorTest
+     PipelinedExecutorTest
+    """
+
 if whichtests in ("${eetestsuite}", "expressions"):
     CTX.TESTS['expressions'] = """
      expression_test
@@ -416,14 +443,17 @@ if whichtests in ("${eetestsuite}", "indexes"):
 
 if whichtests in ("${eetestsuite}", "storage"):
     CTX.TESTS['storage'] = """
+     ColdBlockCompressorTest
      CompactionTest
      constraint_test
      CopyOnWriteTest
      filter_test
      persistent_table_log_test
+     PaxScannerTest
      PersistentTableMemStatsTest
      serialize_test
      StreamedTable_test
+     StringDictionaryTest
      table_and_indexes_test
      table_test
      tabletuple_export_test
@@ -435,9 +465,12 @@ if whichtests in ("${eetestsuite}", "storage"):
 if whichtests in ("${eetestsuite}", "structures"):
     CTX.TESTS['structures'] = """
      CompactingMapTest
+     CompactingBTreeTest
      CompactingMapIndexCountTest
      CompactingHashTest
      CompactingPoolTest
+     OpenAddressingHashTableTest
+     PoolBackedHashSetTest
     """
 
 if whichtests in ("${eetestsuite}", "plannodes"):
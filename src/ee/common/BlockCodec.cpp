@@ -0,0 +1,216 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/BlockCodec.h"
+#include <cstring>
+#include <vector>
+#include <stdint.h>
+
+namespace voltdb {
+
+namespace {
+
+const std::size_t MIN_MATCH = 4;
+const std::size_t MAX_OFFSET = 65535;
+// As the format requires, the last 5 bytes are always literals and
+// the last match starts at least 12 bytes before the end.
+const std::size_t LAST_LITERALS = 5;
+const std::size_t MATCH_FIND_LIMIT = 12;
+const int HASH_LOG = 14;
+// After this many misses in a row the search starts skipping ahead, so
+// stretches that don't compress are passed over quickly.
+const int SKIP_TRIGGER = 6;
+
+inline uint32_t read32(const char *p) {
+    uint32_t value;
+    ::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t hashPosition(uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - HASH_LOG);
+}
+
+/** Write the part of a length that its token's 4 bits can't hold */
+inline char *writeLength(char *op, std::size_t length) {
+    while (length >= 255) {
+        *op++ = static_cast<char>(255);
+        length -= 255;
+    }
+    *op++ = static_cast<char>(length);
+    return op;
+}
+
+/** Read the rest of a length whose token bits were all set */
+inline bool readLength(const unsigned char *&ip, const unsigned char *end, std::size_t &length) {
+    unsigned char byte;
+    do {
+        if (ip >= end) {
+            return false;
+        }
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+/**
+ * Write a sequence of literals and, unless matchLength is 0, the match
+ * that follows them. Return the new output position, or NULL if it won't fit.
+ */
+char *writeSequence(char *op, char *end, const char *literals, std::size_t literalLength,
+                    std::size_t offset, std::size_t matchLength) {
+    const std::size_t needed = 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1;
+    if (static_cast<std::size_t>(end - op) < needed) {
+        return NULL;
+    }
+    char *token = op++;
+    *token = static_cast<char>((literalLength >= 15 ? 15 : literalLength) << 4);
+    if (literalLength >= 15) {
+        op = writeLength(op, literalLength - 15);
+    }
+    ::memcpy(op, literals, literalLength);
+    op += literalLength;
+    if (matchLength == 0) {
+        return op;
+    }
+    *op++ = static_cast<char>(offset & 0xff);
+    *op++ = static_cast<char>(offset >> 8);
+    const std::size_t code = matchLength - MIN_MATCH;
+    *token = static_cast<char>(*token | (code >= 15 ? 15 : code));
+    if (code >= 15) {
+        op = writeLength(op, code - 15);
+    }
+    return op;
+}
+
+}
+
+std::size_t BlockCodec::compress(const char *source, std::size_t sourceSize,
+                                 char *target, std::size_t targetCapacity) {
+    char *op = target;
+    char *const opEnd = target + targetCapacity;
+    const char *anchor = source;
+    const char *const end = source + sourceSize;
+
+    if (sourceSize > MATCH_FIND_LIMIT) {
+        // positions are kept relative to source, off by one so 0 means none
+        std::vector<uint32_t> table(static_cast<std::size_t>(1) << HASH_LOG, 0);
+        const char *const matchFindLimit = end - MATCH_FIND_LIMIT;
+        const char *const matchEndLimit = end - LAST_LITERALS;
+        const char *ip = source;
+        int misses = 0;
+        while (ip < matchFindLimit) {
+            const uint32_t sequence = read32(ip);
+            uint32_t &slot = table[hashPosition(sequence)];
+            const char *ref = slot == 0 ? NULL : source + slot - 1;
+            slot = static_cast<uint32_t>(ip - source) + 1;
+            if (ref == NULL || static_cast<std::size_t>(ip - ref) > MAX_OFFSET || read32(ref) != sequence) {
+                ip += 1 + (misses++ >> SKIP_TRIGGER);
+                continue;
+            }
+            misses = 0;
+            // take in any matching bytes just before, left as literals so far
+            while (ip > anchor && ref > source && ip[-1] == ref[-1]) {
+                --ip;
+                --ref;
+            }
+            const char *matchEnd = ip + MIN_MATCH;
+            const char *refEnd = ref + MIN_MATCH;
+            while (matchEnd + sizeof(uint64_t) <= matchEndLimit) {
+                uint64_t lhs, rhs;
+                ::memcpy(&lhs, matchEnd, sizeof(lhs));
+                ::memcpy(&rhs, refEnd, sizeof(rhs));
+                if (lhs != rhs) {
+                    break;
+                }
+                matchEnd += sizeof(uint64_t);
+                refEnd += sizeof(uint64_t);
+            }
+            while (matchEnd < matchEndLimit && *matchEnd == *refEnd) {
+                ++matchEnd;
+                ++refEnd;
+            }
+            op = writeSequence(op, opEnd, anchor, ip - anchor, ip - ref, matchEnd - ip);
+            if (op == NULL) {
+                return 0;
+            }
+            ip = matchEnd;
+            anchor = ip;
+        }
+    }
+
+    op = writeSequence(op, opEnd, anchor, end - anchor, 0, 0);
+    return op == NULL ? 0 : static_cast<std::size_t>(op - target);
+}
+
+bool BlockCodec::decompress(const char *source, std::size_t sourceSize,
+                            char *target, std::size_t targetSize) {
+    const unsigned char *ip = reinterpret_cast<const unsigned char*>(source);
+    const unsigned char *const ipEnd = ip + sourceSize;
+    char *op = target;
+    char *const opEnd = target + targetSize;
+
+    while (ip < ipEnd) {
+        const unsigned char token = *ip++;
+        std::size_t literalLength = token >> 4;
+        if (literalLength == 15 && ! readLength(ip, ipEnd, literalLength)) {
+            return false;
+        }
+        if (literalLength > static_cast<std::size_t>(ipEnd - ip) ||
+            literalLength > static_cast<std::size_t>(opEnd - op)) {
+            return false;
+        }
+        ::memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+        if (ip == ipEnd) {
+            // the last sequence has no match
+            break;
+        }
+
+        if (ipEnd - ip < 2) {
+            return false;
+        }
+        const std::size_t offset = ip[0] | (static_cast<std::size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<std::size_t>(op - target)) {
+            return false;
+        }
+        std::size_t matchLength = token & 15;
+        if (matchLength == 15 && ! readLength(ip, ipEnd, matchLength)) {
+            return false;
+        }
+        matchLength += MIN_MATCH;
+        if (matchLength > static_cast<std::size_t>(opEnd - op)) {
+            return false;
+        }
+        const char *ref = op - offset;
+        if (offset >= matchLength) {
+            ::memcpy(op, ref, matchLength);
+            op += matchLength;
+        }
+        else {
+            // the copy overlaps what it writes, repeating the last offset bytes
+            for (std::size_t ii = 0; ii < matchLength; ++ii) {
+                *op++ = *ref++;
+            }
+        }
+    }
+    return op == opEnd;
+}
+
+}
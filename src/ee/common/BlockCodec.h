@@ -0,0 +1,56 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BLOCKCODEC_H_
+#define BLOCKCODEC_H_
+
+#include <cstddef>
+
+namespace voltdb {
+
+/**
+ * A fast LZ77 codec for buffers of tuple storage, writing the LZ4 block
+ * format: runs of literals, each followed by a copy of 4 or more bytes
+ * from up to 64KB back. It trades ratio for speed, finding matches
+ * through a single hash probe per position.
+ */
+class BlockCodec {
+public:
+    /** The most bytes compress() may write for sourceSize bytes */
+    static std::size_t compressBound(std::size_t sourceSize) {
+        return sourceSize + sourceSize / 255 + 16;
+    }
+
+    /**
+     * Compress sourceSize bytes into at most targetCapacity bytes of target.
+     * @return the compressed size, or 0 if it didn't fit.
+     */
+    static std::size_t compress(const char *source, std::size_t sourceSize,
+                                char *target, std::size_t targetCapacity);
+
+    /**
+     * Decompress sourceSize bytes from compress() into the targetSize
+     * bytes they were compressed from.
+     * @return false if the source is corrupt or is not of targetSize bytes.
+     */
+    static bool decompress(const char *source, std::size_t sourceSize,
+                           char *target, std::size_t targetSize);
+};
+
+}
+
+#endif /* BLOCKCODEC_H_ */
@@ -19,36 +19,103 @@
 
 #include "StringRef.h"
 
+#include <cstring>
+
 using namespace voltdb;
 using namespace std;
 
 CompactingStringPool::CompactingStringPool(int32_t elementSize,
                                            int32_t elementsPerBuf) :
-    m_pool(elementSize, elementsPerBuf)
+    m_size(elementSize), m_elementsPerBuf(elementsPerBuf),
+    m_allocator(elementSize, elementsPerBuf), m_holes(NULL), m_freeCount(0)
 {
 }
 
 void*
 CompactingStringPool::malloc()
 {
-    return m_pool.malloc();
+    if (m_holes != NULL)
+    {
+        Hole* hole = m_holes;
+        unlinkHole(hole);
+        return hole;
+    }
+    return m_allocator.alloc();
 }
 
 void
 CompactingStringPool::free(void* element)
 {
-    bool mutated = m_pool.free(element);
-    if (mutated)
+    pushHole(reinterpret_cast<Hole*>(element));
+    // Compact once the holes make up a buffer's worth and a quarter of
+    // the pool, so that each compaction gives memory back and the cost
+    // of moving strings stays proportional to the frees that caused it.
+    // A pool left with no strings at all gives everything back at once.
+    if ((m_freeCount >= m_elementsPerBuf && m_freeCount * 4 >= m_allocator.count()) ||
+        m_freeCount == m_allocator.count())
     {
-        // use the backpointer to the StringRef object in the moved
-        // data to update that object with the new string location
-        StringRef* back_ptr = *reinterpret_cast<StringRef**>(element);
-        back_ptr->updateStringLocation(element);
+        compact();
+    }
+}
+
+void
+CompactingStringPool::compact()
+{
+    while (m_freeCount > 0)
+    {
+        void* last = m_allocator.last();
+        if (isHole(last))
+        {
+            unlinkHole(reinterpret_cast<Hole*>(last));
+        }
+        else
+        {
+            // move the last string into a hole and use its backpointer
+            // to update its StringRef with the new string location
+            Hole* hole = m_holes;
+            unlinkHole(hole);
+            memcpy(hole, last, m_size);
+            StringRef* back_ptr = *reinterpret_cast<StringRef**>(hole);
+            back_ptr->updateStringLocation(hole);
+        }
+        m_allocator.trim();
     }
 }
 
 size_t
 CompactingStringPool::getBytesAllocated() const
 {
-    return m_pool.getBytesAllocated();
+    return m_allocator.bytesAllocated();
+}
+
+void
+CompactingStringPool::pushHole(Hole* hole)
+{
+    hole->m_taggedNext = reinterpret_cast<uintptr_t>(m_holes) | 1;
+    hole->m_prev = NULL;
+    if (m_holes != NULL)
+    {
+        m_holes->m_prev = hole;
+    }
+    m_holes = hole;
+    ++m_freeCount;
+}
+
+void
+CompactingStringPool::unlinkHole(Hole* hole)
+{
+    Hole* next = nextHole(hole);
+    if (hole->m_prev != NULL)
+    {
+        hole->m_prev->m_taggedNext = reinterpret_cast<uintptr_t>(next) | 1;
+    }
+    else
+    {
+        m_holes = next;
+    }
+    if (next != NULL)
+    {
+        next->m_prev = hole->m_prev;
+    }
+    --m_freeCount;
 }
@@ -18,12 +18,19 @@
 #ifndef _EE_COMMON_COMPACTINGSTRINGPOOL_H_
 #define _EE_COMMON_COMPACTINGSTRINGPOOL_H_
 
-#include "structures/CompactingPool.h"
+#include "structures/ContiguousAllocator.h"
 
 #include <cstdlib>
+#include <stdint.h>
 
 namespace voltdb
 {
+    // A pool of fixed size slots for the strings of one size class.
+    // Every live slot starts with the backpointer to its StringRef.
+    // Freed slots are kept on a free list and reused by malloc(), and
+    // the pool compacts itself -- moving live strings from the end of
+    // the pool into the holes and updating their StringRefs -- once
+    // enough holes pile up to give back a buffer, or when asked to.
     class CompactingStringPool
     {
     public:
@@ -31,10 +38,42 @@ namespace voltdb
 
         void* malloc();
         void free(void* element);
+
+        // Fill every hole, releasing what memory that frees up.
+        void compact();
+
         size_t getBytesAllocated() const;
+        // strings currently held
+        int64_t getLiveCount() const { return m_allocator.count() - m_freeCount; }
+        // slots freed but not yet compacted away
+        int64_t getFreeCount() const { return m_freeCount; }
 
     private:
-        CompactingPool m_pool;
+        // The layout of a freed slot. Its first word, which in a live
+        // slot is the backpointer, holds the link to the next hole with
+        // the low bit set, so that holes can be told from live strings.
+        struct Hole
+        {
+            uintptr_t m_taggedNext;
+            Hole* m_prev;
+        };
+
+        static bool isHole(void* element)
+        {
+            return (*reinterpret_cast<uintptr_t*>(element) & 1) != 0;
+        }
+        static Hole* nextHole(Hole* hole)
+        {
+            return reinterpret_cast<Hole*>(hole->m_taggedNext & ~static_cast<uintptr_t>(1));
+        }
+        void pushHole(Hole* hole);
+        void unlinkHole(Hole* hole);
+
+        int32_t m_size;
+        int32_t m_elementsPerBuf;
+        ContiguousAllocator m_allocator;
+        Hole* m_holes;
+        int64_t m_freeCount;
     };
 }
 
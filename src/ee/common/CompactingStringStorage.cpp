@@ -17,65 +17,118 @@
 #include "common/CompactingStringStorage.h"
 
 #include "common/FatalException.hpp"
-#include "common/ThreadLocalPool.h"
-#include <boost/unordered_map.hpp>
-#include <iostream>
+
+#include <cassert>
 
 using namespace voltdb;
 using namespace std;
-using boost::shared_ptr;
-
-typedef boost::shared_ptr<CompactingStringPool> PoolPtrType;
-typedef boost::unordered_map<size_t, PoolPtrType> MapType;
 
 CompactingStringStorage::CompactingStringStorage()
 {
+    for (int ii = 0; ii < CLASS_COUNT; ++ii) {
+        m_pools[ii] = NULL;
+    }
 }
 
 CompactingStringStorage::~CompactingStringStorage()
 {
+    for (int ii = 0; ii < CLASS_COUNT; ++ii) {
+        delete m_pools[ii];
+    }
+}
+
+size_t
+CompactingStringStorage::getClassSize(int sizeClass)
+{
+    assert(sizeClass >= 0 && sizeClass < CLASS_COUNT);
+    if (sizeClass == 0) {
+        return MIN_CLASS_SIZE;
+    }
+    if (sizeClass == CLASS_COUNT - 1) {
+        // the top class holds just the largest strings, rounded to keep slots 8 byte aligned
+        return (MAX_ALLOCATION_SIZE + 7) & ~static_cast<size_t>(7);
+    }
+    const int high = (sizeClass - 1) / 2 + 4;
+    if ((sizeClass - 1) % 2 == 0) {
+        return static_cast<size_t>(3) << (high - 1);
+    }
+    return static_cast<size_t>(1) << (high + 1);
+}
+
+size_t
+CompactingStringStorage::getAllocationSize(size_t size)
+{
+    if (size > MAX_ALLOCATION_SIZE) {
+        return 0;
+    }
+    return getClassSize(getSizeClass(size));
 }
 
-PoolPtrType
+CompactingStringPool*
 CompactingStringStorage::get(size_t size)
 {
-    size_t alloc_size = ThreadLocalPool::getAllocationSizeForObject(size);
-    if (alloc_size == 0)
+    if (size > MAX_ALLOCATION_SIZE)
     {
         throwFatalException("Attempted to allocate an object then the 1 meg limit. Requested size was %d",
             static_cast<int32_t>(size));
     }
-    return getExact(alloc_size);
-}
-
-PoolPtrType
-CompactingStringStorage::getExact(size_t size)
-{
-    MapType::iterator iter = m_poolMap.find(size);
-    int32_t ssize = static_cast<int32_t>(size);
-    PoolPtrType pool;
-    if (iter == m_poolMap.end()) {
+    const int sizeClass = getSizeClass(size);
+    CompactingStringPool* pool = m_pools[sizeClass];
+    if (pool == NULL) {
+        int32_t ssize = static_cast<int32_t>(getClassSize(sizeClass));
         // compute num_elements to be closest multiple
         // leading to a 2Meg buffer
         int32_t num_elements = (2 * 1024 * 1024 / ssize) + 1;
-        pool = PoolPtrType(new CompactingStringPool(ssize, num_elements));
-        m_poolMap.insert(pair<size_t, PoolPtrType>(size, pool));
-    }
-    else
-    {
-        pool = iter->second;
+        pool = new CompactingStringPool(ssize, num_elements);
+        m_pools[sizeClass] = pool;
     }
     return pool;
 }
 
-size_t CompactingStringStorage::getPoolAllocationSize()
+void CompactingStringStorage::compact()
+{
+    for (int ii = 0; ii < CLASS_COUNT; ++ii) {
+        if (m_pools[ii] != NULL) {
+            m_pools[ii]->compact();
+        }
+    }
+}
+
+size_t CompactingStringStorage::getPoolAllocationSize() const
 {
     size_t total = 0;
-    for (MapType::iterator iter = m_poolMap.begin();
-         iter != m_poolMap.end();
-         ++iter)
-    {
-        total += iter->second->getBytesAllocated();
+    for (int ii = 0; ii < CLASS_COUNT; ++ii) {
+        if (m_pools[ii] != NULL) {
+            total += m_pools[ii]->getBytesAllocated();
+        }
     }
     return total;
 }
+
+CompactingStringStorage::ClassStats CompactingStringStorage::getClassStats(int sizeClass) const
+{
+    assert(sizeClass >= 0 && sizeClass < CLASS_COUNT);
+    ClassStats classStats;
+    classStats.classSize = getClassSize(sizeClass);
+    classStats.liveCount = 0;
+    classStats.freeCount = 0;
+    classStats.bytesAllocated = 0;
+    const CompactingStringPool* pool = m_pools[sizeClass];
+    if (pool != NULL) {
+        classStats.liveCount = pool->getLiveCount();
+        classStats.freeCount = pool->getFreeCount();
+        classStats.bytesAllocated = pool->getBytesAllocated();
+    }
+    return classStats;
+}
+
+vector<CompactingStringStorage::ClassStats> CompactingStringStorage::getClassStats() const
+{
+    vector<ClassStats> stats;
+    for (int ii = 0; ii < CLASS_COUNT; ++ii) {
+        if (m_pools[ii] != NULL) {
+            stats.push_back(getClassStats(ii));
+        }
+    }
+    return stats;
+}
@@ -19,25 +19,77 @@
 #define _EE_COMMON_COMPACTINGSTRINGSTORAGE_H_
 
 #include "CompactingStringPool.h"
-#include <boost/shared_ptr.hpp>
-#include <boost/unordered_map.hpp>
+#include <boost/noncopyable.hpp>
+#include <vector>
 
 namespace voltdb {
 
-    class CompactingStringStorage {
+    /**
+     * The thread local heap of the non-inlined strings of persistent
+     * tables: one CompactingStringPool per size class, created as the
+     * class is first used. The classes are 16 bytes, then every power
+     * of two and the midpoint above it, up to the largest string a
+     * column can hold, so no allocation wastes more than a third of its
+     * slot and a size finds its class with a few bit operations.
+     */
+    class CompactingStringStorage : private boost::noncopyable {
     public:
+        // VoltType.MAX_VALUE_LENGTH, plus the length prefix and the
+        // backpointer that StringRef stores with the string.
+        static const std::size_t MAX_ALLOCATION_SIZE = 1048576 + sizeof(int32_t) + sizeof(void*);
+        // A slot has to hold a free list link when the string is gone.
+        static const std::size_t MIN_CLASS_SIZE = 16;
+        static const int CLASS_COUNT = 34;
+
+        struct ClassStats {
+            std::size_t classSize;
+            int64_t liveCount;
+            int64_t freeCount;
+            std::size_t bytesAllocated;
+        };
+
         CompactingStringStorage();
         ~CompactingStringStorage();
 
-        boost::shared_ptr<CompactingStringPool> get(size_t size);
+        /** The size class an allocation of size bytes is served from */
+        static int getSizeClass(std::size_t size)
+        {
+            if (size <= MIN_CLASS_SIZE) {
+                return 0;
+            }
+            // With the top bit of size - 1 at 2^high, the next bit down
+            // says whether it fits the midpoint class 3 * 2^(high - 1)
+            // or has to go up to 2^(high + 1).
+            const unsigned long bits = static_cast<unsigned long>(size - 1);
+            const int high = static_cast<int>(sizeof(unsigned long) * 8) - 1 - __builtin_clzl(bits);
+            const int upperHalf = static_cast<int>((bits >> (high - 1)) & 1);
+            return 2 * (high - 4) + upperHalf + 1;
+        }
+
+        /** The slot size of a size class */
+        static std::size_t getClassSize(int sizeClass);
+
+        /**
+         * The bytes that an allocation of size bytes takes up, or 0 if
+         * it is larger than any string can be.
+         */
+        static std::size_t getAllocationSize(std::size_t size);
+
+        CompactingStringPool* get(std::size_t size);
+
+        /** Fill the holes in every size class. */
+        void compact();
+
+        std::size_t getPoolAllocationSize() const;
 
-        boost::shared_ptr<CompactingStringPool> getExact(size_t size);
+        /** Utilization of a size class, all zero but the size if it hasn't been used */
+        ClassStats getClassStats(int sizeClass) const;
 
-        std::size_t getPoolAllocationSize();
+        /** Utilization of each size class that has been used */
+        std::vector<ClassStats> getClassStats() const;
 
     private:
-        boost::unordered_map<size_t,
-                             boost::shared_ptr<CompactingStringPool> > m_poolMap;
+        CompactingStringPool* m_pools[CLASS_COUNT];
     };
 }
 
@@ -0,0 +1,80 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/HyperLogLog.h"
+#include "common/SerializableEEException.h"
+#include <cmath>
+
+namespace voltdb {
+
+static const uint8_t SERIALIZATION_VERSION = 1;
+
+// The largest rank add() can store
+static const uint8_t MAX_RANK = 32 - HyperLogLog::PRECISION + 1;
+
+void HyperLogLog::mergeSerialized(const char *data, int32_t length) {
+    if (length != SERIALIZED_SIZE ||
+        static_cast<uint8_t>(data[0]) != SERIALIZATION_VERSION ||
+        static_cast<uint8_t>(data[1]) != PRECISION) {
+        throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                      "Attempted to merge a value that is not a HyperLogLog sketch");
+    }
+    const uint8_t *registers = reinterpret_cast<const uint8_t*>(data + 2);
+    for (int ii = 0; ii < REGISTER_COUNT; ii++) {
+        if (registers[ii] > MAX_RANK) {
+            throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                          "Attempted to merge a corrupt HyperLogLog sketch");
+        }
+        if (registers[ii] > m_registers[ii]) {
+            m_registers[ii] = registers[ii];
+        }
+    }
+}
+
+void HyperLogLog::serializeTo(char *out) const {
+    out[0] = static_cast<char>(SERIALIZATION_VERSION);
+    out[1] = static_cast<char>(PRECISION);
+    ::memcpy(out + 2, m_registers, REGISTER_COUNT);
+}
+
+int64_t HyperLogLog::estimate() const {
+    const double m = REGISTER_COUNT;
+    double sum = 0.0;
+    int zeros = 0;
+    for (int ii = 0; ii < REGISTER_COUNT; ii++) {
+        sum += std::ldexp(1.0, -m_registers[ii]);
+        if (m_registers[ii] == 0) {
+            zeros++;
+        }
+    }
+    const double alpha = 0.7213 / (1.0 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+
+    const double hashSpace = 4294967296.0;
+    if (estimate <= 2.5 * m) {
+        // Few distinct values: count the registers still empty instead
+        if (zeros != 0) {
+            estimate = m * std::log(m / zeros);
+        }
+    }
+    else if (estimate > hashSpace / 30.0 && estimate < hashSpace) {
+        // Many distinct values: allow for hashes that collided
+        estimate = -hashSpace * std::log(1.0 - estimate / hashSpace);
+    }
+    return static_cast<int64_t>(estimate + 0.5);
+}
+
+}
@@ -0,0 +1,88 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HYPERLOGLOG_H_
+#define HYPERLOGLOG_H_
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+namespace voltdb {
+
+/**
+ * A HyperLogLog sketch (Flajolet et al.) of 32-bit hashes, estimating how
+ * many distinct hashes were added in a fixed 4KB whatever their number.
+ * The standard error of the estimate is about 1.6%.
+ *
+ * Sketches of the same data split any way merge into the sketch of all of
+ * it, so a sketch serialized where the data lives can be merged with the
+ * others where the results are gathered.
+ */
+class HyperLogLog {
+public:
+    // 2^PRECISION registers, addressed by the high bits of a hash
+    static const int PRECISION = 12;
+    static const int REGISTER_COUNT = 1 << PRECISION;
+    // a version byte, the precision and then the registers
+    static const int32_t SERIALIZED_SIZE = 2 + REGISTER_COUNT;
+
+    HyperLogLog() {
+        clear();
+    }
+
+    void clear() {
+        ::memset(m_registers, 0, sizeof(m_registers));
+    }
+
+    void add(uint32_t hash) {
+        const uint32_t index = hash >> (32 - PRECISION);
+        // The low bits, with a guard bit so that the rank stays in range
+        const uint32_t rest = (hash << PRECISION) | (1u << (PRECISION - 1));
+        const uint8_t rank = static_cast<uint8_t>(__builtin_clz(rest) + 1);
+        if (rank > m_registers[index]) {
+            m_registers[index] = rank;
+        }
+    }
+
+    void merge(const HyperLogLog &other) {
+        for (int ii = 0; ii < REGISTER_COUNT; ii++) {
+            if (other.m_registers[ii] > m_registers[ii]) {
+                m_registers[ii] = other.m_registers[ii];
+            }
+        }
+    }
+
+    /**
+     * Merge in a sketch written by serializeTo. Throws a
+     * SerializableEEException if the data is not such a sketch.
+     */
+    void mergeSerialized(const char *data, int32_t length);
+
+    /** Write SERIALIZED_SIZE bytes describing the sketch to out */
+    void serializeTo(char *out) const;
+
+    /** Estimate the number of distinct hashes added */
+    int64_t estimate() const;
+
+private:
+    uint8_t m_registers[REGISTER_COUNT];
+};
+
+}
+
+#endif /* HYPERLOGLOG_H_ */
@@ -292,9 +292,6 @@ void NValue::createDecimalFromString(const std::string &txt) {
 struct NValueList {
     static int allocationSizeForLength(size_t length)
     {
-        //TODO: May want to consider extra allocation, here,
-        // such as space for a sorted copy of the array.
-        // This allocation has the advantage of getting freed via NValue::free.
         return (int)(sizeof(NValueList) + length*sizeof(StlFriendlyNValue));
     }
 
@@ -305,7 +302,7 @@ struct NValueList {
     void operator delete(void*, char*) {}
     void operator delete(void*) {}
 
-    NValueList(size_t length, ValueType elementType) : m_length(length), m_elementType(elementType)
+    NValueList(size_t length, ValueType elementType) : m_length(length), m_elementType(elementType), m_sorted(false)
     { }
 
     void deserializeNValues(SerializeInputBE &input, Pool *dataPool)
@@ -315,14 +312,44 @@ struct NValueList {
         }
     }
 
+    /**
+     * Sort the values and drop the duplicates so that inList can binary search them.
+     * Only lists whose element type has a total order are sorted -- the others keep
+     * their original order and are scanned.
+     */
+    void sortAndDedup()
+    {
+        switch (m_elementType) {
+        case VALUE_TYPE_TINYINT:
+        case VALUE_TYPE_SMALLINT:
+        case VALUE_TYPE_INTEGER:
+        case VALUE_TYPE_BIGINT:
+        case VALUE_TYPE_TIMESTAMP:
+        case VALUE_TYPE_DECIMAL:
+        case VALUE_TYPE_VARCHAR:
+        case VALUE_TYPE_VARBINARY:
+            break;
+        default:
+            return;
+        }
+        std::sort(m_values, m_values + m_length);
+        m_length = std::unique(m_values, m_values + m_length) - m_values;
+        m_sorted = true;
+    }
+
     StlFriendlyNValue const* begin() const { return m_values; }
     StlFriendlyNValue const* end() const { return m_values + m_length; }
 
-    const size_t m_length;
+    size_t m_length;
     const ValueType m_elementType;
+    // Set by sortAndDedup, cleared whenever the elements are reassigned.
+    bool m_sorted;
     StlFriendlyNValue m_values[0];
 };
 
+// Below this many elements a linear scan of a sorted list is as fast as a binary search.
+static const size_t IN_LIST_BINARY_SEARCH_MIN_LENGTH = 16;
+
 /**
  * This NValue can be of any scalar value type.
  * @param rhs  a VALUE_TYPE_ARRAY NValue whose referent must be an NValueList.
@@ -347,10 +374,9 @@ bool NValue::inList(const NValue& rhs) const
     }
     const NValueList* listOfNValues = (NValueList*)rhs.getObjectValue_withoutNull();
     const StlFriendlyNValue& value = *static_cast<const StlFriendlyNValue*>(this);
-    //TODO: An O(ln(length)) implementation vs. the current O(length) implementation
-    // such as binary search would likely require some kind of sorting/re-org of values
-    // post-update/pre-lookup, and would likely require some sortable inequality method
-    // (operator<()?) to be defined on StlFriendlyNValue.
+    if (listOfNValues->m_sorted && listOfNValues->m_length >= IN_LIST_BINARY_SEARCH_MIN_LENGTH) {
+        return std::binary_search(listOfNValues->begin(), listOfNValues->end(), value);
+    }
     return std::find(listOfNValues->begin(), listOfNValues->end(), value) != listOfNValues->end();
 }
 
@@ -363,8 +389,9 @@ void NValue::deserializeIntoANewNValueList(SerializeInputBE &input, Pool *dataPo
     ::memset(storage, 0, trueSize);
     NValueList* nvset = new (storage) NValueList(length, elementType);
     nvset->deserializeNValues(input, dataPool);
-    //TODO: An O(ln(length)) implementation vs. the current O(length) implementation of NValue::inList
-    // would likely require some kind of sorting/re-org of values at this point post-update pre-lookup.
+    // A parameter list is deserialized once and then probed by inList for every row,
+    // so it pays to order it here for inList to binary search.
+    nvset->sortAndDedup();
 }
 
 void NValue::allocateANewNValueList(size_t length, ValueType elementType)
@@ -385,8 +412,8 @@ void NValue::setArrayElements(std::vector<NValue> &args) const
     while (ii--) {
         listOfNValues->m_values[ii] = args[ii];
     }
-    //TODO: An O(ln(length)) implementation vs. the current O(length) implementation of NValue::inList
-    // would likely require some kind of sorting/re-org of values at this point post-update pre-lookup.
+    // These lists are rebuilt per row, so they are left unsorted and inList scans them.
+    listOfNValues->m_sorted = false;
 }
 
 int NValue::arrayLength() const
@@ -356,6 +356,14 @@ class NValue {
     int compare(const NValue rhs) const;
     int compare_withoutNull(const NValue rhs) const;
 
+    /* Write this value's part of a normalized key, a string of bytes
+       that orders as the key's values do, column by column, when
+       compared with memcmp. Keys that compare equal get the same
+       bytes. Only integer, TIMESTAMP, DOUBLE, DECIMAL, VARCHAR and
+       VARBINARY values can be written. Returns the end of what was
+       written, so the next column's value follows on from there. */
+    char *normalizeForKey(char *key) const;
+
     /* Return a boolean NValue with the comparison result */
     NValue op_equals(const NValue rhs) const;
     NValue op_notEquals(const NValue rhs) const;
@@ -2483,6 +2491,121 @@ inline int NValue::compare(const NValue rhs) const {
     return compare_withoutNull(rhs);
 }
 
+/*
+ * Integers and DECIMALs (and their NULLs, the lowest values of their
+ * types) go big endian with the sign bit flipped.
+ * The other types begin with a byte that is 0 for NULL, so NULL sorts
+ * first, followed by nothing more. DOUBLEs tell NaN, which sorts just
+ * after NULL, from numbers by a second value of that byte. A VARCHAR
+ * compares only up to its first NUL, then by its length, so that is what
+ * it is written as: its bytes up to that NUL, a 0 byte and the length.
+ * VARBINARY bytes are written with any 0 byte escaped as 0 0xFF and are
+ * ended by 0 0.
+ */
+inline char *NValue::normalizeForKey(char *key) const {
+    int64_t integer;
+    size_t width;
+    switch (m_valueType) {
+    case VALUE_TYPE_TINYINT:
+        integer = getTinyInt();
+        width = sizeof(int8_t);
+        break;
+    case VALUE_TYPE_SMALLINT:
+        integer = getSmallInt();
+        width = sizeof(int16_t);
+        break;
+    case VALUE_TYPE_INTEGER:
+        integer = getInteger();
+        width = sizeof(int32_t);
+        break;
+    case VALUE_TYPE_BIGINT:
+        integer = getBigInt();
+        width = sizeof(int64_t);
+        break;
+    case VALUE_TYPE_TIMESTAMP:
+        integer = getTimestamp();
+        width = sizeof(int64_t);
+        break;
+    case VALUE_TYPE_DECIMAL: {
+        if (isNull()) {
+            ::memset(key, 0, sizeof(TTInt));
+            return key + sizeof(TTInt);
+        }
+        const TTInt &value = getDecimal();
+        const uint64_t words[2] = { static_cast<uint64_t>(value.table[1]) ^ (1ULL << 63),
+                                    static_cast<uint64_t>(value.table[0]) };
+        for (size_t ii = 0; ii < sizeof(words); ++ii) {
+            *key++ = static_cast<char>(words[ii / 8] >> (56 - 8 * (ii % 8)));
+        }
+        return key;
+    }
+    case VALUE_TYPE_DOUBLE: {
+        if (isNull()) {
+            *key++ = 0;
+            return key;
+        }
+        const double value = getDouble();
+        if (std::isnan(value)) {
+            *key++ = 1;
+            return key;
+        }
+        *key++ = 2;
+        // -0.0 equals 0.0, so it is written as 0.0. Otherwise flipping the sign bit
+        // of positive numbers and all the bits of negative ones orders them.
+        const double canonical = (value == 0.0) ? 0.0 : value;
+        uint64_t bits;
+        ::memcpy(&bits, &canonical, sizeof(bits));
+        const uint64_t ordered = (bits & (1ULL << 63)) ? ~bits : (bits ^ (1ULL << 63));
+        for (size_t ii = 0; ii < sizeof(ordered); ++ii) {
+            *key++ = static_cast<char>(ordered >> (8 * (sizeof(ordered) - 1 - ii)));
+        }
+        return key;
+    }
+    case VALUE_TYPE_VARCHAR: {
+        if (isNull()) {
+            *key++ = 0;
+            return key;
+        }
+        *key++ = 1;
+        const char *value = reinterpret_cast<const char*>(getObjectValue_withoutNull());
+        const int32_t length = getObjectLength_withoutNull();
+        for (int32_t ii = 0; ii < length && value[ii] != '\0'; ++ii) {
+            *key++ = value[ii];
+        }
+        *key++ = 0;
+        integer = length;
+        width = sizeof(int32_t);
+        break;
+    }
+    case VALUE_TYPE_VARBINARY: {
+        if (isNull()) {
+            *key++ = 0;
+            return key;
+        }
+        *key++ = 1;
+        const char *value = reinterpret_cast<const char*>(getObjectValue_withoutNull());
+        const int32_t length = getObjectLength_withoutNull();
+        for (int32_t ii = 0; ii < length; ++ii) {
+            *key++ = value[ii];
+            if (value[ii] == '\0') {
+                *key++ = static_cast<char>(0xFF);
+            }
+        }
+        *key++ = 0;
+        *key++ = 0;
+        return key;
+    }
+    default:
+        throwDynamicSQLException("NValue::normalizeForKey() called with unsupported ValueType '%s'",
+                                 getValueTypeString().c_str());
+    }
+    const uint64_t flipped = static_cast<uint64_t>(integer) ^ (1ULL << (8 * width - 1));
+    for (size_t ii = 0; ii < width; ++ii) {
+        *key++ = static_cast<char>(flipped >> (8 * (width - 1 - ii)));
+    }
+    return key;
+}
+
 /**
  * Set this NValue to null.
  */
@@ -3269,23 +3392,15 @@ inline void NValue::hashCombine(std::size_t &seed) const {
             boost::hash_combine( seed, proxyForDouble); break;
         }
 #endif
-      case VALUE_TYPE_VARCHAR: {
-          if (isNull()) {
-              boost::hash_combine( seed, std::string(""));
-          } else {
-              const int32_t length = getObjectLength_withoutNull();
-              boost::hash_combine( seed, std::string( reinterpret_cast<const char*>(getObjectValue_withoutNull()), length ));
-          }
-          break;
-      }
+      case VALUE_TYPE_VARCHAR:
       case VALUE_TYPE_VARBINARY: {
+          // Hash the bytes in place, 16 at a time, rather than copying them into
+          // a std::string or combining them one by one. NULL hashes as empty.
           if (isNull()) {
-              boost::hash_combine( seed, std::string(""));
+              boost::hash_combine( seed, MurmurHash3_x64_128(NULL, 0, 0));
           } else {
-              const int32_t length = getObjectLength_withoutNull();
-              char* data = reinterpret_cast<char*>(getObjectValue_withoutNull());
-              for (int32_t i = 0; i < length; i++)
-                  boost::hash_combine(seed, data[i]);
+              boost::hash_combine( seed, MurmurHash3_x64_128(getObjectValue_withoutNull(),
+                                                             getObjectLength_withoutNull(), 0));
           }
           break;
       }
@@ -0,0 +1,228 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "common/PageAllocator.h"
+#include "common/FatalException.hpp"
+#include "common/debuglog.h"
+#include <pthread.h>
+#include <sys/mman.h>
+#include <errno.h>
+#include <cstring>
+#include <boost/unordered_map.hpp>
+#ifdef LINUX
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+namespace voltdb {
+
+namespace {
+
+struct SiteState {
+    SiteState() : hugePages(PageAllocator::HUGE_PAGES_NONE), numaNode(-1) {}
+    PageAllocator::HugePages hugePages;
+    int numaNode;
+};
+
+// The counters of the whole process, updated atomically.
+volatile int64_t bytesAllocated = 0;
+volatile int64_t hugePageBytes = 0;
+volatile int64_t numaBoundBytes = 0;
+
+// How each allocation with a backing was backed, so the counters can be
+// taken down again by whichever thread releases it.
+pthread_mutex_t backingsMutex = PTHREAD_MUTEX_INITIALIZER;
+boost::unordered_map<void*, int> backings;
+
+void countAllocation(void *memory, std::size_t size, int backing) {
+    __sync_fetch_and_add(&bytesAllocated, static_cast<int64_t>(size));
+    if (backing == 0) {
+        return;
+    }
+    if (backing & PageAllocator::BACKED_HUGE) {
+        __sync_fetch_and_add(&hugePageBytes, static_cast<int64_t>(size));
+    }
+    if (backing & PageAllocator::BACKED_NUMA) {
+        __sync_fetch_and_add(&numaBoundBytes, static_cast<int64_t>(size));
+    }
+    pthread_mutex_lock(&backingsMutex);
+    backings[memory] = backing;
+    pthread_mutex_unlock(&backingsMutex);
+}
+
+void countRelease(void *memory, std::size_t size) {
+    __sync_fetch_and_sub(&bytesAllocated, static_cast<int64_t>(size));
+    int backing = 0;
+    pthread_mutex_lock(&backingsMutex);
+    if ( ! backings.empty()) {
+        boost::unordered_map<void*, int>::iterator found = backings.find(memory);
+        if (found != backings.end()) {
+            backing = found->second;
+            backings.erase(found);
+        }
+    }
+    pthread_mutex_unlock(&backingsMutex);
+    if (backing & PageAllocator::BACKED_HUGE) {
+        __sync_fetch_and_sub(&hugePageBytes, static_cast<int64_t>(size));
+    }
+    if (backing & PageAllocator::BACKED_NUMA) {
+        __sync_fetch_and_sub(&numaBoundBytes, static_cast<int64_t>(size));
+    }
+}
+
+pthread_key_t siteStateKey;
+pthread_once_t siteStateKeyOnce = PTHREAD_ONCE_INIT;
+
+void deleteSiteState(void *state) {
+    delete static_cast<SiteState*>(state);
+}
+
+void createSiteStateKey() {
+    (void)pthread_key_create(&siteStateKey, deleteSiteState);
+}
+
+SiteState *getSiteState() {
+    (void)pthread_once(&siteStateKeyOnce, createSiteStateKey);
+    return static_cast<SiteState*>(pthread_getspecific(siteStateKey));
+}
+
+void *mapPages(std::size_t size, int extraFlags) {
+    void *memory = ::mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON | extraFlags, -1, 0);
+    return memory == MAP_FAILED ? NULL : memory;
+}
+
+void *mapPlainPages(std::size_t size) {
+    void *memory = mapPages(size, 0);
+    if (memory == NULL) {
+        throwFatalException("Failed mmap of %lu bytes: %s", static_cast<unsigned long>(size), strerror(errno));
+    }
+    return memory;
+}
+
+#ifdef LINUX
+/**
+ * Map size bytes starting on a huge page boundary, so that every whole
+ * 2MB stretch of it can be backed by a transparent huge page, and advise
+ * the kernel to do so. Only the mapping of the requested size is kept.
+ */
+void *mapTransparentHugePages(std::size_t size) {
+    const std::size_t pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const std::size_t mappedSize = (size + pageSize - 1) / pageSize * pageSize;
+    char *mapping = static_cast<char*>(mapPlainPages(mappedSize + PageAllocator::HUGE_PAGE_SIZE));
+    const uintptr_t start = reinterpret_cast<uintptr_t>(mapping);
+    char *aligned = reinterpret_cast<char*>((start + PageAllocator::HUGE_PAGE_SIZE - 1) &
+                                            ~(PageAllocator::HUGE_PAGE_SIZE - 1));
+    if (aligned != mapping) {
+        ::munmap(mapping, aligned - mapping);
+    }
+    char *end = mapping + mappedSize + PageAllocator::HUGE_PAGE_SIZE;
+    if (aligned + mappedSize != end) {
+        ::munmap(aligned + mappedSize, end - (aligned + mappedSize));
+    }
+    if (::madvise(aligned, mappedSize, MADV_HUGEPAGE) != 0) {
+        VOLT_DEBUG("madvise(MADV_HUGEPAGE) failed: %s", strerror(errno));
+    }
+    return aligned;
+}
+
+bool preferNode(void *memory, std::size_t size, int numaNode) {
+    // One word of node mask covers the nodes of any host we run on.
+    const unsigned long nodeMask = 1UL << numaNode;
+    // Preferred rather than strictly bound, so a full node spills over instead of failing.
+    return ::syscall(SYS_mbind, memory, size, MPOL_PREFERRED, &nodeMask, sizeof(nodeMask) * 8, 0) == 0;
+}
+#endif
+
+}
+
+void PageAllocator::configure(HugePages hugePages, int numaNode) {
+    SiteState *state = getSiteState();
+    if (state == NULL) {
+        state = new SiteState();
+        pthread_setspecific(siteStateKey, state);
+    }
+    state->hugePages = hugePages;
+    state->numaNode = numaNode < static_cast<int>(sizeof(unsigned long) * 8) ? numaNode : -1;
+#ifndef LINUX
+    if (hugePages != HUGE_PAGES_NONE || numaNode >= 0) {
+        VOLT_WARN("Huge pages and NUMA placement are only supported on Linux");
+    }
+#endif
+}
+
+bool PageAllocator::hasPolicy() {
+    SiteState *state = getSiteState();
+    return state != NULL && (state->hugePages != HUGE_PAGES_NONE || state->numaNode >= 0);
+}
+
+void *PageAllocator::allocate(std::size_t size, int *backing) {
+    SiteState *state = getSiteState();
+    const HugePages hugePages = state == NULL ? HUGE_PAGES_NONE : state->hugePages;
+    const int numaNode = state == NULL ? -1 : state->numaNode;
+    void *memory = NULL;
+    int backedBy = 0;
+#ifdef LINUX
+    // Huge pages are no use to anything smaller than one.
+    if (hugePages != HUGE_PAGES_NONE && size >= HUGE_PAGE_SIZE) {
+        if (hugePages == HUGE_PAGES_EXPLICIT && size % HUGE_PAGE_SIZE == 0) {
+            memory = mapPages(size, MAP_HUGETLB);
+        }
+        if (memory == NULL) {
+            memory = mapTransparentHugePages(size);
+        }
+        backedBy |= BACKED_HUGE;
+    }
+#endif
+    if (memory == NULL) {
+        memory = mapPlainPages(size);
+    }
+#ifdef LINUX
+    if (numaNode >= 0) {
+        if (preferNode(memory, size, numaNode)) {
+            backedBy |= BACKED_NUMA;
+        }
+        else {
+            VOLT_DEBUG("mbind to node %d failed: %s", numaNode, strerror(errno));
+        }
+    }
+#endif
+    countAllocation(memory, size, backedBy);
+    if (backing != NULL) {
+        *backing = backedBy;
+    }
+    return memory;
+}
+
+void PageAllocator::release(void *memory, std::size_t size) {
+    if (memory == NULL) {
+        return;
+    }
+    countRelease(memory, size);
+    if (::munmap(memory, size) != 0) {
+        throwFatalException("Failed munmap of %lu bytes: %s", static_cast<unsigned long>(size), strerror(errno));
+    }
+}
+
+PageAllocator::Stats PageAllocator::getStats() {
+    Stats stats;
+    stats.bytesAllocated = __sync_fetch_and_add(&bytesAllocated, 0);
+    stats.hugePageBytes = __sync_fetch_and_add(&hugePageBytes, 0);
+    stats.numaBoundBytes = __sync_fetch_and_add(&numaBoundBytes, 0);
+    return stats;
+}
+
+}
@@ -0,0 +1,92 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PAGEALLOCATOR_H_
+#define PAGEALLOCATOR_H_
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace voltdb {
+
+/**
+ * Maps the big, long lived buffers of an engine -- persistent table blocks,
+ * index node arenas and hash bucket arrays -- straight from the OS, backed
+ * the way the engine was configured to back them: with transparent or
+ * explicit huge pages, and/or on the NUMA node of its site.
+ *
+ * The policy is kept per thread, so per engine, as for ThreadLocalPool.
+ * Threads that were never configured map plain pages. The counters are
+ * kept for the whole process, so memory may be released on any thread.
+ */
+class PageAllocator {
+public:
+    enum HugePages {
+        HUGE_PAGES_NONE,
+        // advise the kernel to back aligned 2MB stretches with huge pages
+        HUGE_PAGES_TRANSPARENT,
+        // map from the reserved huge page pool where the size allows it,
+        // falling back to transparent huge pages when the pool is empty
+        HUGE_PAGES_EXPLICIT
+    };
+
+    static const std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    // How an allocation was backed
+    enum Backing {
+        BACKED_HUGE = 1,
+        BACKED_NUMA = 2
+    };
+
+    struct Stats {
+        Stats() : bytesAllocated(0), hugePageBytes(0), numaBoundBytes(0) {}
+        // mapped by the process and not yet released
+        int64_t bytesAllocated;
+        // of those, in huge pages or advised to be
+        int64_t hugePageBytes;
+        // of those, placed on the NUMA node of the engine that mapped them
+        int64_t numaBoundBytes;
+    };
+
+    /**
+     * Set how the calling thread's allocations are backed from now on.
+     * A negative numaNode leaves placement to the kernel.
+     */
+    static void configure(HugePages hugePages, int numaNode);
+
+    /**
+     * Whether the calling thread was configured to back its allocations
+     * with anything but plain pages on any node.
+     */
+    static bool hasPolicy();
+
+    /**
+     * Map size bytes of zeroed, page aligned memory. If backing is not
+     * NULL, set it to the Backing flags the memory got.
+     */
+    static void *allocate(std::size_t size, int *backing = NULL);
+
+    /** Give back memory from allocate(), with the size it was allocated with */
+    static void release(void *memory, std::size_t size);
+
+    /** The counters of the process */
+    static Stats getStats();
+};
+
+}
+
+#endif /* PAGEALLOCATOR_H_ */
@@ -27,13 +27,13 @@ using namespace std;
 size_t
 StringRef::computeStringMemoryUsed(size_t length)
 {
-    // CompactingStringPool will allocate a chunk of this size for storage.
+    // CompactingStringStorage will allocate a chunk of this size for storage.
     // This size is the actual length plus the 4-byte length storage
-    // plus the backpointer to the StringRef
+    // plus the backpointer to the StringRef, rounded up to its size class
     size_t alloc_size =
-        ThreadLocalPool::getAllocationSizeForObject(length +
-                                                    sizeof(int32_t) +
-                                                    sizeof(StringRef*));
+        CompactingStringStorage::getAllocationSize(length +
+                                                   sizeof(int32_t) +
+                                                   sizeof(StringRef*));
     //cout << "Object length: " << length << endl;
     //cout << "StringRef* size: " << sizeof(StringRef*) << endl;
     //cout << "Pool allocation size: " << alloc_size << endl;
@@ -0,0 +1,134 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+#include <string>
+#include "common/StringStorageStats.h"
+#include "common/CompactingStringStorage.h"
+#include "common/ThreadLocalPool.h"
+#include "common/TupleSchema.h"
+#include "common/ValueFactory.hpp"
+#include "common/tabletuple.h"
+#include "storage/table.h"
+#include "storage/tablefactory.h"
+
+using namespace voltdb;
+using namespace std;
+
+vector<string> StringStorageStats::generateStringStorageStatsColumnNames() {
+    vector<string> columnNames = StatsSource::generateBaseStatsColumnNames();
+    columnNames.push_back("SIZE_CLASS");
+    columnNames.push_back("LIVE_COUNT");
+    columnNames.push_back("FREE_COUNT");
+    columnNames.push_back("ALLOCATED_MEMORY");
+    return columnNames;
+}
+
+void StringStorageStats::populateStringStorageStatsSchema(
+        vector<ValueType> &types,
+        vector<int32_t> &columnLengths,
+        vector<bool> &allowNull,
+        vector<bool> &inBytes) {
+    StatsSource::populateBaseSchema(types, columnLengths, allowNull, inBytes);
+
+    // slot size in bytes
+    types.push_back(VALUE_TYPE_INTEGER);
+    columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER));
+    allowNull.push_back(false);
+    inBytes.push_back(false);
+
+    // strings held
+    types.push_back(VALUE_TYPE_BIGINT);
+    columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+    allowNull.push_back(false);
+    inBytes.push_back(false);
+
+    // free slots
+    types.push_back(VALUE_TYPE_BIGINT);
+    columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+    allowNull.push_back(false);
+    inBytes.push_back(false);
+
+    // memory in KB
+    types.push_back(VALUE_TYPE_INTEGER);
+    columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER));
+    allowNull.push_back(false);
+    inBytes.push_back(false);
+}
+
+Table*
+StringStorageStats::generateEmptyStringStorageStatsTable()
+{
+    string name = "String storage stats temp table";
+    // Like the other stats tables, not clearly associated with any database
+    CatalogId databaseId = 1;
+    vector<string> columnNames = StringStorageStats::generateStringStorageStatsColumnNames();
+    vector<ValueType> columnTypes;
+    vector<int32_t> columnLengths;
+    vector<bool> columnAllowNull;
+    vector<bool> columnInBytes;
+    StringStorageStats::populateStringStorageStatsSchema(columnTypes, columnLengths,
+                                                         columnAllowNull, columnInBytes);
+    TupleSchema *schema =
+        TupleSchema::createTupleSchema(columnTypes, columnLengths,
+                                       columnAllowNull, columnInBytes);
+
+    return
+        reinterpret_cast<Table*>(TableFactory::getTempTable(databaseId,
+                                                            name,
+                                                            schema,
+                                                            columnNames,
+                                                            NULL));
+}
+
+StringStorageStats::StringStorageStats(int sizeClass)
+    : StatsSource(), m_sizeClass(sizeClass)
+{
+}
+
+vector<string> StringStorageStats::generateStatsColumnNames()
+{
+    return StringStorageStats::generateStringStorageStatsColumnNames();
+}
+
+/**
+ * The counters are levels rather than totals, so interval stats are the same.
+ */
+void StringStorageStats::updateStatsTuple(TableTuple *tuple) {
+    const CompactingStringStorage::ClassStats stats =
+        ThreadLocalPool::getStringPool()->getClassStats(m_sizeClass);
+    int64_t allocated_kb = static_cast<int64_t>(stats.bytesAllocated / 1024);
+    if (allocated_kb > INT32_MAX) {
+        allocated_kb = -1;
+    }
+    tuple->setNValue(StatsSource::m_columnName2Index["SIZE_CLASS"],
+                     ValueFactory::getIntegerValue(static_cast<int32_t>(stats.classSize)));
+    tuple->setNValue(StatsSource::m_columnName2Index["LIVE_COUNT"],
+                     ValueFactory::getBigIntValue(stats.liveCount));
+    tuple->setNValue(StatsSource::m_columnName2Index["FREE_COUNT"],
+                     ValueFactory::getBigIntValue(stats.freeCount));
+    tuple->setNValue(StatsSource::m_columnName2Index["ALLOCATED_MEMORY"],
+                     ValueFactory::getIntegerValue(static_cast<int32_t>(allocated_kb)));
+}
+
+void StringStorageStats::populateSchema(
+        vector<ValueType> &types,
+        vector<int32_t> &columnLengths,
+        vector<bool> &allowNull,
+        vector<bool> &inBytes) {
+    StringStorageStats::populateStringStorageStatsSchema(types, columnLengths, allowNull, inBytes);
+}
@@ -0,0 +1,74 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STRINGSTORAGESTATS_H_
+#define STRINGSTORAGESTATS_H_
+
+#include <vector>
+#include <string>
+#include "stats/StatsSource.h"
+#include "common/ids.h"
+
+namespace voltdb {
+
+/**
+ * StatsSource for one size class of the engine's non-inlined string
+ * storage, the CompactingStringStorage of its thread: the slot size, the
+ * strings held, the free slots left by strings that are gone, and the
+ * memory the class takes. Sources for every class are registered under
+ * the STRING_STORAGE selector, so it returns a row per size class.
+ */
+class StringStorageStats : public voltdb::StatsSource {
+public:
+    /**
+     * Static method to generate the column names for the tables which
+     * contain string storage stats.
+     */
+    static std::vector<std::string> generateStringStorageStatsColumnNames();
+
+    /**
+     * Static method to generate the remaining schema information for
+     * the tables which contain string storage stats.
+     */
+    static void populateStringStorageStatsSchema(std::vector<voltdb::ValueType>& types,
+                                                 std::vector<int32_t>& columnLengths,
+                                                 std::vector<bool>& allowNull,
+                                                 std::vector<bool>& inBytes);
+
+    static Table* generateEmptyStringStorageStatsTable();
+
+    StringStorageStats(int sizeClass);
+
+protected:
+
+    /**
+     * Update the stats tuple with the latest statistics available to this StatsSource.
+     */
+    virtual void updateStatsTuple(voltdb::TableTuple *tuple);
+
+    virtual std::vector<std::string> generateStatsColumnNames();
+
+    virtual void populateSchema(std::vector<voltdb::ValueType> &types, std::vector<int32_t> &columnLengths,
+            std::vector<bool> &allowNull, std::vector<bool> &inBytes);
+
+private:
+    const int m_sizeClass;
+};
+
+}
+
+#endif /* STRINGSTORAGESTATS_H_ */
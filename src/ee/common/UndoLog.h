@@ -145,6 +145,15 @@ namespace voltdb
             }
         }
 
+        /**
+         * True while some transaction's undo quanta are neither released
+         * nor undone, so that undo actions may hold on to tuple addresses.
+         */
+        bool hasPendingQuanta() const
+        {
+            return !m_undoQuantums.empty();
+        }
+
         int64_t getSize() const
         {
             int64_t total = 0;
@@ -368,6 +368,12 @@ string planNodeToString(PlanNodeType type)
     case PLAN_NODE_TYPE_NESTLOOPINDEX: {
         return "NESTLOOPINDEX";
     }
+    case PLAN_NODE_TYPE_HASHJOIN: {
+        return "HASHJOIN";
+    }
+    case PLAN_NODE_TYPE_MERGEJOIN: {
+        return "MERGEJOIN";
+    }
     case PLAN_NODE_TYPE_UPDATE: {
         return "UPDATE";
     }
@@ -433,6 +439,10 @@ PlanNodeType stringToPlanNode(string str )
         return PLAN_NODE_TYPE_NESTLOOP;
     } else if (str == "NESTLOOPINDEX") {
         return PLAN_NODE_TYPE_NESTLOOPINDEX;
+    } else if (str == "HASHJOIN") {
+        return PLAN_NODE_TYPE_HASHJOIN;
+    } else if (str == "MERGEJOIN") {
+        return PLAN_NODE_TYPE_MERGEJOIN;
     } else if (str == "UPDATE") {
         return PLAN_NODE_TYPE_UPDATE;
     } else if (str == "INSERT") {
@@ -563,6 +573,15 @@ string expressionToString(ExpressionType type)
     case EXPRESSION_TYPE_AGGREGATE_AVG: {
         return "AGGREGATE_AVG";
     }
+    case EXPRESSION_TYPE_AGGREGATE_APPROX_COUNT_DISTINCT: {
+        return "AGGREGATE_APPROX_COUNT_DISTINCT";
+    }
+    case EXPRESSION_TYPE_AGGREGATE_VALS_TO_HYPERLOGLOG: {
+        return "AGGREGATE_VALS_TO_HYPERLOGLOG";
+    }
+    case EXPRESSION_TYPE_AGGREGATE_HYPERLOGLOGS_TO_CARD: {
+        return "AGGREGATE_HYPERLOGLOGS_TO_CARD";
+    }
     case EXPRESSION_TYPE_FUNCTION: {
         return "FUNCTION";
     }
@@ -646,6 +665,12 @@ ExpressionType stringToExpression(string str )
         return EXPRESSION_TYPE_AGGREGATE_MAX;
     } else if (str == "AGGREGATE_AVG") {
         return EXPRESSION_TYPE_AGGREGATE_AVG;
+    } else if (str == "AGGREGATE_APPROX_COUNT_DISTINCT") {
+        return EXPRESSION_TYPE_AGGREGATE_APPROX_COUNT_DISTINCT;
+    } else if (str == "AGGREGATE_VALS_TO_HYPERLOGLOG") {
+        return EXPRESSION_TYPE_AGGREGATE_VALS_TO_HYPERLOGLOG;
+    } else if (str == "AGGREGATE_HYPERLOGLOGS_TO_CARD") {
+        return EXPRESSION_TYPE_AGGREGATE_HYPERLOGLOGS_TO_CARD;
     } else if (str == "FUNCTION") {
         return EXPRESSION_TYPE_FUNCTION;
     } else if (str == "VALUE_VECTOR") {
@@ -187,6 +187,8 @@ enum PlanNodeType {
     //
     PLAN_NODE_TYPE_NESTLOOP         = 20,
     PLAN_NODE_TYPE_NESTLOOPINDEX    = 21,
+    PLAN_NODE_TYPE_HASHJOIN         = 22,
+    PLAN_NODE_TYPE_MERGEJOIN        = 23,
 
     //
     // Operator Nodes
@@ -299,6 +301,9 @@ enum ExpressionType {
     EXPRESSION_TYPE_AGGREGATE_MIN                   = 43,
     EXPRESSION_TYPE_AGGREGATE_MAX                   = 44,
     EXPRESSION_TYPE_AGGREGATE_AVG                   = 45,
+    EXPRESSION_TYPE_AGGREGATE_APPROX_COUNT_DISTINCT = 46, // estimated COUNT(DISTINCT) from a HyperLogLog sketch
+    EXPRESSION_TYPE_AGGREGATE_VALS_TO_HYPERLOGLOG   = 47, // partial APPROX_COUNT_DISTINCT: the serialized sketch
+    EXPRESSION_TYPE_AGGREGATE_HYPERLOGLOGS_TO_CARD  = 48, // merges partial sketches into the estimate
 
     // -----------------------------
     // Functions
@@ -325,6 +330,11 @@ enum ExpressionType {
 enum TableIndexType {
     BALANCED_TREE_INDEX     = 1,
     HASH_TABLE_INDEX        = 2,
+    // A unique hash index on a small integer key, as an open addressing table.
+    // Other keys get a HASH_TABLE_INDEX.
+    OPEN_HASH_TABLE_INDEX   = 3,
+    // A tree index as a B+tree of cache-line-aligned nodes.
+    BTREE_INDEX             = 4,
 };
 
 // ------------------------------------------------------------------
@@ -417,9 +427,11 @@ inline bool tableStreamTypeAppliesToPreTruncateTable(TableStreamType streamType)
 // ------------------------------------------------------------------
 // Statistics Selector Types
 // ------------------------------------------------------------------
+// The values are the ordinals of org.voltdb.StatsSelector.
 enum StatisticsSelectorType {
-    STATISTICS_SELECTOR_TYPE_TABLE,
-    STATISTICS_SELECTOR_TYPE_INDEX
+    STATISTICS_SELECTOR_TYPE_TABLE = 0,
+    STATISTICS_SELECTOR_TYPE_INDEX = 1,
+    STATISTICS_SELECTOR_TYPE_STRING_STORAGE = 24
 };
 
 // ------------------------------------------------------------------
@@ -137,12 +137,14 @@ public:
     ExecutorVector(int64_t fragmentId,
                    int64_t logThreshold,
                    int64_t memoryLimit,
+                   const std::string& spillDirectory,
                    PlanNodeFragment* fragment)
         : m_fragId(fragmentId)
         , m_list()
         , m_limits(memoryLimit, logThreshold)
         , m_fragment(fragment)
     {
+        m_limits.setSpillDirectory(spillDirectory);
     }
 
     /** Build the list of executors from its plan node fragment */
@@ -151,6 +153,19 @@ public:
             initPlanNode(engine, planNode);
             m_list.push_back(planNode->getExecutor());
         }
+
+        // Push the output of streaming executors straight into the
+        // parents that can take it that way.
+        BOOST_FOREACH(AbstractExecutor* executor, m_list) {
+            const std::vector<AbstractPlanNode*>& children = executor->getPlanNode()->getChildren();
+            if (children.size() != 1 || !executor->canConsumePushedTuples()) {
+                continue;
+            }
+            AbstractExecutor* child = children[0]->getExecutor();
+            if (child->canPushTuples()) {
+                child->pipelineInto(executor);
+            }
+        }
     }
 
     /** Accessor function to satisfy boost::multi_index::const_mem_fun template. */
@@ -158,6 +173,16 @@ public:
 
     const TempTableLimits& limits() const { return m_limits; }
 
+    /** Does any executor run expressions specialized for their shape? */
+    bool isSpecialized() const {
+        BOOST_FOREACH (AbstractExecutor* ae, m_list) {
+            if (ae->isSpecialized()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     /** Return a string with helpful info about this object. */
     std::string debug() const {
         std::ostringstream oss;
@@ -165,7 +190,8 @@ public:
         oss << "Fragment ID: " << m_fragId << ", "
             << "Executor list size: " << m_list.size() << ", "
             << "Temp table memory in bytes: "
-            << m_limits.getAllocated() << endl;
+            << m_limits.getAllocated() << ", "
+            << "Specialized: " << (isSpecialized() ? "yes" : "no") << endl;
 
         BOOST_FOREACH (AbstractExecutor* ae, m_list) {
             oss << ae->getPlanNode()->debug(" ") << "\n";
@@ -310,6 +336,7 @@ VoltDBEngine::VoltDBEngine(Topend *topend, LogProxy *logProxy)
       m_lastAccessedTable(NULL),
       m_currentUndoQuantum(NULL),
       m_hashinator(NULL),
+      m_coldBlockTicks(0),
       m_staticParams(MAX_PARAM_COUNT),
       m_pfCount(0),
       m_currentInputDepId(-1),
@@ -356,7 +383,9 @@ VoltDBEngine::initialize(int32_t clusterIndex,
                          int32_t hostId,
                          string hostname,
                          int64_t tempTableMemoryLimit,
-                         int32_t compactionThreshold)
+                         int32_t compactionThreshold,
+                         PageAllocator::HugePages hugePages,
+                         int32_t numaNode)
 {
     m_clusterIndex = clusterIndex;
     m_siteId = siteId;
@@ -364,6 +393,9 @@ VoltDBEngine::initialize(int32_t clusterIndex,
     m_tempTableMemoryLimit = tempTableMemoryLimit;
     m_compactionThreshold = compactionThreshold;
 
+    // Everything this engine's tables and indexes map from here on, on this thread, is backed so.
+    PageAllocator::configure(hugePages, numaNode);
+
     // Instantiate our catalog - it will be populated later on by load()
     m_catalog.reset(new catalog::Catalog());
 
@@ -407,6 +439,14 @@ VoltDBEngine::initialize(int32_t clusterIndex,
                                             hostId,
                                             &m_drStream);
     m_drStream.configure(partitionId);
+
+    // The string storage is the thread's, so its stats sources outlive catalog changes.
+    for (int sizeClass = 0; sizeClass < CompactingStringStorage::CLASS_COUNT; sizeClass++) {
+        boost::shared_ptr<StringStorageStats> stats(new StringStorageStats(sizeClass));
+        stats->configure("String storage stats", 0);
+        m_stringStorageStats.push_back(stats);
+        getStatsManager().registerStatsSource(STATISTICS_SELECTOR_TYPE_STRING_STORAGE, 0, stats.get());
+    }
     return true;
 }
 
@@ -961,17 +1001,24 @@ VoltDBEngine::processCatalogAdditions(int64_t timestamp)
             }
 
             //
-            // Same schema, but TUPLE_LIMIT may change.
+            // Same schema, but TUPLE_LIMIT, the PAX layout or the dictionary
+            // encoded columns may change.
             // Because there is no table rebuilt work next, no special need to take care of
             // the new tuple limit.
             //
             persistenttable->setTupleLimit(catalogTable->tuplelimit());
+            persistenttable->setPaxLayout(catalogTable->paxlayout());
+            persistenttable->setDictionaryEncodedColumns(
+                    TableCatalogDelegate::getDictionaryEncodedColumns(*catalogTable));
 
             //////////////////////////////////////////
             // find all of the indexes to add
             //////////////////////////////////////////
 
             const vector<TableIndex*> currentIndexes = persistenttable->allIndexes();
+            // new indexes are built together, see Table::addIndexes
+            vector<TableIndex*> addedIndexes;
+            vector<catalog::Index*> addedCatalogIndexes;
 
             // iterate over indexes for this table in the catalog
             BOOST_FOREACH (LabeledIndex labeledIndex, catalogTable->indexes()) {
@@ -1002,20 +1049,27 @@ VoltDBEngine::processCatalogAdditions(int64_t timestamp)
                     if (!success) {
                         VOLT_ERROR("Failed to initialize index '%s' from catalog",
                                    foundIndex->name().c_str());
+                        BOOST_FOREACH (TableIndex* index, addedIndexes) {
+                            delete index;
+                        }
                         return false;
                     }
 
                     TableIndex *index = TableIndexFactory::getInstance(scheme);
                     assert(index);
+                    addedIndexes.push_back(index);
+                    addedCatalogIndexes.push_back(foundIndex);
+                }
+            }
 
-                    // all of the data should be added here
-                    persistenttable->addIndex(index);
+            // all of the data should be added here
+            persistenttable->addIndexes(addedIndexes);
 
-                    // add the index to the stats source
-                    index->getIndexStats()->configure(index->getName() + " stats",
-                                                      persistenttable->name(),
-                                                      foundIndex->relativeIndex());
-                }
+            // add the indexes to the stats source
+            for (size_t i = 0; i < addedIndexes.size(); i++) {
+                addedIndexes[i]->getIndexStats()->configure(addedIndexes[i]->getName() + " stats",
+                                                            persistenttable->name(),
+                                                            addedCatalogIndexes[i]->relativeIndex());
             }
 
             //////////////////////////////////////////
@@ -1317,7 +1371,8 @@ ExecutorVector *VoltDBEngine::getExecutorVectorForFragmentId(const int64_t fragI
         // Note: the executor vector takes ownership of the plan node
         // fragment here.
         ExecutorVector* ev =
-          new ExecutorVector(fragId, frag_temptable_log_limit, frag_temptable_limit, pnf);
+          new ExecutorVector(fragId, frag_temptable_log_limit, frag_temptable_limit,
+                             m_tempTableSpillDirectory, pnf);
         boost::shared_ptr<ExecutorVector> ev_guard(ev);
         ev->init(this);
 
@@ -1403,6 +1458,22 @@ void VoltDBEngine::tick(int64_t timeInMillis, int64_t lastCommittedSpHandle) {
     BOOST_FOREACH (TablePair table, m_exportingTables) {
         table.second->flushOldTuples(timeInMillis);
     }
+    // Tuples are only moved or compressed while no undo action can hold on to
+    // their addresses. Tick can run between the fragments of an open
+    // multi-partition transaction.
+    if ( ! m_undoLog.hasPendingQuanta()) {
+        BOOST_FOREACH (TablePair table, m_tablesByName) {
+            PersistentTable *persistentTable = dynamic_cast<PersistentTable*>(table.second);
+            if (persistentTable != NULL) {
+                persistentTable->doIncrementalCompaction();
+                if (m_coldBlockTicks > 0) {
+                    persistentTable->compressColdBlocks(m_coldBlockTicks);
+                }
+            }
+        }
+    }
+    // give back what the strings freed since the last tick hold on to
+    ThreadLocalPool::getStringPool()->compact();
     m_drStream.periodicFlush(timeInMillis, lastCommittedSpHandle);
 }
 
@@ -1439,7 +1510,8 @@ string VoltDBEngine::debug(void) const
  * @param locators Integer identifiers specifying what subset of possible
  *                 statistical sources should be polled. Probably a CatalogId
  *                 Can be NULL in which case all possible sources for the
- *                 selector should be included.
+ *                 selector should be included. The string storage selector
+ *                 has a source per size class and ignores them.
  * @param numLocators Size of locators array.
  * @param interval Whether to return counters since the beginning or since the
  *                 last time this was called
@@ -1494,6 +1566,12 @@ int VoltDBEngine::getStats(int selector, int locators[], int numLocators,
                 (StatisticsSelectorType) selector,
                 locatorIds, interval, now);
             break;
+        case STATISTICS_SELECTOR_TYPE_STRING_STORAGE:
+            // A row per size class; the sources are all registered under 0.
+            resultTable = m_statsManager.getStats(
+                (StatisticsSelectorType) selector,
+                vector<CatalogId>(1, 0), interval, now);
+            break;
         default:
             char message[256];
             snprintf(message, 256, "getStats() called with an unrecognized selector"
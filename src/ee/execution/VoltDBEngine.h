@@ -47,8 +47,10 @@
 #define VOLTDBENGINE_H
 
 #include "common/DefaultTupleSerializer.h"
+#include "common/PageAllocator.h"
 #include "common/Pool.hpp"
 #include "common/serializeio.h"
+#include "common/StringStorageStats.h"
 #include "common/ThreadLocalPool.h"
 #include "common/UndoLog.h"
 #include "common/valuevector.h"
@@ -60,6 +62,7 @@
 #include "storage/BinaryLogSink.h"
 
 #include "boost/scoped_ptr.hpp"
+#include "boost/shared_ptr.hpp"
 #include "boost/unordered_map.hpp"
 
 #include <map>
@@ -119,9 +122,25 @@ class __attribute__((visibility("default"))) VoltDBEngine {
                         int32_t hostId,
                         std::string hostname,
                         int64_t tempTableMemoryLimit,
-                        int32_t compactionThreshold = 95);
+                        int32_t compactionThreshold = 95,
+                        PageAllocator::HugePages hugePages = PageAllocator::HUGE_PAGES_NONE,
+                        int32_t numaNode = -1);
         virtual ~VoltDBEngine();
 
+        /**
+         * Let the temp tables of plan fragments loaded from now on spill to
+         * scratch files in this directory instead of failing at the temp table
+         * memory limit. An empty directory turns spilling off.
+         */
+        void setTempTableSpillDirectory(const std::string& directory) { m_tempTableSpillDirectory = directory; }
+
+        /**
+         * Let tick() compress the blocks of persistent tables that went this
+         * many ticks without being accessed; they are brought back when next
+         * scanned or looked up. 0, the default, keeps all blocks as they are.
+         */
+        void setColdBlockTicks(int32_t ticks) { m_coldBlockTicks = ticks; }
+
         // ------------------------------------------------------------------
         // OBJECT ACCESS FUNCTIONS
         // ------------------------------------------------------------------
@@ -434,6 +453,9 @@ class __attribute__((visibility("default"))) VoltDBEngine {
         boost::scoped_ptr<TheHashinator> m_hashinator;
         size_t m_startOfResultBuffer;
         int64_t m_tempTableMemoryLimit;
+        std::string m_tempTableSpillDirectory;
+        // ticks a table block goes unaccessed before it is compressed, 0 for never
+        int32_t m_coldBlockTicks;
 
         /*
          * Catalog delegates hashed by path.
@@ -518,6 +540,9 @@ class __attribute__((visibility("default"))) VoltDBEngine {
         /** Stats manager for this execution engine **/
         voltdb::StatsAgent m_statsManager;
 
+        /** Stats sources for the size classes of the string storage, by class */
+        std::vector<boost::shared_ptr<StringStorageStats> > m_stringStorageStats;
+
         /*
          * Pool for short lived strings that will not live past the return back to Java.
          */
@@ -92,15 +92,62 @@ class AbstractExecutor {
         }
     }
 
+    /**
+     * Let an input temp table spill to disk under the fragment's limits.
+     * Only for executors that read that input strictly through a TableIterator.
+     */
+    inline void allowInputTempTableSpill(Table * input_table) {
+        TempTable* tmp_input_table = dynamic_cast<TempTable*>(input_table);
+        if (tmp_input_table) {
+            tmp_input_table->enableSpill();
+        }
+    }
+
     virtual void cleanupMemoryPool() {
         // LEAVE as blank on purpose
     }
 
+    /**
+     * Whether init replaced generic expression trees of the plannode with
+     * code specialized for their shape, for the plan cache statistics.
+     */
+    virtual bool isSpecialized() const {
+        return false;
+    }
+
+    /**
+     * PIPELINING
+     *
+     * An executor that produces its output a tuple at a time into a temp
+     * table of its own can instead push each tuple straight into its
+     * parent, when the parent can take its only input that way. The
+     * parent then runs inside the child's execute and its own execute
+     * does nothing, and the child's output table is never filled.
+     * Blocking executors (aggregates, order by without a limit, joins
+     * on their build side) read a materialized input as before.
+     */
+    virtual bool canPushTuples() const {
+        return false;
+    }
+
+    virtual bool canConsumePushedTuples() const {
+        return false;
+    }
+
+    /** Push the output tuples of this executor into consumer. Called once all executors are initialized. */
+    void pipelineInto(AbstractExecutor* consumer) {
+        assert(canPushTuples() && consumer->canConsumePushedTuples());
+        m_consumer = consumer;
+        consumer->m_pipelined = true;
+    }
+
   protected:
     AbstractExecutor(VoltDBEngine* engine, AbstractPlanNode* abstractNode) {
         m_abstractNode = abstractNode;
         m_tmpOutputTable = NULL;
         m_engine = engine;
+        m_consumer = NULL;
+        m_pipelined = false;
     }
 
     /** Concrete executor classes implement initialization in p_init() */
@@ -110,6 +157,37 @@ class AbstractExecutor {
     /** Concrete executor classes impelmenet execution in p_execute() */
     virtual bool p_execute(const NValueArray& params) = 0;
 
+    /**
+     * Executors that can consume pushed tuples implement these in place of
+     * p_execute when they are pipelined. p_push_init is called before the
+     * producer starts, p_push_tuple with each of its output tuples, and
+     * p_push_finish once it is done. p_push_tuple returns true once no more
+     * tuples are wanted, as for AggregateExecutorBase::p_execute_tuple.
+     */
+    virtual void p_push_init(const NValueArray& params) {
+        assert(false);
+    }
+
+    virtual bool p_push_tuple(TableTuple& tuple) {
+        assert(false);
+        return true;
+    }
+
+    virtual void p_push_finish() { }
+
+    /**
+     * Output a tuple: push it into the consumer this executor is pipelined
+     * into, or else insert it into the temp output table. Returns true once
+     * the consumer wants no more tuples.
+     */
+    inline bool outputTuple(TempTable* outputTable, TableTuple& tuple) {
+        if (m_consumer != NULL) {
+            return m_consumer->p_push_tuple(tuple);
+        }
+        outputTable->insertTempTuple(tuple);
+        return false;
+    }
+
     /**
      * Set up a multi-column temp output table for those executors that require one.
      * Called from p_init.
@@ -126,8 +204,28 @@ class AbstractExecutor {
     AbstractPlanNode* m_abstractNode;
     TempTable* m_tmpOutputTable;
 
+    // the parent this executor pushes its output tuples into, if any
+    AbstractExecutor* m_consumer;
+    // whether this executor takes its input from a child pushing it
+    bool m_pipelined;
+
     /** reference to the engine to call up to the top end */
     VoltDBEngine* m_engine;
+
+  private:
+    void pushInit(const NValueArray& params) {
+        p_push_init(params);
+        if (m_consumer != NULL) {
+            m_consumer->pushInit(params);
+        }
+    }
+
+    void pushFinish() {
+        p_push_finish();
+        if (m_consumer != NULL) {
+            m_consumer->pushFinish();
+        }
+    }
 };
 
 
@@ -136,8 +234,23 @@ inline bool AbstractExecutor::execute(const NValueArray& params)
     assert(m_abstractNode);
     VOLT_TRACE("Starting execution of plannode(id=%d)...",  m_abstractNode->getPlanNodeId());
 
-    // run the executor
-    return p_execute(params);
+    // A pipelined executor ran as its input was pushed
+    if (m_pipelined) {
+        return true;
+    }
+
+    if (m_consumer == NULL) {
+        // run the executor
+        return p_execute(params);
+    }
+
+    // run the executor along with the consumers it pushes its output into
+    m_consumer->pushInit(params);
+    if (!p_execute(params)) {
+        return false;
+    }
+    m_consumer->pushFinish();
+    return true;
 }
 
 }
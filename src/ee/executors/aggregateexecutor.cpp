@@ -48,15 +48,24 @@
 #include "common/ValueFactory.hpp"
 #include "common/common.h"
 #include "common/debuglog.h"
+#include "common/executorcontext.hpp"
+#include "common/HyperLogLog.h"
 #include "common/SerializableEEException.h"
+#include "common/ValuePeeker.hpp"
 #include "expressions/abstractexpression.h"
+#include "expressions/tuplevalueexpression.h"
 #include "plannodes/aggregatenode.h"
 #include "plannodes/limitnode.h"
+#include "structures/PoolBackedHashSet.h"
+#include "storage/tablefactory.h"
 #include "storage/temptable.h"
 #include "storage/tableiterator.h"
+#include "storage/TempTableLimits.h"
 
 #include "boost/foreach.hpp"
+#include "boost/functional/hash.hpp"
 #include "boost/unordered_map.hpp"
+#include "murmur3/MurmurHash3.h"
 
 #include <algorithm>
 #include <limits>
@@ -66,11 +75,12 @@
 
 namespace voltdb {
 /*
- * Type of the hash set used to check for column aggregate distinctness
+ * Type of the hash set used to check for column aggregate distinctness.
+ * Its slots come from the executor's memory pool, as the aggregates do.
  */
-typedef boost::unordered_set<NValue,
-                             NValue::hash,
-                             NValue::equal_to> AggregateNValueSetType;
+typedef PoolBackedHashSet<NValue,
+                          NValue::hash,
+                          NValue::equal_to> AggregateNValueSetType;
 
 /**
  * Mix-in class to tweak some Aggs' behavior when the DISTINCT flag was specified,
@@ -78,19 +88,25 @@ typedef boost::unordered_set<NValue,
  * It is specified as a parameter class that determines the type of the ifDistinct data member.
  */
 struct Distinct : public AggregateNValueSetType {
+    Distinct(Pool* memoryPool) : AggregateNValueSetType(memoryPool), m_memoryPool(memoryPool) { }
+
     bool excludeValue(const NValue& val)
     {
-        // find this value in the set.  If it doesn't exist, add
-        // it, otherwise indicate it shouldn't be included in the
-        // aggregate
-        iterator setval = find(val);
-        if (setval == end())
-        {
-            insert(val);
-            return false; // Include value just this once.
+        // add this value to the set.  If it was already there,
+        // indicate it shouldn't be included in the aggregate
+        std::pair<NValue*, bool> added = insert(val);
+        if ( ! added.second) {
+            return true; // Never again this value;
         }
-        return true; // Never again this value;
+        // A string inlined in the input tuple goes away with the tuple.
+        if (val.getSourceInlined()) {
+            added.first->allocateObjectFromInlinedValue(m_memoryPool);
+        }
+        return false; // Include value just this once.
     }
+
+private:
+    Pool* m_memoryPool;
 };
 
 /**
@@ -99,6 +115,7 @@ struct Distinct : public AggregateNValueSetType {
  * It is specified as a parameter class that determines the type of the ifDistinct data member.
  */
 struct NotDistinct {
+    NotDistinct(Pool* memoryPool) { }
     void clear() { }
     bool excludeValue(const NValue& val)
     {
@@ -111,7 +128,7 @@ template<class D>
 class SumAgg : public Agg
 {
   public:
-    SumAgg() {}
+    SumAgg(Pool* memoryPool) : ifDistinct(memoryPool) {}
 
     virtual void advance(const NValue& val)
     {
@@ -143,7 +160,7 @@ template<class D>
 class AvgAgg : public Agg
 {
 public:
-    AvgAgg() : m_count(0) {}
+    AvgAgg(Pool* memoryPool) : ifDistinct(memoryPool), m_count(0) {}
 
     virtual void advance(const NValue& val)
     {
@@ -187,7 +204,7 @@ template<class D>
 class CountAgg : public Agg
 {
 public:
-    CountAgg() : m_count(0) {}
+    CountAgg(Pool* memoryPool) : ifDistinct(memoryPool), m_count(0) {}
 
     virtual void advance(const NValue& val)
     {
@@ -340,6 +357,112 @@ private:
     Pool* m_memoryPool;
 };
 
+/*
+ * Hash a non-null value for a HyperLogLog sketch. Equal values must hash
+ * alike on every partition, so only the value itself goes into the hash.
+ */
+static uint32_t hashForHyperLogLog(const NValue& val)
+{
+    switch (ValuePeeker::peekValueType(val)) {
+    case VALUE_TYPE_TINYINT:
+    case VALUE_TYPE_SMALLINT:
+    case VALUE_TYPE_INTEGER:
+    case VALUE_TYPE_BIGINT:
+    case VALUE_TYPE_TIMESTAMP:
+        return MurmurHash3_x64_128(ValuePeeker::peekAsRawInt64(val));
+    case VALUE_TYPE_DOUBLE: {
+        // -0.0 == 0.0
+        double d = ValuePeeker::peekDouble(val) + 0.0;
+        return MurmurHash3_x64_128(&d, sizeof(d), 0);
+    }
+    case VALUE_TYPE_DECIMAL: {
+        TTInt decimal = ValuePeeker::peekDecimal(val);
+        return MurmurHash3_x64_128(decimal.table, sizeof(decimal.table), 0);
+    }
+    case VALUE_TYPE_VARCHAR:
+    case VALUE_TYPE_VARBINARY:
+        return MurmurHash3_x64_128(ValuePeeker::peekObjectValue_withoutNull(val),
+                                   ValuePeeker::peekObjectLength_withoutNull(val), 0);
+    default:
+        throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                      "Attempted to estimate distinct values of an unsupported type");
+    }
+}
+
+/*
+ * Estimates COUNT(DISTINCT) with a HyperLogLog sketch, whose size does not
+ * grow with the number of distinct values.
+ */
+class ApproxCountDistinctAgg : public Agg
+{
+public:
+    ApproxCountDistinctAgg() {}
+
+    virtual void advance(const NValue& val)
+    {
+        if (val.isNull()) {
+            return;
+        }
+        m_hyperLogLog.add(hashForHyperLogLog(val));
+    }
+
+    virtual NValue finalize(ValueType type)
+    {
+        return ValueFactory::getBigIntValue(m_hyperLogLog.estimate()).castAs(type);
+    }
+
+    virtual void resetAgg()
+    {
+        Agg::resetAgg();
+        m_hyperLogLog.clear();
+    }
+
+protected:
+    HyperLogLog m_hyperLogLog;
+};
+
+/*
+ * The partial APPROX_COUNT_DISTINCT of a partition: the sketch itself,
+ * serialized as VARBINARY to be sent to the coordinator.
+ */
+class ValsToHyperLogLogAgg : public ApproxCountDistinctAgg
+{
+public:
+    ValsToHyperLogLogAgg() {}
+
+    virtual NValue finalize(ValueType type)
+    {
+        char serialized[HyperLogLog::SERIALIZED_SIZE];
+        m_hyperLogLog.serializeTo(serialized);
+        return ValueFactory::getBinaryValue(reinterpret_cast<const unsigned char*>(serialized),
+                                            HyperLogLog::SERIALIZED_SIZE,
+                                            ExecutorContext::getTempStringPool());
+    }
+};
+
+/*
+ * Merges the sketches of the partitions made by ValsToHyperLogLogAgg into
+ * the estimate of APPROX_COUNT_DISTINCT over all of them.
+ */
+class HyperLogLogsToCardAgg : public ApproxCountDistinctAgg
+{
+public:
+    HyperLogLogsToCardAgg() {}
+
+    virtual void advance(const NValue& val)
+    {
+        if (val.isNull()) {
+            return;
+        }
+        if (ValuePeeker::peekValueType(val) != VALUE_TYPE_VARBINARY) {
+            throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                          "Attempted to merge a value that is not a HyperLogLog sketch");
+        }
+        m_hyperLogLog.mergeSerialized(static_cast<const char*>(ValuePeeker::peekObjectValue_withoutNull(val)),
+                                      ValuePeeker::peekObjectLength_withoutNull(val));
+    }
+};
+
 /*
  * Create an instance of an aggregator for the specified aggregate type and "distinct" flag.
  * The object is allocated from the provided memory pool.
@@ -355,19 +478,25 @@ inline Agg* getAggInstance(Pool& memoryPool, ExpressionType agg_type, bool isDis
         return new (memoryPool) MaxAgg(&memoryPool);
     case EXPRESSION_TYPE_AGGREGATE_COUNT:
         if (isDistinct) {
-            return new (memoryPool) CountAgg<Distinct>();
+            return new (memoryPool) CountAgg<Distinct>(&memoryPool);
         }
-        return new (memoryPool) CountAgg<NotDistinct>();
+        return new (memoryPool) CountAgg<NotDistinct>(&memoryPool);
     case EXPRESSION_TYPE_AGGREGATE_SUM:
         if (isDistinct) {
-            return new (memoryPool) SumAgg<Distinct>();
+            return new (memoryPool) SumAgg<Distinct>(&memoryPool);
         }
-        return new (memoryPool) SumAgg<NotDistinct>();
+        return new (memoryPool) SumAgg<NotDistinct>(&memoryPool);
     case EXPRESSION_TYPE_AGGREGATE_AVG:
         if (isDistinct) {
-            return new (memoryPool) AvgAgg<Distinct>();
+            return new (memoryPool) AvgAgg<Distinct>(&memoryPool);
         }
-        return new (memoryPool) AvgAgg<NotDistinct>();
+        return new (memoryPool) AvgAgg<NotDistinct>(&memoryPool);
+    case EXPRESSION_TYPE_AGGREGATE_APPROX_COUNT_DISTINCT:
+        return new (memoryPool) ApproxCountDistinctAgg();
+    case EXPRESSION_TYPE_AGGREGATE_VALS_TO_HYPERLOGLOG:
+        return new (memoryPool) ValsToHyperLogLogAgg();
+    case EXPRESSION_TYPE_AGGREGATE_HYPERLOGLOGS_TO_CARD:
+        return new (memoryPool) HyperLogLogsToCardAgg();
     default:
     {
         char message[128];
@@ -617,17 +746,111 @@ void AggregateExecutorBase::p_execute_finish()
     m_memoryPool.purge();
 }
 
-AggregateHashExecutor::~AggregateHashExecutor() {}
+/// The address a string column of a key is taken by, NULL for a null.
+static inline const void* stringReference(const TableTuple& key, int column)
+{
+    const NValue value = key.getNValue(column);
+    return value.isNull() ? NULL : ValuePeeker::peekObjectValue_withoutNull(value);
+}
+
+size_t GroupByKeyHasher::operator()(const TableTuple& key) const
+{
+    if (m_byReference == NULL || m_byReference->empty()) {
+        return key.hashCode();
+    }
+    size_t seed = 0;
+    for (int ii = 0; ii < key.sizeInValues(); ii++) {
+        if ((*m_byReference)[ii]) {
+            boost::hash_combine(seed, stringReference(key, ii));
+        }
+        else {
+            key.getNValue(ii).hashCombine(seed);
+        }
+    }
+    return seed;
+}
+
+bool GroupByKeyEqualityChecker::operator()(const TableTuple& lhs, const TableTuple& rhs) const
+{
+    if (m_byReference == NULL || m_byReference->empty()) {
+        return lhs.equalsNoSchemaCheck(rhs);
+    }
+    for (int ii = 0; ii < lhs.sizeInValues(); ii++) {
+        if ((*m_byReference)[ii]) {
+            if (stringReference(lhs, ii) != stringReference(rhs, ii)) {
+                return false;
+            }
+        }
+        else if (lhs.getNValue(ii).op_notEquals(rhs.getNValue(ii)).isTrue()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Number of grace hash partitions and the fraction of the temp table memory
+// limit that the groups held in memory may use once spilling is enabled.
+static const int HASH_AGGREGATE_SPILL_PARTITIONS = 16;
+static const int64_t HASH_AGGREGATE_MEMORY_DIVISOR = 4;
+
+AggregateHashExecutor::~AggregateHashExecutor()
+{
+    dropSpillPartitions(m_spillPartitions);
+}
+
+bool AggregateHashExecutor::p_init(AbstractPlanNode* abstract_node, TempTableLimits* limits)
+{
+    m_limits = limits;
+    if ( ! m_abstractNode->isInline()) {
+        // Input tuples are copied into the groups, so the input may spill to disk.
+        allowInputTempTableSpill(m_abstractNode->getInputTable());
+    }
+    return AggregateExecutorBase::p_init(abstract_node, limits);
+}
 
 TableTuple AggregateHashExecutor::p_execute_init(const NValueArray& params,
         ProgressMonitorProxy* pmp, const TupleSchema * schema, TempTable* newTempTable)
 {
     VOLT_TRACE("hash aggregate executor init..");
     m_hash.clear();
+    m_groupByReference.clear();
+    // partitions left over from an execution that failed
+    dropSpillPartitions(m_spillPartitions);
+    m_spillThreshold = -1;
+    m_spillPass = 0;
+    m_spillingNewGroups = false;
+    if (m_limits != NULL && m_limits->spillEnabled()) {
+        m_spillThreshold = m_limits->getMemoryLimit() / HASH_AGGREGATE_MEMORY_DIVISOR;
+    }
 
     return AggregateExecutorBase::p_execute_init(params, pmp, schema, newTempTable);
 }
 
+void AggregateHashExecutor::setDictionaryEncodedInput(const std::vector<StringDictionary*>& dictionaries)
+{
+    assert(m_hash.empty());
+    m_groupByReference.clear();
+    if (dictionaries.empty()) {
+        return;
+    }
+    std::vector<bool> byReference(m_groupByExpressions.size(), false);
+    bool any = false;
+    for (int ii = 0; ii < m_groupByExpressions.size(); ii++) {
+        // The key holds the row's own string object only if it holds the column as it is.
+        const TupleValueExpression* column = dynamic_cast<const TupleValueExpression*>(m_groupByExpressions[ii]);
+        if (column != NULL && column->getTupleId() == 0 &&
+            column->getColumnId() >= 0 && column->getColumnId() < dictionaries.size() &&
+            dictionaries[column->getColumnId()] != NULL &&
+            ! m_groupByKeySchema->getColumnInfo(ii)->inlined) {
+            byReference[ii] = true;
+            any = true;
+        }
+    }
+    if (any) {
+        m_groupByReference.swap(byReference);
+    }
+}
+
 bool AggregateHashExecutor::p_execute(const NValueArray& params)
 {
     // Input table
@@ -663,6 +886,11 @@ bool AggregateHashExecutor::p_execute_tuple(const TableTuple& nextTuple) {
 
     // Group not found. Make a new entry in the hash for this new group.
     if (keyIter == m_hash.end()) {
+        if (m_spillThreshold >= 0 &&
+            (m_spillingNewGroups || m_memoryPool.getAllocatedMemory() > m_spillThreshold)) {
+            spillTuple(nextTuple);
+            return false;
+        }
         VOLT_TRACE("hash aggregate: new group..");
         aggregateRow = new (m_memoryPool, m_aggTypes.size()) AggregateRow();
         m_hash.insert(HashAggregateMapType::value_type(nextGroupByKeyTuple, aggregateRow));
@@ -691,6 +919,45 @@ bool AggregateHashExecutor::p_execute_tuple(const TableTuple& nextTuple) {
 
 void AggregateHashExecutor::p_execute_finish() {
     VOLT_TRACE("finalizing..");
+    outputGroups();
+
+    // Each spilled partition holds every input tuple of its groups,
+    // so it can be aggregated and output on its own. The groups of a
+    // partition that don't fit in memory either are spilled again, to the
+    // partitions of the next pass, which hash the groups differently.
+    std::vector<TempTable*> partitions;
+    // the partitions hold copies of the input strings
+    m_groupByReference.clear();
+    try {
+        while ( ! m_spillPartitions.empty()) {
+            partitions.swap(m_spillPartitions);
+            ++m_spillPass;
+            for (size_t ii = 0; ii < partitions.size(); ii++) {
+                TableTuple& nextGroupByKeyTuple = m_nextGroupByKeyStorage;
+                nextGroupByKeyTuple.move(NULL);
+                m_memoryPool.purge();
+                m_spillingNewGroups = false;
+
+                TempTable* partition = partitions[ii];
+                TableTuple tuple(partition->schema());
+                TableIterator it = partition->iteratorDeletingAsWeGo();
+                while (it.next(tuple)) {
+                    AggregateHashExecutor::p_execute_tuple(tuple);
+                }
+                outputGroups();
+            }
+            dropSpillPartitions(partitions);
+        }
+    }
+    catch (...) {
+        dropSpillPartitions(partitions);
+        throw;
+    }
+
+    AggregateExecutorBase::p_execute_finish();
+}
+
+void AggregateHashExecutor::outputGroups() {
     for (HashAggregateMapType::const_iterator iter = m_hash.begin(); iter != m_hash.end(); iter++) {
         AggregateRow *aggregateRow = iter->second;
         if (insertOutputTuple(aggregateRow)) {
@@ -701,7 +968,46 @@ void AggregateHashExecutor::p_execute_finish() {
 
     // Clean up
     m_hash.clear();
-    AggregateExecutorBase::p_execute_finish();
+}
+
+void AggregateHashExecutor::spillTuple(const TableTuple& nextTuple) {
+    m_spillingNewGroups = true;
+    if (m_spillPartitions.empty()) {
+        VOLT_DEBUG("hash aggregate: spilling new groups to %d partitions", HASH_AGGREGATE_SPILL_PARTITIONS);
+        std::vector<std::string> columnNames(m_inputSchema->columnCount());
+        for (int ii = 0; ii < HASH_AGGREGATE_SPILL_PARTITIONS; ii++) {
+            TempTable* partition = TableFactory::getTempTable(m_abstractNode->databaseId(),
+                                                              "HASH_AGGREGATE_SPILL",
+                                                              TupleSchema::createTupleSchema(m_inputSchema),
+                                                              columnNames,
+                                                              m_limits);
+            m_spillPartitions.push_back(partition);
+            partition->enableSpill();
+        }
+    }
+    // The groups of a partition all have the same hash modulo the partition
+    // count, so each pass mixes its number into the hash to split them.
+    TableTuple& nextGroupByKeyTuple = m_nextGroupByKeyStorage;
+    size_t hash = m_spillPass;
+    boost::hash_combine(hash, nextGroupByKeyTuple.hashCode());
+    size_t partition = hash % m_spillPartitions.size();
+    TableTuple source(nextTuple);
+    m_spillPartitions[partition]->insertTempTuple(source);
+    // The partitions fill up blocks in parallel, so spilling only the one that
+    // allocates a block is not enough to stay under the limit.
+    if (m_limits->shouldSpill(0)) {
+        BOOST_FOREACH(TempTable* partition, m_spillPartitions) {
+            partition->spillResidentBlocks();
+        }
+    }
+}
+
+void AggregateHashExecutor::dropSpillPartitions(std::vector<TempTable*>& partitions) {
+    BOOST_FOREACH(TempTable* partition, partitions) {
+        partition->freeAllBlocks();
+        delete partition;
+    }
+    partitions.clear();
 }
 
 AggregateSerialExecutor::~AggregateSerialExecutor() {}
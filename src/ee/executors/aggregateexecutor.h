@@ -57,6 +57,8 @@
 
 namespace voltdb {
 
+class StringDictionary;
+
 /*
  * Base class for an individual aggregate that aggregates a specific
  * column for a group
@@ -118,13 +120,8 @@ struct AggregateRow
         // Stop at the terminating null agg pointer that has been allocated as an extra and ignored since.
         for (int ii = 0; m_aggregates[ii] != NULL; ++ii) {
             // All the aggs inherit no-op delete operators, so, "delete" is really just destructor invocation.
-            // The destructor being invoked is the implicit specialization of Agg's destructor.
-            // The compiler generates it to invoke the destructor (if any) of the distinct value set (if any).
-            // It must be called because the pooled Agg object only embeds the (boost) set's "head".
-            // The "body" is allocated by boost via its defaulted stl allocator as the set grows
-            // -- AND it is not completely deallocated when "clear" is called.
-            // This AggregateRow destructor would not be required at all if distinct was based on a home-grown
-            // pool-aware hash, incapable of leaking outside the pool.
+            // The distinct value sets keep their slots in the pool, so no agg currently holds
+            // anything outside of it, but an agg that does can rely on its destructor being run.
             delete m_aggregates[ii];
         }
     }
@@ -185,6 +182,13 @@ public:
      */
     virtual void p_execute_finish();
 
+    /**
+     * Called after p_execute_init when the input tuples of this execution
+     * are the rows of a persistent table with these string dictionaries,
+     * by column. By default, nothing comes of it.
+     */
+    virtual void setDictionaryEncodedInput(const std::vector<StringDictionary*>& dictionaries) { }
+
     virtual void cleanupMemoryPool() {
         AggregateExecutorBase::p_execute_finish();
     }
@@ -255,10 +259,32 @@ private:
     TupleSchema* constructGroupBySchema(bool partial);
 };
 
+/**
+ * Hashes and compares group by keys, taking the key columns flagged in
+ * byReference by the address of their string rather than by its value.
+ * That is only right for strings shared through a StringDictionary, where
+ * equal strings are one object. With no flags, keys are taken by value.
+ */
+class GroupByKeyHasher {
+public:
+    GroupByKeyHasher(const std::vector<bool>* byReference = NULL) : m_byReference(byReference) { }
+    size_t operator()(const TableTuple& key) const;
+private:
+    const std::vector<bool>* m_byReference;
+};
+
+class GroupByKeyEqualityChecker {
+public:
+    GroupByKeyEqualityChecker(const std::vector<bool>* byReference = NULL) : m_byReference(byReference) { }
+    bool operator()(const TableTuple& lhs, const TableTuple& rhs) const;
+private:
+    const std::vector<bool>* m_byReference;
+};
+
 typedef boost::unordered_map<TableTuple,
                              AggregateRow*,
-                             TableTupleHasher,
-                             TableTupleEqualityChecker> HashAggregateMapType;
+                             GroupByKeyHasher,
+                             GroupByKeyEqualityChecker> HashAggregateMapType;
 
 
 /**
@@ -269,9 +295,11 @@ class AggregateHashExecutor : public AggregateExecutorBase
 {
 public:
     AggregateHashExecutor(VoltDBEngine* engine, AbstractPlanNode* abstract_node) :
-        AggregateExecutorBase(engine, abstract_node) { }
+        AggregateExecutorBase(engine, abstract_node),
+        m_hash(0, GroupByKeyHasher(&m_groupByReference), GroupByKeyEqualityChecker(&m_groupByReference)),
+        m_limits(NULL), m_spillThreshold(-1), m_spillPass(0), m_spillingNewGroups(false) { }
 
-    // empty destructor defined in .cpp file because of it is called virtually (not inline)
+    // destructor defined in .cpp file because of it is called virtually (not inline)
     // same reason for serial and partial
     ~AggregateHashExecutor();
 
@@ -280,9 +308,33 @@ public:
     bool p_execute_tuple(const TableTuple& nextTuple);
     void p_execute_finish();
 
+    /// Group by the address of the shared strings of dictionary encoded columns.
+    void setDictionaryEncodedInput(const std::vector<StringDictionary*>& dictionaries);
+
+protected:
+    virtual bool p_init(AbstractPlanNode*, TempTableLimits*);
+
 private:
     virtual bool p_execute(const NValueArray& params);
+
+    /// Insert the results of all groups in the hash into the output table and clear the hash.
+    void outputGroups();
+    /// Set aside an input tuple of a group that does not fit in memory (grace hash partitioning).
+    void spillTuple(const TableTuple& nextTuple);
+    void dropSpillPartitions(std::vector<TempTable*>& partitions);
+
+    /// The group by key columns taken by reference, empty if none are.
+    std::vector<bool> m_groupByReference;
     HashAggregateMapType m_hash;
+    TempTableLimits* m_limits;
+    /// Pool memory held by groups beyond which the input tuples of new groups
+    /// are spilled to partitions that are aggregated one at a time; -1 never spills.
+    int64_t m_spillThreshold;
+    /// Number of passes over spilled partitions so far, 0 while reading the input.
+    int m_spillPass;
+    /// Whether the new groups of the input being aggregated go to the spill partitions.
+    bool m_spillingNewGroups;
+    std::vector<TempTable*> m_spillPartitions;
 };
 
 /**
@@ -53,12 +53,19 @@
 #include "storage/temptable.h"
 #include "storage/tableiterator.h"
 #include "storage/tablefactory.h"
+#include "storage/TempTableLimits.h"
+
+#include "boost/foreach.hpp"
 
-#include <set>
 #include <cassert>
 
 using namespace voltdb;
 
+// Chunk size of the pools, small since most DISTINCTs see few values
+static const uint64_t DISTINCT_POOL_CHUNK_SIZE = 16 * 1024;
+// Slot memory kept from one execution to the next
+static const int64_t MAX_RETAINED_HASH_POOL_BYTES = 1024 * 1024;
+
 bool DistinctExecutor::p_init(AbstractPlanNode*,
                               TempTableLimits* limits)
 {
@@ -80,9 +87,119 @@ bool DistinctExecutor::p_init(AbstractPlanNode*,
                                               node->getInputTable(),
                                               limits));
     }
+    m_tempLimits = limits;
+
+    //
+    // A DISTINCT on several expressions de-duplicates a key tuple of their values
+    //
+    TupleSchema::freeTupleSchema(m_keySchema);
+    m_keySchema = NULL;
+    if (node->getDistinctExpression() == NULL) {
+        std::vector<ValueType> keyColumnTypes;
+        std::vector<int32_t> keyColumnSizes;
+        std::vector<bool> keyColumnAllowNull;
+        std::vector<bool> keyColumnInBytes;
+        BOOST_FOREACH (AbstractExpression* expr, node->getDistinctExpressions()) {
+            keyColumnTypes.push_back(expr->getValueType());
+            keyColumnSizes.push_back(expr->getValueSize());
+            keyColumnAllowNull.push_back(true);
+            keyColumnInBytes.push_back(expr->getInBytes());
+        }
+        m_keySchema = TupleSchema::createTupleSchema(keyColumnTypes,
+                                                     keyColumnSizes,
+                                                     keyColumnAllowNull,
+                                                     keyColumnInBytes);
+    }
     return (true);
 }
 
+void DistinctExecutor::initDistinctSets()
+{
+    if (m_hashPool == NULL) {
+        m_hashPool.reset(new Pool(DISTINCT_POOL_CHUNK_SIZE, 1));
+    }
+    if (m_memoryPool == NULL) {
+        m_memoryPool.reset(new Pool(DISTINCT_POOL_CHUNK_SIZE, 1));
+        if (m_keySchema != NULL) {
+            m_nextKeyStorage.init(m_keySchema, m_memoryPool.get());
+        }
+    }
+    if (m_values == NULL) {
+        m_values.reset(new DistinctValueSetType(m_hashPool.get()));
+        m_keys.reset(new DistinctKeySetType(m_hashPool.get()));
+    }
+}
+
+bool DistinctExecutor::insertDistinctValue(AbstractExpression* distinctExpression,
+                                           const TableTuple& tuple)
+{
+    NValue tuple_value = distinctExpression->eval(&tuple, NULL);
+    std::pair<NValue*, bool> added = m_values->insert(tuple_value);
+    if ( ! added.second) {
+        return false;
+    }
+    // A string inlined in the input tuple goes away with the tuple.
+    if (tuple_value.getSourceInlined()) {
+        added.first->allocateObjectFromInlinedValue(m_memoryPool.get());
+    }
+    return true;
+}
+
+bool DistinctExecutor::insertDistinctKey(const std::vector<AbstractExpression*>& distinctExpressions,
+                                         const TableTuple& tuple)
+{
+    TableTuple& nextKeyTuple = m_nextKeyStorage;
+    if (nextKeyTuple.isNullTuple()) {
+        m_nextKeyStorage.allocateActiveTuple();
+    }
+    for (int ii = 0; ii < distinctExpressions.size(); ii++) {
+        nextKeyTuple.setNValue(ii, distinctExpressions[ii]->eval(&tuple, NULL));
+    }
+    if ( ! m_keys->insert(nextKeyTuple).second) {
+        return false;
+    }
+    // The set is referencing the current key tuple,
+    // so force a new tuple allocation to hold the next key.
+    nextKeyTuple.move(NULL);
+    return true;
+}
+
+void DistinctExecutor::accountPooledBytes()
+{
+    const int64_t pooledBytes = m_hashPool->getAllocatedMemory() + m_memoryPool->getAllocatedMemory();
+    if (pooledBytes > m_hashedBytes) {
+        // Count it first so that releaseDistinctValues gives back exactly what was charged
+        // even if this charge is the one that exceeds the limit and throws.
+        const int64_t bytes = pooledBytes - m_hashedBytes;
+        m_hashedBytes = pooledBytes;
+        m_tempLimits->increaseAllocated(static_cast<int>(bytes));
+    }
+}
+
+void DistinctExecutor::releaseDistinctValues()
+{
+    if (m_hashPool->getAllocatedMemory() > MAX_RETAINED_HASH_POOL_BYTES) {
+        // The sets grew for an unusually large input; drop their slots
+        // along with the memory they outgrew.
+        m_values.reset();
+        m_keys.reset();
+        m_hashPool->purge();
+    }
+    else {
+        m_values->clear();
+        m_keys->clear();
+    }
+    if (m_keySchema != NULL) {
+        TableTuple& nextKeyTuple = m_nextKeyStorage;
+        nextKeyTuple.move(NULL);
+    }
+    m_memoryPool->purge();
+    if (m_hashedBytes > 0) {
+        m_tempLimits->reduceAllocated(static_cast<int>(m_hashedBytes));
+        m_hashedBytes = 0;
+    }
+}
+
 bool DistinctExecutor::p_execute(const NValueArray &params) {
     DistinctPlanNode* node = dynamic_cast<DistinctPlanNode*>(m_abstractNode);
     assert(node);
@@ -95,27 +212,38 @@ bool DistinctExecutor::p_execute(const NValueArray &params) {
     TableTuple tuple(input_table->schema());
 
     AbstractExpression *distinctExpression = node->getDistinctExpression();
-    std::set<NValue, NValue::ltNValue> found_values;
-    while (iterator.next(tuple)) {
-        //
-        // Check whether this value already exists in our list
-        //
-        NValue tuple_value = distinctExpression->eval(&tuple, NULL);
-        if (found_values.find(tuple_value) == found_values.end()) {
-            found_values.insert(tuple_value);
-            if (!output_table->insertTuple(tuple)) {
-                VOLT_ERROR("Failed to insert tuple from input table '%s' into"
-                           " output table '%s'",
-                           input_table->name().c_str(),
-                           output_table->name().c_str());
-                return false;
+    const std::vector<AbstractExpression*>& distinctExpressions = node->getDistinctExpressions();
+    initDistinctSets();
+    try {
+        while (iterator.next(tuple)) {
+            //
+            // Check whether this value already exists in our set
+            //
+            bool added = (distinctExpression != NULL) ?
+                insertDistinctValue(distinctExpression, tuple) :
+                insertDistinctKey(distinctExpressions, tuple);
+            if (added) {
+                accountPooledBytes();
+                if (!output_table->insertTuple(tuple)) {
+                    VOLT_ERROR("Failed to insert tuple from input table '%s' into"
+                               " output table '%s'",
+                               input_table->name().c_str(),
+                               output_table->name().c_str());
+                    releaseDistinctValues();
+                    return false;
+                }
             }
         }
+    } catch (...) {
+        releaseDistinctValues();
+        throw;
     }
 
+    releaseDistinctValues();
     cleanupInputTempTable(input_table);
     return true;
 }
 
 DistinctExecutor::~DistinctExecutor() {
+    TupleSchema::freeTupleSchema(m_keySchema);
 }
@@ -47,20 +47,32 @@
 #define HSTOREDISTINCTEXECUTOR_H
 
 #include "common/common.h"
+#include "common/Pool.hpp"
+#include "common/tabletuple.h"
 #include "common/valuevector.h"
 #include "executors/abstractexecutor.h"
 #include "plannodes/distinctnode.h"
+#include "structures/PoolBackedHashSet.h"
+
+#include "boost/scoped_ptr.hpp"
 
 namespace voltdb {
 
 class UndoLog;
 class ReadWriteSet;
 
+/**
+ * De-duplicates its input on the value of the distinct expression, or on
+ * the values of the distinct expressions taken together as a key tuple,
+ * with a hash set whose slots are kept from one execution to the next.
+ * The memory it holds while executing is charged to the TempTableLimits.
+ */
 class DistinctExecutor : public AbstractExecutor
 {
 public:
     DistinctExecutor(VoltDBEngine *engine, AbstractPlanNode* abstract_node)
-        : AbstractExecutor(engine, abstract_node)
+        : AbstractExecutor(engine, abstract_node), m_keySchema(NULL),
+          m_tempLimits(NULL), m_hashedBytes(0)
     {
         this->distinct_column_type = VALUE_TYPE_INVALID;
     }
@@ -73,6 +85,45 @@ protected:
     bool p_execute(const NValueArray &params);
 
     ValueType distinct_column_type;
+
+private:
+    typedef PoolBackedHashSet<NValue,
+                              NValue::hash,
+                              NValue::equal_to> DistinctValueSetType;
+    typedef PoolBackedHashSet<TableTuple,
+                              TableTupleHasher,
+                              TableTupleEqualityChecker> DistinctKeySetType;
+
+    /** Add the distinct value of tuple to the set. Return false if it was there already. */
+    bool insertDistinctValue(AbstractExpression* distinctExpression, const TableTuple& tuple);
+
+    /** Add the distinct key of tuple to the set. Return false if it was there already. */
+    bool insertDistinctKey(const std::vector<AbstractExpression*>& distinctExpressions,
+                           const TableTuple& tuple);
+
+    /** Charge the pooled memory not charged yet to the temp table limits. */
+    void accountPooledBytes();
+
+    /** Create the pools and the sets before the first execution. */
+    void initDistinctSets();
+
+    /**
+     * Empty the sets and give back the accounted memory. The slots are kept
+     * for the next execution unless they have grown past a modest size.
+     */
+    void releaseDistinctValues();
+
+    // the slots of the sets, which outlive an execution
+    boost::scoped_ptr<Pool> m_hashPool;
+    // the values and keys held by the sets, purged after each execution
+    boost::scoped_ptr<Pool> m_memoryPool;
+    boost::scoped_ptr<DistinctValueSetType> m_values;
+    boost::scoped_ptr<DistinctKeySetType> m_keys;
+    TupleSchema* m_keySchema;
+    PoolBackedTupleStorage m_nextKeyStorage;
+
+    TempTableLimits* m_tempLimits;
+    int64_t m_hashedBytes;
 };
 
 }
@@ -0,0 +1,336 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hashjoinexecutor.h"
+
+#include "common/debuglog.h"
+#include "common/tabletuple.h"
+#include "common/TupleSchema.h"
+#include "executors/aggregateexecutor.h"
+#include "execution/ProgressMonitorProxy.h"
+#include "expressions/abstractexpression.h"
+#include "plannodes/hashjoinnode.h"
+#include "plannodes/limitnode.h"
+#include "storage/table.h"
+#include "storage/temptable.h"
+#include "storage/tableiterator.h"
+#include "storage/TempTableLimits.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace voltdb;
+
+// Rough per-entry overhead of an unordered_multimap node and its bucket slot,
+// charged to the temp table limits on top of the pooled key and build row.
+static const int HASH_ENTRY_OVERHEAD =
+    static_cast<int>(sizeof(std::pair<TableTuple, void*>) + 3 * sizeof(void*));
+
+HashJoinExecutor::~HashJoinExecutor()
+{
+    // NULL safe operation
+    TupleSchema::freeTupleSchema(m_keySchema);
+}
+
+bool HashJoinExecutor::p_init(AbstractPlanNode* abstract_node,
+                              TempTableLimits* limits)
+{
+    VOLT_TRACE("init HashJoin Executor");
+
+    HashJoinPlanNode* node = dynamic_cast<HashJoinPlanNode*>(abstract_node);
+    assert(node);
+
+    // Create output table based on output schema from the plan
+    setTempOutputTable(limits);
+    assert(m_tmpOutputTable);
+    m_tempLimits = limits;
+
+    // NULL tuple for outer join
+    if (node->getJoinType() == JOIN_TYPE_LEFT) {
+        Table* inner_table = node->getInputTable(1);
+        assert(inner_table);
+        m_null_tuple.init(inner_table->schema());
+    }
+
+    // Both sides hash and compare their keys through one schema, so the
+    // column type of a key pair that differs is promoted the way a
+    // comparison between the two would be.
+    const std::vector<AbstractExpression*>& outerKeys = node->getOuterHashKeys();
+    const std::vector<AbstractExpression*>& innerKeys = node->getInnerHashKeys();
+    std::vector<ValueType> keyColumnTypes;
+    std::vector<int32_t> keyColumnSizes;
+    std::vector<bool> keyColumnAllowNull;
+    std::vector<bool> keyColumnInBytes;
+    for (int ii = 0; ii < outerKeys.size(); ii++) {
+        ValueType outerType = outerKeys[ii]->getValueType();
+        ValueType innerType = innerKeys[ii]->getValueType();
+        ValueType keyType = outerType;
+        if (outerType != innerType) {
+            keyType = NValue::promoteForOp(outerType, innerType);
+            if (keyType == VALUE_TYPE_INVALID) {
+                VOLT_ERROR("Hash join key %d has incompatible types %s and %s", ii,
+                           getTypeName(outerType).c_str(), getTypeName(innerType).c_str());
+                return false;
+            }
+        }
+        keyColumnTypes.push_back(keyType);
+        keyColumnSizes.push_back(std::max(outerKeys[ii]->getValueSize(), innerKeys[ii]->getValueSize()));
+        keyColumnAllowNull.push_back(true);
+        keyColumnInBytes.push_back(outerKeys[ii]->getInBytes() && innerKeys[ii]->getInBytes());
+    }
+    m_keySchema = TupleSchema::createTupleSchema(keyColumnTypes,
+                                                 keyColumnSizes,
+                                                 keyColumnAllowNull,
+                                                 keyColumnInBytes);
+    m_nextKeyStorage.init(m_keySchema, &m_memoryPool);
+    m_probeKeyStorage.init(m_keySchema);
+
+    // Inline aggregation can be serial, partial or hash
+    m_aggExec = voltdb::getInlineAggregateExecutor(m_abstractNode);
+
+    return true;
+}
+
+bool HashJoinExecutor::initKeyTuple(const TableTuple& keyTuple,
+                                    const std::vector<AbstractExpression*>& keys,
+                                    bool isOuter, const TableTuple& tuple) const
+{
+    for (int ii = 0; ii < keys.size(); ii++) {
+        NValue value = isOuter ? keys[ii]->eval(&tuple, NULL) : keys[ii]->eval(NULL, &tuple);
+        if (value.isNull()) {
+            return false;
+        }
+        keyTuple.setNValue(ii, value);
+    }
+    return true;
+}
+
+bool HashJoinExecutor::outputJoinedTuple(const TableTuple& outerTuple, const TableTuple& innerTuple)
+{
+    // Check if we have to skip this tuple because of offset
+    if (m_tupleSkipped < m_offset) {
+        m_tupleSkipped++;
+        return false;
+    }
+    ++m_tupleCtr;
+    m_joinTuple.setNValues(0, outerTuple, 0, m_outerCols);
+    m_joinTuple.setNValues(m_outerCols, innerTuple, 0, m_innerCols);
+    if (m_aggExec != NULL) {
+        if (m_aggExec->p_execute_tuple(m_joinTuple)) {
+            // Get enough rows for LIMIT
+            return true;
+        }
+    } else {
+        m_tmpOutputTable->insertTempTuple(m_joinTuple);
+    }
+    return m_limit != -1 && m_tupleCtr >= m_limit;
+}
+
+void HashJoinExecutor::accountHashedBytes(int bytes)
+{
+    // Count it first so that releaseHashTable gives back exactly what was charged
+    // even if this charge is the one that exceeds the limit and throws.
+    m_hashedBytes += bytes;
+    m_tempLimits->increaseAllocated(bytes);
+}
+
+void HashJoinExecutor::releaseHashTable()
+{
+    m_hash.clear();
+    m_buildRows.clear();
+    TableTuple& nextKeyTuple = m_nextKeyStorage;
+    nextKeyTuple.move(NULL);
+    m_memoryPool.purge();
+    if (m_hashedBytes > 0) {
+        m_tempLimits->reduceAllocated(static_cast<int>(m_hashedBytes));
+        m_hashedBytes = 0;
+    }
+}
+
+bool HashJoinExecutor::p_execute(const NValueArray &params) {
+    VOLT_DEBUG("executing HashJoin...");
+
+    HashJoinPlanNode* node = dynamic_cast<HashJoinPlanNode*>(m_abstractNode);
+    assert(node);
+    assert(node->getInputTableCount() == 2);
+
+    // output table must be a temp table
+    assert(m_tmpOutputTable);
+
+    Table* outer_table = node->getInputTable();
+    assert(outer_table);
+
+    Table* inner_table = node->getInputTable(1);
+    assert(inner_table);
+
+    VOLT_TRACE ("input table left:\n %s", outer_table->debug().c_str());
+    VOLT_TRACE ("input table right:\n %s", inner_table->debug().c_str());
+
+    AbstractExpression *preJoinPredicate = node->getPreJoinPredicate();
+    AbstractExpression *joinPredicate = node->getJoinPredicate();
+    AbstractExpression *wherePredicate = node->getWherePredicate();
+
+    // Join type
+    JoinType join_type = node->getJoinType();
+    assert(join_type == JOIN_TYPE_INNER || join_type == JOIN_TYPE_LEFT);
+
+    LimitPlanNode* limit_node = dynamic_cast<LimitPlanNode*>(node->getInlinePlanNode(PLAN_NODE_TYPE_LIMIT));
+    m_limit = -1;
+    m_offset = -1;
+    if (limit_node) {
+        limit_node->getLimitAndOffsetByReference(params, m_limit, m_offset);
+    }
+    m_tupleCtr = 0;
+    m_tupleSkipped = 0;
+
+    m_outerCols = outer_table->columnCount();
+    m_innerCols = inner_table->columnCount();
+    const TableTuple& null_tuple = m_null_tuple.tuple();
+
+    ProgressMonitorProxy pmp(m_engine, this, inner_table);
+    if (m_aggExec != NULL) {
+        VOLT_TRACE("Init inline aggregate...");
+        const TupleSchema * aggInputSchema = node->getTupleSchemaPreAgg();
+        m_joinTuple = m_aggExec->p_execute_init(params, &pmp, aggInputSchema, m_tmpOutputTable);
+    } else {
+        m_joinTuple = m_tmpOutputTable->tempTuple();
+    }
+
+    // Hash the smaller input. When that is the outer side of a left outer join,
+    // every outer tuple is remembered so the unmatched ones can be null-padded
+    // after the probe.
+    bool buildOuter = outer_table->activeTupleCount() < inner_table->activeTupleCount();
+    bool trackUnmatched = buildOuter && join_type == JOIN_TYPE_LEFT;
+    Table* build_table = buildOuter ? outer_table : inner_table;
+    Table* probe_table = buildOuter ? inner_table : outer_table;
+    const std::vector<AbstractExpression*>& buildKeys =
+        buildOuter ? node->getOuterHashKeys() : node->getInnerHashKeys();
+    const std::vector<AbstractExpression*>& probeKeys =
+        buildOuter ? node->getInnerHashKeys() : node->getOuterHashKeys();
+    const int keyTupleBytes = m_keySchema->tupleLength() + TUPLE_HEADER_SIZE;
+    bool done = (m_limit == 0);
+
+    try {
+        //
+        // Build
+        //
+        TableTuple build_tuple(build_table->schema());
+        TableIterator buildIterator = build_table->iterator();
+        while ( ! done && buildIterator.next(build_tuple)) {
+            pmp.countdownProgress();
+            BuildRow* row = NULL;
+            if (trackUnmatched) {
+                row = new (m_memoryPool) BuildRow(build_tuple);
+                m_buildRows.push_back(row);
+                accountHashedBytes(static_cast<int>(sizeof(BuildRow) + sizeof(BuildRow*)));
+            }
+            // An outer tuple that fails the pre-join predicate can't match any inner tuple.
+            if (buildOuter && preJoinPredicate != NULL &&
+                ! preJoinPredicate->eval(&build_tuple, NULL).isTrue()) {
+                continue;
+            }
+            TableTuple& nextKeyTuple = m_nextKeyStorage;
+            if (nextKeyTuple.isNullTuple()) {
+                m_nextKeyStorage.allocateActiveTuple();
+            }
+            if ( ! initKeyTuple(nextKeyTuple, buildKeys, buildOuter, build_tuple)) {
+                continue;
+            }
+            if (row == NULL) {
+                row = new (m_memoryPool) BuildRow(build_tuple);
+            }
+            m_hash.insert(HashJoinMapType::value_type(nextKeyTuple, row));
+            accountHashedBytes(keyTupleBytes + static_cast<int>(sizeof(BuildRow)) + HASH_ENTRY_OVERHEAD);
+            // The map is referencing the current key tuple,
+            // so force a new tuple allocation to hold the next key.
+            nextKeyTuple.move(NULL);
+        }
+        VOLT_TRACE("hashed %d tuples of the %s input", (int)m_hash.size(), buildOuter ? "outer" : "inner");
+
+        //
+        // Probe
+        //
+        const TableTuple& probeKeyTuple = m_probeKeyStorage.tuple();
+        TableTuple probe_tuple(probe_table->schema());
+        TableIterator probeIterator = probe_table->iterator();
+        while ( ! done && probeIterator.next(probe_tuple)) {
+            pmp.countdownProgress();
+            bool match = false;
+            if ((buildOuter || preJoinPredicate == NULL ||
+                 preJoinPredicate->eval(&probe_tuple, NULL).isTrue()) &&
+                initKeyTuple(probeKeyTuple, probeKeys, ! buildOuter, probe_tuple)) {
+                std::pair<HashJoinMapType::const_iterator, HashJoinMapType::const_iterator> range =
+                    m_hash.equal_range(probeKeyTuple);
+                for (HashJoinMapType::const_iterator iter = range.first; iter != range.second; ++iter) {
+                    BuildRow* row = iter->second;
+                    const TableTuple& outer_tuple = buildOuter ? row->m_tuple : probe_tuple;
+                    const TableTuple& inner_tuple = buildOuter ? probe_tuple : row->m_tuple;
+                    // Apply the residual join filter, then the where filter
+                    if (joinPredicate == NULL || joinPredicate->eval(&outer_tuple, &inner_tuple).isTrue()) {
+                        match = true;
+                        row->m_matched = true;
+                        if (wherePredicate == NULL || wherePredicate->eval(&outer_tuple, &inner_tuple).isTrue()) {
+                            if (outputJoinedTuple(outer_tuple, inner_tuple)) {
+                                done = true;
+                                break;
+                            }
+                            pmp.countdownProgress();
+                        }
+                    }
+                }
+            }
+
+            //
+            // Left Outer Join, probing with the outer table
+            //
+            if (join_type == JOIN_TYPE_LEFT && ! buildOuter && ! match && ! done) {
+                // Still needs to pass the filter
+                if (wherePredicate == NULL || wherePredicate->eval(&probe_tuple, &null_tuple).isTrue()) {
+                    done = outputJoinedTuple(probe_tuple, null_tuple);
+                }
+            }
+        }
+
+        //
+        // Left Outer Join, with the outer table hashed
+        //
+        for (int ii = 0; trackUnmatched && ! done && ii < m_buildRows.size(); ii++) {
+            BuildRow* row = m_buildRows[ii];
+            if (row->m_matched) {
+                continue;
+            }
+            // Still needs to pass the filter
+            if (wherePredicate == NULL || wherePredicate->eval(&row->m_tuple, &null_tuple).isTrue()) {
+                done = outputJoinedTuple(row->m_tuple, null_tuple);
+            }
+        }
+    } catch (...) {
+        releaseHashTable();
+        throw;
+    }
+
+    releaseHashTable();
+
+    if (m_aggExec != NULL) {
+        m_aggExec->p_execute_finish();
+    }
+
+    cleanupInputTempTable(inner_table);
+    cleanupInputTempTable(outer_table);
+
+    return (true);
+}
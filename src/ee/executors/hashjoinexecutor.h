@@ -0,0 +1,116 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HSTOREHASHJOINEXECUTOR_H
+#define HSTOREHASHJOINEXECUTOR_H
+
+#include "common/common.h"
+#include "common/Pool.hpp"
+#include "common/tabletuple.h"
+#include "common/valuevector.h"
+#include "executors/abstractexecutor.h"
+
+#include "boost/unordered_map.hpp"
+
+#include <vector>
+
+namespace voltdb {
+
+class AbstractExpression;
+class AggregateExecutorBase;
+class TempTableLimits;
+
+/**
+ * Equi-join that builds a hash table over the smaller of its two inputs and
+ * probes it with each tuple of the other, instead of rescanning the inner
+ * table for every outer tuple as NestLoopExecutor does.
+ * Supports inner and left outer joins, inline LIMIT/OFFSET and inline aggregation.
+ * The memory held by the hash table is charged to the fragment's TempTableLimits.
+ */
+class HashJoinExecutor : public AbstractExecutor {
+public:
+    HashJoinExecutor(VoltDBEngine *engine, AbstractPlanNode* abstract_node) :
+        AbstractExecutor(engine, abstract_node), m_keySchema(NULL), m_tempLimits(NULL),
+        m_hashedBytes(0), m_aggExec(NULL)
+    { }
+    ~HashJoinExecutor();
+
+protected:
+    bool p_init(AbstractPlanNode*, TempTableLimits* limits);
+    bool p_execute(const NValueArray &params);
+
+private:
+    /** A tuple of the build side input and whether it has joined with any probe tuple. */
+    struct BuildRow {
+        void* operator new(size_t size, Pool& memoryPool) { return memoryPool.allocate(size); }
+        void operator delete(void*, Pool& memoryPool) { /* NOOP -- on alloc error unroll nothing */ }
+        void operator delete(void*) { /* NOOP -- deallocate wholesale with pool */ }
+
+        BuildRow(const TableTuple& tuple) : m_tuple(tuple), m_matched(false) { }
+
+        TableTuple m_tuple;
+        bool m_matched;
+    };
+
+    typedef boost::unordered_multimap<TableTuple,
+                                      BuildRow*,
+                                      TableTupleHasher,
+                                      TableTupleEqualityChecker> HashJoinMapType;
+
+    /**
+     * Evaluate the given key expressions into the key tuple.
+     * Return false if any key value is NULL, since such a tuple can not satisfy the equi-join.
+     */
+    bool initKeyTuple(const TableTuple& keyTuple, const std::vector<AbstractExpression*>& keys,
+                      bool isOuter, const TableTuple& tuple) const;
+
+    /**
+     * Apply OFFSET, then add the joined tuple to the output table or inline aggregate.
+     * Return true when no more output is needed (LIMIT reached or aggregate returned early).
+     */
+    bool outputJoinedTuple(const TableTuple& outerTuple, const TableTuple& innerTuple);
+
+    /** Charge the memory of one more hashed tuple to the temp table limits. */
+    void accountHashedBytes(int bytes);
+
+    /** Drop the hash table and its pooled keys and give back the accounted memory. */
+    void releaseHashTable();
+
+    HashJoinMapType m_hash;
+    std::vector<BuildRow*> m_buildRows;
+    Pool m_memoryPool;
+    TupleSchema* m_keySchema;
+    PoolBackedTupleStorage m_nextKeyStorage;
+    StandAloneTupleStorage m_probeKeyStorage;
+    StandAloneTupleStorage m_null_tuple;
+
+    TempTableLimits* m_tempLimits;
+    int64_t m_hashedBytes;
+
+    AggregateExecutorBase* m_aggExec;
+    TableTuple m_joinTuple;
+    int m_outerCols;
+    int m_innerCols;
+    int m_limit;
+    int m_offset;
+    int m_tupleCtr;
+    int m_tupleSkipped;
+};
+
+}
+
+#endif
@@ -436,8 +436,8 @@ bool IndexScanExecutor::p_execute(const NValueArray &params)
                     if (m_aggExec->p_execute_tuple(temp_tuple)) {
                         break;
                     }
-                } else {
-                    m_outputTable->insertTupleNonVirtual(temp_tuple);
+                } else if (outputTuple(m_outputTable, temp_tuple)) {
+                    break;
                 }
             }
             else
@@ -448,9 +448,11 @@ bool IndexScanExecutor::p_execute(const NValueArray &params)
                     }
                 } else {
                     //
-                    // Straight Insert
+                    // Straight Insert, or push into our parent
                     //
-                    m_outputTable->insertTupleNonVirtual(tuple);
+                    if (outputTuple(m_outputTable, tuple)) {
+                        break;
+                    }
                 }
             }
             pmp.countdownProgress();
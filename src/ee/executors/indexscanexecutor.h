@@ -78,6 +78,10 @@ public:
     {}
     ~IndexScanExecutor();
 
+    bool canPushTuples() const {
+        return m_aggExec == NULL;
+    }
+
 private:
     bool p_init(AbstractPlanNode*,
                 TempTableLimits* limits);
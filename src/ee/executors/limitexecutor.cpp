@@ -88,8 +88,7 @@ LimitExecutor::p_execute(const NValueArray &params)
 {
     LimitPlanNode* node = dynamic_cast<LimitPlanNode*>(m_abstractNode);
     assert(node);
-    Table* output_table = node->getOutputTable();
-    assert(output_table);
+    assert(m_tmpOutputTable);
     Table* input_table = node->getInputTable();
     assert(input_table);
 
@@ -100,29 +99,11 @@ LimitExecutor::p_execute(const NValueArray &params)
     TableTuple tuple(input_table->schema());
     TableIterator iterator = input_table->iteratorDeletingAsWeGo();
 
-    int tuple_ctr = 0;
-    int tuples_skipped = 0;
-    int limit = -1;
-    int offset = -1;
-    node->getLimitAndOffsetByReference(params, limit, offset);
-
-    while ((limit == -1 || tuple_ctr < limit) && iterator.next(tuple))
+    p_push_init(params);
+    while ((m_limit == -1 || m_tupleCount < m_limit) && iterator.next(tuple))
     {
-        // TODO: need a way to skip / iterate N items.
-        if (tuples_skipped < offset)
-        {
-            tuples_skipped++;
-            continue;
-        }
-        tuple_ctr++;
-
-        if (!output_table->insertTuple(tuple))
-        {
-            VOLT_ERROR("Failed to insert tuple from input table '%s' into"
-                       " output table '%s'",
-                       input_table->name().c_str(),
-                       output_table->name().c_str());
-            return false;
+        if (p_push_tuple(tuple)) {
+            break;
         }
     }
 
@@ -130,3 +111,36 @@ LimitExecutor::p_execute(const NValueArray &params)
 
     return true;
 }
+
+void
+LimitExecutor::p_push_init(const NValueArray &params)
+{
+    LimitPlanNode* node = dynamic_cast<LimitPlanNode*>(m_abstractNode);
+    assert(node);
+    m_tupleCount = 0;
+    m_tuplesSkipped = 0;
+    m_limit = -1;
+    m_offset = -1;
+    node->getLimitAndOffsetByReference(params, m_limit, m_offset);
+}
+
+bool
+LimitExecutor::p_push_tuple(TableTuple &tuple)
+{
+    if (m_limit != -1 && m_tupleCount >= m_limit) {
+        return true;
+    }
+    // TODO: need a way to skip / iterate N items.
+    if (m_tuplesSkipped < m_offset)
+    {
+        m_tuplesSkipped++;
+        return false;
+    }
+    m_tupleCount++;
+
+    // Copy the tuple to our output table, or push it further up
+    if (outputTuple(m_tmpOutputTable, tuple)) {
+        return true;
+    }
+    return m_limit != -1 && m_tupleCount >= m_limit;
+}
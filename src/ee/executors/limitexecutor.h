@@ -58,16 +58,36 @@ namespace voltdb
     public:
         LimitExecutor(VoltDBEngine* engine, AbstractPlanNode* abstract_node)
             : AbstractExecutor(engine, abstract_node)
+            , m_limit(-1)
+            , m_offset(-1)
+            , m_tupleCount(0)
+            , m_tuplesSkipped(0)
         {
         }
 
         ~LimitExecutor() {
         }
 
+        bool canPushTuples() const {
+            return true;
+        }
+
+        bool canConsumePushedTuples() const {
+            return true;
+        }
+
     private:
         bool p_init(AbstractPlanNode*,
                     TempTableLimits* limits);
         bool p_execute(const NValueArray &params);
+
+        void p_push_init(const NValueArray &params);
+        bool p_push_tuple(TableTuple &tuple);
+
+        int m_limit;
+        int m_offset;
+        int m_tupleCount;
+        int m_tuplesSkipped;
     };
 
 }
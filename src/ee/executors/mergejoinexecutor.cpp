@@ -0,0 +1,445 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mergejoinexecutor.h"
+
+#include "common/debuglog.h"
+#include "common/SQLException.h"
+#include "execution/ProgressMonitorProxy.h"
+#include "execution/VoltDBEngine.h"
+#include "executors/aggregateexecutor.h"
+#include "expressions/abstractexpression.h"
+#include "expressions/tuplevalueexpression.h"
+#include "indexes/tableindex.h"
+#include "plannodes/indexscannode.h"
+#include "plannodes/limitnode.h"
+#include "plannodes/mergejoinnode.h"
+#include "storage/persistenttable.h"
+
+using namespace std;
+using namespace voltdb;
+
+namespace {
+
+/**
+ * One side of the merge: a forward index scan positioned by the scan node's
+ * search keys and filtered by its skip-null, end and post predicates.
+ * The scan node's expressions refer to a single table, which may be either
+ * tuple index, so they are always evaluated against the scanned tuple twice.
+ */
+class MergeJoinInput {
+public:
+    MergeJoinInput(IndexScanPlanNode* scanNode, const TableTuple& searchKey)
+        : m_scanNode(scanNode)
+        , m_index(static_cast<PersistentTable*>(scanNode->getTargetTable())->
+                  index(scanNode->getTargetIndexName()))
+        , m_cursor(m_index->getTupleSchema())
+        , m_searchKey(searchKey)
+        , m_lookupType(scanNode->getLookupType())
+        , m_activeNumOfSearchKeys(static_cast<int>(scanNode->getSearchKeyExpressions().size()))
+        , m_skipNullExpr(scanNode->getSkipNullPredicate())
+        , m_exhausted(false)
+    { }
+
+    /** Position the cursor on the first candidate entry. */
+    void open()
+    {
+        const vector<AbstractExpression*>& searchKeys = m_scanNode->getSearchKeyExpressions();
+        m_searchKey.setAllNulls();
+        for (int ctr = 0; ctr < m_activeNumOfSearchKeys; ctr++) {
+            NValue candidateValue = searchKeys[ctr]->eval(NULL, NULL);
+            try {
+                m_searchKey.setNValue(ctr, candidateValue);
+            }
+            catch (const SQLException &e) {
+                // re-throw if not an overflow or underflow
+                if ((e.getInternalFlags() & (SQLException::TYPE_OVERFLOW | SQLException::TYPE_UNDERFLOW)) == 0) {
+                    throw e;
+                }
+                // An out of range EQ key or GT/GTE bound above the column
+                // range matches nothing; a GT/GTE bound below the range
+                // scans everything under the preceding key columns.
+                if (m_lookupType != INDEX_LOOKUP_TYPE_EQ &&
+                    ctr == (m_activeNumOfSearchKeys - 1) &&
+                    (e.getInternalFlags() & SQLException::TYPE_UNDERFLOW)) {
+                    // don't allow GTE because it breaks null handling
+                    m_lookupType = INDEX_LOOKUP_TYPE_GT;
+                    m_activeNumOfSearchKeys--;
+                }
+                else {
+                    m_exhausted = true;
+                    return;
+                }
+                break;
+            }
+        }
+
+        if (m_activeNumOfSearchKeys == 0) {
+            m_index->moveToEnd(true, m_cursor);
+        }
+        else if (m_lookupType == INDEX_LOOKUP_TYPE_EQ) {
+            m_index->moveToKey(&m_searchKey, m_cursor);
+        }
+        else if (m_lookupType == INDEX_LOOKUP_TYPE_GT) {
+            m_index->moveToGreaterThanKey(&m_searchKey, m_cursor);
+        }
+        else {
+            assert(m_lookupType == INDEX_LOOKUP_TYPE_GTE);
+            m_index->moveToKeyOrGreater(&m_searchKey, m_cursor);
+        }
+    }
+
+    /** Return the next qualifying tuple, or a null tuple at the end of the scan. */
+    TableTuple next(ProgressMonitorProxy& pmp)
+    {
+        TableTuple tuple;
+        if (m_exhausted) {
+            return tuple;
+        }
+        AbstractExpression* endExpr = m_scanNode->getEndExpression();
+        AbstractExpression* postExpr = m_scanNode->getPredicate();
+        while (true) {
+            if (m_lookupType == INDEX_LOOKUP_TYPE_EQ && m_activeNumOfSearchKeys > 0) {
+                tuple = m_index->nextValueAtKey(m_cursor);
+            }
+            else {
+                tuple = m_index->nextValue(m_cursor);
+            }
+            if (tuple.isNullTuple()) {
+                break;
+            }
+            pmp.countdownProgress();
+            if (m_skipNullExpr != NULL) {
+                if (m_skipNullExpr->eval(&tuple, &tuple).isTrue()) {
+                    continue;
+                }
+                m_skipNullExpr = NULL;
+            }
+            if (endExpr != NULL && !endExpr->eval(&tuple, &tuple).isTrue()) {
+                tuple = TableTuple();
+                break;
+            }
+            if (postExpr == NULL || postExpr->eval(&tuple, &tuple).isTrue()) {
+                return tuple;
+            }
+        }
+        m_exhausted = true;
+        return tuple;
+    }
+
+    PersistentTable* table() const { return static_cast<PersistentTable*>(m_scanNode->getTargetTable()); }
+
+private:
+    IndexScanPlanNode* m_scanNode;
+    TableIndex* m_index;
+    IndexCursor m_cursor;
+    const TableTuple& m_searchKey;
+    IndexLookupType m_lookupType;
+    int m_activeNumOfSearchKeys;
+    AbstractExpression* m_skipNullExpr;
+    bool m_exhausted;
+};
+
+/**
+ * Evaluate the join keys of one side. Return false if any of them is NULL,
+ * since such a tuple can not satisfy the equi-join.
+ */
+bool evalJoinKeys(const vector<AbstractExpression*>& keys, bool isOuter,
+                  const TableTuple& tuple, vector<NValue>& values)
+{
+    for (int ii = 0; ii < keys.size(); ii++) {
+        values[ii] = isOuter ? keys[ii]->eval(&tuple, NULL) : keys[ii]->eval(NULL, &tuple);
+        if (values[ii].isNull()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int compareJoinKeys(const vector<NValue>& lhs, const vector<NValue>& rhs)
+{
+    for (int ii = 0; ii < lhs.size(); ii++) {
+        int cmp = lhs[ii].compare(rhs[ii]);
+        if (cmp != 0) {
+            return cmp;
+        }
+    }
+    return 0;
+}
+
+/**
+ * The merge only works if each side delivers its tuples ordered by its join
+ * keys, i.e. if the keys are plain references to the leading columns of the
+ * scanned index, in index column order.
+ */
+bool joinKeysLeadIndex(const vector<AbstractExpression*>& keys, int tupleIdx, const TableIndex* index)
+{
+    const vector<int>& indexColumns = index->getColumnIndices();
+    if (keys.empty() || keys.size() > indexColumns.size() ||
+        ! index->getIndexedExpressions().empty()) {
+        return false;
+    }
+    for (int ii = 0; ii < keys.size(); ii++) {
+        const TupleValueExpression* tve = dynamic_cast<const TupleValueExpression*>(keys[ii]);
+        if (tve == NULL || tve->getTupleId() != tupleIdx ||
+            tve->getColumnId() != indexColumns[ii]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool MergeJoinExecutor::initIndexScan(IndexScanPlanNode* scanNode, StandAloneTupleStorage& searchKey,
+                                      const vector<AbstractExpression*>& joinKeys, int tupleIdx)
+{
+    PersistentTable* table = dynamic_cast<PersistentTable*>(scanNode->getTargetTable());
+    if (table == NULL) {
+        VOLT_ERROR("Merge join input '%s' is not a persistent table",
+                   scanNode->getTargetTableName().c_str());
+        return false;
+    }
+
+    TableIndex* index = table->index(scanNode->getTargetIndexName());
+    if (index == NULL) {
+        VOLT_ERROR("Failed to retreive index '%s' from table '%s' for"
+                   " internal PlanNode '%s'",
+                   scanNode->getTargetIndexName().c_str(),
+                   table->name().c_str(), scanNode->debug().c_str());
+        return false;
+    }
+
+    // The merge consumes both inputs in ascending key order only.
+    IndexLookupType lookupType = scanNode->getLookupType();
+    if (scanNode->getSortDirection() == SORT_DIRECTION_TYPE_DESC ||
+        lookupType == INDEX_LOOKUP_TYPE_LT || lookupType == INDEX_LOOKUP_TYPE_LTE) {
+        VOLT_ERROR("Merge join requires an ascending scan of index '%s'",
+                   scanNode->getTargetIndexName().c_str());
+        return false;
+    }
+
+    if ( ! joinKeysLeadIndex(joinKeys, tupleIdx, index)) {
+        VOLT_ERROR("Merge join keys are not the leading columns of index '%s'",
+                   scanNode->getTargetIndexName().c_str());
+        return false;
+    }
+
+    searchKey.init(index->getKeySchema());
+    return true;
+}
+
+bool MergeJoinExecutor::p_init(AbstractPlanNode* abstractNode,
+                               TempTableLimits* limits)
+{
+    VOLT_TRACE("init MergeJoin Executor");
+    assert(limits);
+
+    MergeJoinPlanNode* node = dynamic_cast<MergeJoinPlanNode*>(abstractNode);
+    assert(node);
+    m_joinType = node->getJoinType();
+    if (m_joinType != JOIN_TYPE_INNER && m_joinType != JOIN_TYPE_LEFT) {
+        VOLT_ERROR("Merge join does not support join type %d", (int)m_joinType);
+        return false;
+    }
+
+    // Both scans resolved their target tables when the plan was loaded.
+    m_innerScanNode = node->getInnerIndexScan();
+    m_outerScanNode = node->getOuterIndexScan();
+    const vector<AbstractExpression*>& outerKeys = node->getOuterJoinKeys();
+    const vector<AbstractExpression*>& innerKeys = node->getInnerJoinKeys();
+    if (outerKeys.size() != innerKeys.size()) {
+        VOLT_ERROR("Merge join has %d outer and %d inner join keys",
+                   (int)outerKeys.size(), (int)innerKeys.size());
+        return false;
+    }
+    if ( ! initIndexScan(m_outerScanNode, m_outerSearchKey, outerKeys, 0) ||
+         ! initIndexScan(m_innerScanNode, m_innerSearchKey, innerKeys, 1)) {
+        return false;
+    }
+
+    // Create output table based on output schema from the plan
+    setTempOutputTable(limits);
+    assert(m_tmpOutputTable);
+
+    node->getOutputColumnExpressions(m_outputExpressions);
+
+    // NULL tuple for outer join
+    if (m_joinType == JOIN_TYPE_LEFT) {
+        m_null_tuple.init(m_innerScanNode->getTargetTable()->schema());
+    }
+
+    // Inline aggregation can be serial, partial or hash
+    m_aggExec = voltdb::getInlineAggregateExecutor(m_abstractNode);
+    return true;
+}
+
+bool MergeJoinExecutor::p_execute(const NValueArray &params)
+{
+    VOLT_DEBUG("executing MergeJoin...");
+
+    MergeJoinPlanNode* node = dynamic_cast<MergeJoinPlanNode*>(m_abstractNode);
+    assert(node);
+    assert(m_tmpOutputTable);
+
+    MergeJoinInput outerInput(m_outerScanNode, m_outerSearchKey.tuple());
+    MergeJoinInput innerInput(m_innerScanNode, m_innerSearchKey.tuple());
+    PersistentTable* inner_table = innerInput.table();
+
+    const vector<AbstractExpression*>& outerKeys = node->getOuterJoinKeys();
+    const vector<AbstractExpression*>& innerKeys = node->getInnerJoinKeys();
+    AbstractExpression* prejoin_expression = node->getPreJoinPredicate();
+    AbstractExpression* join_expression = node->getJoinPredicate();
+    AbstractExpression* where_expression = node->getWherePredicate();
+
+    LimitPlanNode* limit_node = dynamic_cast<LimitPlanNode*>(node->getInlinePlanNode(PLAN_NODE_TYPE_LIMIT));
+    int tuple_ctr = 0;
+    int tuple_skipped = 0;
+    int limit = -1;
+    int offset = -1;
+    if (limit_node) {
+        limit_node->getLimitAndOffsetByReference(params, limit, offset);
+    }
+
+    ProgressMonitorProxy pmp(m_engine, this, inner_table);
+    const TableTuple& null_tuple = m_null_tuple.tuple();
+
+    TableTuple join_tuple;
+    if (m_aggExec != NULL) {
+        VOLT_TRACE("Init inline aggregate...");
+        const TupleSchema * aggInputSchema = node->getTupleSchemaPreAgg();
+        join_tuple = m_aggExec->p_execute_init(params, &pmp, aggInputSchema, m_tmpOutputTable);
+    } else {
+        join_tuple = m_tmpOutputTable->tempTuple();
+    }
+    int num_of_cols = join_tuple.sizeInValues();
+
+    // The run holds the inner tuples whose key equals runKey.
+    vector<TableTuple> run;
+    bool haveRunKey = false;
+    vector<NValue> runKey(outerKeys.size());
+    vector<NValue> outerKey(outerKeys.size());
+    vector<NValue> innerKey(innerKeys.size());
+
+    bool earlyReturned = (limit == 0);
+    if ( ! earlyReturned) {
+        outerInput.open();
+        innerInput.open();
+    }
+    TableTuple inner_tuple = earlyReturned ? TableTuple() : innerInput.next(pmp);
+    TableTuple outer_tuple;
+    while ( ! earlyReturned && !(outer_tuple = outerInput.next(pmp)).isNullTuple()) {
+        // did this outer tuple find at least one match?
+        bool match = false;
+        if ((prejoin_expression == NULL || prejoin_expression->eval(&outer_tuple, NULL).isTrue()) &&
+            evalJoinKeys(outerKeys, true, outer_tuple, outerKey)) {
+
+            if ( ! haveRunKey || compareJoinKeys(outerKey, runKey) != 0) {
+                // The outer key moved forward: skip the smaller inner keys and
+                // buffer the run of inner tuples matching the new key.
+                run.clear();
+                runKey = outerKey;
+                haveRunKey = true;
+                while ( ! inner_tuple.isNullTuple()) {
+                    if (evalJoinKeys(innerKeys, false, inner_tuple, innerKey)) {
+                        int cmp = compareJoinKeys(innerKey, outerKey);
+                        if (cmp > 0) {
+                            break;
+                        }
+                        if (cmp == 0) {
+                            run.push_back(inner_tuple);
+                        }
+                    }
+                    inner_tuple = innerInput.next(pmp);
+                }
+            }
+
+            for (vector<TableTuple>::const_iterator it = run.begin(); it != run.end(); ++it) {
+                const TableTuple& run_tuple = *it;
+                if (join_expression != NULL && !join_expression->eval(&outer_tuple, &run_tuple).isTrue()) {
+                    continue;
+                }
+                match = true;
+                // Still need to pass where filtering
+                if (where_expression != NULL && !where_expression->eval(&outer_tuple, &run_tuple).isTrue()) {
+                    continue;
+                }
+                // Check if we have to skip this tuple because of offset
+                if (tuple_skipped < offset) {
+                    tuple_skipped++;
+                    continue;
+                }
+                ++tuple_ctr;
+                for (int col_ctr = 0; col_ctr < num_of_cols; ++col_ctr) {
+                    join_tuple.setNValue(col_ctr, m_outputExpressions[col_ctr]->eval(&outer_tuple, &run_tuple));
+                }
+                if (m_aggExec != NULL) {
+                    if (m_aggExec->p_execute_tuple(join_tuple)) {
+                        // Get enough rows for LIMIT
+                        earlyReturned = true;
+                        break;
+                    }
+                } else {
+                    m_tmpOutputTable->insertTempTuple(join_tuple);
+                    pmp.countdownProgress();
+                }
+                if (limit != -1 && tuple_ctr >= limit) {
+                    earlyReturned = true;
+                    break;
+                }
+            }
+        }
+
+        //
+        // Left Outer Join
+        //
+        if (m_joinType == JOIN_TYPE_LEFT && !match && !earlyReturned) {
+            if (where_expression == NULL || where_expression->eval(&outer_tuple, &null_tuple).isTrue()) {
+                // Check if we have to skip this tuple because of offset
+                if (tuple_skipped < offset) {
+                    tuple_skipped++;
+                    continue;
+                }
+                ++tuple_ctr;
+                for (int col_ctr = 0; col_ctr < num_of_cols; ++col_ctr) {
+                    join_tuple.setNValue(col_ctr, m_outputExpressions[col_ctr]->eval(&outer_tuple, &null_tuple));
+                }
+                if (m_aggExec != NULL) {
+                    if (m_aggExec->p_execute_tuple(join_tuple)) {
+                        earlyReturned = true;
+                    }
+                } else {
+                    m_tmpOutputTable->insertTempTuple(join_tuple);
+                    pmp.countdownProgress();
+                }
+                if (limit != -1 && tuple_ctr >= limit) {
+                    earlyReturned = true;
+                }
+            }
+        }
+    }
+
+    if (m_aggExec != NULL) {
+        m_aggExec->p_execute_finish();
+    }
+
+    VOLT_TRACE("result table:\n %s", m_tmpOutputTable->debug().c_str());
+    VOLT_TRACE("Finished MergeJoin");
+    return true;
+}
+
+MergeJoinExecutor::~MergeJoinExecutor() { }
@@ -0,0 +1,75 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HSTOREMERGEJOINEXECUTOR_H
+#define HSTOREMERGEJOINEXECUTOR_H
+
+#include "common/common.h"
+#include "common/tabletuple.h"
+#include "common/valuevector.h"
+#include "executors/abstractexecutor.h"
+
+#include <vector>
+
+namespace voltdb {
+
+class AggregateExecutorBase;
+class IndexScanPlanNode;
+
+/**
+ * Merge join of two index scans whose tree indexes deliver the join keys
+ * in ascending order. Both cursors advance in lockstep; the run of inner
+ * tuples sharing the current key is buffered so that consecutive outer
+ * tuples with a duplicate key join against it without re-probing the index.
+ * Unlike NestLoopIndexExecutor there is one index descent per side rather
+ * than one per outer tuple.
+ */
+class MergeJoinExecutor : public AbstractExecutor
+{
+public:
+    MergeJoinExecutor(VoltDBEngine *engine, AbstractPlanNode* abstract_node)
+        : AbstractExecutor(engine, abstract_node)
+        , m_outerScanNode(NULL)
+        , m_innerScanNode(NULL)
+        , m_joinType(JOIN_TYPE_INVALID)
+        , m_aggExec(NULL)
+    { }
+
+    ~MergeJoinExecutor();
+
+protected:
+    bool p_init(AbstractPlanNode*,
+                TempTableLimits* limits);
+    bool p_execute(const NValueArray &params);
+
+private:
+    bool initIndexScan(IndexScanPlanNode* scanNode, StandAloneTupleStorage& searchKey,
+                       const std::vector<AbstractExpression*>& joinKeys, int tupleIdx);
+
+    IndexScanPlanNode* m_outerScanNode;
+    IndexScanPlanNode* m_innerScanNode;
+    JoinType m_joinType;
+    std::vector<AbstractExpression*> m_outputExpressions;
+    StandAloneTupleStorage m_null_tuple;
+    StandAloneTupleStorage m_outerSearchKey;
+    StandAloneTupleStorage m_innerSearchKey;
+    AggregateExecutorBase* m_aggExec;
+};
+
+}
+
+#endif
@@ -213,7 +213,11 @@ bool NestLoopExecutor::p_execute(const NValueArray &params) {
                                 break;
                             }
                         } else {
-                            m_tmpOutputTable->insertTempTuple(join_tuple);
+                            if (outputTuple(m_tmpOutputTable, join_tuple)) {
+                                // Our parent has enough rows
+                                earlyReturned = true;
+                                break;
+                            }
                             pmp.countdownProgress();
                         }
                     }
@@ -239,7 +243,9 @@ bool NestLoopExecutor::p_execute(const NValueArray &params) {
                         earlyReturned = true;
                     }
                 } else {
-                    m_tmpOutputTable->insertTempTuple(join_tuple);
+                    if (outputTuple(m_tmpOutputTable, join_tuple)) {
+                        earlyReturned = true;
+                    }
                     pmp.countdownProgress();
                 }
             }
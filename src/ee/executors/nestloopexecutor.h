@@ -63,6 +63,10 @@ class NestLoopExecutor : public AbstractExecutor {
     public:
         NestLoopExecutor(VoltDBEngine *engine, AbstractPlanNode* abstract_node) :
             AbstractExecutor(engine, abstract_node) { }
+
+        bool canPushTuples() const {
+            return m_aggExec == NULL;
+        }
     protected:
         bool p_init(AbstractPlanNode*,
                     TempTableLimits* limits);
@@ -494,7 +494,11 @@ bool NestLoopIndexExecutor::p_execute(const NValueArray &params)
                                     break;
                                 }
                             } else {
-                                m_tmpOutputTable->insertTempTuple(join_tuple);
+                                if (outputTuple(m_tmpOutputTable, join_tuple)) {
+                                    // Our parent has enough rows
+                                    earlyReturned = true;
+                                    break;
+                                }
                                 pmp.countdownProgress();
                             }
 
@@ -530,7 +534,10 @@ bool NestLoopIndexExecutor::p_execute(const NValueArray &params)
                         break;
                     }
                 } else {
-                    m_tmpOutputTable->insertTempTuple(join_tuple);
+                    if (outputTuple(m_tmpOutputTable, join_tuple)) {
+                        earlyReturned = true;
+                        break;
+                    }
                     pmp.countdownProgress();
                 }
             }
@@ -82,6 +82,10 @@ public:
 
     ~NestLoopIndexExecutor();
 
+    bool canPushTuples() const {
+        return m_aggExec == NULL;
+    }
+
 protected:
     bool p_init(AbstractPlanNode*,
                 TempTableLimits* limits);
@@ -44,23 +44,93 @@
  */
 
 #include <algorithm>
+#include <queue>
 #include <vector>
 #include "orderbyexecutor.h"
 #include "common/debuglog.h"
 #include "common/common.h"
 #include "common/tabletuple.h"
 #include "common/FatalException.hpp"
+#include "common/executorcontext.hpp"
 #include "execution/ProgressMonitorProxy.h"
+#include "expressions/tuplevalueexpression.h"
+#include "indexes/tableindex.h"
+#include "plannodes/indexscannode.h"
 #include "plannodes/orderbynode.h"
 #include "plannodes/limitnode.h"
+#include "plannodes/projectionnode.h"
 #include "storage/table.h"
 #include "storage/temptable.h"
 #include "storage/tableiterator.h"
 #include "storage/tablefactory.h"
+#include "storage/TempTableLimits.h"
 
 using namespace voltdb;
 using namespace std;
 
+/**
+ * Does the input arrive already sorted? It does from an index scan that
+ * walks a simple column index in the direction of every sort key, when the
+ * sort keys are leading columns of the index, in order.
+ */
+static bool isSortedByIndexScan(OrderByPlanNode* node)
+{
+    IndexScanPlanNode* scan = dynamic_cast<IndexScanPlanNode*>(node->getChildren()[0]);
+    if (scan == NULL || scan->getSortDirection() == SORT_DIRECTION_TYPE_INVALID) {
+        return false;
+    }
+    if (scan->getInlinePlanNode(PLAN_NODE_TYPE_AGGREGATE) != NULL ||
+        scan->getInlinePlanNode(PLAN_NODE_TYPE_HASHAGGREGATE) != NULL ||
+        scan->getInlinePlanNode(PLAN_NODE_TYPE_PARTIALAGGREGATE) != NULL) {
+        return false;
+    }
+
+    // Only the less-than lookups walk the index backwards.
+    const bool descending = (scan->getSortDirection() == SORT_DIRECTION_TYPE_DESC);
+    if ( ! scan->getSearchKeyExpressions().empty()) {
+        const IndexLookupType lookupType = scan->getLookupType();
+        const bool backwards = (lookupType == INDEX_LOOKUP_TYPE_LT || lookupType == INDEX_LOOKUP_TYPE_LTE);
+        if (backwards != descending) {
+            return false;
+        }
+    }
+
+    Table* targetTable = scan->getTargetTable();
+    TableIndex* index = (targetTable == NULL) ? NULL : targetTable->index(scan->getTargetIndexName());
+    if (index == NULL || ! index->getIndexedExpressions().empty()) {
+        return false;
+    }
+    const vector<int>& indexColumns = index->getColumnIndices();
+    const vector<AbstractExpression*>& keys = node->getSortExpressions();
+    const vector<SortDirectionType>& dirs = node->getSortDirections();
+    if (keys.size() > indexColumns.size()) {
+        return false;
+    }
+
+    ProjectionPlanNode* projection =
+        dynamic_cast<ProjectionPlanNode*>(scan->getInlinePlanNode(PLAN_NODE_TYPE_PROJECTION));
+    for (size_t ii = 0; ii < keys.size(); ii++) {
+        TupleValueExpression* key = dynamic_cast<TupleValueExpression*>(keys[ii]);
+        if (key == NULL || dirs[ii] != scan->getSortDirection()) {
+            return false;
+        }
+        int column = key->getColumnId();
+        if (projection != NULL) {
+            // Follow the key back through the scan's projection to the table
+            TupleValueExpression* source =
+                dynamic_cast<TupleValueExpression*>(projection->getOutputColumnExpressions()[column]);
+            if (source == NULL) {
+                return false;
+            }
+            column = source->getColumnId();
+        }
+        if (column != indexColumns[ii]) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool
 OrderByExecutor::p_init(AbstractPlanNode* abstract_node,
                         TempTableLimits* limits)
@@ -83,11 +153,20 @@ OrderByExecutor::p_init(AbstractPlanNode* abstract_node,
                                           node->getInputTable(),
                                           limits));
 
+    // An input that may grow past the memory limit is spilled and sorted
+    // externally; it is only ever read here through an iterator.
+    m_limits = limits;
+    allowInputTempTableSpill(node->getInputTable());
+
     // pickup an inlined limit, if one exists
     limit_node =
         dynamic_cast<LimitPlanNode*>(node->
                                      getInlinePlanNode(PLAN_NODE_TYPE_LIMIT));
 
+    // With a limit, an input in sort order need only be read until the
+    // top-N heap fills.
+    m_inputOrdered = (limit_node != NULL) && isSortedByIndexScan(node);
+
     return true;
 }
 
@@ -134,33 +213,155 @@ private:
     size_t m_keyCount;
 };
 
-bool
-OrderByExecutor::p_execute(const NValueArray &params)
+/** Orders merge candidates so that the smallest tuple is on top of the heap. */
+class MergeEntryComparer
 {
-    OrderByPlanNode* node = dynamic_cast<OrderByPlanNode*>(m_abstractNode);
-    assert(node);
-    TempTable* output_table = dynamic_cast<TempTable*>(node->getOutputTable());
-    assert(output_table);
-    Table* input_table = node->getInputTable();
-    assert(input_table);
+public:
+    MergeEntryComparer(const TupleComparer& comparer) : m_comparer(comparer) { }
 
-    //
-    // OPTIMIZATION: NESTED LIMIT
-    // How nice! We can also cut off our scanning with a nested limit!
-    //
-    int limit = -1;
-    int offset = -1;
-    if (limit_node != NULL)
+    bool operator()(const pair<TableTuple, size_t>& a, const pair<TableTuple, size_t>& b)
     {
-        limit_node->getLimitAndOffsetByReference(params, limit, offset);
+        return m_comparer(b.first, a.first);
+    }
+
+private:
+    TupleComparer m_comparer;
+};
+
+// Each sorted run may take up this fraction of the temp table memory limit
+// while it is being sorted.
+static const int64_t SORT_RUN_MEMORY_DIVISOR = 4;
+
+// Chunk size of the storage for the slots of the top-N heap
+static const size_t TOP_N_POOL_CHUNK_SIZE = 64 * 1024;
+
+static int64_t sortRunTupleCount(const TempTableLimits* limits, const Table* input_table)
+{
+    int64_t tupleSize = input_table->schema()->tupleLength() + TUPLE_HEADER_SIZE;
+    return max(static_cast<int64_t>(1), limits->getMemoryLimit() / SORT_RUN_MEMORY_DIVISOR / tupleSize);
+}
+
+static void dropScratchTables(TempTable* runBuffer, vector<TempTable*>& runs)
+{
+    runBuffer->freeAllBlocks();
+    delete runBuffer;
+    for (size_t ii = 0; ii < runs.size(); ii++) {
+        runs[ii]->freeAllBlocks();
+        delete runs[ii];
+    }
+    runs.clear();
+}
+
+void
+OrderByExecutor::writeSortedRun(OrderByPlanNode* node, TempTable* runBuffer,
+                                vector<TempTable*>& runs, ProgressMonitorProxy& pmp)
+{
+    if (runBuffer->isTempTableEmpty()) {
+        return;
+    }
+    vector<TableTuple> xs;
+    xs.reserve(static_cast<size_t>(runBuffer->tempTableTupleCount()));
+    TableTuple tuple(runBuffer->schema());
+    TableIterator iterator = runBuffer->iterator();
+    while (iterator.next(tuple)) {
+        xs.push_back(tuple);
+    }
+    sort(xs.begin(), xs.end(),
+         TupleComparer(node->getSortExpressions(), node->getSortDirections()));
+
+    TempTable* run = TableFactory::getCopiedTempTable(node->databaseId(), runBuffer->name(),
+                                                      runBuffer, m_limits);
+    runs.push_back(run);
+    run->enableSpill();
+    for (vector<TableTuple>::iterator it = xs.begin(); it != xs.end(); it++) {
+        run->insertTempTuple(*it);
+        pmp.countdownProgress();
+    }
+    // Keep nothing of the finished run in memory until the merge reads it.
+    run->spillResidentBlocks();
+    runBuffer->deleteAllTuplesNonVirtual(false);
+}
+
+void
+OrderByExecutor::externalSort(OrderByPlanNode* node, Table* input_table, TempTable* output_table,
+                              int limit, int offset, ProgressMonitorProxy& pmp)
+{
+    VOLT_DEBUG("External sort of %d tuples", (int)input_table->activeTupleCount());
+    const int64_t runTupleCount = sortRunTupleCount(m_limits, input_table);
+    TempTable* runBuffer = TableFactory::getCopiedTempTable(node->databaseId(), input_table->name(),
+                                                            input_table, m_limits);
+    vector<TempTable*> runs;
+    try {
+        // Copy the input into bounded sorted runs, releasing it as we go.
+        TableIterator iterator = input_table->iteratorDeletingAsWeGo();
+        TableTuple tuple(input_table->schema());
+        while (iterator.next(tuple)) {
+            pmp.countdownProgress();
+            runBuffer->insertTempTuple(tuple);
+            if (runBuffer->tempTableTupleCount() >= runTupleCount) {
+                writeSortedRun(node, runBuffer, runs, pmp);
+            }
+        }
+        writeSortedRun(node, runBuffer, runs, pmp);
+
+        // Merge the runs, each of which keeps only the block under its cursor in memory.
+        TupleComparer comparer(node->getSortExpressions(), node->getSortDirections());
+        priority_queue<pair<TableTuple, size_t>, vector<pair<TableTuple, size_t> >,
+                       MergeEntryComparer> heap(comparer);
+        vector<TableIterator*> iterators;
+        for (size_t ii = 0; ii < runs.size(); ii++) {
+            iterators.push_back(&runs[ii]->iterator());
+            TableTuple head(runs[ii]->schema());
+            if (iterators[ii]->next(head)) {
+                heap.push(make_pair(head, ii));
+            }
+        }
+
+        int tuple_ctr = 0;
+        int tuple_skipped = 0;
+        while ( ! heap.empty()) {
+            pair<TableTuple, size_t> top = heap.top();
+            heap.pop();
+            if (tuple_skipped < offset) {
+                tuple_skipped++;
+            }
+            else {
+                output_table->insertTupleNonVirtual(top.first);
+                pmp.countdownProgress();
+                if (limit >= 0 && ++tuple_ctr >= limit) {
+                    break;
+                }
+            }
+            if (iterators[top.second]->next(top.first)) {
+                heap.push(top);
+            }
+        }
+    }
+    catch (...) {
+        dropScratchTables(runBuffer, runs);
+        throw;
+    }
+    dropScratchTables(runBuffer, runs);
+}
+
+void
+OrderByExecutor::sortInput(OrderByPlanNode* node, Table* input_table, TempTable* output_table,
+                           ProgressMonitorProxy& pmp)
+{
+    int limit = m_limit;
+    int offset = m_offset;
+
+    TempTable* temp_input = dynamic_cast<TempTable*>(input_table);
+    if (temp_input != NULL && m_limits->spillEnabled() &&
+        (temp_input->hasSpilledBlocks() ||
+         temp_input->tempTableTupleCount() > sortRunTupleCount(m_limits, input_table))) {
+        externalSort(node, input_table, output_table, limit, offset, pmp);
+        return;
     }
 
-    VOLT_TRACE("Running OrderBy '%s'", m_abstractNode->debug().c_str());
-    VOLT_TRACE("Input Table:\n '%s'", input_table->debug().c_str());
     TableIterator iterator = input_table->iterator();
     TableTuple tuple(input_table->schema());
     vector<TableTuple> xs;
-    ProgressMonitorProxy pmp(m_engine, this);
     while (iterator.next(tuple))
     {
         pmp.countdownProgress();
@@ -171,9 +372,9 @@ OrderByExecutor::p_execute(const NValueArray &params)
                input_table->debug().c_str());
 
 
-    if (limit >= 0 && xs.begin() + limit + offset < xs.end()) {
+    if (limit >= 0 && static_cast<size_t>(limit) + max(offset, 0) < xs.size()) {
         // partial sort
-        partial_sort(xs.begin(), xs.begin() + limit + offset, xs.end(),
+        partial_sort(xs.begin(), xs.begin() + limit + max(offset, 0), xs.end(),
                 TupleComparer(node->getSortExpressions(), node->getSortDirections()));
     } else {
         // full sort
@@ -204,12 +405,167 @@ OrderByExecutor::p_execute(const NValueArray &params)
             break;
         }
     }
-    VOLT_TRACE("Result of OrderBy:\n '%s'", output_table->debug().c_str());
+}
 
-    cleanupInputTempTable(input_table);
+bool
+OrderByExecutor::offerTopN(OrderByPlanNode* node, const TableTuple& tuple)
+{
+    if (m_heapCapacity == 0) {
+        return true;
+    }
+    TupleComparer comparer(node->getSortExpressions(), node->getSortDirections());
+    if (m_heap.size() < m_heapCapacity) {
+        const TupleSchema* schema = node->getInputTable()->schema();
+        TableTuple slot(schema);
+        slot.move(m_heapPool->allocate(schema->tupleLength() + TUPLE_HEADER_SIZE));
+        slot.copyForPersistentInsert(tuple);
+        m_heap.push_back(slot);
+        push_heap(m_heap.begin(), m_heap.end(), comparer);
+        // Nothing after the tuple that fills the heap can get into it when
+        // the input is sorted already.
+        return m_inputOrdered && m_heap.size() == m_heapCapacity;
+    }
+    if ( ! comparer(tuple, m_heap.front())) {
+        return m_inputOrdered;
+    }
+    // Evict the last of the tuples kept and reuse its slot
+    pop_heap(m_heap.begin(), m_heap.end(), comparer);
+    TableTuple& slot = m_heap.back();
+    slot.freeObjectColumns();
+    slot.copyForPersistentInsert(tuple);
+    push_heap(m_heap.begin(), m_heap.end(), comparer);
+    return false;
+}
+
+void
+OrderByExecutor::emitTopN(OrderByPlanNode* node, TempTable* output_table, ProgressMonitorProxy& pmp)
+{
+    sort_heap(m_heap.begin(), m_heap.end(),
+              TupleComparer(node->getSortExpressions(), node->getSortDirections()));
+    // The output table only refers to the strings of the tuples it takes,
+    // so they are copied to the temp string pool before the heap's own
+    // copies are freed.
+    TableTuple& temp_tuple = output_table->tempTuple();
+    for (size_t ii = max(m_offset, 0); ii < m_heap.size(); ii++) {
+        temp_tuple.copyForPersistentInsert(m_heap[ii], ExecutorContext::getTempStringPool());
+        output_table->insertTempTuple(temp_tuple);
+        pmp.countdownProgress();
+    }
+    releaseTopN();
+}
+
+void
+OrderByExecutor::releaseTopN()
+{
+    for (vector<TableTuple>::iterator it = m_heap.begin(); it != m_heap.end(); it++) {
+        it->freeObjectColumns();
+    }
+    m_heap.clear();
+    if (m_heapPool != NULL) {
+        m_heapPool->purge();
+    }
+}
+
+bool
+OrderByExecutor::p_execute(const NValueArray &params)
+{
+    OrderByPlanNode* node = dynamic_cast<OrderByPlanNode*>(m_abstractNode);
+    assert(node);
+    Table* input_table = node->getInputTable();
+    assert(input_table);
+
+    VOLT_TRACE("Running OrderBy '%s'", m_abstractNode->debug().c_str());
+    VOLT_TRACE("Input Table:\n '%s'", input_table->debug().c_str());
+
+    p_push_init(params);
+    if (m_topN) {
+        ProgressMonitorProxy pmp(m_engine, this);
+        TableIterator iterator = input_table->iterator();
+        TableTuple tuple(input_table->schema());
+        while (iterator.next(tuple)) {
+            pmp.countdownProgress();
+            assert(tuple.isActive());
+            if (offerTopN(node, tuple)) {
+                break;
+            }
+        }
+    }
+    p_push_finish();
 
     return true;
 }
 
+void
+OrderByExecutor::p_push_init(const NValueArray &params)
+{
+    OrderByPlanNode* node = dynamic_cast<OrderByPlanNode*>(m_abstractNode);
+    assert(node);
+
+    // Drop whatever an execution that failed part way left in the heap
+    releaseTopN();
+
+    //
+    // OPTIMIZATION: NESTED LIMIT
+    // How nice! We can also cut off our scanning with a nested limit!
+    //
+    m_limit = -1;
+    m_offset = -1;
+    if (limit_node != NULL)
+    {
+        limit_node->getLimitAndOffsetByReference(params, m_limit, m_offset);
+    }
+
+    // Keep the top limit + offset tuples in a heap instead of sorting the
+    // whole input, unless that would take more memory than a sorted run of
+    // the external sort.
+    m_topN = false;
+    if (m_limit >= 0) {
+        const int64_t capacity = static_cast<int64_t>(m_limit) + max(m_offset, 0);
+        if (capacity <= sortRunTupleCount(m_limits, node->getInputTable())) {
+            m_topN = true;
+            m_heapCapacity = static_cast<size_t>(capacity);
+            if (m_heapPool == NULL) {
+                m_heapPool.reset(new Pool(TOP_N_POOL_CHUNK_SIZE, 1));
+            }
+        }
+    }
+}
+
+bool
+OrderByExecutor::p_push_tuple(TableTuple &tuple)
+{
+    OrderByPlanNode* node = static_cast<OrderByPlanNode*>(m_abstractNode);
+    if (m_topN) {
+        return offerTopN(node, tuple);
+    }
+    // The limit is too large for a heap: gather the input to sort as usual
+    TempTable* input_table = static_cast<TempTable*>(node->getInputTable());
+    assert(input_table == dynamic_cast<TempTable*>(node->getInputTable()));
+    input_table->insertTempTuple(tuple);
+    return false;
+}
+
+void
+OrderByExecutor::p_push_finish()
+{
+    OrderByPlanNode* node = dynamic_cast<OrderByPlanNode*>(m_abstractNode);
+    assert(node);
+    TempTable* output_table = dynamic_cast<TempTable*>(node->getOutputTable());
+    assert(output_table);
+    Table* input_table = node->getInputTable();
+    assert(input_table);
+
+    ProgressMonitorProxy pmp(m_engine, this);
+    if (m_topN) {
+        emitTopN(node, output_table, pmp);
+    } else {
+        sortInput(node, input_table, output_table, pmp);
+    }
+    VOLT_TRACE("Result of OrderBy:\n '%s'", output_table->debug().c_str());
+
+    cleanupInputTempTable(input_table);
+}
+
 OrderByExecutor::~OrderByExecutor() {
+    releaseTopN();
 }
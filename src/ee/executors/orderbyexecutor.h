@@ -47,14 +47,22 @@
 #define HSTOREORDERBYEXECUTOR_H
 
 #include "common/common.h"
+#include "common/Pool.hpp"
 #include "common/valuevector.h"
 #include "executors/abstractexecutor.h"
 
+#include <boost/scoped_ptr.hpp>
+#include <vector>
+
 namespace voltdb {
 
     class UndoLog;
     class ReadWriteSet;
     class LimitPlanNode;
+    class OrderByPlanNode;
+    class ProgressMonitorProxy;
+    class TempTable;
+    class TempTableLimits;
 
     /**
      *
@@ -62,17 +70,70 @@ namespace voltdb {
     class OrderByExecutor : public AbstractExecutor {
     public:
         OrderByExecutor(VoltDBEngine *engine, AbstractPlanNode* abstract_node)
-            : AbstractExecutor(engine, abstract_node), limit_node(NULL)
+            : AbstractExecutor(engine, abstract_node), limit_node(NULL), m_limits(NULL),
+              m_inputOrdered(false), m_limit(-1), m_offset(-1), m_topN(false), m_heapCapacity(0)
             { }
         ~OrderByExecutor();
 
+        /** With an inlined limit the input can be sorted as it streams in */
+        bool canConsumePushedTuples() const {
+            return limit_node != NULL;
+        }
+
     protected:
         bool p_init(AbstractPlanNode* abstract_node,
                     TempTableLimits* limits);
         bool p_execute(const NValueArray &params);
 
+        void p_push_init(const NValueArray &params);
+        bool p_push_tuple(TableTuple &tuple);
+        void p_push_finish();
+
     private:
+        /**
+         * Sort the materialized input table and copy the tuples within the
+         * limit and offset to the output table.
+         */
+        void sortInput(OrderByPlanNode* node, Table* input_table, TempTable* output_table,
+                       ProgressMonitorProxy& pmp);
+
+        /**
+         * TOP-N
+         *
+         * With a limit, only the first limit + offset tuples in sort order
+         * are kept, in a bounded heap whose top is the last of them. A
+         * tuple is deep copied into one of the heap's slots only when it
+         * enters the heap.
+         */
+        bool offerTopN(OrderByPlanNode* node, const TableTuple& tuple);
+        void emitTopN(OrderByPlanNode* node, TempTable* output_table, ProgressMonitorProxy& pmp);
+        void releaseTopN();
+
+        /**
+         * Sort an input too large to sort in place: sorted runs of bounded
+         * size are written to spillable temp tables and then merged.
+         */
+        void externalSort(OrderByPlanNode* node, Table* input_table, TempTable* output_table,
+                          int limit, int offset, ProgressMonitorProxy& pmp);
+        void writeSortedRun(OrderByPlanNode* node, TempTable* runBuffer,
+                            std::vector<TempTable*>& runs, ProgressMonitorProxy& pmp);
+
         LimitPlanNode *limit_node;
+        TempTableLimits* m_limits;
+
+        // whether the input arrives in sort order, from an index scan
+        bool m_inputOrdered;
+
+        // limit and offset of the current execution
+        int m_limit;
+        int m_offset;
+
+        // whether the current execution keeps a top-N heap
+        bool m_topN;
+        size_t m_heapCapacity;
+        std::vector<TableTuple> m_heap;
+        // storage for the heap's slots, reused as tuples are evicted
+        boost::scoped_ptr<Pool> m_heapPool;
     };
 
 }
@@ -102,6 +102,26 @@ bool ProjectionExecutor::p_init(AbstractPlanNode *abstractNode,
     return true;
 }
 
+inline TableTuple &ProjectionExecutor::project(const NValueArray &params, const TableTuple &input_tuple) {
+    TableTuple &temp_tuple = output_table->tempTuple();
+    if (all_tuple_array != NULL) {
+        VOLT_TRACE("sweet, all tuples");
+        for (int ctr = m_columnCount - 1; ctr >= 0; --ctr) {
+            temp_tuple.setNValue(ctr, input_tuple.getNValue(all_tuple_array[ctr]));
+        }
+    } else if (all_param_array != NULL) {
+        VOLT_TRACE("sweet, all params");
+        for (int ctr = m_columnCount - 1; ctr >= 0; --ctr) {
+            temp_tuple.setNValue(ctr, params[all_param_array[ctr]]);
+        }
+    } else {
+        for (int ctr = m_columnCount - 1; ctr >= 0; --ctr) {
+            temp_tuple.setNValue(ctr, expression_array[ctr]->eval(&input_tuple, NULL));
+        }
+    }
+    return temp_tuple;
+}
+
 bool ProjectionExecutor::p_execute(const NValueArray &params) {
 #ifndef NDEBUG
     ProjectionPlanNode* node = dynamic_cast<ProjectionPlanNode*>(m_abstractNode);
@@ -138,26 +158,9 @@ bool ProjectionExecutor::p_execute(const NValueArray &params) {
     TableIterator iterator = input_table->iteratorDeletingAsWeGo();
     assert (tuple.sizeInValues() == input_table->columnCount());
     while (iterator.next(tuple)) {
-        //
-        // Project (or replace) values from input tuple
-        //
-        TableTuple &temp_tuple = output_table->tempTuple();
-        if (all_tuple_array != NULL) {
-            VOLT_TRACE("sweet, all tuples");
-            for (int ctr = m_columnCount - 1; ctr >= 0; --ctr) {
-                temp_tuple.setNValue(ctr, tuple.getNValue(all_tuple_array[ctr]));
-            }
-        } else if (all_param_array != NULL) {
-            VOLT_TRACE("sweet, all params");
-            for (int ctr = m_columnCount - 1; ctr >= 0; --ctr) {
-                temp_tuple.setNValue(ctr, params[all_param_array[ctr]]);
-            }
-        } else {
-            for (int ctr = m_columnCount - 1; ctr >= 0; --ctr) {
-                temp_tuple.setNValue(ctr, expression_array[ctr]->eval(&tuple, NULL));
-            }
+        if (outputTuple(output_table, project(params, tuple))) {
+            break;
         }
-        output_table->insertTupleNonVirtual(temp_tuple);
 
         VOLT_TRACE("OUTPUT TABLE: %s\n", output_table->debug().c_str());
     }
@@ -167,6 +170,14 @@ bool ProjectionExecutor::p_execute(const NValueArray &params) {
     return (true);
 }
 
+void ProjectionExecutor::p_push_init(const NValueArray &params) {
+    m_pushParams = &params;
+}
+
+bool ProjectionExecutor::p_push_tuple(TableTuple &input_tuple) {
+    return outputTuple(output_table, project(*m_pushParams, input_tuple));
+}
+
 ProjectionExecutor::~ProjectionExecutor() {
 }
 
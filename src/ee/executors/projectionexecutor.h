@@ -66,14 +66,29 @@ class ProjectionExecutor : public AbstractExecutor {
     public:
         ProjectionExecutor(VoltDBEngine *engine, AbstractPlanNode* abstract_node) : AbstractExecutor(engine, abstract_node) {
             output_table = NULL;
+            m_pushParams = NULL;
         }
         ~ProjectionExecutor();
+
+        bool canPushTuples() const {
+            return true;
+        }
+
+        bool canConsumePushedTuples() const {
+            return true;
+        }
     protected:
         bool p_init(AbstractPlanNode*,
                     TempTableLimits* limits);
         bool p_execute(const NValueArray &params);
 
+        void p_push_init(const NValueArray &params);
+        bool p_push_tuple(TableTuple &input_tuple);
+
     private:
+        /** Project (or replace) values from an input tuple into the output table's temp tuple */
+        TableTuple &project(const NValueArray &params, const TableTuple &input_tuple);
+
         TempTable* output_table;
         int m_columnCount;
         boost::shared_array<int> all_tuple_array_ptr;
@@ -86,6 +101,8 @@ class ProjectionExecutor : public AbstractExecutor {
 
         boost::shared_array<AbstractExpression*> expression_array_ptr;
         AbstractExpression** expression_array;
+
+        const NValueArray* m_pushParams;
 };
 
 }
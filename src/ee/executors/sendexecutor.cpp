@@ -68,6 +68,8 @@ bool SendExecutor::p_init(AbstractPlanNode* abstractNode,
     VOLT_TRACE("init Send Executor");
     assert(dynamic_cast<SendPlanNode*>(m_abstractNode));
     assert(m_abstractNode->getInputTableCount() == 1);
+    // The table is only serialized, so it may spill to disk.
+    allowInputTempTableSpill(m_abstractNode->getInputTable());
     return true;
 }
 
@@ -43,26 +43,49 @@
  * OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <iostream>
 #include "seqscanexecutor.h"
 #include "common/debuglog.h"
 #include "common/common.h"
 #include "common/tabletuple.h"
 #include "common/FatalException.hpp"
+#include "common/SerializableEEException.h"
 #include "executors/aggregateexecutor.h"
 #include "execution/ProgressMonitorProxy.h"
 #include "expressions/abstractexpression.h"
+#include "expressions/expressionutil.h"
 #include "plannodes/aggregatenode.h"
 #include "plannodes/seqscannode.h"
 #include "plannodes/projectionnode.h"
 #include "plannodes/limitnode.h"
 #include "storage/table.h"
+#include "storage/persistenttable.h"
+#include "storage/PaxScanner.h"
 #include "storage/temptable.h"
 #include "storage/tablefactory.h"
 #include "storage/tableiterator.h"
 
 using namespace voltdb;
 
+// Number of tuples the predicate is evaluated on at a time.
+static const int PREDICATE_BATCH_SIZE = 1024;
+
+static bool collectColumns(const AbstractExpression* expression, std::vector<int>& columns)
+{
+    return expression == NULL || expression->collectTupleColumns(columns);
+}
+
+static bool collectColumns(const std::vector<AbstractExpression*>& expressions, std::vector<int>& columns)
+{
+    for (int ii = 0; ii < expressions.size(); ii++) {
+        if ( ! collectColumns(expressions[ii], columns)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool SeqScanExecutor::p_init(AbstractPlanNode* abstract_node,
                              TempTableLimits* limits)
 {
@@ -103,6 +126,25 @@ bool SeqScanExecutor::p_init(AbstractPlanNode* abstract_node,
     // Inline aggregation can be serial, partial or hash
     m_aggExec = voltdb::getInlineAggregateExecutor(node);
 
+    //
+    // OPTIMIZATION: SPECIALIZED EXPRESSIONS
+    //
+    // The plan is cached until the catalog changes, so the target table's
+    // schema is fixed for its lifetime and the predicate can be bound to it.
+    //
+    if ( ! isSubquery) {
+        PersistentTable* target_table = dynamic_cast<PersistentTable*>(node->getTargetTable());
+        m_fusedPredicate.reset(FusedPredicateExpression::specialize(node->getPredicate(),
+                                                                    node->getTargetTable()->schema(),
+                                                                    target_table == NULL ? NULL :
+                                                                    &target_table->stringDictionaries()));
+    }
+    ProjectionPlanNode* projection_node =
+        dynamic_cast<ProjectionPlanNode*>(node->getInlinePlanNode(PLAN_NODE_TYPE_PROJECTION));
+    if (projection_node != NULL) {
+        m_projectionColumns = ExpressionUtil::convertIfAllTupleValues(projection_node->getOutputColumnExpressions());
+    }
+
     return true;
 }
 
@@ -166,6 +208,55 @@ bool SeqScanExecutor::p_execute(const NValueArray &params) {
         TableTuple tuple(input_table->schema());
         TableIterator iterator = input_table->iteratorDeletingAsWeGo();
         AbstractExpression *predicate = node->getPredicate();
+        PersistentTable* persistent_table = dynamic_cast<PersistentTable*>(input_table);
+        if (m_fusedPredicate) {
+            // A truncated table is replaced, along with its dictionaries.
+            if (persistent_table != NULL) {
+                m_fusedPredicate->bindDictionaries(persistent_table->stringDictionaries());
+            }
+            predicate = m_fusedPredicate.get();
+        }
+
+        //
+        // OPTIMIZATION: PAX SCAN
+        //
+        // If the table keeps PAX mini-pages, the predicate, projection and
+        // aggregates can be evaluated on a scratch tuple holding just the
+        // columns they read, and the row is only looked at for tuples that
+        // pass the predicate.
+        //
+        boost::scoped_ptr<PaxScanner> paxScanner;
+        StandAloneTupleStorage scratchStorage;
+        TableTuple scratch(input_table->schema());
+        std::vector<int> paxColumns;
+        if (persistent_table != NULL && persistent_table->isPaxLayout() &&
+            choosePaxScanColumns(node, persistent_table, projection_node, paxColumns)) {
+            VOLT_DEBUG("PAX scan of %d columns of %s", (int)paxColumns.size(), input_table->name().c_str());
+            paxScanner.reset(new PaxScanner(*persistent_table, paxColumns));
+            scratchStorage.init(input_table->schema());
+            scratch = scratchStorage.tuple();
+        }
+        // What the projection and the aggregates read
+        TableTuple& source_tuple = paxScanner ? scratch : tuple;
+
+        //
+        // OPTIMIZATION: BATCHED PREDICATE
+        //
+        // Otherwise the predicate is evaluated on a batch of tuples at a
+        // time, so its tree is walked once per batch rather than per tuple.
+        // An inline aggregate with a LIMIT can stop the scan at any tuple,
+        // so it gets the tuples one at a time rather than evaluating the
+        // predicate ahead for tuples it never takes.
+        //
+        const bool batched = (predicate != NULL && ! paxScanner &&
+                              (m_aggExec == NULL ||
+                               m_aggExec->getPlanNode()->getInlinePlanNode(PLAN_NODE_TYPE_LIMIT) == NULL));
+        if (batched) {
+            m_batchTuples.assign(PREDICATE_BATCH_SIZE, tuple);
+            m_batchSelection.resize(PREDICATE_BATCH_SIZE);
+        }
+        m_batchCount = 0;
+        m_batchPosition = 0;
 
         if (predicate)
         {
@@ -191,20 +282,32 @@ bool SeqScanExecutor::p_execute(const NValueArray &params) {
             }
             temp_tuple = m_aggExec->p_execute_init(params, &pmp,
                     inputSchema, output_temp_table);
+            // Rows are aggregated in place, so their shared strings can be grouped by address.
+            if (persistent_table != NULL && projection_node == NULL && ! paxScanner) {
+                m_aggExec->setDictionaryEncodedInput(persistent_table->stringDictionaries());
+            }
         } else {
             temp_tuple = output_temp_table->tempTuple();
         }
 
-        while ((limit == -1 || tuple_ctr < limit) && iterator.next(tuple))
+        while ((limit == -1 || tuple_ctr < limit) &&
+               (paxScanner ? nextPaxTuple(*paxScanner, predicate, scratch, tuple) :
+                batched ? nextBatchedTuple(iterator, predicate,
+                                           // no more tuples than could still be output
+                                           limit == -1 ? PREDICATE_BATCH_SIZE :
+                                           limit - tuple_ctr + std::max(0, offset - tuple_skipped),
+                                           pmp, tuple) :
+                iterator.next(tuple)))
         {
             VOLT_TRACE("INPUT TUPLE: %s, %d/%d\n",
                        tuple.debug(input_table->name()).c_str(), tuple_ctr,
                        (int)input_table->activeTupleCount());
             pmp.countdownProgress();
             //
-            // For each tuple we need to evaluate it against our predicate
+            // For each tuple we need to evaluate it against our predicate,
+            // unless the PAX scan or the batch already did
             //
-            if (predicate == NULL || predicate->eval(&tuple, NULL).isTrue())
+            if (predicate == NULL || paxScanner || batched || predicate->eval(&tuple, NULL).isTrue())
             {
                 // Check if we have to skip this tuple because of offset
                 if (tuple_skipped < offset) {
@@ -220,30 +323,39 @@ bool SeqScanExecutor::p_execute(const NValueArray &params) {
                 if (projection_node != NULL)
                 {
                     VOLT_TRACE("inline projection...");
-                    for (int ctr = 0; ctr < num_of_columns; ctr++) {
-                        NValue value = projection_node->getOutputColumnExpressions()[ctr]->eval(&tuple, NULL);
-                        temp_tuple.setNValue(ctr, value);
+                    if (m_projectionColumns) {
+                        for (int ctr = 0; ctr < num_of_columns; ctr++) {
+                            temp_tuple.setNValue(ctr, source_tuple.getNValue(m_projectionColumns[ctr]));
+                        }
+                    } else {
+                        for (int ctr = 0; ctr < num_of_columns; ctr++) {
+                            NValue value = projection_node->getOutputColumnExpressions()[ctr]->eval(&source_tuple, NULL);
+                            temp_tuple.setNValue(ctr, value);
+                        }
                     }
 
                     if (m_aggExec != NULL) {
                         if (m_aggExec->p_execute_tuple(temp_tuple)) {
                             break;
                         }
-                    } else {
-                        output_temp_table->insertTupleNonVirtual(temp_tuple);
+                    } else if (outputTuple(output_temp_table, temp_tuple)) {
+                        break;
                     }
                 }
                 else
                 {
                     if (m_aggExec != NULL) {
-                        if (m_aggExec->p_execute_tuple(tuple)) {
+                        if (m_aggExec->p_execute_tuple(source_tuple)) {
                             break;
                         }
                     } else {
                         //
-                        // Insert the tuple into our output table
+                        // Insert the tuple into our output table,
+                        // or push it into our parent
                         //
-                        output_temp_table->insertTupleNonVirtual(tuple);
+                        if (outputTuple(output_temp_table, tuple)) {
+                            break;
+                        }
                     }
                 }
                 pmp.countdownProgress();
@@ -263,3 +375,113 @@ bool SeqScanExecutor::p_execute(const NValueArray &params) {
 
     return true;
 }
+
+bool SeqScanExecutor::canPushTuples() const
+{
+    // Without a predicate or inline nodes, the output is the scanned table
+    // itself and nothing is copied. With an inline aggregate, the output is
+    // the aggregate's.
+    SeqScanPlanNode* node = static_cast<SeqScanPlanNode*>(m_abstractNode);
+    return (node->getPredicate() != NULL || node->getInlinePlanNodes().size() > 0) && m_aggExec == NULL;
+}
+
+bool SeqScanExecutor::choosePaxScanColumns(SeqScanPlanNode* node, PersistentTable* table,
+                                           ProjectionPlanNode* projection_node,
+                                           std::vector<int>& columns) const
+{
+    // The rows themselves are output when nothing is projected or aggregated.
+    if (projection_node == NULL && m_aggExec == NULL && node->getPredicate() == NULL) {
+        return false;
+    }
+    if ( ! collectColumns(node->getPredicate(), columns)) {
+        return false;
+    }
+    if (projection_node != NULL) {
+        if ( ! collectColumns(projection_node->getOutputColumnExpressions(), columns)) {
+            return false;
+        }
+    }
+    else if (m_aggExec != NULL) {
+        // The aggregate reads the scanned tuples directly.
+        AggregatePlanNode* agg_node = dynamic_cast<AggregatePlanNode*>(m_aggExec->getPlanNode());
+        assert(agg_node);
+        if ( ! collectColumns(agg_node->getAggregateInputExpressions(), columns) ||
+             ! collectColumns(agg_node->getGroupByExpressions(), columns) ||
+             ! collectColumns(agg_node->getPrePredicate(), columns)) {
+            return false;
+        }
+        // Output columns that are not aggregates pass through from an input tuple.
+        const std::vector<int>& aggregateOutputColumns = agg_node->getAggregateOutputColumns();
+        const std::vector<SchemaColumn*>& outputSchema = agg_node->getOutputSchema();
+        for (int ii = 0; ii < outputSchema.size(); ii++) {
+            if (std::find(aggregateOutputColumns.begin(), aggregateOutputColumns.end(), ii) ==
+                aggregateOutputColumns.end() &&
+                ! collectColumns(outputSchema[ii]->getExpression(), columns)) {
+                return false;
+            }
+        }
+    }
+
+    std::sort(columns.begin(), columns.end());
+    columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+    if ( ! PaxScanner::canScan(table->schema(), columns)) {
+        return false;
+    }
+    // Copying most of every row out of mini-pages costs more than reading the rows.
+    uint32_t scannedLength = 0;
+    const TupleSchema* schema = table->schema();
+    for (int ii = 0; ii < columns.size(); ii++) {
+        scannedLength += schema->getColumnInfo(columns[ii] + 1)->offset - schema->getColumnInfo(columns[ii])->offset;
+    }
+    return scannedLength * 2 <= schema->tupleLength();
+}
+
+bool SeqScanExecutor::nextBatchedTuple(TableIterator& iterator, const AbstractExpression* predicate,
+                                       int maxTuples, ProgressMonitorProxy& pmp, TableTuple& tuple)
+{
+    while (m_batchPosition == m_batchCount) {
+        const int count = iterator.nextBatch(&m_batchTuples[0], std::min(maxTuples, PREDICATE_BATCH_SIZE));
+        if (count == 0) {
+            return false;
+        }
+        for (int ii = 0; ii < count; ii++) {
+            m_batchSelection[ii] = ii;
+        }
+        m_batchCount = predicate->evalBatch(&m_batchTuples[0], &m_batchSelection[0], count);
+        m_batchPosition = 0;
+        // The tuples that are returned get counted by the caller.
+        for (int ii = m_batchCount; ii < count; ii++) {
+            pmp.countdownProgress();
+        }
+    }
+    tuple = m_batchTuples[m_batchSelection[m_batchPosition++]];
+    return true;
+}
+
+bool SeqScanExecutor::nextPaxTuple(PaxScanner& scanner, const AbstractExpression* predicate,
+                                   TableTuple& scratch, TableTuple& tuple) const
+{
+    while (scanner.next(scratch)) {
+        bool passed;
+        try {
+            passed = (predicate == NULL || predicate->eval(&scratch, NULL).isTrue());
+        }
+        catch (const SerializableEEException&) {
+            // The scanner skips free slots, but a tuple pending delete is
+            // no longer visible, so its failure doesn't count.
+            scanner.moveToRow(tuple);
+            if ( ! tuple.isPendingDelete() && ! tuple.isPendingDeleteOnUndoRelease()) {
+                throw;
+            }
+            continue;
+        }
+        if ( ! passed) {
+            continue;
+        }
+        scanner.moveToRow(tuple);
+        if ( ! tuple.isPendingDelete() && ! tuple.isPendingDeleteOnUndoRelease()) {
+            return true;
+        }
+    }
+    return false;
+}
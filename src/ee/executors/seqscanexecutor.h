@@ -50,26 +50,82 @@
 #include "common/valuevector.h"
 #include "executors/abstractexecutor.h"
 #include "execution/VoltDBEngine.h"
+#include "expressions/fusedpredicateexpression.h"
+
+#include "boost/scoped_ptr.hpp"
+#include "boost/shared_array.hpp"
+
+#include <vector>
 
 namespace voltdb
 {
     class UndoLog;
     class ReadWriteSet;
     class AggregateExecutorBase;
+    class PaxScanner;
+    class PersistentTable;
+    class ProgressMonitorProxy;
+    class ProjectionPlanNode;
+    class SeqScanPlanNode;
+    class TableIterator;
 
     class SeqScanExecutor : public AbstractExecutor {
     public:
         SeqScanExecutor(VoltDBEngine *engine, AbstractPlanNode* abstract_node)
             : AbstractExecutor(engine, abstract_node)
             , m_aggExec(NULL)
+            , m_batchCount(0)
+            , m_batchPosition(0)
         {}
+
+        bool isSpecialized() const {
+            return m_fusedPredicate || m_projectionColumns;
+        }
+
+        bool canPushTuples() const;
     protected:
         bool p_init(AbstractPlanNode* abstract_node,
                     TempTableLimits* limits);
         bool p_execute(const NValueArray& params);
 
     private:
+        /**
+         * Find the columns the scan reads from its input tuples, if it can read
+         * them all from the PAX mini-pages of the table and that pays off.
+         */
+        bool choosePaxScanColumns(SeqScanPlanNode* node, PersistentTable* table,
+                                  ProjectionPlanNode* projection_node,
+                                  std::vector<int>& columns) const;
+
+        /**
+         * Advance to the next visible tuple that satisfies the predicate,
+         * which is evaluated on the scanned columns in scratch before the row
+         * is looked at. Leave tuple pointing at the row.
+         */
+        bool nextPaxTuple(PaxScanner& scanner, const AbstractExpression* predicate,
+                          TableTuple& scratch, TableTuple& tuple) const;
+
+        /**
+         * Advance to the next tuple that satisfies the predicate. The
+         * predicate is evaluated a batch of at most maxTuples tuples at a time.
+         */
+        bool nextBatchedTuple(TableIterator& iterator, const AbstractExpression* predicate,
+                              int maxTuples, ProgressMonitorProxy& pmp, TableTuple& tuple);
+
         AggregateExecutorBase* m_aggExec;
+
+        // The predicate specialized for the target table, if it has that shape.
+        boost::scoped_ptr<FusedPredicateExpression> m_fusedPredicate;
+        // The columns of the input tuple that the inline projection copies,
+        // if it only copies columns.
+        boost::shared_array<int> m_projectionColumns;
+
+        // The current batch of scanned tuples and the positions in it of
+        // those that satisfy the predicate.
+        std::vector<TableTuple> m_batchTuples;
+        std::vector<int> m_batchSelection;
+        int m_batchCount;
+        int m_batchPosition;
     };
 }
 
@@ -47,6 +47,7 @@
 
 #include "common/debuglog.h"
 #include "common/serializeio.h"
+#include "common/tabletuple.h"
 #include "common/types.h"
 #include "expressions/expressionutil.h"
 
@@ -96,6 +97,26 @@ AbstractExpression::hasParameter() const
     return (m_right && m_right->hasParameter());
 }
 
+int
+AbstractExpression::evalBatch(const TableTuple *tuples, int *selection, int count) const
+{
+    int selected = 0;
+    for (int ii = 0; ii < count; ii++) {
+        if (eval(&tuples[selection[ii]], NULL).isTrue()) {
+            selection[selected++] = selection[ii];
+        }
+    }
+    return selected;
+}
+
+bool
+AbstractExpression::collectTupleColumns(std::vector<int> &columns) const
+{
+    if (m_left && !m_left->collectTupleColumns(columns))
+        return false;
+    return (m_right == NULL || m_right->collectTupleColumns(columns));
+}
+
 bool
 AbstractExpression::initParamShortCircuits()
 {
@@ -73,9 +73,24 @@ class AbstractExpression {
 
     virtual NValue eval(const TableTuple *tuple1 = NULL, const TableTuple *tuple2 = NULL) const = 0;
 
+    /**
+     * Evaluate this predicate for a batch of tuples, each as the first tuple.
+     * selection holds count increasing positions in tuples; narrow it in
+     * place to the positions of the tuples the predicate is true for and
+     * return how many are left. The default calls eval() for each tuple.
+     */
+    virtual int evalBatch(const TableTuple *tuples, int *selection, int count) const;
+
     /** return true if self or descendent should be substitute()'d */
     virtual bool hasParameter() const;
 
+    /**
+     * Add the indexes of the columns of the first tuple that self or a
+     * descendent reads. Return false if they also read the tuples in some
+     * other way, e.g. a column of the second tuple or a tuple's address.
+     */
+    virtual bool collectTupleColumns(std::vector<int> &columns) const;
+
     /* debugging methods - some various ways to create a sring
        describing the expression tree */
     std::string debug() const;
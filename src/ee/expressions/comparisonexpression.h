@@ -48,6 +48,8 @@
 
 #include "common/common.h"
 #include "common/serializeio.h"
+#include "common/tabletuple.h"
+#include "common/ValuePeeker.hpp"
 #include "common/valuevector.h"
 
 #include "expressions/abstractexpression.h"
@@ -94,6 +96,169 @@ public:
     { return l.inList(r) ? NValue::getTrue() : NValue::getFalse(); }
 };
 
+/**
+ * The comparisons that can be done on raw integer column storage by the
+ * batch kernel below, which leaves the others to eval().
+ */
+template <typename C>
+struct IntegerComparison {
+    static const bool supported = false;
+    static inline bool cmp(int64_t l, int64_t r) { return false; }
+};
+template <> struct IntegerComparison<CmpEq> {
+    static const bool supported = true;
+    static inline bool cmp(int64_t l, int64_t r) { return l == r; }
+};
+template <> struct IntegerComparison<CmpNe> {
+    static const bool supported = true;
+    static inline bool cmp(int64_t l, int64_t r) { return l != r; }
+};
+template <> struct IntegerComparison<CmpLt> {
+    static const bool supported = true;
+    static inline bool cmp(int64_t l, int64_t r) { return l < r; }
+};
+template <> struct IntegerComparison<CmpGt> {
+    static const bool supported = true;
+    static inline bool cmp(int64_t l, int64_t r) { return l > r; }
+};
+template <> struct IntegerComparison<CmpLte> {
+    static const bool supported = true;
+    static inline bool cmp(int64_t l, int64_t r) { return l <= r; }
+};
+template <> struct IntegerComparison<CmpGte> {
+    static const bool supported = true;
+    static inline bool cmp(int64_t l, int64_t r) { return l >= r; }
+};
+
+/**
+ * Narrow selection to the tuples whose integer column at offset compares
+ * true with key. The loop has no branch on the outcome: every position is
+ * written and the count only moves past the ones that pass. A null column
+ * value compares as NULL, so it never passes.
+ */
+template <typename C, typename T>
+inline int selectIntegerColumn(const TableTuple *tuples, int *selection, int count,
+                               uint32_t offset, T nullValue, int64_t key)
+{
+    int selected = 0;
+    for (int ii = 0; ii < count; ii++) {
+        const int position = selection[ii];
+        const T value = *reinterpret_cast<const T*>(tuples[position].address() + offset);
+        selection[selected] = position;
+        selected += (value != nullValue) & IntegerComparison<C>::cmp(value, key);
+    }
+    return selected;
+}
+
+/** selectIntegerColumn for a column of T whose NULL is NULL_VALUE. */
+template <typename C, typename T, int64_t NULL_VALUE>
+int selectIntegerColumnOf(const TableTuple *tuples, int *selection, int count,
+                          uint32_t offset, int64_t key)
+{
+    return selectIntegerColumn<C, T>(tuples, selection, count, offset,
+                                     static_cast<T>(NULL_VALUE), key);
+}
+
+typedef int (*IntegerColumnSelector)(const TableTuple *tuples, int *selection, int count,
+                                     uint32_t offset, int64_t key);
+
+/**
+ * The batch kernel comparing a column of columnType with C, or NULL if
+ * columnType is not stored as an integer.
+ */
+template <typename C>
+inline IntegerColumnSelector integerColumnSelector(ValueType columnType)
+{
+    switch (columnType) {
+    case VALUE_TYPE_TINYINT:
+        return &selectIntegerColumnOf<C, int8_t, INT8_NULL>;
+    case VALUE_TYPE_SMALLINT:
+        return &selectIntegerColumnOf<C, int16_t, INT16_NULL>;
+    case VALUE_TYPE_INTEGER:
+        return &selectIntegerColumnOf<C, int32_t, INT32_NULL>;
+    case VALUE_TYPE_BIGINT:
+    case VALUE_TYPE_TIMESTAMP:
+        return &selectIntegerColumnOf<C, int64_t, INT64_NULL>;
+    default:
+        return NULL;
+    }
+}
+
+/**
+ * Can a column of columnType be compared with a value of valueType on
+ * their raw integers? Timestamps only compare with timestamps.
+ */
+inline bool isIntegerComparable(ValueType columnType, ValueType valueType)
+{
+    switch (valueType) {
+    case VALUE_TYPE_TINYINT:
+    case VALUE_TYPE_SMALLINT:
+    case VALUE_TYPE_INTEGER:
+    case VALUE_TYPE_BIGINT:
+        return columnType == VALUE_TYPE_TINYINT || columnType == VALUE_TYPE_SMALLINT ||
+            columnType == VALUE_TYPE_INTEGER || columnType == VALUE_TYPE_BIGINT;
+    case VALUE_TYPE_TIMESTAMP:
+        return columnType == VALUE_TYPE_TIMESTAMP;
+    default:
+        return false;
+    }
+}
+
+/**
+ * Batch kernel for comparing an integer or timestamp column of the first
+ * tuple with a value that is the same for the whole batch. Return -1 if
+ * the comparison or the types are not ones it handles.
+ */
+template <typename C>
+inline int selectColumnAgainstValue(const TupleValueExpression *column, const NValue &value,
+                                    const TableTuple *tuples, int *selection, int count)
+{
+    if ( ! IntegerComparison<C>::supported || column->getTupleId() != 0) {
+        return -1;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    const TupleSchema::ColumnInfo *columnInfo =
+        tuples[selection[0]].getSchema()->getColumnInfo(column->getColumnId());
+    const ValueType columnType = columnInfo->getVoltType();
+    if ( ! isIntegerComparable(columnType, ValuePeeker::peekValueType(value))) {
+        return -1;
+    }
+    if (value.isNull()) {
+        return 0;
+    }
+    return integerColumnSelector<C>(columnType)(tuples, selection, count,
+                                                TUPLE_HEADER_SIZE + columnInfo->offset,
+                                                ValuePeeker::peekAsBigInt(value));
+}
+
+/**
+ * Picks the batch kernel for the operand types of an inlined comparison.
+ * Only a column compared with a constant or a parameter has one.
+ */
+template <typename C, typename L, typename R>
+struct BatchComparison {
+    static inline int evalBatch(const L *left, const R *right,
+                                const TableTuple *tuples, int *selection, int count) {
+        return -1;
+    }
+};
+template <typename C>
+struct BatchComparison<C, TupleValueExpression, ConstantValueExpression> {
+    static inline int evalBatch(const TupleValueExpression *left, const ConstantValueExpression *right,
+                                const TableTuple *tuples, int *selection, int count) {
+        return selectColumnAgainstValue<C>(left, right->eval(NULL, NULL), tuples, selection, count);
+    }
+};
+template <typename C>
+struct BatchComparison<C, TupleValueExpression, ParameterValueExpression> {
+    static inline int evalBatch(const TupleValueExpression *left, const ParameterValueExpression *right,
+                                const TableTuple *tuples, int *selection, int count) {
+        return selectColumnAgainstValue<C>(left, right->eval(NULL, NULL), tuples, selection, count);
+    }
+};
+
 template <typename C>
 class ComparisonExpression : public AbstractExpression {
 public:
@@ -151,11 +316,22 @@ private:
 template <typename C, typename L, typename R>
 class InlinedComparisonExpression : public ComparisonExpression<C> {
 public:
-    InlinedComparisonExpression(ExpressionType type,
-                                         AbstractExpression *left,
-                                         AbstractExpression *right)
-        : ComparisonExpression<C>(type, left, right)
+    InlinedComparisonExpression(ExpressionType type, L *left, R *right)
+        : ComparisonExpression<C>(type, left, right), m_typedLeft(left), m_typedRight(right)
     {}
+
+    int evalBatch(const TableTuple *tuples, int *selection, int count) const {
+        int selected = BatchComparison<C, L, R>::evalBatch(m_typedLeft, m_typedRight,
+                                                           tuples, selection, count);
+        if (selected < 0) {
+            return AbstractExpression::evalBatch(tuples, selection, count);
+        }
+        return selected;
+    }
+
+private:
+    const L *m_typedLeft;
+    const R *m_typedRight;
 };
 
 }
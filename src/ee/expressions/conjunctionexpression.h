@@ -52,7 +52,9 @@
 
 #include "expressions/abstractexpression.h"
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 namespace voltdb {
 
@@ -74,12 +76,19 @@ class ConjunctionExpression : public AbstractExpression
 
     NValue eval(const TableTuple *tuple1, const TableTuple *tuple2) const;
 
+    int evalBatch(const TableTuple *tuples, int *selection, int count) const;
+
     std::string debugInfo(const std::string &spacer) const {
         return (spacer + "ConjunctionExpression\n");
     }
 
     AbstractExpression *m_left;
     AbstractExpression *m_right;
+
+  private:
+    // Positions an OR hands to each side, kept so batches reuse their capacity
+    mutable std::vector<int> m_leftSelection;
+    mutable std::vector<int> m_rightSelection;
 };
 
 template<> inline NValue
@@ -130,5 +139,48 @@ ConjunctionExpression<ConjunctionOr>::eval(const TableTuple *tuple1,
     return NValue::getNullValue(VALUE_TYPE_BOOLEAN);
 }
 
+template<> inline int
+ConjunctionExpression<ConjunctionAnd>::evalBatch(const TableTuple *tuples,
+                                                 int *selection, int count) const
+{
+    // The right side only sees the tuples the left side is true for.
+    count = m_left->evalBatch(tuples, selection, count);
+    if (count == 0) {
+        return 0;
+    }
+    return m_right->evalBatch(tuples, selection, count);
+}
+
+template<> inline int
+ConjunctionExpression<ConjunctionOr>::evalBatch(const TableTuple *tuples,
+                                                int *selection, int count) const
+{
+    if (count == 0) {
+        return 0;
+    }
+    m_leftSelection.assign(selection, selection + count);
+    const int leftCount = m_left->evalBatch(tuples, &m_leftSelection[0], count);
+
+    // The right side only sees the tuples the left side is not true for.
+    m_rightSelection.clear();
+    int leftPosition = 0;
+    for (int ii = 0; ii < count; ii++) {
+        if (leftPosition < leftCount && m_leftSelection[leftPosition] == selection[ii]) {
+            ++leftPosition;
+        } else {
+            m_rightSelection.push_back(selection[ii]);
+        }
+    }
+    int rightCount = 0;
+    if ( ! m_rightSelection.empty()) {
+        rightCount = m_right->evalBatch(tuples, &m_rightSelection[0],
+                                        static_cast<int>(m_rightSelection.size()));
+    }
+    std::merge(m_leftSelection.begin(), m_leftSelection.begin() + leftCount,
+               m_rightSelection.begin(), m_rightSelection.begin() + rightCount,
+               selection);
+    return leftCount + rightCount;
+}
+
 }
 #endif
@@ -162,6 +162,9 @@ ExpressionUtil::comparisonFactory(ExpressionType et, AbstractExpression *lc, Abs
     TupleValueExpression *r_tuple =
       dynamic_cast<TupleValueExpression*>(rc);
 
+    ParameterValueExpression *r_param =
+      dynamic_cast<ParameterValueExpression*>(rc);
+
     // this will inline getValue(), hooray!
     if (l_const != NULL && r_const != NULL) { // CONST-CONST can it happen?
         return getMoreSpecialized<ConstantValueExpression, ConstantValueExpression>(et, l_const, r_const);
@@ -171,6 +174,8 @@ ExpressionUtil::comparisonFactory(ExpressionType et, AbstractExpression *lc, Abs
         return getMoreSpecialized<TupleValueExpression, ConstantValueExpression >(et, l_tuple, r_const);
     } else if (l_tuple != NULL && r_tuple != NULL) { // TUPLE-TUPLE
         return getMoreSpecialized<TupleValueExpression, TupleValueExpression>(et, l_tuple, r_tuple);
+    } else if (l_tuple != NULL && r_param != NULL) { // TUPLE-PARAM
+        return getMoreSpecialized<TupleValueExpression, ParameterValueExpression>(et, l_tuple, r_param);
     }
 
     //okay, still getTypedValue is beneficial.
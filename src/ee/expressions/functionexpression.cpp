@@ -128,6 +128,10 @@ public:
         return m_child->hasParameter();
     }
 
+    virtual bool collectTupleColumns(std::vector<int> &columns) const {
+        return m_child->collectTupleColumns(columns);
+    }
+
     NValue eval(const TableTuple *tuple1, const TableTuple *tuple2) const {
         assert (m_child);
         return (m_child->eval(tuple1, tuple2)).callUnary<F>();
@@ -167,6 +171,15 @@ public:
         return false;
     }
 
+    virtual bool collectTupleColumns(std::vector<int> &columns) const {
+        for (size_t i = 0; i < m_args.size(); i++) {
+            if (!m_args[i]->collectTupleColumns(columns)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     NValue eval(const TableTuple *tuple1, const TableTuple *tuple2) const {
         //TODO: Could make this vector a member, if the memory management implications
         // (of the NValue internal state) were clear -- is there a penalty for longer-lived
@@ -0,0 +1,321 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "expressions/fusedpredicateexpression.h"
+
+#include "common/tabletuple.h"
+#include "common/ValuePeeker.hpp"
+#include "expressions/comparisonexpression.h"
+#include "expressions/constantvalueexpression.h"
+#include "expressions/parametervalueexpression.h"
+#include "expressions/tuplevalueexpression.h"
+#include "storage/StringDictionary.h"
+
+#include <cstring>
+#include <sstream>
+
+namespace voltdb {
+
+/** The batch kernel for a comparison of type with a column of columnType, or NULL. */
+static IntegerColumnSelector integerSelector(ExpressionType type, ValueType columnType)
+{
+    switch (type) {
+    case EXPRESSION_TYPE_COMPARE_EQUAL:
+        return integerColumnSelector<CmpEq>(columnType);
+    case EXPRESSION_TYPE_COMPARE_NOTEQUAL:
+        return integerColumnSelector<CmpNe>(columnType);
+    case EXPRESSION_TYPE_COMPARE_LESSTHAN:
+        return integerColumnSelector<CmpLt>(columnType);
+    case EXPRESSION_TYPE_COMPARE_GREATERTHAN:
+        return integerColumnSelector<CmpGt>(columnType);
+    case EXPRESSION_TYPE_COMPARE_LESSTHANOREQUALTO:
+        return integerColumnSelector<CmpLte>(columnType);
+    case EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO:
+        return integerColumnSelector<CmpGte>(columnType);
+    default:
+        return NULL;
+    }
+}
+
+/** The comparison with its operands swapped, e.g. 5 < A is A > 5. */
+static ExpressionType reverseComparison(ExpressionType type)
+{
+    switch (type) {
+    case EXPRESSION_TYPE_COMPARE_LESSTHAN:
+        return EXPRESSION_TYPE_COMPARE_GREATERTHAN;
+    case EXPRESSION_TYPE_COMPARE_GREATERTHAN:
+        return EXPRESSION_TYPE_COMPARE_LESSTHAN;
+    case EXPRESSION_TYPE_COMPARE_LESSTHANOREQUALTO:
+        return EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO;
+    case EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO:
+        return EXPRESSION_TYPE_COMPARE_LESSTHANOREQUALTO;
+    default:
+        return type;
+    }
+}
+
+FusedPredicateExpression::FusedPredicateExpression(const AbstractExpression *generic)
+    : AbstractExpression(generic->getExpressionType()), m_generic(generic)
+{
+    setValueType(VALUE_TYPE_BOOLEAN);
+}
+
+FusedPredicateExpression*
+FusedPredicateExpression::specialize(const AbstractExpression *predicate, const TupleSchema *schema,
+                                     const std::vector<StringDictionary*> *dictionaries)
+{
+    if (predicate == NULL || schema == NULL) {
+        return NULL;
+    }
+    FusedPredicateExpression *fused = new FusedPredicateExpression(predicate);
+    if ( ! fused->addTerms(predicate, schema, dictionaries)) {
+        delete fused;
+        return NULL;
+    }
+    return fused;
+}
+
+bool
+FusedPredicateExpression::addTerms(const AbstractExpression *expression, const TupleSchema *schema,
+                                   const std::vector<StringDictionary*> *dictionaries)
+{
+    ExpressionType type = expression->getExpressionType();
+    if (type == EXPRESSION_TYPE_CONJUNCTION_AND) {
+        return addTerms(expression->getLeft(), schema, dictionaries) &&
+            addTerms(expression->getRight(), schema, dictionaries);
+    }
+
+    const AbstractExpression *operand = expression->getRight();
+    const TupleValueExpression *column = dynamic_cast<const TupleValueExpression*>(expression->getLeft());
+    if (column == NULL) {
+        operand = expression->getLeft();
+        column = dynamic_cast<const TupleValueExpression*>(expression->getRight());
+        type = reverseComparison(type);
+    }
+    if (column == NULL || column->getTupleId() != 0 ||
+        column->getColumnId() < 0 || column->getColumnId() >= schema->columnCount()) {
+        return false;
+    }
+
+    Term term;
+    const TupleSchema::ColumnInfo *columnInfo = schema->getColumnInfo(column->getColumnId());
+    term.m_column = column->getColumnId();
+    term.m_offset = TUPLE_HEADER_SIZE + columnInfo->offset;
+    term.m_columnType = columnInfo->getVoltType();
+    term.m_parameter = NULL;
+    term.m_constant = 0;
+    term.m_constantIsNull = false;
+    term.m_encoded = (dictionaries != NULL && term.m_column < dictionaries->size() &&
+                      (*dictionaries)[term.m_column] != NULL);
+    term.m_dictionaryKey = DICTIONARY_KEY_UNBOUND;
+
+    const ConstantValueExpression *constant = dynamic_cast<const ConstantValueExpression*>(operand);
+    const ParameterValueExpression *parameter = dynamic_cast<const ParameterValueExpression*>(operand);
+    if (term.m_encoded) {
+        // Equal strings of the column are one object, so equality is on its address.
+        if (type != EXPRESSION_TYPE_COMPARE_EQUAL && type != EXPRESSION_TYPE_COMPARE_NOTEQUAL) {
+            return false;
+        }
+        if (constant != NULL) {
+            term.m_string = constant->eval(NULL, NULL);
+            term.m_constantIsNull = term.m_string.isNull();
+            if ( ! term.m_constantIsNull && ValuePeeker::peekValueType(term.m_string) != VALUE_TYPE_VARCHAR) {
+                return false;
+            }
+        }
+        else if (parameter != NULL && parameter->getParameterSlot() != NULL) {
+            term.m_parameter = parameter->getParameterSlot();
+        }
+        else {
+            return false;
+        }
+        // The string objects are compared as integers, NULL being no object.
+        if (type == EXPRESSION_TYPE_COMPARE_EQUAL) {
+            term.m_selector = &selectIntegerColumnOf<CmpEq, int64_t, 0>;
+        }
+        else {
+            term.m_selector = &selectIntegerColumnOf<CmpNe, int64_t, 0>;
+        }
+        m_terms.push_back(term);
+        return true;
+    }
+    if (constant != NULL) {
+        NValue value = constant->eval(NULL, NULL);
+        if (value.isNull()) {
+            term.m_constantIsNull = true;
+        }
+        else if (isIntegerComparable(term.m_columnType, ValuePeeker::peekValueType(value))) {
+            term.m_constant = ValuePeeker::peekAsBigInt(value);
+        }
+        else {
+            return false;
+        }
+    }
+    else if (parameter != NULL && parameter->getParameterSlot() != NULL) {
+        term.m_parameter = parameter->getParameterSlot();
+    }
+    else {
+        return false;
+    }
+
+    term.m_selector = integerSelector(type, term.m_columnType);
+    if (term.m_selector == NULL) {
+        return false;
+    }
+    m_terms.push_back(term);
+    return true;
+}
+
+void
+FusedPredicateExpression::bindDictionaries(const std::vector<StringDictionary*> &dictionaries)
+{
+    for (int ii = 0; ii < m_terms.size(); ii++) {
+        Term &term = m_terms[ii];
+        if ( ! term.m_encoded) {
+            continue;
+        }
+        term.m_dictionaryKey = DICTIONARY_KEY_UNBOUND;
+        const StringDictionary *dictionary =
+            term.m_column < dictionaries.size() ? dictionaries[term.m_column] : NULL;
+        if (dictionary == NULL) {
+            continue;
+        }
+        const NValue &value = term.m_parameter == NULL ? term.m_string : *term.m_parameter;
+        if ((term.m_parameter == NULL && term.m_constantIsNull) || value.isNull()) {
+            term.m_dictionaryKey = DICTIONARY_KEY_NULL;
+            continue;
+        }
+        if (ValuePeeker::peekValueType(value) != VALUE_TYPE_VARCHAR) {
+            continue;
+        }
+        const char *data = static_cast<const char*>(ValuePeeker::peekObjectValue_withoutNull(value));
+        const int32_t length = ValuePeeker::peekObjectLength_withoutNull(value);
+        // The generic comparison stops at a NUL, so strings that differ after one may be equal.
+        if (::memchr(data, '\0', length) != NULL) {
+            continue;
+        }
+        const char *object = dictionary->find(data, length);
+        // no row's string is at address 1
+        term.m_constant = object == NULL ? 1 : reinterpret_cast<intptr_t>(object);
+        term.m_dictionaryKey = DICTIONARY_KEY_BOUND;
+    }
+}
+
+inline bool
+FusedPredicateExpression::termKey(const Term &term, int64_t &key, bool &isNull) const
+{
+    if (term.m_encoded) {
+        isNull = (term.m_dictionaryKey == DICTIONARY_KEY_NULL);
+        key = term.m_constant;
+        return term.m_dictionaryKey != DICTIONARY_KEY_UNBOUND;
+    }
+    if (term.m_parameter == NULL) {
+        isNull = term.m_constantIsNull;
+        key = term.m_constant;
+        return true;
+    }
+    const NValue &value = *term.m_parameter;
+    isNull = value.isNull();
+    if (isNull) {
+        return true;
+    }
+    if ( ! isIntegerComparable(term.m_columnType, ValuePeeker::peekValueType(value))) {
+        return false;
+    }
+    key = ValuePeeker::peekAsBigInt(value);
+    return true;
+}
+
+NValue
+FusedPredicateExpression::eval(const TableTuple *tuple1, const TableTuple *tuple2) const
+{
+    assert(tuple1);
+    // The same three valued logic as the conjunctions and comparisons it replaces
+    bool sawNull = false;
+    for (int ii = 0; ii < m_terms.size(); ii++) {
+        const Term &term = m_terms[ii];
+        int64_t key;
+        bool isNull;
+        if ( ! termKey(term, key, isNull)) {
+            return m_generic->eval(tuple1, tuple2);
+        }
+        if (isNull) {
+            sawNull = true;
+            continue;
+        }
+        // The batch kernel on a batch of one; a NULL column fails it as well.
+        int position = 0;
+        if (term.m_selector(tuple1, &position, 1, term.m_offset, key) == 0) {
+            if ( ! tuple1->isNull(term.m_column)) {
+                return NValue::getFalse();
+            }
+            sawNull = true;
+        }
+    }
+    return sawNull ? NValue::getNullValue(VALUE_TYPE_BOOLEAN) : NValue::getTrue();
+}
+
+int
+FusedPredicateExpression::evalBatch(const TableTuple *tuples, int *selection, int count) const
+{
+    int64_t key;
+    bool isNull;
+    for (int ii = 0; ii < m_terms.size(); ii++) {
+        if ( ! termKey(m_terms[ii], key, isNull)) {
+            return m_generic->evalBatch(tuples, selection, count);
+        }
+        if (isNull) {
+            return 0;
+        }
+    }
+    for (int ii = 0; ii < m_terms.size() && count > 0; ii++) {
+        const Term &term = m_terms[ii];
+        termKey(term, key, isNull);
+        count = term.m_selector(tuples, selection, count, term.m_offset, key);
+    }
+    return count;
+}
+
+bool
+FusedPredicateExpression::hasParameter() const
+{
+    for (int ii = 0; ii < m_terms.size(); ii++) {
+        if (m_terms[ii].m_parameter != NULL) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+FusedPredicateExpression::collectTupleColumns(std::vector<int> &columns) const
+{
+    for (int ii = 0; ii < m_terms.size(); ii++) {
+        columns.push_back(m_terms[ii].m_column);
+    }
+    return true;
+}
+
+std::string
+FusedPredicateExpression::debugInfo(const std::string &spacer) const
+{
+    std::ostringstream buffer;
+    buffer << spacer << "FusedPredicate[" << m_terms.size() << " comparisons]\n";
+    return buffer.str();
+}
+
+}
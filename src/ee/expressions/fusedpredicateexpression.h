@@ -0,0 +1,122 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef VOLTDBFUSEDPREDICATEEXPRESSION_H
+#define VOLTDBFUSEDPREDICATEEXPRESSION_H
+
+#include "expressions/abstractexpression.h"
+#include "expressions/comparisonexpression.h"
+
+#include "common/NValue.hpp"
+#include "common/TupleSchema.h"
+
+#include <string>
+#include <vector>
+
+namespace voltdb {
+
+class StringDictionary;
+
+/**
+ * A predicate that is a conjunction of comparisons of integer or timestamp
+ * columns of the first tuple with constants or parameters, e.g.
+ * "A > ? AND B = 5", specialized for one tuple schema.
+ *
+ * Each comparison is bound to the batch kernel the inlined comparisons
+ * use for its comparison and column type, which reads the column straight
+ * from the tuple storage; a single row is evaluated as a batch of one.
+ * A parameter whose value turns out to be of a type they can't compare
+ * with sends the evaluation to the generic expression tree it came from.
+ *
+ * Equality comparisons of dictionary encoded VARCHAR columns are fused as
+ * well: the string compared with is looked up in the column's dictionary
+ * once per execution, and rows are compared on the address of their
+ * shared string.
+ */
+class FusedPredicateExpression : public AbstractExpression {
+  public:
+    /**
+     * Return a FusedPredicateExpression equivalent to predicate for tuples
+     * of schema, or NULL if predicate does not have the shape it handles.
+     * The generic predicate must outlive the returned expression.
+     * Columns that have a dictionary in dictionaries are dictionary encoded.
+     */
+    static FusedPredicateExpression* specialize(const AbstractExpression *predicate,
+                                                const TupleSchema *schema,
+                                                const std::vector<StringDictionary*> *dictionaries = NULL);
+
+    /**
+     * Look up the strings the dictionary encoded columns are compared
+     * with in the table's dictionaries, by column, once the parameters of
+     * an execution are set. Until then, and when a string can't be looked
+     * up, the evaluation goes to the generic expression.
+     */
+    void bindDictionaries(const std::vector<StringDictionary*> &dictionaries);
+
+    NValue eval(const TableTuple *tuple1, const TableTuple *tuple2) const;
+
+    int evalBatch(const TableTuple *tuples, int *selection, int count) const;
+
+    bool hasParameter() const;
+
+    bool collectTupleColumns(std::vector<int> &columns) const;
+
+    std::string debugInfo(const std::string &spacer) const;
+
+  private:
+    enum DictionaryKey {
+        // not looked up in the current dictionary
+        DICTIONARY_KEY_UNBOUND,
+        // m_constant is the address of the string or, if no row holds it, 1
+        DICTIONARY_KEY_BOUND,
+        DICTIONARY_KEY_NULL
+    };
+
+    struct Term {
+        int m_column;
+        /// Offset of the column in the tuple storage, header included.
+        uint32_t m_offset;
+        ValueType m_columnType;
+        /// The parameter compared with, or NULL for m_constant.
+        const NValue *m_parameter;
+        int64_t m_constant;
+        bool m_constantIsNull;
+        /// The comparison's batch kernel, from comparisonexpression.h
+        IntegerColumnSelector m_selector;
+        /// For a dictionary encoded column, the string constant compared with,
+        /// and how the string compared with was last looked up.
+        bool m_encoded;
+        NValue m_string;
+        DictionaryKey m_dictionaryKey;
+    };
+
+    FusedPredicateExpression(const AbstractExpression *generic);
+
+    bool addTerms(const AbstractExpression *expression, const TupleSchema *schema,
+                  const std::vector<StringDictionary*> *dictionaries);
+
+    /**
+     * Set key to the value the term compares with. Return false if the
+     * value is not one the term's functions can compare with.
+     */
+    bool termKey(const Term &term, int64_t &key, bool &isNull) const;
+
+    const AbstractExpression *m_generic;
+    std::vector<Term> m_terms;
+};
+
+}
+#endif
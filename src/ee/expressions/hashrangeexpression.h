@@ -62,6 +62,11 @@ public:
         return binarySearch(hash);
     }
 
+    bool collectTupleColumns(std::vector<int> &columns) const {
+        columns.push_back(value_idx);
+        return true;
+    }
+
     voltdb::NValue binarySearch(const int32_t hash) const {
         //The binary search blows up on only one range
         if (num_ranges == 1) {
@@ -90,6 +90,11 @@ public:
         return this->m_valueIdx;
     }
 
+    /** The slot the parameter's value is substituted into for each execution. */
+    const voltdb::NValue* getParameterSlot() const {
+        return m_paramValue;
+    }
+
   private:
     int m_valueIdx;
     voltdb::NValue* m_paramValue;
@@ -69,6 +69,10 @@ class TupleAddressExpression : public AbstractExpression {
         return ValueFactory::getAddressValue(tuple1->address());
     }
 
+    bool collectTupleColumns(std::vector<int> &columns) const {
+        return false;
+    }
+
     std::string debugInfo(const std::string &spacer) const {
         return spacer + "TupleAddressExpression\n";
     }
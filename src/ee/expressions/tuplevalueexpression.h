@@ -93,6 +93,16 @@ class TupleValueExpression : public AbstractExpression {
 
     int getColumnId() const {return this->value_idx;}
 
+    int getTupleId() const {return this->tuple_idx;}
+
+    bool collectTupleColumns(std::vector<int> &columns) const {
+        if (tuple_idx != 0) {
+            return false;
+        }
+        columns.push_back(value_idx);
+        return true;
+    }
+
   protected:
 
     const int tuple_idx;           // which tuple. defaults to tuple1
@@ -56,6 +56,16 @@ public:
         return false;
     }
 
+    virtual bool collectTupleColumns(std::vector<int> &columns) const
+    {
+        for (size_t i = 0; i < m_args.size(); i++) {
+            if (!m_args[i]->collectTupleColumns(columns)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     NValue eval(const TableTuple *tuple1, const TableTuple *tuple2) const
     {
         //TODO: Could make this vector a member, if the memory management implications
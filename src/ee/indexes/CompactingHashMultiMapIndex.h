@@ -78,6 +78,13 @@ class CompactingHashMultiMapIndex : public TableIndex
         return m_entries.insert(setKeyFromTuple(tuple), tuple->address());
     }
 
+    bool addEntries(const std::vector<TableTuple> &tuples)
+    {
+        // size the table for all of them up front rather than growing it as they go in
+        m_entries.reserve(tuples.size());
+        return TableIndex::addEntries(tuples);
+    }
+
     bool deleteEntry(const TableTuple *tuple)
     {
         ++m_deletes;
@@ -129,7 +136,7 @@ class CompactingHashMultiMapIndex : public TableIndex
             cursor.m_match.move(NULL);
             return false;
         }
-        cursor.m_match.move(const_cast<void*>(mapIter.value()));
+        moveToEntryTuple(cursor.m_match, mapIter.value());
         return true;
     }
 
@@ -144,7 +151,7 @@ class CompactingHashMultiMapIndex : public TableIndex
         if (mapIter.isEnd()) {
             cursor.m_match.move(NULL);
         } else {
-            cursor.m_match.move(const_cast<void*>(mapIter.value()));
+            moveToEntryTuple(cursor.m_match, mapIter.value());
         }
         return retval;
     }
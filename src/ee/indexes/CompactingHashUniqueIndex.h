@@ -77,6 +77,12 @@ class CompactingHashUniqueIndex : public TableIndex
         return m_entries.insert(setKeyFromTuple(tuple), tuple->address());
     }
 
+    bool addEntries(const std::vector<TableTuple> &tuples) {
+        // size the table for all of them up front rather than growing it as they go in
+        m_entries.reserve(tuples.size());
+        return TableIndex::addEntries(tuples);
+    }
+
     bool deleteEntry(const TableTuple *tuple) {
         ++m_deletes;
         return m_entries.erase(setKeyFromTuple(tuple));
@@ -125,7 +131,7 @@ class CompactingHashUniqueIndex : public TableIndex
             cursor.m_match.move(NULL);
             return false;
         }
-        cursor.m_match.move(const_cast<void*>(mapIter.value()));
+        moveToEntryTuple(cursor.m_match, mapIter.value());
 
         return true;
     }
@@ -141,7 +147,7 @@ class CompactingHashUniqueIndex : public TableIndex
         TableTuple retval(getTupleSchema());
         const MapIterator keyIter = findTuple(searchTuple);
         if ( ! keyIter.isEnd()) {
-            retval.move(const_cast<void*>(keyIter.value()));
+            moveToEntryTuple(retval, keyIter.value());
         }
         return retval;
     }
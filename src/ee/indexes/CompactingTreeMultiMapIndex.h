@@ -50,20 +50,23 @@
 #include <cassert>
 #include "indexes/tableindex.h"
 #include "common/tabletuple.h"
-#include "structures/CompactingMap.h"
+#include "indexes/SortedIndexEntries.h"
+#include "indexes/TreeIndexMapName.h"
 
 namespace voltdb {
 
 /**
- * Index implemented as a Binary Tree Multimap.
+ * Index implemented as a Binary Tree Multimap, or as a B+tree one
+ * when TreeMap is CompactingBTree.
  * @see TableIndex
  */
-template<typename KeyValuePair, bool hasRank>
+template<typename KeyValuePair, bool hasRank,
+         template<typename, typename, bool> class TreeMap = CompactingMap>
 class CompactingTreeMultiMapIndex : public TableIndex
 {
     typedef typename KeyValuePair::first_type KeyType;
     typedef typename KeyType::KeyComparator KeyComparator;
-    typedef CompactingMap<KeyValuePair, KeyComparator, hasRank> MapType;
+    typedef TreeMap<KeyValuePair, KeyComparator, hasRank> MapType;
     typedef typename MapType::iterator MapIterator;
     typedef std::pair<MapIterator, MapIterator> MapRange;
 
@@ -83,6 +86,21 @@ class CompactingTreeMultiMapIndex : public TableIndex
         return m_entries.insert(setKeyFromTuple(tuple), tuple->address());
     }
 
+    bool addEntries(const std::vector<TableTuple> &tuples)
+    {
+        // sort the entries first, then the map can take them in one pass
+        SortedIndexEntries<KeyValuePair, KeyComparator> entries(tuples.size());
+        for (size_t ii = 0; ii < tuples.size(); ++ii) {
+            entries.add(setKeyFromTuple(&tuples[ii]), tuples[ii].address());
+        }
+        entries.sort(m_cmp);
+        if ( ! m_entries.insertSorted(entries.begin(), entries.end())) {
+            return false;
+        }
+        m_inserts += static_cast<int>(tuples.size());
+        return true;
+    }
+
     bool deleteEntry(const TableTuple *tuple)
     {
         ++m_deletes;
@@ -133,7 +151,7 @@ class CompactingTreeMultiMapIndex : public TableIndex
             cursor.m_match.move(NULL);
             return false;
         }
-        cursor.m_match.move(const_cast<void*>(mapIter.value()));
+        moveToEntryTuple(cursor.m_match, mapIter.value());
 
         return true;
     }
@@ -204,7 +222,7 @@ class CompactingTreeMultiMapIndex : public TableIndex
         MapIterator &mapIter = castToIter(cursor);
 
         if (! mapIter.isEnd()) {
-            retval.move(const_cast<void*>(mapIter.value()));
+            moveToEntryTuple(retval, mapIter.value());
             if (cursor.m_forward) {
                 mapIter.moveNext();
             } else {
@@ -228,7 +246,7 @@ class CompactingTreeMultiMapIndex : public TableIndex
         if (mapIter.equals(mapEndIter)) {
             cursor.m_match.move(NULL);
         } else {
-            cursor.m_match.move(const_cast<void*>(mapIter.value()));
+            moveToEntryTuple(cursor.m_match, mapIter.value());
         }
         return retval;
     }
@@ -250,7 +268,7 @@ class CompactingTreeMultiMapIndex : public TableIndex
             cursor.m_match.move(NULL);
             return false;
         }
-        cursor.m_match.move(const_cast<void*>(mapIter.value()));
+        moveToEntryTuple(cursor.m_match, mapIter.value());
         return true;
     }
 
@@ -321,7 +339,7 @@ class CompactingTreeMultiMapIndex : public TableIndex
         MapIterator iter = m_entries.begin();
         while (!iter.isEnd()) {
             TableTuple retval(getTupleSchema());
-            retval.move(const_cast<void*>(iter.value()));
+            moveToEntryTuple(retval, iter.value());
             buffer << retval.debugNoHeader() << std::endl;
             iter.moveNext();
         }
@@ -329,7 +347,7 @@ class CompactingTreeMultiMapIndex : public TableIndex
         return (ret);
     }
 
-    std::string getTypeName() const { return "CompactingTreeMultiMapIndex"; };
+    std::string getTypeName() const { return TreeIndexMapName<TreeMap>::get() + "MultiMapIndex"; };
 
     MapIterator findKey(const TableTuple *searchKey) const {
         KeyType tempKey(searchKey);
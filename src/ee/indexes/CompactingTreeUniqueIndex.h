@@ -52,20 +52,23 @@
 #include "common/debuglog.h"
 #include "common/tabletuple.h"
 #include "indexes/tableindex.h"
-#include "structures/CompactingMap.h"
+#include "indexes/SortedIndexEntries.h"
+#include "indexes/TreeIndexMapName.h"
 
 namespace voltdb {
 
 /**
- * Index implemented as a Binary Tree Unique Map.
+ * Index implemented as a Binary Tree Unique Map, or as a B+tree one
+ * when TreeMap is CompactingBTree.
  * @see TableIndex
  */
-template<typename KeyValuePair, bool hasRank>
+template<typename KeyValuePair, bool hasRank,
+         template<typename, typename, bool> class TreeMap = CompactingMap>
 class CompactingTreeUniqueIndex : public TableIndex
 {
     typedef typename KeyValuePair::first_type KeyType;
     typedef typename KeyType::KeyComparator KeyComparator;
-    typedef CompactingMap<KeyValuePair, KeyComparator, hasRank> MapType;
+    typedef TreeMap<KeyValuePair, KeyComparator, hasRank> MapType;
     typedef typename MapType::iterator MapIterator;
 
     ~CompactingTreeUniqueIndex() {};
@@ -80,6 +83,21 @@ class CompactingTreeUniqueIndex : public TableIndex
         return m_entries.insert(setKeyFromTuple(tuple), tuple->address());
     }
 
+    bool addEntries(const std::vector<TableTuple> &tuples)
+    {
+        // sort the entries first, then the map can take them in one pass
+        SortedIndexEntries<KeyValuePair, KeyComparator> entries(tuples.size());
+        for (size_t ii = 0; ii < tuples.size(); ++ii) {
+            entries.add(setKeyFromTuple(&tuples[ii]), tuples[ii].address());
+        }
+        entries.sort(m_cmp);
+        if ( ! m_entries.insertSorted(entries.begin(), entries.end())) {
+            return false;
+        }
+        m_inserts += static_cast<int>(tuples.size());
+        return true;
+    }
+
     bool deleteEntry(const TableTuple *tuple)
     {
         ++m_deletes;
@@ -132,7 +150,7 @@ class CompactingTreeUniqueIndex : public TableIndex
             cursor.m_match.move(NULL);
             return false;
         }
-        cursor.m_match.move(const_cast<void*>(mapIter.value()));
+        moveToEntryTuple(cursor.m_match, mapIter.value());
         return true;
     }
 
@@ -205,7 +223,7 @@ class CompactingTreeUniqueIndex : public TableIndex
         MapIterator &mapIter = castToIter(cursor);
 
         if (! mapIter.isEnd()) {
-            retval.move(const_cast<void*>(mapIter.value()));
+            moveToEntryTuple(retval, mapIter.value());
             if (cursor.m_forward) {
                 mapIter.moveNext();
             } else {
@@ -238,7 +256,7 @@ class CompactingTreeUniqueIndex : public TableIndex
             return false;
         }
 
-        cursor.m_match.move(const_cast<void*>(mapIter.value()));
+        moveToEntryTuple(cursor.m_match, mapIter.value());
         return true;
     }
 
@@ -247,7 +265,7 @@ class CompactingTreeUniqueIndex : public TableIndex
         TableTuple retval(getTupleSchema());
         const MapIterator keyIter = findTuple(searchTuple);
         if ( ! keyIter.isEnd()) {
-            retval.move(const_cast<void*>(keyIter.value()));
+            moveToEntryTuple(retval, keyIter.value());
         }
         return retval;
     }
@@ -310,7 +328,7 @@ class CompactingTreeUniqueIndex : public TableIndex
         MapIterator iter = m_entries.begin();
         while (!iter.isEnd()) {
             TableTuple retval(getTupleSchema());
-            retval.move(const_cast<void*>(iter.value()));
+            moveToEntryTuple(retval, iter.value());
             buffer << retval.debugNoHeader() << std::endl;
             iter.moveNext();
         }
@@ -318,11 +336,11 @@ class CompactingTreeUniqueIndex : public TableIndex
         return (ret);
     }
 
-    std::string getTypeName() const { return "CompactingTreeUniqueIndex"; };
+    std::string getTypeName() const { return TreeIndexMapName<TreeMap>::get() + "UniqueIndex"; };
 
     virtual TableIndex *cloneEmptyNonCountingTreeIndex() const
     {
-        return new CompactingTreeUniqueIndex<KeyValuePair, false >(TupleSchema::createTupleSchema(getKeySchema()), m_scheme);
+        return new CompactingTreeUniqueIndex<KeyValuePair, false, TreeMap>(TupleSchema::createTupleSchema(getKeySchema()), m_scheme);
     }
 
 
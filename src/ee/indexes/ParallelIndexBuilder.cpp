@@ -0,0 +1,142 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include "indexes/ParallelIndexBuilder.h"
+#include "indexes/tableindex.h"
+#include "common/debuglog.h"
+#include "common/FatalException.hpp"
+
+namespace voltdb {
+
+void ParallelIndexBuilder::fill(TableIndex *index, const std::vector<TableTuple> &tuples)
+{
+    if ( ! index->addEntries(tuples)) {
+        // some tuples violate the index's uniqueness: add what can be added, as ever
+        for (size_t ii = 0; ii < tuples.size(); ++ii) {
+            index->addEntry(&tuples[ii]);
+        }
+    }
+}
+
+ParallelIndexBuilder::ParallelIndexBuilder(int maxHelperThreads)
+    : m_maxHelperThreads(maxHelperThreads), m_tuples(NULL), m_failed(false)
+{
+    pthread_mutex_init(&m_mutex, NULL);
+}
+
+ParallelIndexBuilder::~ParallelIndexBuilder()
+{
+    pthread_mutex_destroy(&m_mutex);
+}
+
+void ParallelIndexBuilder::build(const std::vector<TableIndex*> &indexes, const std::vector<TableTuple> &tuples)
+{
+    m_anyThread.clear();
+    m_callerOnly.clear();
+    for (size_t ii = indexes.size(); ii > 0; --ii) {
+        // taken from the back, so they are built roughly in the order given
+        TableIndex *index = indexes[ii - 1];
+        if (index->getIndexedExpressions().empty()) {
+            m_anyThread.push_back(index);
+        }
+        else {
+            m_callerOnly.push_back(index);
+        }
+    }
+    m_tuples = &tuples;
+    m_failed = false;
+
+    // the calling thread takes one of the indexes too
+    int helperCount = 0;
+    if (tuples.size() >= MIN_PARALLEL_TUPLES) {
+        const size_t forHelpers = m_anyThread.size() - (m_callerOnly.empty() && ! m_anyThread.empty() ? 1 : 0);
+        helperCount = static_cast<int>(std::min(static_cast<size_t>(std::max(m_maxHelperThreads, 0)), forHelpers));
+    }
+    std::vector<pthread_t> helpers;
+    for (int ii = 0; ii < helperCount; ++ii) {
+        pthread_t helper;
+        // if a thread can't be started, the others (or this one) build its share
+        if (pthread_create(&helper, NULL, helperMain, this) == 0) {
+            helpers.push_back(helper);
+        }
+        else {
+            VOLT_WARN("Failed to start an index build thread");
+        }
+    }
+
+    try {
+        buildPending(false);
+    }
+    catch (...) {
+        // let the helpers finish what they have, but take nothing more
+        pthread_mutex_lock(&m_mutex);
+        m_anyThread.clear();
+        pthread_mutex_unlock(&m_mutex);
+        for (size_t ii = 0; ii < helpers.size(); ++ii) {
+            pthread_join(helpers[ii], NULL);
+        }
+        throw;
+    }
+    for (size_t ii = 0; ii < helpers.size(); ++ii) {
+        pthread_join(helpers[ii], NULL);
+    }
+    m_tuples = NULL;
+    if (m_failed) {
+        throwFatalException("Failed to build an index on an index build thread");
+    }
+}
+
+void *ParallelIndexBuilder::helperMain(void *builder)
+{
+    ParallelIndexBuilder *self = static_cast<ParallelIndexBuilder*>(builder);
+    try {
+        self->buildPending(true);
+    }
+    catch (...) {
+        pthread_mutex_lock(&self->m_mutex);
+        self->m_failed = true;
+        pthread_mutex_unlock(&self->m_mutex);
+    }
+    return NULL;
+}
+
+void ParallelIndexBuilder::buildPending(bool onHelper)
+{
+    TableIndex *index;
+    while ((index = takeIndex(onHelper)) != NULL) {
+        fill(index, *m_tuples);
+    }
+}
+
+TableIndex *ParallelIndexBuilder::takeIndex(bool onHelper)
+{
+    TableIndex *index = NULL;
+    pthread_mutex_lock(&m_mutex);
+    if ( ! onHelper && ! m_callerOnly.empty()) {
+        index = m_callerOnly.back();
+        m_callerOnly.pop_back();
+    }
+    else if ( ! m_anyThread.empty() && ! (onHelper && m_failed)) {
+        index = m_anyThread.back();
+        m_anyThread.pop_back();
+    }
+    pthread_mutex_unlock(&m_mutex);
+    return index;
+}
+
+}
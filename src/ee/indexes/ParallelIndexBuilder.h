@@ -0,0 +1,80 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PARALLELINDEXBUILDER_H_
+#define PARALLELINDEXBUILDER_H_
+
+#include <vector>
+#include <pthread.h>
+#include "common/tabletuple.h"
+
+namespace voltdb {
+
+class TableIndex;
+
+/**
+ * Fills new indexes with the tuples of a table, building several indexes at
+ * once on a few helper threads while the calling thread builds its share.
+ * The calling thread waits for all of them, and each index ends up exactly
+ * as if it had been filled alone by fill().
+ *
+ * Only indexes on plain columns are given to helper threads. Keys of
+ * expression indexes are evaluated and allocated through the thread local
+ * pools of the site thread, so those indexes are always built by the
+ * calling thread.
+ */
+class ParallelIndexBuilder {
+public:
+    // Helper threads started for a build unless told otherwise.
+    static const int DEFAULT_HELPER_THREADS = 3;
+    // Tables smaller than this are not worth starting threads for.
+    static const size_t MIN_PARALLEL_TUPLES = 10000;
+
+    /**
+     * Add an entry to index for each of the tuples. If the index rejects
+     * them as a whole for violating uniqueness, add those it will take.
+     */
+    static void fill(TableIndex *index, const std::vector<TableTuple> &tuples);
+
+    /**
+     * Fill each of the indexes, using at most maxHelperThreads threads
+     * besides the calling one.
+     */
+    ParallelIndexBuilder(int maxHelperThreads = DEFAULT_HELPER_THREADS);
+    ~ParallelIndexBuilder();
+
+    void build(const std::vector<TableIndex*> &indexes, const std::vector<TableTuple> &tuples);
+
+private:
+    static void *helperMain(void *builder);
+    // Take indexes to build until none are left for this thread.
+    void buildPending(bool onHelper);
+    TableIndex *takeIndex(bool onHelper);
+
+    const int m_maxHelperThreads;
+    pthread_mutex_t m_mutex;
+    // indexes not yet taken, by who may build them
+    std::vector<TableIndex*> m_anyThread;
+    std::vector<TableIndex*> m_callerOnly;
+    const std::vector<TableTuple> *m_tuples;
+    // set if a helper thread's build threw
+    bool m_failed;
+};
+
+}
+
+#endif // PARALLELINDEXBUILDER_H_
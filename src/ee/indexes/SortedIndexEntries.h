@@ -0,0 +1,76 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SORTEDINDEXENTRIES_H_
+#define SORTEDINDEXENTRIES_H_
+
+#include <algorithm>
+#include <vector>
+
+namespace voltdb {
+
+/**
+ * The entries of a tree index for a batch of tuples, put in key order to
+ * be given to the map's insertSorted().
+ *
+ * The entries themselves never move once added: only pointers to them
+ * are sorted, so keys that own memory (GenericPersistentKey) are not
+ * copied around. Equal keys keep the order they were added in.
+ */
+template<typename KeyValuePair, typename KeyComparator>
+class SortedIndexEntries {
+    typedef typename KeyValuePair::first_type KeyType;
+    typedef std::vector<const KeyValuePair*> Order;
+
+    struct KeyLess {
+        const KeyComparator &m_cmp;
+        KeyLess(const KeyComparator &cmp) : m_cmp(cmp) {}
+        bool operator()(const KeyValuePair *lhs, const KeyValuePair *rhs) const {
+            return m_cmp(lhs->getKey(), rhs->getKey()) < 0;
+        }
+    };
+
+public:
+    typedef typename Order::const_iterator const_iterator;
+
+    SortedIndexEntries(size_t count) : m_entries(count) {
+        m_order.reserve(count);
+    }
+
+    void add(const KeyType &key, const void *value) {
+        KeyValuePair &entry = m_entries[m_order.size()];
+        // as in the maps, assignment takes over any memory the key owns
+        entry.setKey(key);
+        entry.setValue(value);
+        m_order.push_back(&entry);
+    }
+
+    void sort(const KeyComparator &cmp) {
+        std::stable_sort(m_order.begin(), m_order.end(), KeyLess(cmp));
+    }
+
+    const_iterator begin() const { return m_order.begin(); }
+    const_iterator end() const { return m_order.end(); }
+
+private:
+    std::vector<KeyValuePair> m_entries;
+    Order m_order;
+};
+
+}
+
+#endif // SORTEDINDEXENTRIES_H_
@@ -0,0 +1,48 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TREEINDEXMAPNAME_H_
+#define TREEINDEXMAPNAME_H_
+
+#include "structures/CompactingMap.h"
+#include "structures/CompactingBTree.h"
+
+#include <string>
+
+namespace voltdb {
+
+/**
+ * Names the map a tree index keeps its entries in, for the index's type name:
+ * a CompactingMap red-black tree by default, or a CompactingBTree for
+ * BTREE_INDEX indexes.
+ */
+template<template<typename, typename, bool> class TreeMap>
+struct TreeIndexMapName;
+
+template<>
+struct TreeIndexMapName<CompactingMap> {
+    static std::string get() { return "CompactingTree"; }
+};
+
+template<>
+struct TreeIndexMapName<CompactingBTree> {
+    static std::string get() { return "BTree"; }
+};
+
+}
+
+#endif // TREEINDEXMAPNAME_H_
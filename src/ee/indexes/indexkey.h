@@ -50,6 +50,7 @@
 #include "common/tabletuple.h"
 
 #include "expressions/abstractexpression.h"
+#include "storage/ColdBlockCompressor.h"
 
 #include <cassert>
 #include <iostream>
@@ -616,7 +617,9 @@ struct GenericEqualityChecker
     inline bool operator()(const GenericKey<keySize> &lhs, const GenericKey<keySize> &rhs) const {
         TableTuple lhTuple(m_keySchema); lhTuple.moveToReadOnlyTuple(reinterpret_cast<const void*>(&lhs));
         TableTuple rhTuple(m_keySchema); rhTuple.moveToReadOnlyTuple(reinterpret_cast<const void*>(&rhs));
-        return lhTuple.equalsNoSchemaCheck(rhTuple);
+        // compare, unlike equalsNoSchemaCheck, tells a NULL apart from a non-NULL value,
+        // which matters for the unrelated keys that share a hash bucket.
+        return lhTuple.compare(rhTuple) == VALUE_COMPARE_EQUAL;
     }
 private:
     const TupleSchema *m_keySchema;
@@ -642,6 +645,138 @@ private:
     const TupleSchema *m_keySchema;
 };
 
+/**
+ * The most bytes a NormalizedKey takes for a key of the schema, or 0
+ * if some column's type can't be normalized (see NValue::normalizeForKey).
+ */
+inline std::size_t normalizedKeySize(const TupleSchema *keySchema)
+{
+    std::size_t size = 0;
+    for (int ii = 0; ii < keySchema->columnCount(); ++ii) {
+        const TupleSchema::ColumnInfo *columnInfo = keySchema->getColumnInfo(ii);
+        switch (columnInfo->getVoltType()) {
+        case VALUE_TYPE_TINYINT:
+        case VALUE_TYPE_SMALLINT:
+        case VALUE_TYPE_INTEGER:
+        case VALUE_TYPE_BIGINT:
+        case VALUE_TYPE_TIMESTAMP:
+        case VALUE_TYPE_DECIMAL:
+            size += NValue::getTupleStorageSize(columnInfo->getVoltType());
+            break;
+        case VALUE_TYPE_DOUBLE:
+            size += 1 + sizeof(double);
+            break;
+        case VALUE_TYPE_VARCHAR: {
+            const std::size_t maxBytes = columnInfo->inBytes ?
+                    columnInfo->length : columnInfo->length * MAX_BYTES_PER_UTF8_CHARACTER;
+            size += 1 + maxBytes + 1 + sizeof(int32_t);
+            break;
+        }
+        case VALUE_TYPE_VARBINARY:
+            size += 1 + 2 * columnInfo->length + 2;
+            break;
+        default:
+            return 0;
+        }
+    }
+    return size;
+}
+
+template <std::size_t keySize> struct NormalizedComparator;
+
+/**
+ * Key object for tree indexes of columns of mixed types, holding the key's
+ * values normalized into a single string of bytes that compares with memcmp.
+ * The key holds copies of its strings rather than pointers to them.
+ * Only for keys of columns (not expressions) that normalizedKeySize() fits
+ * into keySize.
+ */
+template <std::size_t keySize>
+struct NormalizedKey
+{
+    typedef NormalizedComparator<keySize> KeyComparator;
+
+    static inline bool keyDependsOnTupleAddress() { return false; }
+    static inline bool keyUsesNonInlinedMemory() { return false; }
+
+    NormalizedKey() {
+        ::memset(data, 0, keySize);
+    }
+
+    NormalizedKey(const TableTuple *tuple) {
+        assert(tuple);
+        char *end = data;
+        const int columnCount = tuple->getSchema()->columnCount();
+        for (int ii = 0; ii < columnCount; ++ii) {
+            end = append(end, tuple->getNValue(ii));
+        }
+        ::memset(end, 0, data + keySize - end);
+    }
+
+    NormalizedKey(const TableTuple *tuple, const std::vector<int> &indices,
+                  const std::vector<AbstractExpression*> &indexed_expressions, const TupleSchema *keySchema) {
+        assert(tuple);
+        assert(indexed_expressions.size() == 0);
+        char *end = data;
+        const int columnCount = keySchema->columnCount();
+        for (int ii = 0; ii < columnCount; ++ii) {
+            end = append(end, tuple->getNValue(indices[ii]));
+        }
+        ::memset(end, 0, data + keySize - end);
+    }
+
+    char data[keySize];
+
+private:
+    /**
+     * Write the value's part of the key after end, unless it could take more
+     * bytes than are left. normalizedKeySize() leaves room for every value that
+     * fits its column, so only a string longer than its key column is refused.
+     */
+    char *append(char *end, const NValue &value) {
+        const ValueType type = ValuePeeker::peekValueType(value);
+        std::size_t size;
+        if (type == VALUE_TYPE_VARCHAR && ! value.isNull()) {
+            size = 1 + ValuePeeker::peekObjectLength_withoutNull(value) + 1 + sizeof(int32_t);
+        } else if (type == VALUE_TYPE_VARBINARY && ! value.isNull()) {
+            size = 1 + 2 * ValuePeeker::peekObjectLength_withoutNull(value) + 2;
+        } else if (type == VALUE_TYPE_VARCHAR || type == VALUE_TYPE_VARBINARY) {
+            size = 1;
+        } else if (type == VALUE_TYPE_DOUBLE) {
+            size = 1 + sizeof(double);
+        } else {
+            size = NValue::getTupleStorageSize(type);
+        }
+        if (size > static_cast<std::size_t>(data + keySize - end)) {
+            throw SQLException(SQLException::data_exception_string_data_length_mismatch,
+                               "Value is too long for its column of the index key");
+        }
+        return value.normalizeForKey(end);
+    }
+};
+
+/**
+ * Required by CompactingMap keyed by NormalizedKey<>
+ */
+template <std::size_t keySize>
+struct NormalizedComparator
+{
+    // Only as many bytes as the schema's keys can take are compared.
+    NormalizedComparator(const TupleSchema *keySchema) : m_size(normalizedKeySize(keySchema)) {
+        assert(m_size > 0 && m_size <= keySize);
+    }
+
+    inline int operator()(const NormalizedKey<keySize> &lhs, const NormalizedKey<keySize> &rhs) const {
+        const int diff = ::memcmp(lhs.data, rhs.data, m_size);
+        if (diff == 0) {
+            return VALUE_COMPARE_EQUAL;
+        }
+        return diff < 0 ? VALUE_COMPARE_LESSTHAN : VALUE_COMPARE_GREATERTHAN;
+    }
+private:
+    std::size_t m_size;
+};
+
 struct TupleKeyComparator;
 
 /*
@@ -708,6 +843,10 @@ struct TupleKey
 
     // Return a table tuple that is valid for comparison
     TableTuple getTupleForComparison() const {
+        if (m_columnIndices != NULL) {
+            // a persistent tuple, whose block may have gone cold
+            ColdBlockCompressor::makeResident(m_keyTuple);
+        }
         return TableTuple(static_cast<char*>(const_cast<void*>(m_keyTuple)), m_keyTupleSchema);
     }
 
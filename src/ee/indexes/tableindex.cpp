@@ -72,6 +72,19 @@ TableIndex::~TableIndex()
     }
 }
 
+bool TableIndex::addEntries(const std::vector<TableTuple> &tuples)
+{
+    for (size_t ii = 0; ii < tuples.size(); ++ii) {
+        if ( ! addEntry(&tuples[ii])) {
+            while (ii > 0) {
+                deleteEntry(&tuples[--ii]);
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
 std::string TableIndex::debug() const
 {
     std::ostringstream buffer;
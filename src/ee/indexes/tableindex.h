@@ -56,6 +56,7 @@
 #include "common/tabletuple.h"
 #include "common/TupleSchema.h"
 #include "indexes/IndexStats.h"
+#include "storage/ColdBlockCompressor.h"
 #include "common/ThreadLocalPool.h"
 
 namespace voltdb {
@@ -211,6 +212,13 @@ public:
      */
     virtual bool addEntry(const TableTuple *tuple) = 0;
 
+    /**
+     * adds an index entry for each of the tuples, faster than adding
+     * them one at a time when there are many. Returns false, leaving
+     * the index as it was, if any of them violates uniqueness.
+     */
+    virtual bool addEntries(const std::vector<TableTuple> &tuples);
+
     /**
      * removes the index entry linked to given value (and tuple
      * pointer, if it's non-unique index).
@@ -483,6 +491,16 @@ protected:
 
     TableIndex(const TupleSchema *keySchema, const TableIndexScheme &scheme);
 
+    /**
+     * Point tuple at the table tuple of an entry, bringing its block back
+     * first if it was compressed as cold.
+     */
+    static void moveToEntryTuple(TableTuple &tuple, const void *address)
+    {
+        ColdBlockCompressor::makeResident(address);
+        tuple.move(const_cast<void*>(address));
+    }
+
     TableIndexScheme m_scheme;
     const TupleSchema * const m_keySchema;
     const std::string m_id;
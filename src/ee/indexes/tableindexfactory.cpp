@@ -56,6 +56,7 @@
 #include "indexes/CompactingTreeMultiMapIndex.h"
 #include "indexes/CompactingHashUniqueIndex.h"
 #include "indexes/CompactingHashMultiMapIndex.h"
+#include "indexes/OpenHashUniqueIndex.h"
 
 namespace voltdb {
 
@@ -64,17 +65,35 @@ class TableIndexPicker
     template <class TKeyType>
     TableIndex *getInstanceForKeyType() const
     {
-        if (m_scheme.unique) {
-            if (m_type != BALANCED_TREE_INDEX) {
+        if (m_type == HASH_TABLE_INDEX) {
+            if (m_scheme.unique) {
                 return new CompactingHashUniqueIndex<TKeyType >(m_keySchema, m_scheme);
+            }
+            return new CompactingHashMultiMapIndex<TKeyType >(m_keySchema, m_scheme);
+        }
+        return getTreeInstanceForKeyType<TKeyType>();
+    }
+
+    template <class TKeyType>
+    TableIndex *getTreeInstanceForKeyType() const
+    {
+        if (m_scheme.unique) {
+            if (m_type == BTREE_INDEX) {
+                if (m_scheme.countable) {
+                    return new CompactingTreeUniqueIndex<NormalKeyValuePair<TKeyType>, true, CompactingBTree>(m_keySchema, m_scheme);
+                }
+                return new CompactingTreeUniqueIndex<NormalKeyValuePair<TKeyType>, false, CompactingBTree>(m_keySchema, m_scheme);
             } else if (m_scheme.countable) {
                 return new CompactingTreeUniqueIndex<NormalKeyValuePair<TKeyType>, true>(m_keySchema, m_scheme);
             } else {
                 return new CompactingTreeUniqueIndex<NormalKeyValuePair<TKeyType>, false>(m_keySchema, m_scheme);
             }
         } else {
-            if (m_type != BALANCED_TREE_INDEX) {
-                return new CompactingHashMultiMapIndex<TKeyType >(m_keySchema, m_scheme);
+            if (m_type == BTREE_INDEX) {
+                if (m_scheme.countable) {
+                    return new CompactingTreeMultiMapIndex<PointerKeyValuePair<TKeyType>, true, CompactingBTree>(m_keySchema, m_scheme);
+                }
+                return new CompactingTreeMultiMapIndex<PointerKeyValuePair<TKeyType>, false, CompactingBTree>(m_keySchema, m_scheme);
             } else if (m_scheme.countable) {
                 return new CompactingTreeMultiMapIndex<PointerKeyValuePair<TKeyType>, true>(m_keySchema, m_scheme);
             } else {
@@ -94,13 +113,6 @@ class TableIndexPicker
             // the number of 8-byte uint64's required to store KeySize packed bytes.
             return getInstanceForKeyType<IntsKey<(KeySize-1)/8 + 1> >();
         }
-        // Generic Key
-        if (m_type == HASH_TABLE_INDEX) {
-            VOLT_INFO("Producing a tree index for %s: "
-                      "hash index not currently supported for this index key.\n",
-                      m_scheme.name.c_str());
-            m_type = BALANCED_TREE_INDEX;
-        }
         // If any indexed expression value can not either be stored "inline" within a (GenericKey) key tuple
         // or specifically in a non-inlined object shared with the base table (because it is a simple column value),
         // then the GenericKey will have to reference and maintain its own persistent non-inline storage.
@@ -112,35 +124,63 @@ class TableIndexPicker
         return getInstanceForKeyType<GenericPersistentKey<KeySize> >();
     }
 
-    template <int ColCount>
-    TableIndex *getInstanceForHashedGenericColumns() const
+    template <std::size_t KeySize>
+    TableIndex *getNormalizedInstanceIfKeyFits()
     {
-        if (m_scheme.unique) {
-            return new CompactingHashUniqueIndex<GenericKey<ColCount> >(m_keySchema, m_scheme);
-        } else {
-            return new CompactingHashMultiMapIndex<GenericKey<ColCount> >(m_keySchema, m_scheme);
+        if (m_normalizedKeySize == 0 || m_normalizedKeySize > KeySize) {
+            return NULL;
         }
+        return getTreeInstanceForKeyType<NormalizedKey<KeySize> >();
     }
 
+    bool hasMixedColumnTypes() const
+    {
+        for (int ii = 1; ii < m_keySchema->columnCount(); ++ii) {
+            if (m_keySchema->columnType(ii) != m_keySchema->columnType(0)) {
+                return true;
+            }
+        }
+        return false;
+    }
 
 public:
 
     TableIndex *getInstance()
     {
         TableIndex *result;
-/*
-        if ((!m_intsOnly) && (m_type == HASH_TABLE_INDEX)) {
-            switch (colCount) {
-                case 1: return getInstanceForHashedGenericColumns<1>();
-                case 2: return getInstanceForHashedGenericColumns<2>();
-                case 3: return getInstanceForHashedGenericColumns<3>();
-                case 4: return getInstanceForHashedGenericColumns<4>();
-                case 5: return getInstanceForHashedGenericColumns<5>();
-                case 6: return getInstanceForHashedGenericColumns<6>();
-                default: throwFatalException( "We currently only support up to 6 column generic hash indexes..." );
+
+        if (m_type == OPEN_HASH_TABLE_INDEX) {
+            if (m_scheme.unique && m_intsOnly && m_keySize <= 8) {
+                return new OpenHashUniqueIndex<IntsKey<1> >(m_keySchema, m_scheme);
+            }
+            if (m_scheme.unique && m_intsOnly && m_keySize <= 16) {
+                return new OpenHashUniqueIndex<IntsKey<2> >(m_keySchema, m_scheme);
+            }
+            VOLT_INFO("Producing a chained hash index for %s: "
+                      "open addressing hash index only supported for unique keys of up to 16 bytes of integers.\n",
+                      m_scheme.name.c_str());
+            m_type = HASH_TABLE_INDEX;
+        }
+
+        // Tree indexes on columns of mixed types compare keys normalized into bytes
+        // with memcmp, unless the keys are integers or too big to normalize.
+        if (m_type != HASH_TABLE_INDEX && ! m_intsOnly && hasMixedColumnTypes()) {
+            if ((result = getNormalizedInstanceIfKeyFits<16>())) {
+                return result;
+            }
+            if ((result = getNormalizedInstanceIfKeyFits<24>())) {
+                return result;
+            }
+            if ((result = getNormalizedInstanceIfKeyFits<32>())) {
+                return result;
+            }
+            if ((result = getNormalizedInstanceIfKeyFits<48>())) {
+                return result;
+            }
+            if ((result = getNormalizedInstanceIfKeyFits<64>())) {
+                return result;
             }
         }
-*/
 
         if ((result = getInstanceIfKeyFits<4>())) {
             return result;
@@ -181,6 +221,24 @@ public:
             return result;
         }
 
+        // TupleKey can't be hashed, so keys this wide are only ever indexed by a tree.
+        if (m_type == HASH_TABLE_INDEX) {
+            VOLT_INFO("Producing a tree index for %s: "
+                      "hash index not currently supported for this index key.\n",
+                      m_scheme.name.c_str());
+        }
+        if (m_type == BTREE_INDEX) {
+            if (m_scheme.unique) {
+                if (m_scheme.countable) {
+                    return new CompactingTreeUniqueIndex<NormalKeyValuePair<TupleKey>, true, CompactingBTree>(m_keySchema, m_scheme);
+                }
+                return new CompactingTreeUniqueIndex<NormalKeyValuePair<TupleKey>, false, CompactingBTree>(m_keySchema, m_scheme);
+            }
+            if (m_scheme.countable) {
+                return new CompactingTreeMultiMapIndex<PointerKeyValuePair<TupleKey>, true, CompactingBTree>(m_keySchema, m_scheme);
+            }
+            return new CompactingTreeMultiMapIndex<PointerKeyValuePair<TupleKey>, false, CompactingBTree>(m_keySchema, m_scheme);
+        }
         if (m_scheme.unique) {
             if (m_scheme.countable) {
                 return new CompactingTreeUniqueIndex<NormalKeyValuePair<TupleKey>, true >(m_keySchema, m_scheme);
@@ -202,6 +260,7 @@ public:
         m_keySize(keySchema->tupleLength()),
         m_intsOnly(intsOnly),
         m_inlinesOrColumnsOnly(inlinesOrColumnsOnly),
+        m_normalizedKeySize(scheme.indexedExpressions.empty() ? normalizedKeySize(keySchema) : 0),
         m_type(scheme.type)
     {}
 
@@ -211,6 +270,8 @@ private:
     const int m_keySize;
     bool m_intsOnly;
     bool m_inlinesOrColumnsOnly;
+    // 0 if the keys can't be normalized
+    const std::size_t m_normalizedKeySize;
     TableIndexType m_type;
 };
 
@@ -58,14 +58,28 @@ PlanNodeType DistinctPlanNode::getPlanNodeType() const { return PLAN_NODE_TYPE_D
 std::string DistinctPlanNode::debugInfo(const std::string &spacer) const
 {
     std::ostringstream buffer;
-    buffer << spacer << "DistinctExpression[" << m_distinctExpression->debug() << "]\n";
+    if (m_distinctExpression != NULL) {
+        buffer << spacer << "DistinctExpression[" << m_distinctExpression->debug() << "]\n";
+    }
+    else {
+        buffer << spacer << "DistinctExpressions[";
+        for (int ii = 0; ii < m_distinctExpressions.size(); ii++) {
+            buffer << spacer << m_distinctExpressions[ii]->debug(spacer);
+        }
+        buffer << "]\n";
+    }
     return buffer.str();
 }
 
 void DistinctPlanNode::loadFromJSONObject(PlannerDomValue obj)
 {
-    PlannerDomValue value = obj.valueForKey("DISTINCT_EXPRESSION");
-    m_distinctExpression = AbstractExpression::buildExpressionTree(value);
+    m_distinctExpression = loadExpressionFromJSONObject("DISTINCT_EXPRESSION", obj);
+    m_distinctExpressions.loadExpressionArrayFromJSONObject("DISTINCT_EXPRESSIONS", obj);
+    if ((m_distinctExpression == NULL) == m_distinctExpressions.empty()) {
+        throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                      "DistinctPlanNode::loadFromJSONObject:"
+                                      " Expected either DISTINCT_EXPRESSION or DISTINCT_EXPRESSIONS.");
+    }
 }
 
 } // namespace voltdb
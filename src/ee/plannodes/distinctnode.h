@@ -52,16 +52,20 @@ namespace voltdb {
 class DistinctPlanNode : public AbstractPlanNode
 {
 public:
-    DistinctPlanNode() { }
+    DistinctPlanNode() : m_distinctExpression(NULL) { }
     ~DistinctPlanNode();
     PlanNodeType getPlanNodeType() const;
     std::string debugInfo(const std::string& spacer) const;
 
+    /** The expression to de-duplicate on, or NULL for a DISTINCT on several expressions */
     AbstractExpression* getDistinctExpression() const { return m_distinctExpression; }
+    /** The expressions of a DISTINCT on several of them, empty if there is just one */
+    const std::vector<AbstractExpression*>& getDistinctExpressions() const { return m_distinctExpressions; }
 
 protected:
     void loadFromJSONObject(PlannerDomValue obj);
     AbstractExpression* m_distinctExpression;
+    OwningExpressionVector m_distinctExpressions;
 };
 
 } // namespace voltdb
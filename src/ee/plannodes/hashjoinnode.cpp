@@ -0,0 +1,57 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hashjoinnode.h"
+
+#include "common/SerializableEEException.h"
+#include "expressions/abstractexpression.h"
+
+#include <sstream>
+
+namespace voltdb {
+
+HashJoinPlanNode::~HashJoinPlanNode() { }
+
+PlanNodeType HashJoinPlanNode::getPlanNodeType() const { return PLAN_NODE_TYPE_HASHJOIN; }
+
+std::string HashJoinPlanNode::debugInfo(const std::string& spacer) const
+{
+    std::ostringstream buffer;
+    buffer << AbstractJoinPlanNode::debugInfo(spacer);
+    buffer << spacer << "HashKeys[" << m_outerHashKeys.size() << "]\n";
+    for (int ctr = 0, cnt = (int) m_outerHashKeys.size(); ctr < cnt; ctr++) {
+        buffer << spacer << "Outer Key\n" << m_outerHashKeys[ctr]->debug(spacer);
+        buffer << spacer << "Inner Key\n" << m_innerHashKeys[ctr]->debug(spacer);
+    }
+    return buffer.str();
+}
+
+void HashJoinPlanNode::loadFromJSONObject(PlannerDomValue obj)
+{
+    AbstractJoinPlanNode::loadFromJSONObject(obj);
+
+    m_outerHashKeys.loadExpressionArrayFromJSONObject("OUTER_HASH_KEYS", obj);
+    m_innerHashKeys.loadExpressionArrayFromJSONObject("INNER_HASH_KEYS", obj);
+
+    if (m_outerHashKeys.empty() || m_outerHashKeys.size() != m_innerHashKeys.size()) {
+        throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                      "HashJoinPlanNode::loadFromJSONObject:"
+                                      " Missing or mismatched outer and inner hash keys.");
+    }
+}
+
+} // namespace voltdb
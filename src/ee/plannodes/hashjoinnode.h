@@ -0,0 +1,51 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HSTOREHASHJOINNODE_H
+#define HSTOREHASHJOINNODE_H
+
+#include "abstractjoinnode.h"
+
+namespace voltdb {
+
+/**
+ * Equi-join of two intermediate results through an in-memory hash table.
+ * The OUTER_HASH_KEYS and INNER_HASH_KEYS arrays are pairwise equal-length
+ * lists of expressions over the outer (TABLE_IDX 0) and inner (TABLE_IDX 1)
+ * input. Any residual join condition remains in the join predicate.
+ */
+class HashJoinPlanNode : public AbstractJoinPlanNode
+{
+public:
+    HashJoinPlanNode() { }
+    ~HashJoinPlanNode();
+    PlanNodeType getPlanNodeType() const;
+    std::string debugInfo(const std::string& spacer) const;
+
+    const std::vector<AbstractExpression*>& getOuterHashKeys() const { return m_outerHashKeys; }
+    const std::vector<AbstractExpression*>& getInnerHashKeys() const { return m_innerHashKeys; }
+
+protected:
+    void loadFromJSONObject(PlannerDomValue obj);
+
+    OwningExpressionVector m_outerHashKeys;
+    OwningExpressionVector m_innerHashKeys;
+};
+
+} // namespace voltdb
+
+#endif
@@ -0,0 +1,82 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mergejoinnode.h"
+
+#include "common/SerializableEEException.h"
+#include "expressions/abstractexpression.h"
+#include "plannodes/indexscannode.h"
+
+#include <sstream>
+
+namespace voltdb {
+
+MergeJoinPlanNode::~MergeJoinPlanNode() { }
+
+PlanNodeType MergeJoinPlanNode::getPlanNodeType() const { return PLAN_NODE_TYPE_MERGEJOIN; }
+
+IndexScanPlanNode* MergeJoinPlanNode::getOuterIndexScan() const
+{
+    return static_cast<IndexScanPlanNode*>(m_outerIndexScan.get());
+}
+
+IndexScanPlanNode* MergeJoinPlanNode::getInnerIndexScan() const
+{
+    return static_cast<IndexScanPlanNode*>(getInlinePlanNode(PLAN_NODE_TYPE_INDEXSCAN));
+}
+
+std::string MergeJoinPlanNode::debugInfo(const std::string& spacer) const
+{
+    std::ostringstream buffer;
+    buffer << AbstractJoinPlanNode::debugInfo(spacer);
+    buffer << spacer << "Outer Index Scan\n" << m_outerIndexScan->debug(spacer + "  ");
+    buffer << spacer << "JoinKeys[" << m_outerJoinKeys.size() << "]\n";
+    for (int ctr = 0, cnt = (int) m_outerJoinKeys.size(); ctr < cnt; ctr++) {
+        buffer << spacer << "Outer Key\n" << m_outerJoinKeys[ctr]->debug(spacer);
+        buffer << spacer << "Inner Key\n" << m_innerJoinKeys[ctr]->debug(spacer);
+    }
+    return buffer.str();
+}
+
+void MergeJoinPlanNode::loadFromJSONObject(PlannerDomValue obj)
+{
+    AbstractJoinPlanNode::loadFromJSONObject(obj);
+
+    if ( ! obj.hasNonNullKey("OUTER_INDEX_SCAN")) {
+        throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                      "MergeJoinPlanNode::loadFromJSONObject:"
+                                      " Missing outer index scan.");
+    }
+    m_outerIndexScan.reset(AbstractPlanNode::fromJSONObject(obj.valueForKey("OUTER_INDEX_SCAN")));
+    if (m_outerIndexScan->getPlanNodeType() != PLAN_NODE_TYPE_INDEXSCAN ||
+        getInlinePlanNode(PLAN_NODE_TYPE_INDEXSCAN) == NULL) {
+        throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                      "MergeJoinPlanNode::loadFromJSONObject:"
+                                      " Both join inputs must be index scans.");
+    }
+
+    m_outerJoinKeys.loadExpressionArrayFromJSONObject("OUTER_JOIN_KEYS", obj);
+    m_innerJoinKeys.loadExpressionArrayFromJSONObject("INNER_JOIN_KEYS", obj);
+
+    if (m_outerJoinKeys.empty() || m_outerJoinKeys.size() != m_innerJoinKeys.size()) {
+        throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                      "MergeJoinPlanNode::loadFromJSONObject:"
+                                      " Missing or mismatched outer and inner join keys.");
+    }
+}
+
+} // namespace voltdb
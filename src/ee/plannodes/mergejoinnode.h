@@ -0,0 +1,60 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HSTOREMERGEJOINNODE_H
+#define HSTOREMERGEJOINNODE_H
+
+#include "abstractjoinnode.h"
+
+namespace voltdb {
+
+class IndexScanPlanNode;
+
+/**
+ * Equi-join of two persistent tables that are both read in join key order
+ * through a tree index. The inner scan is the inline INDEXSCAN node, as for
+ * NestLoopIndexPlanNode; the outer scan is serialized as OUTER_INDEX_SCAN.
+ * OUTER_JOIN_KEYS and INNER_JOIN_KEYS are pairwise equal-length lists of
+ * expressions over the outer (TABLE_IDX 0) and inner (TABLE_IDX 1) tuple
+ * whose values each index delivers in ascending order.
+ */
+class MergeJoinPlanNode : public AbstractJoinPlanNode
+{
+public:
+    MergeJoinPlanNode() { }
+    ~MergeJoinPlanNode();
+    PlanNodeType getPlanNodeType() const;
+    std::string debugInfo(const std::string& spacer) const;
+
+    IndexScanPlanNode* getOuterIndexScan() const;
+    IndexScanPlanNode* getInnerIndexScan() const;
+
+    const std::vector<AbstractExpression*>& getOuterJoinKeys() const { return m_outerJoinKeys; }
+    const std::vector<AbstractExpression*>& getInnerJoinKeys() const { return m_innerJoinKeys; }
+
+protected:
+    void loadFromJSONObject(PlannerDomValue obj);
+
+    boost::scoped_ptr<AbstractPlanNode> m_outerIndexScan;
+
+    OwningExpressionVector m_outerJoinKeys;
+    OwningExpressionVector m_innerJoinKeys;
+};
+
+} // namespace voltdb
+
+#endif
@@ -19,6 +19,7 @@
 #include "common/ids.h"
 #include "common/tabletuple.h"
 #include "common/TupleSchema.h"
+#include "common/StringStorageStats.h"
 #include "storage/PersistentTableStats.h"
 #include "storage/tablefactory.h"
 #include "storage/tableiterator.h"
@@ -49,6 +50,10 @@ namespace
             {
                 return IndexStats::generateEmptyIndexStatsTable();
             }
+        case STATISTICS_SELECTOR_TYPE_STRING_STORAGE:
+            {
+                return StringStorageStats::generateEmptyStringStorageStatsTable();
+            }
         default:
             {
                 throwFatalException("Attempted to get unsupported stats type");
@@ -0,0 +1,128 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "storage/ColdBlockCompressor.h"
+#include "storage/TupleBlock.h"
+#include <pthread.h>
+#include <map>
+
+namespace voltdb {
+
+volatile int32_t ColdBlockCompressor::s_compressedBlocks = 0;
+
+namespace {
+
+struct SiteState {
+    ColdBlockCompressor::Stats stats;
+    // compressed blocks by the address of their storage
+    std::map<const char*, TupleBlock*> blocks;
+    std::vector<char> scratch;
+};
+
+pthread_key_t siteStateKey;
+pthread_once_t siteStateKeyOnce = PTHREAD_ONCE_INIT;
+
+void deleteSiteState(void *state) {
+    delete static_cast<SiteState*>(state);
+}
+
+void createSiteStateKey() {
+    (void)pthread_key_create(&siteStateKey, deleteSiteState);
+}
+
+SiteState *findSiteState() {
+    (void)pthread_once(&siteStateKeyOnce, createSiteStateKey);
+    return static_cast<SiteState*>(pthread_getspecific(siteStateKey));
+}
+
+SiteState *getSiteState() {
+    SiteState *state = findSiteState();
+    if (state == NULL) {
+        state = new SiteState();
+        pthread_setspecific(siteStateKey, state);
+    }
+    return state;
+}
+
+void forgetBlock(SiteState *state, TupleBlock *block, std::size_t compressedBytes, std::size_t uncompressedBytes) {
+    state->blocks.erase(block->address());
+    state->stats.compressedBlocks--;
+    state->stats.compressedBytes -= compressedBytes;
+    state->stats.uncompressedBytes -= uncompressedBytes;
+}
+
+}
+
+void ColdBlockCompressor::makeResidentSlow(const void *address) {
+    SiteState *state = findSiteState();
+    if (state == NULL || state->blocks.empty()) {
+        return;
+    }
+    const char *tuple = static_cast<const char*>(address);
+    std::map<const char*, TupleBlock*>::iterator found = state->blocks.upper_bound(tuple);
+    if (found == state->blocks.begin()) {
+        return;
+    }
+    --found;
+    TupleBlock *block = found->second;
+    if (tuple < block->address() + block->allocationSize()) {
+        block->makeResident();
+    }
+}
+
+void ColdBlockCompressor::blockCompressed(TupleBlock *block, std::size_t compressedBytes,
+                                          std::size_t uncompressedBytes) {
+    SiteState *state = getSiteState();
+    state->blocks[block->address()] = block;
+    state->stats.compressedBlocks++;
+    state->stats.compressedBytes += compressedBytes;
+    state->stats.uncompressedBytes += uncompressedBytes;
+    state->stats.compressions++;
+    __sync_fetch_and_add(&s_compressedBlocks, 1);
+}
+
+void ColdBlockCompressor::blockDecompressed(TupleBlock *block, std::size_t compressedBytes,
+                                            std::size_t uncompressedBytes) {
+    SiteState *state = getSiteState();
+    forgetBlock(state, block, compressedBytes, uncompressedBytes);
+    state->stats.decompressions++;
+    __sync_fetch_and_sub(&s_compressedBlocks, 1);
+}
+
+void ColdBlockCompressor::blockReleased(TupleBlock *block, std::size_t compressedBytes,
+                                        std::size_t uncompressedBytes) {
+    forgetBlock(getSiteState(), block, compressedBytes, uncompressedBytes);
+    __sync_fetch_and_sub(&s_compressedBlocks, 1);
+}
+
+void ColdBlockCompressor::compressionRejected() {
+    getSiteState()->stats.rejections++;
+}
+
+void ColdBlockCompressor::countResidentHits(int64_t hits) {
+    getSiteState()->stats.residentHits += hits;
+}
+
+std::vector<char> &ColdBlockCompressor::scratchBuffer() {
+    return getSiteState()->scratch;
+}
+
+ColdBlockCompressor::Stats ColdBlockCompressor::getStats() {
+    SiteState *state = findSiteState();
+    return state == NULL ? Stats() : state->stats;
+}
+
+}
@@ -0,0 +1,99 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COLDBLOCKCOMPRESSOR_H_
+#define COLDBLOCKCOMPRESSOR_H_
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+namespace voltdb {
+
+class TupleBlock;
+
+/**
+ * Keeps account of the persistent table blocks an engine holds compressed
+ * because they went cold (see PersistentTable::compressColdBlocks), so that
+ * the address of a tuple found through an index can be traced back to its
+ * block and the block brought back before the tuple is read.
+ *
+ * The state is kept per thread, so per engine; only the count of
+ * compressed blocks that makeResident() checks is shared by the process.
+ * A compressed block must be brought back or released on the thread of
+ * the engine that compressed it. The table stats report the compressed
+ * blocks of each table.
+ */
+class ColdBlockCompressor {
+public:
+    struct Stats {
+        Stats() : compressedBlocks(0), compressedBytes(0), uncompressedBytes(0),
+                  compressions(0), decompressions(0), rejections(0), residentHits(0) {}
+        // blocks held compressed now
+        int64_t compressedBlocks;
+        // bytes of compressed tuples held for them
+        int64_t compressedBytes;
+        // bytes of tuple storage those stand for
+        int64_t uncompressedBytes;
+        // blocks compressed and brought back since the engine started
+        int64_t compressions;
+        int64_t decompressions;
+        // cold blocks left as they were because they wouldn't shrink enough
+        int64_t rejections;
+        // accesses to blocks that found them resident
+        int64_t residentHits;
+
+        /** The share of block accesses that didn't have to decompress */
+        double hitRate() const {
+            const int64_t accesses = residentHits + decompressions;
+            return accesses == 0 ? 1.0 : static_cast<double>(residentHits) / static_cast<double>(accesses);
+        }
+    };
+
+    /**
+     * Bring back the block of the tuple at address if it is compressed.
+     * Free unless some engine of the process holds compressed blocks.
+     */
+    static inline void makeResident(const void *address) {
+        if (s_compressedBlocks != 0) {
+            makeResidentSlow(address);
+        }
+    }
+
+    static void blockCompressed(TupleBlock *block, std::size_t compressedBytes, std::size_t uncompressedBytes);
+    static void blockDecompressed(TupleBlock *block, std::size_t compressedBytes, std::size_t uncompressedBytes);
+    /** A compressed block was freed without being brought back */
+    static void blockReleased(TupleBlock *block, std::size_t compressedBytes, std::size_t uncompressedBytes);
+    static void compressionRejected();
+    static void countResidentHits(int64_t hits);
+
+    /** A buffer of the calling thread's engine to compress blocks into */
+    static std::vector<char> &scratchBuffer();
+
+    /** The counters of the calling thread's engine */
+    static Stats getStats();
+
+private:
+    static void makeResidentSlow(const void *address);
+
+    // compressed blocks of all the engines of the process
+    static volatile int32_t s_compressedBlocks;
+};
+
+}
+
+#endif /* COLDBLOCKCOMPRESSOR_H_ */
@@ -36,6 +36,7 @@ CopyOnWriteIterator::CopyOnWriteIterator(
         m_surgeon->snapshotFinishedScanningBlock(m_currentBlock, m_blockIterator.data());
         m_location = m_blockIterator.key();
         m_currentBlock = m_blockIterator.data();
+        m_currentBlock->makeResident();
         m_blockIterator++;
     }
     m_blockOffset = 0;
@@ -61,6 +62,7 @@ bool CopyOnWriteIterator::next(TableTuple &out) {
 
             m_location = m_blockIterator.key();
             m_currentBlock = m_blockIterator.data();
+            m_currentBlock->makeResident();
             assert(m_currentBlock->address() == m_location);
             m_blockOffset = 0;
 
@@ -109,6 +111,7 @@ int64_t CopyOnWriteIterator::countRemaining() const {
     TBPtr currentBlock(pcurrentBlock);
     TBMapI blockIterator = m_blockIterator;
     int64_t count = 0;
+    currentBlock->makeResident();
     while (true) {
         if (blockOffset >= currentBlock->unusedTupleBoundry()) {
             if (blockIterator == m_end) {
@@ -116,6 +119,7 @@ int64_t CopyOnWriteIterator::countRemaining() const {
             }
             location = blockIterator.key();
             currentBlock = blockIterator.data();
+            currentBlock->makeResident();
             assert(currentBlock->address() == location);
             blockOffset = 0;
             blockIterator++;
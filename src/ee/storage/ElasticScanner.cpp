@@ -53,6 +53,7 @@ bool ElasticScanner::continueScan() {
                 // Shift to the next block.
                 m_tuplePtr = m_blockIterator.key();
                 m_currentBlockPtr = m_blockIterator.data();
+                m_currentBlockPtr->makeResident();
                 m_scannedBlocks.insert(m_currentBlockPtr);
                 assert(m_currentBlockPtr->address() == m_tuplePtr);
                 m_blockIterator.data() = TBPtr();
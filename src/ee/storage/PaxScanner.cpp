@@ -0,0 +1,107 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "storage/PaxScanner.h"
+#include "storage/persistenttable.h"
+#include "common/TupleSchema.h"
+#include "common/tabletuple.h"
+
+namespace voltdb
+{
+
+PaxScanner::PaxScanner(PersistentTable &table, const std::vector<int> &columns) :
+    m_tupleLength(table.getTupleLength()),
+    m_blockIterator(table.m_data.begin()),
+    m_blockEnd(table.m_data.end()),
+    m_currentBlock(NULL),
+    m_slotCount(0),
+    m_slot(0)
+{
+    assert(table.isPaxLayout());
+    assert(canScan(table.schema(), columns));
+    table.refreshPaxMiniPages();
+    const TupleSchema *schema = table.schema();
+    for (int ii = 0; ii < columns.size(); ii++) {
+        ScannedColumn column;
+        column.m_index = columns[ii];
+        // The header is part of the row but not of the schema's offsets.
+        column.m_offset = TUPLE_HEADER_SIZE + schema->getColumnInfo(columns[ii])->offset;
+        column.m_width = schema->getColumnInfo(columns[ii] + 1)->offset -
+                         schema->getColumnInfo(columns[ii])->offset;
+        column.m_miniPage = NULL;
+        m_columns.push_back(column);
+    }
+}
+
+bool PaxScanner::canScan(const TupleSchema *schema, const std::vector<int> &columns)
+{
+    for (int ii = 0; ii < columns.size(); ii++) {
+        if (columns[ii] < 0 || columns[ii] >= schema->columnCount() ||
+            !schema->columnIsInlined(columns[ii])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PaxScanner::next(TableTuple &scratch)
+{
+    do {
+        if (m_currentBlock.get() == NULL || ++m_slot >= m_slotCount) {
+            if (!nextBlock()) {
+                return false;
+            }
+        }
+    } while (m_freeSlots[m_slot]);
+    char *target = scratch.address();
+    for (int ii = 0; ii < m_columns.size(); ii++) {
+        const ScannedColumn &column = m_columns[ii];
+        ::memcpy(target + column.m_offset, column.m_miniPage + m_slot * column.m_width, column.m_width);
+    }
+    return true;
+}
+
+void PaxScanner::moveToRow(TableTuple &tuple) const
+{
+    assert(m_slot < m_slotCount);
+    tuple.move(m_currentBlock->address() + m_slot * m_tupleLength);
+}
+
+bool PaxScanner::nextBlock()
+{
+    do {
+        if (m_blockIterator == m_blockEnd) {
+            m_currentBlock = NULL;
+            m_slotCount = 0;
+            return false;
+        }
+        m_currentBlock = m_blockIterator.data();
+        ++m_blockIterator;
+        m_slotCount = m_currentBlock->unusedTupleBoundry();
+    } while (m_slotCount == 0);
+    m_currentBlock->makeResident();
+    m_currentBlock->flagFreeSlots(m_freeSlots);
+
+    m_slot = 0;
+    for (int ii = 0; ii < m_columns.size(); ii++) {
+        ScannedColumn &column = m_columns[ii];
+        column.m_miniPage = m_currentBlock->paxMiniPage(column.m_index, column.m_offset, column.m_width);
+    }
+    return true;
+}
+
+} // namespace voltdb
@@ -0,0 +1,106 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PAXSCANNER_H_
+#define PAXSCANNER_H_
+
+#include <vector>
+#include "storage/TupleBlock.h"
+
+namespace voltdb
+{
+
+class PersistentTable;
+class TableTuple;
+class TupleSchema;
+
+/**
+ * Block at a time scan of a few inlined columns of a PAX layout table.
+ * The columns are read from the PAX mini-pages of each block, and free
+ * slots are skipped using the block's free list, so only the rows of the
+ * slots the caller goes on to look at are touched.
+ * The table must not be modified during the scan.
+ */
+class PaxScanner
+{
+  public:
+
+    /**
+     * Constructor. All columns must be inlined.
+     */
+    PaxScanner(PersistentTable &table, const std::vector<int> &columns);
+
+    /**
+     * Return true if a PaxScanner can read the columns of this schema.
+     */
+    static bool canScan(const TupleSchema *schema, const std::vector<int> &columns);
+
+    /**
+     * Move to the next tuple slot in use and copy its scanned columns into
+     * the same columns of scratch, a tuple of the table's schema.
+     * The other columns of scratch are left alone. Return false at the end.
+     */
+    bool next(TableTuple &scratch);
+
+    /**
+     * Point tuple at the row of the current slot. The caller must check that
+     * it is not pending delete before using it.
+     */
+    void moveToRow(TableTuple &tuple) const;
+
+  private:
+
+    /**
+     * Move to the next block with used slots and bring the mini-pages of
+     * the scanned columns up to date. Return false after the last block.
+     */
+    bool nextBlock();
+
+    struct ScannedColumn {
+        int m_index;
+        uint32_t m_offset;
+        uint32_t m_width;
+        const char *m_miniPage;
+    };
+
+    std::vector<ScannedColumn> m_columns;
+
+    /// Tuple size in bytes.
+    const uint32_t m_tupleLength;
+
+    /// Block iterator.
+    TBMapI m_blockIterator;
+
+    /// Block iterator end marker.
+    TBMapI m_blockEnd;
+
+    /// Current block pointer.
+    TBPtr m_currentBlock;
+
+    /// Number of used or free slots in the current block.
+    uint32_t m_slotCount;
+
+    /// Flags of the free slots of the current block.
+    std::vector<bool> m_freeSlots;
+
+    /// Current slot in the current block.
+    uint32_t m_slot;
+};
+
+} // namespace voltdb
+
+#endif // PAXSCANNER_H_
@@ -16,13 +16,22 @@
  */
 #include "storage/PersistentTableStats.h"
 #include "storage/persistenttable.h"
+#include "common/ValueFactory.hpp"
+#include "common/tabletuple.h"
 #include <vector>
 #include <string>
 
 namespace voltdb {
 
+/** KB, or -1 if that overflows, as for the other memory columns */
+static int32_t memoryKB(int64_t bytes) {
+    const int64_t kb = bytes / 1024;
+    return kb > INT32_MAX ? -1 : static_cast<int32_t>(kb);
+}
+
 PersistentTableStats::PersistentTableStats(voltdb::PersistentTable* table)
-  : voltdb::TableStats(table)
+  : voltdb::TableStats(table), m_persistentTable(table),
+    m_lastCompactedTupleCount(0), m_lastCompactionStallMicros(0)
 {
 }
 
@@ -30,4 +39,38 @@ std::vector<std::string> PersistentTableStats::generateStatsColumnNames() {
     std::vector<std::string> columnNames = TableStats::generateStatsColumnNames();
     return columnNames;
 }
+
+void PersistentTableStats::updateStatsTuple(voltdb::TableTuple *tuple) {
+    TableStats::updateStatsTuple(tuple);
+    int64_t compactedTupleCount = m_persistentTable->compactedTupleCount();
+    int64_t stallMicros = m_persistentTable->compactionStallMicros();
+    if (interval()) {
+        compactedTupleCount -= m_lastCompactedTupleCount;
+        m_lastCompactedTupleCount = m_persistentTable->compactedTupleCount();
+        stallMicros -= m_lastCompactionStallMicros;
+        m_lastCompactionStallMicros = m_persistentTable->compactionStallMicros();
+    }
+    tuple->setNValue(StatsSource::m_columnName2Index["COMPACTED_TUPLE_COUNT"],
+            ValueFactory::getBigIntValue(compactedTupleCount));
+    tuple->setNValue(StatsSource::m_columnName2Index["COMPACTION_PENDING_TUPLE_COUNT"],
+            ValueFactory::getBigIntValue(m_persistentTable->pendingCompactionTupleCount()));
+    tuple->setNValue(StatsSource::m_columnName2Index["COMPACTION_STALL_TIME"],
+            ValueFactory::getBigIntValue(stallMicros));
+
+    int64_t hugePageBytes;
+    int64_t numaBoundBytes;
+    m_persistentTable->pageBackedMemory(hugePageBytes, numaBoundBytes);
+    tuple->setNValue(StatsSource::m_columnName2Index["HUGE_PAGE_MEMORY"],
+            ValueFactory::getIntegerValue(memoryKB(hugePageBytes)));
+    tuple->setNValue(StatsSource::m_columnName2Index["NUMA_NODE_MEMORY"],
+            ValueFactory::getIntegerValue(memoryKB(numaBoundBytes)));
+
+    int32_t compressedBlocks;
+    int64_t compressedBytes;
+    m_persistentTable->compressedMemory(compressedBlocks, compressedBytes);
+    tuple->setNValue(StatsSource::m_columnName2Index["COMPRESSED_BLOCK_COUNT"],
+            ValueFactory::getIntegerValue(compressedBlocks));
+    tuple->setNValue(StatsSource::m_columnName2Index["COMPRESSED_MEMORY"],
+            ValueFactory::getIntegerValue(memoryKB(compressedBytes)));
+}
 }
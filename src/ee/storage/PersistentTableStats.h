@@ -26,13 +26,21 @@ namespace voltdb {
 class PersistentTable;
 
 /**
- * Further specialization of TableStats that currently adds no extra functionality.
+ * Further specialization of TableStats that fills in the forced compaction
+ * columns from the persistent table.
  */
 class PersistentTableStats : public voltdb::TableStats {
   public:
     PersistentTableStats(voltdb::PersistentTable* table);
   protected:
     virtual std::vector<std::string> generateStatsColumnNames();
+
+    virtual void updateStatsTuple(voltdb::TableTuple *tuple);
+
+  private:
+    voltdb::PersistentTable* m_persistentTable;
+    int64_t m_lastCompactedTupleCount;
+    int64_t m_lastCompactionStallMicros;
 };
 
 }
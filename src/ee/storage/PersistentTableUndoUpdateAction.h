@@ -44,7 +44,7 @@ public:
     virtual void undo()
     {
         m_table->updateTupleForUndo(m_newTuple, m_oldTuple, m_revertIndexes);
-        NValue::freeObjectsFromTupleStorage(m_newUninlineableColumns);
+        m_table->freeObjects(m_newUninlineableColumns);
         m_table->DRRollback(m_drMark);
     }
 
@@ -53,7 +53,7 @@ public:
      * to be undone in the future. In this case the string allocations
      * of the old tuple must be released.
      */
-    virtual void release() { NValue::freeObjectsFromTupleStorage(m_oldUninlineableColumns); }
+    virtual void release() { m_table->freeObjects(m_oldUninlineableColumns); }
 
     virtual ~PersistentTableUndoUpdateAction() { }
 
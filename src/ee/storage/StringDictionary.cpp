@@ -0,0 +1,140 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "storage/StringDictionary.h"
+#include "common/NValue.hpp"
+#include "common/StringRef.h"
+#include "common/ValuePeeker.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <boost/functional/hash.hpp>
+
+namespace voltdb {
+
+StringDictionary::~StringDictionary()
+{
+    for (ObjectsByHash::iterator iter = m_objectsByHash.begin(); iter != m_objectsByHash.end(); ++iter) {
+        const char *data;
+        int32_t length;
+        readString(iter->second, data, length);
+        m_memorySize -= StringRef::computeStringMemoryUsed(length);
+        StringRef::destroy(reinterpret_cast<StringRef*>(iter->second));
+    }
+}
+
+size_t StringDictionary::hashString(const char *data, int32_t length)
+{
+    return boost::hash_range(data, data + length);
+}
+
+void StringDictionary::readString(const char *object, const char *&data, int32_t &length)
+{
+    const NValue value = NValue::initFromTupleStorage(&object, VALUE_TYPE_VARCHAR, false);
+    data = static_cast<const char*>(ValuePeeker::peekObjectValue_withoutNull(value));
+    length = ValuePeeker::peekObjectLength_withoutNull(value);
+}
+
+const char *StringDictionary::find(const char *data, int32_t length) const
+{
+    std::pair<ObjectsByHash::const_iterator, ObjectsByHash::const_iterator> range =
+        m_objectsByHash.equal_range(hashString(data, length));
+    for (ObjectsByHash::const_iterator iter = range.first; iter != range.second; ++iter) {
+        const char *candidate;
+        int32_t candidateLength;
+        readString(iter->second, candidate, candidateLength);
+        if (candidateLength == length && ::memcmp(candidate, data, length) == 0) {
+            return iter->second;
+        }
+    }
+    return NULL;
+}
+
+void StringDictionary::insert(char *object, size_t hash, int32_t length)
+{
+    m_objectsByHash.insert(ObjectsByHash::value_type(hash, object));
+    m_references[object] = 1;
+    m_memorySize += StringRef::computeStringMemoryUsed(length);
+}
+
+char *StringDictionary::acquire(const NValue &value, int32_t maxLength, bool inBytes)
+{
+    assert(ValuePeeker::peekValueType(value) == VALUE_TYPE_VARCHAR && ! value.isNull());
+    const char *data = static_cast<const char*>(ValuePeeker::peekObjectValue_withoutNull(value));
+    const int32_t length = ValuePeeker::peekObjectLength_withoutNull(value);
+    char *object = const_cast<char*>(find(data, length));
+    if (object != NULL) {
+        ++m_references[object];
+        return object;
+    }
+    // the first row to hold the string: copy it, checking that it fits the column
+    value.serializeToTupleStorageAllocateForObjects(&object, false, maxLength, inBytes, NULL);
+    insert(object, hashString(data, length), length);
+    return object;
+}
+
+char *StringDictionary::intern(char *object)
+{
+    if (object == NULL) {
+        return NULL;
+    }
+    const char *data;
+    int32_t length;
+    readString(object, data, length);
+    char *shared = const_cast<char*>(find(data, length));
+    if (shared != NULL) {
+        ++m_references[shared];
+        StringRef::destroy(reinterpret_cast<StringRef*>(object));
+        return shared;
+    }
+    insert(object, hashString(data, length), length);
+    return object;
+}
+
+bool StringDictionary::release(char *object)
+{
+    boost::unordered_map<const char*, int64_t>::iterator found = m_references.find(object);
+    if (found == m_references.end()) {
+        return false;
+    }
+    if (--found->second > 0) {
+        return true;
+    }
+    m_references.erase(found);
+    const char *data;
+    int32_t length;
+    readString(object, data, length);
+    std::pair<ObjectsByHash::iterator, ObjectsByHash::iterator> range =
+        m_objectsByHash.equal_range(hashString(data, length));
+    for (ObjectsByHash::iterator iter = range.first; iter != range.second; ++iter) {
+        if (iter->second == object) {
+            m_objectsByHash.erase(iter);
+            break;
+        }
+    }
+    m_memorySize -= StringRef::computeStringMemoryUsed(length);
+    StringRef::destroy(reinterpret_cast<StringRef*>(object));
+    return true;
+}
+
+int64_t StringDictionary::referenceCount(const char *object) const
+{
+    boost::unordered_map<const char*, int64_t>::const_iterator found = m_references.find(object);
+    return found == m_references.end() ? 0 : found->second;
+}
+
+} // namespace voltdb
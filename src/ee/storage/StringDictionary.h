@@ -0,0 +1,101 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STRINGDICTIONARY_H_
+#define STRINGDICTIONARY_H_
+
+#include <cstddef>
+#include <stdint.h>
+#include <boost/unordered_map.hpp>
+
+namespace voltdb
+{
+
+class NValue;
+
+/**
+ * The distinct strings of one dictionary encoded VARCHAR column of a
+ * persistent table. All rows holding the same string point at the one
+ * copy the dictionary keeps, with a count of the rows referring to it,
+ * so a row costs a pointer and two rows hold the same string exactly
+ * when their pointers are equal. That pointer is the string's code:
+ * predicates and groupings can compare and hash it in place of the
+ * string.
+ *
+ * Strings are kept as the non-inlined objects (StringRef pointers) of
+ * the tuple storage, so rows of encoded columns read like any others.
+ * The memory they take is added to a counter given by the owner, once
+ * per string rather than once per row.
+ */
+class StringDictionary
+{
+  public:
+    explicit StringDictionary(int64_t &memorySize) : m_memorySize(memorySize) {}
+
+    /**
+     * Free the strings, which no row may refer to any more.
+     */
+    ~StringDictionary();
+
+    /**
+     * Return the shared object holding value, a non-null VARCHAR that
+     * fits the column, to store in a row, adding a reference to it.
+     */
+    char *acquire(const NValue &value, int32_t maxLength, bool inBytes);
+
+    /**
+     * Take a row's own copy of a string and return the shared object to
+     * store in the row instead, which may be the copy itself.
+     */
+    char *intern(char *object);
+
+    /**
+     * Drop a reference taken by acquire() or intern(), freeing the string
+     * with the last one. Return false if object is not the dictionary's.
+     */
+    bool release(char *object);
+
+    /**
+     * Return the shared object holding exactly these bytes, or NULL if
+     * no row holds them.
+     */
+    const char *find(const char *data, int32_t length) const;
+
+    /** Number of distinct strings */
+    size_t size() const { return m_references.size(); }
+
+    /** Number of rows referring to object */
+    int64_t referenceCount(const char *object) const;
+
+  private:
+    static size_t hashString(const char *data, int32_t length);
+    static void readString(const char *object, const char *&data, int32_t &length);
+
+    /** Add an object not yet in the dictionary, with one reference. */
+    void insert(char *object, size_t hash, int32_t length);
+
+    // The strings by hash. Strings move when the string pool compacts,
+    // so they are looked up through their objects rather than by address.
+    typedef boost::unordered_multimap<size_t, char*> ObjectsByHash;
+    ObjectsByHash m_objectsByHash;
+    boost::unordered_map<const char*, int64_t> m_references;
+    int64_t &m_memorySize;
+};
+
+} // namespace voltdb
+
+#endif // STRINGDICTIONARY_H_
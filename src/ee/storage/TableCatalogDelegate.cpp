@@ -94,6 +94,18 @@ TupleSchema *TableCatalogDelegate::createTupleSchema(catalog::Table const &catal
                                           columnInBytes);
 }
 
+vector<int> TableCatalogDelegate::getDictionaryEncodedColumns(catalog::Table const &catalogTable) {
+    vector<int> columns;
+    map<string, catalog::Column*>::const_iterator col_iterator;
+    for (col_iterator = catalogTable.columns().begin();
+         col_iterator != catalogTable.columns().end(); col_iterator++) {
+        if (col_iterator->second->dictionaryencoded()) {
+            columns.push_back(col_iterator->second->index());
+        }
+    }
+    return columns;
+}
+
 bool TableCatalogDelegate::getIndexScheme(catalog::Table const &catalogTable,
                                           catalog::Index const &catalogIndex,
                                           const TupleSchema *schema,
@@ -165,6 +177,12 @@ getIndexIdFromMap(TableIndexType type, bool countable, bool isUnique,
         case HASH_TABLE_INDEX:
             retval += "H";
             break;
+        case OPEN_HASH_TABLE_INDEX:
+            retval += "O";
+            break;
+        case BTREE_INDEX:
+            retval += "T";
+            break;
         default:
             // this would need to change if we added index types
             assert(false);
@@ -379,6 +397,11 @@ Table *TableCatalogDelegate::constructTableFromCatalog(catalog::Database const &
                                                     0,
                                                     catalogTable.tuplelimit(),
                                                     compactionThreshold);
+    PersistentTable *persistentTable = dynamic_cast<PersistentTable*>(table);
+    if (persistentTable != NULL) {
+        persistentTable->setPaxLayout(catalogTable.paxlayout());
+        persistentTable->setDictionaryEncodedColumns(getDictionaryEncodedColumns(catalogTable));
+    }
 
     // add a pkey index if one exists
     if (pkey_index_id.size() != 0) {
@@ -73,6 +73,9 @@ class TableCatalogDelegate : public CatalogDelegate {
 
     static TupleSchema *createTupleSchema(catalog::Table const &catalogTable);
 
+    /** The indexes of the columns the catalog asks to dictionary encode */
+    static std::vector<int> getDictionaryEncodedColumns(catalog::Table const &catalogTable);
+
     static bool getIndexScheme(catalog::Table const &catalogTable,
                                catalog::Index const &catalogIndex,
                                const TupleSchema *schema,
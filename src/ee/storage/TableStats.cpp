@@ -39,6 +39,13 @@ vector<string> TableStats::generateTableStatsColumnNames() {
     columnNames.push_back("STRING_DATA_MEMORY");
     columnNames.push_back("TUPLE_LIMIT");
     columnNames.push_back("PERCENT_FULL");
+    columnNames.push_back("COMPACTED_TUPLE_COUNT");
+    columnNames.push_back("COMPACTION_PENDING_TUPLE_COUNT");
+    columnNames.push_back("COMPACTION_STALL_TIME");
+    columnNames.push_back("HUGE_PAGE_MEMORY");
+    columnNames.push_back("NUMA_NODE_MEMORY");
+    columnNames.push_back("COMPRESSED_BLOCK_COUNT");
+    columnNames.push_back("COMPRESSED_MEMORY");
     return columnNames;
 }
 
@@ -56,6 +63,13 @@ void TableStats::populateTableStatsSchema(
     types.push_back(VALUE_TYPE_INTEGER); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER)); allowNull.push_back(false);inBytes.push_back(false);
     types.push_back(VALUE_TYPE_INTEGER); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER)); allowNull.push_back(false);inBytes.push_back(false);
     types.push_back(VALUE_TYPE_INTEGER); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER)); allowNull.push_back(false);inBytes.push_back(false);
+    types.push_back(VALUE_TYPE_BIGINT);  columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));  allowNull.push_back(false);inBytes.push_back(false);
+    types.push_back(VALUE_TYPE_BIGINT);  columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));  allowNull.push_back(false);inBytes.push_back(false);
+    types.push_back(VALUE_TYPE_BIGINT);  columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));  allowNull.push_back(false);inBytes.push_back(false);
+    types.push_back(VALUE_TYPE_INTEGER); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER)); allowNull.push_back(false);inBytes.push_back(false);
+    types.push_back(VALUE_TYPE_INTEGER); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER)); allowNull.push_back(false);inBytes.push_back(false);
+    types.push_back(VALUE_TYPE_INTEGER); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER)); allowNull.push_back(false);inBytes.push_back(false);
+    types.push_back(VALUE_TYPE_INTEGER); columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER)); allowNull.push_back(false);inBytes.push_back(false);
 }
 
 Table*
@@ -183,6 +197,17 @@ void TableStats::updateStatsTuple(TableTuple *tuple) {
         percentage = static_cast<int32_t> (ceil(static_cast<double>(tupleCount) * 100.0 / tupleLimit));
     }
     tuple->setNValue(StatsSource::m_columnName2Index["PERCENT_FULL"],ValueFactory::getIntegerValue(percentage));
+
+    // Only persistent tables are compacted, see PersistentTableStats
+    tuple->setNValue(StatsSource::m_columnName2Index["COMPACTED_TUPLE_COUNT"], ValueFactory::getBigIntValue(0));
+    tuple->setNValue(StatsSource::m_columnName2Index["COMPACTION_PENDING_TUPLE_COUNT"], ValueFactory::getBigIntValue(0));
+    tuple->setNValue(StatsSource::m_columnName2Index["COMPACTION_STALL_TIME"], ValueFactory::getBigIntValue(0));
+    // Only persistent table blocks are mapped by the PageAllocator
+    tuple->setNValue(StatsSource::m_columnName2Index["HUGE_PAGE_MEMORY"], ValueFactory::getIntegerValue(0));
+    tuple->setNValue(StatsSource::m_columnName2Index["NUMA_NODE_MEMORY"], ValueFactory::getIntegerValue(0));
+    // Only persistent table blocks go cold and get compressed
+    tuple->setNValue(StatsSource::m_columnName2Index["COMPRESSED_BLOCK_COUNT"], ValueFactory::getIntegerValue(0));
+    tuple->setNValue(StatsSource::m_columnName2Index["COMPRESSED_MEMORY"], ValueFactory::getIntegerValue(0));
 }
 
 /**
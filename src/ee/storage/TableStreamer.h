@@ -158,6 +158,13 @@ public:
         return context;
     }
 
+    /**
+     * Return true while any stream is active.
+     */
+    virtual bool hasActiveStreams() const {
+        return !m_streams.empty();
+    }
+
     virtual TableStreamerInterface* cloneForTruncatedTable(PersistentTableSurgeon &surgeon);
 
 private:
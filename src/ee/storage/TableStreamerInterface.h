@@ -98,6 +98,11 @@ namespace voltdb
          */
         virtual TableStreamerContextPtr findStreamContext(TableStreamType streamType) = 0;
 
+        /**
+         * Return true while any stream is active.
+         */
+        virtual bool hasActiveStreams() const = 0;
+
         /**
          * Return context or null for specified type (const flavor).
          */
@@ -19,6 +19,7 @@
 #define _EE_STORAGE_TEMPTABLELIMITS_H_
 
 #include <stdint.h>
+#include <string>
 
 namespace voltdb {
 
@@ -47,6 +48,24 @@ public:
     int64_t getAllocated() const { return m_currMemoryInBytes; }
     int64_t getPeakMemoryInBytes() const { return m_peakMemoryInBytes; }
     void resetPeakMemory() { m_peakMemoryInBytes = m_currMemoryInBytes; }
+    int64_t getMemoryLimit() const { return m_memoryLimit; }
+
+    /**
+     * Temp tables that opt in to spilling write their full blocks to a scratch
+     * file in this directory instead of running into the memory limit.
+     * An empty directory, the default, disables spilling.
+     */
+    void setSpillDirectory(const std::string& directory) { m_spillDirectory = directory; }
+    const std::string& getSpillDirectory() const { return m_spillDirectory; }
+    bool spillEnabled() const { return m_memoryLimit > 0 && ! m_spillDirectory.empty(); }
+
+    /**
+     * Spillable temp tables start spilling once the fragment passes half of its
+     * memory limit, which leaves the other half to the tables that can not spill.
+     */
+    bool shouldSpill(int bytes) const {
+        return spillEnabled() && m_currMemoryInBytes + bytes > m_memoryLimit / 2;
+    }
 
 private:
     /// The current amount of memory used by temp tables for this plan fragment.
@@ -63,6 +82,8 @@ private:
     /// True if we have already generated a log message for
     /// exceeding the log threshold and not yet dropped below it.
     bool m_logLatch;
+    /// Where spillable temp tables keep their scratch files; empty if spilling is disabled.
+    std::string m_spillDirectory;
 };
 
 } // namespace voltdb
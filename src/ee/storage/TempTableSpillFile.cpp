@@ -0,0 +1,102 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TempTableSpillFile.h"
+
+#include "common/SQLException.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+
+namespace voltdb {
+
+TempTableSpillFile::TempTableSpillFile(const std::string& directory)
+    : m_directory(directory), m_fd(-1), m_size(0)
+{
+    std::string pattern = directory + "/volt_temp_spill_XXXXXX";
+    std::vector<char> path(pattern.begin(), pattern.end());
+    path.push_back('\0');
+    m_fd = ::mkstemp(&path[0]);
+    if (m_fd == -1) {
+        throwIOError("create");
+    }
+    ::unlink(&path[0]);
+}
+
+TempTableSpillFile::~TempTableSpillFile()
+{
+    if (m_fd != -1) {
+        ::close(m_fd);
+    }
+}
+
+int64_t TempTableSpillFile::write(const char* data, size_t length)
+{
+    int64_t offset = m_size;
+    size_t written = 0;
+    while (written < length) {
+        ssize_t rc = ::pwrite(m_fd, data + written, length - written,
+                              static_cast<off_t>(offset + static_cast<int64_t>(written)));
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throwIOError("write");
+        }
+        written += static_cast<size_t>(rc);
+    }
+    m_size += static_cast<int64_t>(length);
+    return offset;
+}
+
+void TempTableSpillFile::read(int64_t offset, char* data, size_t length) const
+{
+    size_t done = 0;
+    while (done < length) {
+        ssize_t rc = ::pread(m_fd, data + done, length - done,
+                             static_cast<off_t>(offset + static_cast<int64_t>(done)));
+        if (rc <= 0) {
+            if (rc < 0 && errno == EINTR) {
+                continue;
+            }
+            throwIOError("read");
+        }
+        done += static_cast<size_t>(rc);
+    }
+}
+
+void TempTableSpillFile::truncate()
+{
+    if (::ftruncate(m_fd, 0) != 0) {
+        throwIOError("truncate");
+    }
+    m_size = 0;
+}
+
+void TempTableSpillFile::throwIOError(const char* operation) const
+{
+    char msg[1024];
+    snprintf(msg, sizeof(msg), "Failed to %s temp table spill file in '%s': %s",
+             operation, m_directory.c_str(), strerror(errno));
+    throw SQLException(SQLException::volt_temp_table_memory_overflow, msg);
+}
+
+} // namespace voltdb
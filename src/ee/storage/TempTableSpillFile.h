@@ -0,0 +1,61 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EE_STORAGE_TEMPTABLESPILLFILE_H_
+#define _EE_STORAGE_TEMPTABLESPILLFILE_H_
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+
+namespace voltdb {
+
+/**
+ * Anonymous scratch file that holds the blocks a spillable TempTable has
+ * written out. The file is unlinked as soon as it is created, so it
+ * disappears with its descriptor even if the process dies.
+ * I/O failures throw a SQLException, which aborts the fragment
+ * the same way running out of temp table memory does.
+ */
+class TempTableSpillFile {
+public:
+    explicit TempTableSpillFile(const std::string& directory);
+    ~TempTableSpillFile();
+
+    /** Append the bytes and return the offset at which they were written. */
+    int64_t write(const char* data, size_t length);
+
+    void read(int64_t offset, char* data, size_t length) const;
+
+    /** Discard all contents so that the space can be reused. */
+    void truncate();
+
+private:
+    // no copies, no assignment
+    TempTableSpillFile(TempTableSpillFile const&);
+    TempTableSpillFile operator=(TempTableSpillFile const&);
+
+    void throwIOError(const char* operation) const;
+
+    const std::string m_directory;
+    int m_fd;
+    int64_t m_size;
+};
+
+} // namespace voltdb
+
+#endif // _EE_STORAGE_TEMPTABLESPILLFILE_H_
@@ -19,13 +19,20 @@
 #include <sys/mman.h>
 #include <errno.h>
 #include "common/ThreadLocalPool.h"
+#include "common/PageAllocator.h"
+#include "common/BlockCodec.h"
+#include "storage/ColdBlockCompressor.h"
 
 namespace voltdb {
 
 volatile int tupleBlocksAllocated = 0;
 
+// Blocks brought back this many times wait 32 times as long to go cold.
+static const uint32_t MAX_COLD_TICKS_SHIFT = 5;
+
 TupleBlock::TupleBlock(Table *table, TBBucketPtr bucket) :
         m_storage(NULL),
+        m_allocationSize(static_cast<uint32_t>(table->m_tableAllocationSize)),
         m_references(0),
         m_tupleLength(table->m_tupleLength),
         m_tuplesPerBlock(table->m_tuplesPerBlock),
@@ -34,7 +41,14 @@ TupleBlock::TupleBlock(Table *table, TBBucketPtr bucket) :
         m_lastCompactionOffset(0),
         m_tuplesPerBlockDivNumBuckets(m_tuplesPerBlock / static_cast<double>(TUPLE_BLOCK_NUM_BUCKETS)),
         m_bucket(bucket),
-        m_bucketIndex(0)
+        m_bucketIndex(0),
+        m_paxVersion(0),
+        m_compressedData(NULL),
+        m_compressedSize(0),
+        m_idleTicks(0),
+        m_coldTicksShift(0),
+        m_residentHits(0),
+        m_pageBacking(0)
 {
 #ifdef USE_MMAP
     size_t tableAllocationSize = static_cast<size_t> (m_tupleLength * m_tuplesPerBlock);
@@ -44,12 +58,25 @@ TupleBlock::TupleBlock(Table *table, TBBucketPtr bucket) :
         throwFatalException("Failed mmap");
     }
 #else
-    m_storage = new char[table->m_tableAllocationSize];
+    // Blocks as big as those of persistent tables are mapped as the engine's
+    // PageAllocator was configured to, with huge pages or on its NUMA node.
+    // The smaller ones of temp tables come and go too often for that.
+    if (m_allocationSize >= PageAllocator::HUGE_PAGE_SIZE) {
+        m_storage = static_cast<char*>(PageAllocator::allocate(m_allocationSize, &m_pageBacking));
+    }
+    else {
+        m_storage = new char[m_allocationSize];
+    }
 #endif
     tupleBlocksAllocated++;
 }
 
 TupleBlock::~TupleBlock() {
+    freePaxMiniPages();
+    if (m_compressedData != NULL) {
+        ColdBlockCompressor::blockReleased(this, m_compressedSize, m_nextFreeTuple * m_tupleLength);
+        delete [] m_compressedData;
+    }
 #ifdef USE_MMAP
     size_t tableAllocationSize = static_cast<size_t> (m_tupleLength * m_tuplesPerBlock);
     if (::munmap( m_storage, tableAllocationSize) != 0) {
@@ -57,10 +84,145 @@ TupleBlock::~TupleBlock() {
         throwFatalException("Failed munmap");
     }
 #else
-    delete []m_storage;
+    if (m_allocationSize >= PageAllocator::HUGE_PAGE_SIZE) {
+        PageAllocator::release(m_storage, m_allocationSize);
+    }
+    else {
+        delete []m_storage;
+    }
 #endif
 }
 
+void TupleBlock::agePastTick(uint32_t coldTicks) {
+    if (m_compressedData != NULL || m_nextFreeTuple == 0 || m_allocationSize < PageAllocator::HUGE_PAGE_SIZE) {
+        return;
+    }
+    if (++m_idleTicks >= (static_cast<uint64_t>(coldTicks) << m_coldTicksShift) && !compress()) {
+        // try again after as long again
+        m_idleTicks = 0;
+        ColdBlockCompressor::compressionRejected();
+    }
+}
+
+bool TupleBlock::compress() {
+    assert(m_compressedData == NULL);
+    const std::size_t sourceSize = m_nextFreeTuple * m_tupleLength;
+    std::vector<char> &scratch = ColdBlockCompressor::scratchBuffer();
+    scratch.resize(BlockCodec::compressBound(sourceSize));
+    const std::size_t compressedSize = BlockCodec::compress(m_storage, sourceSize, &scratch[0], scratch.size());
+    // Saving less than a quarter isn't worth the decompressions.
+    if (compressedSize == 0 || compressedSize > sourceSize / 4 * 3) {
+        return false;
+    }
+    char *compressedData = new char[compressedSize];
+    ::memcpy(compressedData, &scratch[0], compressedSize);
+
+    // The pages stay mapped, so the addresses of the tuples held by indexes
+    // stay valid, but any read that doesn't bring the block back first faults.
+    if (::mprotect(m_storage, m_allocationSize, PROT_NONE) != 0) {
+        delete [] compressedData;
+        return false;
+    }
+    if (::madvise(m_storage, m_allocationSize, MADV_DONTNEED) != 0) {
+        if (::mprotect(m_storage, m_allocationSize, PROT_READ | PROT_WRITE) != 0) {
+            throwFatalException("Failed mprotect of a tuple block: %s", strerror(errno));
+        }
+        delete [] compressedData;
+        return false;
+    }
+    freePaxMiniPages();
+    m_compressedData = compressedData;
+    m_compressedSize = static_cast<uint32_t>(compressedSize);
+    ColdBlockCompressor::blockCompressed(this, compressedSize, sourceSize);
+    return true;
+}
+
+void TupleBlock::decompress() {
+    assert(m_compressedData != NULL);
+    const std::size_t targetSize = m_nextFreeTuple * m_tupleLength;
+    if (::mprotect(m_storage, m_allocationSize, PROT_READ | PROT_WRITE) != 0) {
+        throwFatalException("Failed mprotect of a tuple block: %s", strerror(errno));
+    }
+    if (!BlockCodec::decompress(m_compressedData, m_compressedSize, m_storage, targetSize)) {
+        throwFatalException("Failed to decompress a tuple block");
+    }
+    ColdBlockCompressor::blockDecompressed(this, m_compressedSize, targetSize);
+    delete [] m_compressedData;
+    m_compressedData = NULL;
+    m_compressedSize = 0;
+    if (m_coldTicksShift < MAX_COLD_TICKS_SHIFT) {
+        ++m_coldTicksShift;
+    }
+}
+
+const char* TupleBlock::paxMiniPage(int columnIndex, uint32_t offset, uint32_t width) {
+    if (m_paxMiniPages.size() <= columnIndex) {
+        m_paxMiniPages.resize(columnIndex + 1);
+    }
+    PaxMiniPage &page = m_paxMiniPages[columnIndex];
+    if (page.m_data == NULL) {
+        page.m_data = new char[width * m_tuplesPerBlock];
+        page.m_offset = offset;
+        page.m_width = width;
+        page.m_version = m_paxVersion;
+    }
+    assert(page.m_width == width);
+
+    // Appends only add slots past the ones already copied. Copied slots
+    // written since are patched by refreshPaxSlot, or bump the version.
+    uint32_t firstSlot = page.m_tupleCount;
+    if (page.m_version != m_paxVersion) {
+        firstSlot = 0;
+        page.m_version = m_paxVersion;
+    }
+    const char *source = m_storage + firstSlot * m_tupleLength + offset;
+    char *target = page.m_data + firstSlot * width;
+    for (uint32_t ii = firstSlot; ii < m_nextFreeTuple; ii++) {
+        ::memcpy(target, source, width);
+        source += m_tupleLength;
+        target += width;
+    }
+    page.m_tupleCount = m_nextFreeTuple;
+    return page.m_data;
+}
+
+void TupleBlock::refreshPaxSlot(const char *tuple) {
+    const uint32_t slot = static_cast<uint32_t>(tuple - m_storage) / m_tupleLength;
+    for (int ii = 0; ii < m_paxMiniPages.size(); ii++) {
+        PaxMiniPage &page = m_paxMiniPages[ii];
+        // Slots not copied yet, or pages to be rebuilt, are read from the rows anyway.
+        if (page.m_data == NULL || page.m_version != m_paxVersion || slot >= page.m_tupleCount) {
+            continue;
+        }
+        ::memcpy(page.m_data + slot * page.m_width, tuple + page.m_offset, page.m_width);
+    }
+}
+
+void TupleBlock::freePaxMiniPages() {
+    for (int ii = 0; ii < m_paxMiniPages.size(); ii++) {
+        delete [] m_paxMiniPages[ii].m_data;
+    }
+    m_paxMiniPages.clear();
+}
+
+int64_t TupleBlock::paxMiniPageBytes() const {
+    int64_t bytes = 0;
+    for (int ii = 0; ii < m_paxMiniPages.size(); ii++) {
+        if (m_paxMiniPages[ii].m_data != NULL) {
+            bytes += static_cast<int64_t>(m_paxMiniPages[ii].m_width) * m_tuplesPerBlock;
+        }
+    }
+    return bytes;
+}
+
+void TupleBlock::flagFreeSlots(std::vector<bool> &freeSlots) const {
+    freeSlots.assign(m_nextFreeTuple, false);
+    for (std::deque<TruncatedInt, FastAllocator<TruncatedInt> >::const_iterator i = m_freeList.begin();
+         i != m_freeList.end(); ++i) {
+        freeSlots[i->unpack() / m_tupleLength] = true;
+    }
+}
+
 std::pair<int, int> TupleBlock::merge(Table *table, TBPtr source, TupleMovementListener *listener) {
     assert(source != this);
     /*
@@ -71,6 +233,12 @@ std::pair<int, int> TupleBlock::merge(Table *table, TBPtr source, TupleMovementL
                 << " and active tuple count is " << source->m_activeTuples << std::endl;
     */
 
+    // Both blocks' tuples are read and written.
+    makeResident();
+    source->makeResident();
+    // The moved tuples fill freed slots, too many to patch one by one.
+    invalidatePaxMiniPages();
+
     uint32_t m_nextTupleInSourceOffset = source->lastCompactionOffset();
     int sourceTuplesPendingDeleteOnUndoRelease = 0;
     while (hasFreeTuples() && !source->isEmpty()) {
@@ -63,7 +63,7 @@ public:
         return *this;
     }
 
-    uint32_t unpack() {
+    uint32_t unpack() const {
         char valueBytes[4];
         ::memcpy(valueBytes, m_data, 3);
         valueBytes[3] = 0;
@@ -199,12 +199,24 @@ public:
         m_activeTuples = 0;
         m_nextFreeTuple = 0;
         m_freeList.clear();
+        ++m_paxVersion;
     }
 
     inline uint32_t unusedTupleBoundry() {
         return m_nextFreeTuple;
     }
 
+    /**
+     * Mark the first tupleCount slots used, for a block whose storage has
+     * been refilled from a copy taken while it was full (temp table spill).
+     */
+    inline void restoreUsedTuples(uint32_t tupleCount) {
+        assert(tupleCount <= m_tuplesPerBlock);
+        reset();
+        m_activeTuples = tupleCount;
+        m_nextFreeTuple = tupleCount;
+    }
+
     ~TupleBlock();
 
     inline uint32_t lastCompactionOffset() {
@@ -222,8 +234,109 @@ public:
     inline TBBucketPtr currentBucket() {
         return m_bucket;
     }
+
+    /**
+     * Return the PAX mini-page of a column: the column's width bytes of
+     * every used tuple slot of this block, stored contiguously in slot order.
+     * It is built from the rows on first use and brought up to date on later
+     * uses. Slots that are free hold stale bytes.
+     */
+    const char* paxMiniPage(int columnIndex, uint32_t offset, uint32_t width);
+
+    /**
+     * Copy the row of a slot that was written in place, or reused after
+     * being freed, into the mini-pages that already hold the slot.
+     */
+    void refreshPaxSlot(const char *tuple);
+
+    /**
+     * Make the next paxMiniPage() calls rebuild the mini-pages from the rows,
+     * when too many slots were written to patch them one by one.
+     */
+    inline void invalidatePaxMiniPages() {
+        ++m_paxVersion;
+    }
+
+    void freePaxMiniPages();
+
+    /** Bytes allocated for the PAX mini-pages */
+    int64_t paxMiniPageBytes() const;
+
+    /** Set the flags of the slots below unusedTupleBoundry() that are free */
+    void flagFreeSlots(std::vector<bool> &freeSlots) const;
+
+    inline uint32_t allocationSize() const {
+        return m_allocationSize;
+    }
+
+    /** The PageAllocator::Backing flags of the block's storage */
+    inline int pageBacking() const {
+        return m_pageBacking;
+    }
+
+    /**
+     * True while the block's tuples are held compressed, its storage
+     * pages given back to the OS and mapped inaccessible.
+     */
+    inline bool isCompressed() const {
+        return m_compressedData != NULL;
+    }
+
+    /** Bytes of the compressed tuples while the block is compressed */
+    inline uint32_t compressedSize() const {
+        return m_compressedSize;
+    }
+
+    /**
+     * Must be called before the block's tuple storage is read or written
+     * by anything that didn't come to it through TableIterator, an index
+     * or another path that already did. Brings the tuples back if they
+     * were compressed, and keeps the block from going cold for a while.
+     */
+    inline void makeResident() {
+        m_idleTicks = 0;
+        if (m_compressedData != NULL) {
+            decompress();
+        }
+        else {
+            ++m_residentHits;
+        }
+    }
+
+    /**
+     * Count a tick the block went without being accessed, and compress it
+     * once it has gone coldTicks of them in a row -- twice as many for each
+     * time it had to be brought back, so blocks that are read now and then
+     * aren't compressed over and over.
+     * Only blocks mapped by the PageAllocator can be compressed.
+     */
+    void agePastTick(uint32_t coldTicks);
+
+    /** Return and reset the number of accesses that found the block resident */
+    inline uint32_t takeResidentHits() {
+        uint32_t hits = m_residentHits;
+        m_residentHits = 0;
+        return hits;
+    }
 private:
+    bool compress();
+    void decompress();
+
+    struct PaxMiniPage {
+        PaxMiniPage() : m_data(NULL), m_offset(0), m_width(0), m_version(0), m_tupleCount(0) { }
+        char* m_data;
+        /// Offset of the column in the row.
+        uint32_t m_offset;
+        uint32_t m_width;
+        /// Value of m_paxVersion when the mini-page was last brought up to date.
+        uint32_t m_version;
+        /// Number of leading slots that were copied at that time.
+        uint32_t m_tupleCount;
+    };
+
     char*   m_storage;
+    // bytes allocated for m_storage
+    const uint32_t m_allocationSize;
     uint32_t m_references;
     uint32_t m_tupleLength;
     uint32_t m_tuplesPerBlock;
@@ -243,6 +356,21 @@ private:
 
     TBBucketPtr m_bucket;
     int m_bucketIndex;
+
+    /// PAX mini-pages by column index, allocated for the columns that have been scanned.
+    std::vector<PaxMiniPage> m_paxMiniPages;
+    /// Bumped when the copied slots must all be copied again.
+    uint32_t m_paxVersion;
+
+    /// The used slots compressed by BlockCodec while the block is cold, else NULL.
+    char* m_compressedData;
+    uint32_t m_compressedSize;
+    /// Ticks since the block was last made resident.
+    uint32_t m_idleTicks;
+    /// Doubles the ticks the block must stay idle to be compressed again.
+    uint32_t m_coldTicksShift;
+    uint32_t m_residentHits;
+    int m_pageBacking;
 };
 
 /**
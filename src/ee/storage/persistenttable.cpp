@@ -46,7 +46,8 @@
 #include <sstream>
 #include <cassert>
 #include <cstdio>
-#include <algorithm>    // std::find
+#include <algorithm>    // std::find, std::sort
+#include <sys/time.h>
 #include <boost/foreach.hpp>
 #include <boost/scoped_ptr.hpp>
 #include "storage/persistenttable.h"
@@ -58,6 +59,7 @@
 #include "common/UndoQuantum.h"
 #include "common/executorcontext.hpp"
 #include "common/FatalException.hpp"
+#include "common/PageAllocator.h"
 #include "common/types.h"
 #include "common/RecoveryProtoMessage.h"
 #include "common/StreamPredicateList.h"
@@ -80,6 +82,8 @@
 #include "storage/CopyOnWriteContext.h"
 #include "storage/MaterializedViewMetadata.h"
 #include "storage/DRTupleStream.h"
+#include "storage/StringDictionary.h"
+#include "storage/ColdBlockCompressor.h"
 
 namespace voltdb {
 
@@ -87,6 +91,7 @@ void* keyTupleStorage = NULL;
 TableTuple keyTuple;
 
 #define TABLE_BLOCKSIZE 2097152
+#define COMPACTION_BUDGET_MICROS 5000
 
 PersistentTable::PersistentTable(int partitionColumn, char * signature, bool isMaterialized, int tableAllocationTargetSize, int tupleLimit) :
     Table(tableAllocationTargetSize == 0 ? TABLE_BLOCKSIZE : tableAllocationTargetSize),
@@ -94,8 +99,13 @@ PersistentTable::PersistentTable(int partitionColumn, char * signature, bool isM
     m_allowNulls(),
     m_partitionColumn(partitionColumn),
     m_tupleLimit(tupleLimit),
+    m_paxLayout(false),
     stats_(this),
     m_failedCompactionCount(0),
+    m_compactionInProgress(false),
+    m_compactionBudgetMicros(COMPACTION_BUDGET_MICROS),
+    m_compactedTupleCount(0),
+    m_compactionStallMicros(0),
     m_invisibleTuplesPendingDeleteCount(0),
     m_surgeon(*this),
     m_isMaterialized(isMaterialized)
@@ -123,9 +133,13 @@ PersistentTable::~PersistentTable()
     TableIterator ti(this, m_data.begin());
     TableTuple tuple(m_schema);
     while (ti.next(tuple)) {
-        tuple.freeObjectColumns();
+        freeObjectColumns(tuple);
         tuple.setActiveFalse();
     }
+    // along with the strings of any rows still pending delete
+    for (int ii = 0; ii < m_stringDictionaries.size(); ii++) {
+        delete m_stringDictionaries[ii];
+    }
 
     // note this class has ownership of the views, even if they
     // were allocated by VoltDBEngine
@@ -136,6 +150,233 @@ PersistentTable::~PersistentTable()
     // Indexes are deleted in parent class Table destructor.
 }
 
+void PersistentTable::setPaxLayout(bool paxLayout) {
+    if (m_paxLayout && !paxLayout) {
+        // Updates stop invalidating the mini-pages, so they must go.
+        for (TBMapI i = m_data.begin(); i != m_data.end(); ++i) {
+            i.data()->freePaxMiniPages();
+        }
+        m_paxWrittenTuples.clear();
+    }
+    m_paxLayout = paxLayout;
+}
+
+void PersistentTable::refreshPaxMiniPages() {
+    if (m_paxWrittenTuples.empty()) {
+        return;
+    }
+    // Walk the noted slots and the blocks together, both in address order.
+    // A slot whose block has gone since is skipped; one in a block since
+    // allocated at the same address is copied as it is now, which is right.
+    std::sort(m_paxWrittenTuples.begin(), m_paxWrittenTuples.end());
+    TBMapI block = m_data.begin();
+    for (std::vector<char*>::const_iterator i = m_paxWrittenTuples.begin();
+         i != m_paxWrittenTuples.end() && block != m_data.end(); ++i) {
+        while (block != m_data.end() && *i >= block.key() + m_tableAllocationSize) {
+            ++block;
+        }
+        if (block != m_data.end() && *i >= block.key()) {
+            block.data()->refreshPaxSlot(*i);
+        }
+    }
+    m_paxWrittenTuples.clear();
+}
+
+int64_t PersistentTable::allocatedTupleMemory() const {
+    int64_t bytes = Table::allocatedTupleMemory();
+    if (m_paxLayout) {
+        for (TBMap::const_iterator i = m_data.begin(); i != m_data.end(); ++i) {
+            bytes += i.data()->paxMiniPageBytes();
+        }
+    }
+    return bytes;
+}
+
+void PersistentTable::setDictionaryEncodedColumns(const std::vector<int> &columns) {
+    std::vector<bool> encoded(m_schema->columnCount(), false);
+    for (int ii = 0; ii < columns.size(); ii++) {
+        const int column = columns[ii];
+        if (column < 0 || column >= m_schema->columnCount()) {
+            continue;
+        }
+        const TupleSchema::ColumnInfo *columnInfo = m_schema->getColumnInfo(column);
+        if (columnInfo->getVoltType() == VALUE_TYPE_VARCHAR && !columnInfo->inlined) {
+            encoded[column] = true;
+        }
+    }
+    bool anyEncoded = false;
+    for (int column = 0; column < m_schema->columnCount(); column++) {
+        const bool wasEncoded = !m_stringDictionaries.empty() && m_stringDictionaries[column] != NULL;
+        if (wasEncoded && !encoded[column]) {
+            decodeColumn(column);
+        }
+        else if (!wasEncoded && encoded[column]) {
+            encodeColumn(column);
+        }
+        anyEncoded = anyEncoded || encoded[column];
+    }
+    if (!anyEncoded) {
+        m_stringDictionaries.clear();
+    }
+}
+
+void PersistentTable::encodeColumn(int column) {
+    if (m_stringDictionaries.empty()) {
+        m_stringDictionaries.resize(m_schema->columnCount(), NULL);
+    }
+    StringDictionary *dictionary = new StringDictionary(m_nonInlinedMemorySize);
+    m_stringDictionaries[column] = dictionary;
+    // Every stored row, pending delete or not, gives up its own copy.
+    const TupleSchema::ColumnInfo *columnInfo = m_schema->getColumnInfo(column);
+    TableTuple tuple(m_schema);
+    for (TBMapI i = m_data.begin(); i != m_data.end(); ++i) {
+        TBPtr block = i.data();
+        block->makeResident();
+        for (uint32_t jj = 0; jj < block->unusedTupleBoundry(); jj++) {
+            tuple.move(block->address() + jj * m_tupleLength);
+            if (tuple.isActive()) {
+                char **object = reinterpret_cast<char**>(tuple.getWritableDataPtr(columnInfo));
+                const NValue value = tuple.getNValue(column);
+                if (!value.isNull()) {
+                    decreaseStringMemCount(StringRef::computeStringMemoryUsed(
+                            ValuePeeker::peekObjectLength_withoutNull(value)));
+                }
+                *object = dictionary->intern(*object);
+            }
+        }
+    }
+}
+
+void PersistentTable::decodeColumn(int column) {
+    StringDictionary *dictionary = m_stringDictionaries[column];
+    const TupleSchema::ColumnInfo *columnInfo = m_schema->getColumnInfo(column);
+    TableTuple tuple(m_schema);
+    for (TBMapI i = m_data.begin(); i != m_data.end(); ++i) {
+        TBPtr block = i.data();
+        block->makeResident();
+        for (uint32_t jj = 0; jj < block->unusedTupleBoundry(); jj++) {
+            tuple.move(block->address() + jj * m_tupleLength);
+            if (tuple.isActive()) {
+                char **object = reinterpret_cast<char**>(tuple.getWritableDataPtr(columnInfo));
+                if (*object == NULL) {
+                    continue;
+                }
+                char *shared = *object;
+                const NValue value = tuple.getNValue(column);
+                value.serializeToTupleStorageAllocateForObjects(object, false, columnInfo->length,
+                                                                columnInfo->inBytes, NULL);
+                increaseStringMemCount(StringRef::computeStringMemoryUsed(
+                        ValuePeeker::peekObjectLength_withoutNull(value)));
+                dictionary->release(shared);
+            }
+        }
+    }
+    m_stringDictionaries[column] = NULL;
+    delete dictionary;
+}
+
+void PersistentTable::copyForPersistentInsert(TableTuple &target, const TableTuple &source) {
+    if (m_stringDictionaries.empty()) {
+        target.copyForPersistentInsert(source); // tuple in freelist must be already cleared
+        return;
+    }
+    // as TableTuple::copyForPersistentInsert does, but with shared strings
+    ::memcpy(target.address(), source.address(), m_schema->tupleLength() + TUPLE_HEADER_SIZE);
+    const uint16_t uninlinedColumnCount = m_schema->getUninlinedObjectColumnCount();
+    for (uint16_t ii = 0; ii < uninlinedColumnCount; ii++) {
+        const int column = m_schema->getUninlinedObjectColumnInfoIndex(ii);
+        StringDictionary *dictionary = m_stringDictionaries[column];
+        if (dictionary == NULL) {
+            target.setNValueAllocateForObjectCopies(column, source.getNValue(column), NULL);
+            continue;
+        }
+        const TupleSchema::ColumnInfo *columnInfo = m_schema->getColumnInfo(column);
+        char **object = reinterpret_cast<char**>(target.getWritableDataPtr(columnInfo));
+        const NValue value = source.getNValue(column);
+        *object = value.isNull() ? NULL :
+            dictionary->acquire(value, columnInfo->length, columnInfo->inBytes);
+    }
+}
+
+void PersistentTable::encodeObjectColumns(TableTuple &tuple, std::vector<char*> *newObjects) {
+    for (int column = 0; column < m_stringDictionaries.size(); column++) {
+        StringDictionary *dictionary = m_stringDictionaries[column];
+        if (dictionary == NULL) {
+            continue;
+        }
+        char **object = reinterpret_cast<char**>(tuple.getWritableDataPtr(m_schema->getColumnInfo(column)));
+        if (newObjects == NULL) {
+            *object = dictionary->intern(*object);
+            continue;
+        }
+        // Only the strings an update just copied into the row are its own.
+        std::vector<char*>::iterator newObject = std::find(newObjects->begin(), newObjects->end(), *object);
+        if (*object != NULL && newObject != newObjects->end()) {
+            *object = dictionary->intern(*object);
+            *newObject = *object;
+        }
+    }
+}
+
+void PersistentTable::freeObjectColumns(TableTuple &tuple) {
+    if (m_stringDictionaries.empty()) {
+        tuple.freeObjectColumns();
+        return;
+    }
+    const uint16_t uninlinedColumnCount = m_schema->getUninlinedObjectColumnCount();
+    for (uint16_t ii = 0; ii < uninlinedColumnCount; ii++) {
+        const int column = m_schema->getUninlinedObjectColumnInfoIndex(ii);
+        char *object = *reinterpret_cast<char**>(tuple.getWritableDataPtr(m_schema->getColumnInfo(column)));
+        if (object == NULL) {
+            continue;
+        }
+        if (m_stringDictionaries[column] != NULL) {
+            m_stringDictionaries[column]->release(object);
+        }
+        else {
+            StringRef::destroy(reinterpret_cast<StringRef*>(object));
+        }
+    }
+}
+
+void PersistentTable::freeObjects(const std::vector<char*> &objects) {
+    if (m_stringDictionaries.empty()) {
+        NValue::freeObjectsFromTupleStorage(objects);
+        return;
+    }
+    for (int ii = 0; ii < objects.size(); ii++) {
+        if (objects[ii] == NULL) {
+            continue;
+        }
+        bool released = false;
+        for (int column = 0; column < m_stringDictionaries.size() && !released; column++) {
+            released = m_stringDictionaries[column] != NULL && m_stringDictionaries[column]->release(objects[ii]);
+        }
+        if (!released) {
+            StringRef::destroy(reinterpret_cast<StringRef*>(objects[ii]));
+        }
+    }
+}
+
+size_t PersistentTable::rowNonInlinedMemorySize(const TableTuple &tuple) const {
+    if (m_stringDictionaries.empty()) {
+        return tuple.getNonInlinedMemorySize();
+    }
+    size_t bytes = 0;
+    const uint16_t uninlinedColumnCount = m_schema->getUninlinedObjectColumnCount();
+    for (uint16_t ii = 0; ii < uninlinedColumnCount; ii++) {
+        const int column = m_schema->getUninlinedObjectColumnInfoIndex(ii);
+        if (m_stringDictionaries[column] != NULL) {
+            continue;
+        }
+        const NValue value = tuple.getNValue(column);
+        if (!value.isNull()) {
+            bytes += StringRef::computeStringMemoryUsed(ValuePeeker::peekObjectLength_withoutNull(value));
+        }
+    }
+    return bytes;
+}
+
 // ------------------------------------------------------------------
 // OPERATIONS
 // ------------------------------------------------------------------
@@ -146,6 +387,7 @@ void PersistentTable::nextFreeTuple(TableTuple *tuple) {
         VOLT_TRACE("GRABBED FREE TUPLE!\n");
         stx::btree_set<TBPtr >::iterator begin = m_blocksWithSpace.begin();
         TBPtr block = (*begin);
+        block->makeResident();
         std::pair<char*, int> retval = block->nextFreeTuple();
 
         /**
@@ -166,6 +408,10 @@ void PersistentTable::nextFreeTuple(TableTuple *tuple) {
 
         tuple->move(retval.first);
         ++m_tupleCount;
+        // Unlike an append, a freed slot may already be in the mini-pages.
+        if (retval.first != block->address() + (block->unusedTupleBoundry() - 1) * m_tupleLength) {
+            notePaxTupleWritten(*tuple);
+        }
         if (!block->hasFreeTuples()) {
             m_blocksWithSpace.erase(block);
         }
@@ -355,7 +601,7 @@ void PersistentTable::insertPersistentTuple(TableTuple &source, bool fallible)
     //
     // Then copy the source into the target
     //
-    target.copyForPersistentInsert(source); // tuple in freelist must be already cleared
+    copyForPersistentInsert(target, source);
 
     try {
         insertTupleCommon(source, target, fallible);
@@ -365,7 +611,8 @@ void PersistentTable::insertPersistentTuple(TableTuple &source, bool fallible)
     }
 }
 
-void PersistentTable::insertTupleCommon(TableTuple &source, TableTuple &target, bool fallible, bool shouldDRStream)
+void PersistentTable::insertTupleCommon(TableTuple &source, TableTuple &target, bool fallible, bool shouldDRStream,
+                                        bool alreadyIndexed)
 {
     if (fallible) {
         // not null checks at first
@@ -376,7 +623,7 @@ void PersistentTable::insertTupleCommon(TableTuple &source, TableTuple &target,
     }
 
     if (m_schema->getUninlinedObjectColumnCount() != 0) {
-        increaseStringMemCount(target.getNonInlinedMemorySize());
+        increaseStringMemCount(rowNonInlinedMemorySize(target));
     }
 
     target.setActiveTrue();
@@ -394,7 +641,7 @@ void PersistentTable::insertTupleCommon(TableTuple &source, TableTuple &target,
         target.setDirtyFalse();
     }
 
-    if (!tryInsertOnAllIndexes(&target)) {
+    if (!alreadyIndexed && !tryInsertOnAllIndexes(&target)) {
         throw ConstraintFailureException(this, source, TableTuple(),
                 CONSTRAINT_TYPE_UNIQUE);
     }
@@ -539,8 +786,8 @@ bool PersistentTable::updateTupleWithSpecificIndexes(TableTuple &targetTupleToUp
     }
 
     if (m_schema->getUninlinedObjectColumnCount() != 0) {
-        decreaseStringMemCount(targetTupleToUpdate.getNonInlinedMemorySize());
-        increaseStringMemCount(sourceTupleWithNewValues.getNonInlinedMemorySize());
+        decreaseStringMemCount(rowNonInlinedMemorySize(targetTupleToUpdate));
+        increaseStringMemCount(rowNonInlinedMemorySize(sourceTupleWithNewValues));
     }
 
     // TODO: This is a little messed up.
@@ -567,6 +814,10 @@ bool PersistentTable::updateTupleWithSpecificIndexes(TableTuple &targetTupleToUp
 
     // this is the actual write of the new values
     targetTupleToUpdate.copyForPersistentUpdate(sourceTupleWithNewValues, oldObjects, newObjects);
+    if (!m_stringDictionaries.empty() && !newObjects.empty()) {
+        encodeObjectColumns(targetTupleToUpdate, &newObjects);
+    }
+    notePaxTupleWritten(targetTupleToUpdate);
 
     ExecutorContext *ec = ExecutorContext::getExecutorContext();
     DRTupleStream *drStream = ec->drStream();
@@ -595,7 +846,7 @@ bool PersistentTable::updateTupleWithSpecificIndexes(TableTuple &targetTupleToUp
         // -- though maybe even that case should delegate memory management back to the PersistentTable
         // to keep the UndoAction stupid simple?
         // Anyway, there is no Undo Action in this case, so DIY.
-        NValue::freeObjectsFromTupleStorage(oldObjects);
+        freeObjects(oldObjects);
     }
 
     /**
@@ -656,13 +907,14 @@ void PersistentTable::updateTupleForUndo(char* tupleWithUnwantedValues,
 
     if (m_schema->getUninlinedObjectColumnCount() != 0)
     {
-        decreaseStringMemCount(targetTupleToUpdate.getNonInlinedMemorySize());
-        increaseStringMemCount(sourceTupleWithNewValues.getNonInlinedMemorySize());
+        decreaseStringMemCount(rowNonInlinedMemorySize(targetTupleToUpdate));
+        increaseStringMemCount(rowNonInlinedMemorySize(sourceTupleWithNewValues));
     }
 
     bool dirty = targetTupleToUpdate.isDirty();
     // this is the actual in-place revert to the old version
     targetTupleToUpdate.copy(sourceTupleWithNewValues);
+    notePaxTupleWritten(targetTupleToUpdate);
     if (dirty) {
         targetTupleToUpdate.setDirtyTrue();
     } else {
@@ -880,6 +1132,23 @@ bool PersistentTable::tryInsertOnAllIndexes(TableTuple *tuple) {
     return true;
 }
 
+bool PersistentTable::tryBulkInsertOnAllIndexes(const std::vector<TableTuple> &tuples) {
+    for (int i = static_cast<int>(m_indexes.size()) - 1; i >= 0; --i) {
+        FAIL_IF(!m_indexes[i]->addEntries(tuples)) {
+            VOLT_DEBUG("Failed to bulk insert into index %s,%s",
+                       m_indexes[i]->getTypeName().c_str(),
+                       m_indexes[i]->getName().c_str());
+            for (int j = i + 1; j < m_indexes.size(); ++j) {
+                BOOST_FOREACH(const TableTuple &tuple, tuples) {
+                    m_indexes[j]->deleteEntry(&tuple);
+                }
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
 bool PersistentTable::checkUpdateOnUniqueIndexes(TableTuple &targetTupleToUpdate,
                                                  const TableTuple &sourceTupleWithNewValues,
                                                  std::vector<TableIndex*> const &indexesToUpdate)
@@ -1084,6 +1353,66 @@ void PersistentTable::processLoadedTuple(TableTuple &tuple,
     }
 }
 
+/*
+ * Indexes take many tuples at once faster than one at a time, so the tuples
+ * that can be inserted are indexed together first. If any of them violates a
+ * unique index, they all go through processLoadedTuple instead, to find out
+ * which.
+ */
+void PersistentTable::processLoadedTuples(std::vector<TableTuple> &tuples,
+                                          ReferenceSerializeOutput *uniqueViolationOutput,
+                                          int32_t &serializedTupleCount,
+                                          size_t &tupleCountPosition,
+                                          bool shouldDRStreamRows) {
+    if (!m_stringDictionaries.empty()) {
+        // the strings were read into copies of the rows' own
+        for (size_t ii = 0; ii < tuples.size(); ++ii) {
+            encodeObjectColumns(tuples[ii]);
+        }
+    }
+    std::vector<bool> indexed(tuples.size(), false);
+    if ( ! m_indexes.empty() && tuples.size() > 1) {
+        std::vector<TableTuple> indexable;
+        indexable.reserve(tuples.size());
+        for (size_t ii = 0; ii < tuples.size(); ++ii) {
+            // tuples with nulls where they may not be will fail before reaching the indexes
+            if (checkNulls(tuples[ii])) {
+                indexable.push_back(tuples[ii]);
+                indexed[ii] = true;
+            }
+        }
+        if ( ! tryBulkInsertOnAllIndexes(indexable)) {
+            indexed.assign(tuples.size(), false);
+        }
+    }
+
+    size_t ii = 0;
+    try {
+        for (; ii < tuples.size(); ++ii) {
+            if (indexed[ii]) {
+                insertTupleCommon(tuples[ii], tuples[ii], true, shouldDRStreamRows, true);
+            }
+            else {
+                processLoadedTuple(tuples[ii], uniqueViolationOutput, serializedTupleCount, tupleCountPosition,
+                                   shouldDRStreamRows);
+            }
+        }
+    } catch (...) {
+        // the tuples after the failed one were never inserted
+        for (size_t jj = ii + 1; jj < tuples.size(); ++jj) {
+            if (indexed[jj]) {
+                deleteFromAllIndexes(&tuples[jj]);
+            }
+            if (m_schema->getUninlinedObjectColumnCount() != 0) {
+                // balance what deleteTupleStorage takes off for their strings
+                increaseStringMemCount(rowNonInlinedMemorySize(tuples[jj]));
+            }
+            deleteTupleStorage(tuples[jj]);
+        }
+        throw;
+    }
+}
+
 TableStats* PersistentTable::getTableStats() {
     return &stats_;
 }
@@ -1225,6 +1554,7 @@ void PersistentTable::notifyBlockWasCompactedAway(TBPtr block) {
 // Call-back from TupleBlock::merge() for each tuple moved.
 void PersistentTable::notifyTupleMovement(TBPtr sourceBlock, TBPtr targetBlock,
                                           TableTuple &sourceTuple, TableTuple &targetTuple) {
+    ++m_compactedTupleCount;
     if (m_tableStreamer != NULL) {
         m_tableStreamer->notifyTupleMovement(sourceBlock, targetBlock, sourceTuple, targetTuple);
     }
@@ -1361,6 +1691,45 @@ bool PersistentTable::doCompactionWithinSubset(TBBucketMap *bucketMap) {
     return true;
 }
 
+void PersistentTable::compressColdBlocks(uint32_t coldTicks) {
+    if (m_tableStreamer != NULL && m_tableStreamer->hasActiveStreams()) {
+        return;
+    }
+    int64_t residentHits = 0;
+    for (TBMapI i = m_data.begin(); i != m_data.end(); ++i) {
+        TBPtr block = i.data();
+        residentHits += block->takeResidentHits();
+        block->agePastTick(coldTicks);
+    }
+    ColdBlockCompressor::countResidentHits(residentHits);
+}
+
+void PersistentTable::pageBackedMemory(int64_t &hugePageBytes, int64_t &numaBoundBytes) {
+    hugePageBytes = 0;
+    numaBoundBytes = 0;
+    for (TBMapI i = m_data.begin(); i != m_data.end(); ++i) {
+        TBPtr block = i.data();
+        if (block->pageBacking() & PageAllocator::BACKED_HUGE) {
+            hugePageBytes += block->allocationSize();
+        }
+        if (block->pageBacking() & PageAllocator::BACKED_NUMA) {
+            numaBoundBytes += block->allocationSize();
+        }
+    }
+}
+
+void PersistentTable::compressedMemory(int32_t &compressedBlocks, int64_t &compressedBytes) {
+    compressedBlocks = 0;
+    compressedBytes = 0;
+    for (TBMapI i = m_data.begin(); i != m_data.end(); ++i) {
+        TBPtr block = i.data();
+        if (block->isCompressed()) {
+            ++compressedBlocks;
+            compressedBytes += block->compressedSize();
+        }
+    }
+}
+
 void PersistentTable::doIdleCompaction() {
     if (!m_blocksNotPendingSnapshot.empty()) {
         doCompactionWithinSubset(&m_blocksNotPendingSnapshotLoad);
@@ -1370,7 +1739,18 @@ void PersistentTable::doIdleCompaction() {
     }
 }
 
-void PersistentTable::doForcedCompaction() {
+static int64_t currentMicros() {
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+/*
+ * Merge blocks until the compaction predicate is satisfied or budgetMicros
+ * have passed. A compaction that runs out of budget is resumed by the next
+ * transaction to release an undo quantum on this table, or by the next tick.
+ */
+void PersistentTable::doBudgetedCompaction(int64_t budgetMicros) {
     if (m_tableStreamer.get() != NULL && m_tableStreamer->hasStreamType(TABLE_STREAM_RECOVERY)) {
         LogManager::getThreadLogger(LOGGERID_SQL)->log(LOGLEVEL_INFO,
             "Deferring compaction until recovery is complete.");
@@ -1380,10 +1760,14 @@ void PersistentTable::doForcedCompaction() {
     bool hadWork2 = true;
 
     char msg[512];
-    snprintf(msg, sizeof(msg), "Doing forced compaction with allocated tuple count %zd",
-             ((intmax_t)allocatedTupleCount()));
-    LogManager::getThreadLogger(LOGGERID_SQL)->log(LOGLEVEL_INFO, msg);
+    if (!m_compactionInProgress) {
+        snprintf(msg, sizeof(msg), "Doing forced compaction with allocated tuple count %zd",
+                 ((intmax_t)allocatedTupleCount()));
+        LogManager::getThreadLogger(LOGGERID_SQL)->log(LOGLEVEL_INFO, msg);
+        m_compactionInProgress = true;
+    }
 
+    const int64_t startMicros = currentMicros();
     int failedCompactionCountBefore = m_failedCompactionCount;
     while (compactionPredicate()) {
         assert(hadWork1 || hadWork2);
@@ -1424,7 +1808,14 @@ void PersistentTable::doForcedCompaction() {
             //std::cout << "Compacting blocks pending snapshot " << m_blocksPendingSnapshot.size() << std::endl;
             hadWork2 = doCompactionWithinSubset(&m_blocksPendingSnapshotLoad);
         }
+        if (budgetMicros >= 0 && currentMicros() - startMicros >= budgetMicros &&
+            compactionPredicate()) {
+            m_compactionStallMicros += currentMicros() - startMicros;
+            return;
+        }
     }
+    m_compactionStallMicros += currentMicros() - startMicros;
+    m_compactionInProgress = false;
     //If compactions have been failing lately, but it didn't fail this time
     //then compaction progressed until the predicate was satisfied
     if (failedCompactionCountBefore > 0 && failedCompactionCountBefore == m_failedCompactionCount) {
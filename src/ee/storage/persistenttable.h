@@ -81,6 +81,8 @@ class MaterializedViewInfo;
 
 namespace voltdb {
 
+class StringDictionary;
+
 /**
  * Interface used by contexts, scanners, iterators, and undo actions to access
  * normally-private stuff in PersistentTable.
@@ -102,6 +104,7 @@ public:
     void deleteTupleForUndo(char* tupleData, bool skipLookup = false);
     void deleteTupleRelease(char* tuple);
     void deleteTupleStorage(TableTuple &tuple, TBPtr block = TBPtr(NULL));
+    void freeObjects(const std::vector<char*> &objects);
 
     void snapshotFinishedScanningBlock(TBPtr finishedBlock, TBPtr nextBlock);
     uint32_t getTupleCount() const;
@@ -190,6 +193,7 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest,
                         public TupleMovementListener {
     friend class PersistentTableSurgeon;
     friend class TableFactory;
+    friend class PaxScanner;
     friend class ::CopyOnWriteTest;
     friend class ::CompactionTest_BasicCompaction;
     friend class ::CompactionTest_CompactionWithCopyOnWrite;
@@ -208,7 +212,7 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest,
 
     void notifyQuantumRelease() {
         if (compactionPredicate()) {
-            doForcedCompaction();
+            doBudgetedCompaction(m_compactionBudgetMicros);
         }
     }
 
@@ -351,8 +355,58 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest,
     }
 
     void doIdleCompaction();
+    /**
+     * Continue a forced compaction that earlier transactions left unfinished,
+     * for no longer than the compaction budget. Called from VoltDBEngine::tick,
+     * only while no transaction is open.
+     */
+    void doIncrementalCompaction() {
+        if (compactionPredicate()) {
+            doBudgetedCompaction(m_compactionBudgetMicros);
+        }
+    }
+
+    /**
+     * Age this table's blocks by a tick, compressing the ones that have gone
+     * coldTicks ticks without an access (see TupleBlock::agePastTick).
+     * Called from VoltDBEngine::tick, only while no transaction is open.
+     * The blocks of a table being streamed are left as they are until its
+     * streams finish.
+     */
+    void compressColdBlocks(uint32_t coldTicks);
     void printBucketInfo();
 
+    /**
+     * Bound the time, in microseconds, that one transaction or tick spends in
+     * forced compaction of this table. The bound is checked between block
+     * merges, so at least one merge is done per call. A negative budget
+     * compacts to completion.
+     */
+    void setCompactionBudget(int64_t micros) {
+        m_compactionBudgetMicros = micros;
+    }
+
+    // Number of tuples moved by compaction.
+    int64_t compactedTupleCount() const {
+        return m_compactedTupleCount;
+    }
+
+    // Number of free tuple slots that forced compaction has yet to reclaim.
+    int64_t pendingCompactionTupleCount() {
+        return compactionPredicate() ? allocatedTupleCount() - activeTupleCount() : 0;
+    }
+
+    // Microseconds spent in forced compaction.
+    int64_t compactionStallMicros() const {
+        return m_compactionStallMicros;
+    }
+
+    // Bytes of the table's blocks in huge pages, and on its engine's NUMA node.
+    void pageBackedMemory(int64_t &hugePageBytes, int64_t &numaBoundBytes);
+
+    // The table's blocks held compressed by compressColdBlocks, and the bytes they take compressed.
+    void compressedMemory(int32_t &compressedBlocks, int64_t &compressedBytes);
+
     void increaseStringMemCount(size_t bytes)
     {
         m_nonInlinedMemorySize += bytes;
@@ -366,6 +420,9 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest,
         return m_data.size();
     }
 
+    // The blocks and their PAX mini-pages
+    int64_t allocatedTupleMemory() const;
+
     // This is a testability feature not intended for use in product logic.
     int visibleTupleCount() const { return m_tupleCount - m_invisibleTuplesPendingDeleteCount; }
 
@@ -377,6 +434,33 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest,
         m_tupleLimit = newLimit;
     }
 
+    /**
+     * With the PAX layout, scans that read only a few inlined columns can
+     * read them from per-block column mini-pages (see PaxScanner) instead of
+     * from the full rows. The rows stay the primary storage either way.
+     */
+    bool isPaxLayout() const {
+        return m_paxLayout;
+    }
+
+    void setPaxLayout(bool paxLayout);
+
+    /**
+     * Keep each distinct string of these columns once, in a dictionary
+     * per column, with the rows holding it all pointing at that copy.
+     * Only non-inlined VARCHAR columns are encoded, the others are left
+     * as they are. The strings of rows already in the table are re-encoded.
+     */
+    void setDictionaryEncodedColumns(const std::vector<int> &columns);
+
+    /**
+     * The dictionaries of the encoded columns, by column, NULL for the
+     * others. Empty if no column is encoded.
+     */
+    const std::vector<StringDictionary*> &stringDictionaries() const {
+        return m_stringDictionaries;
+    }
+
     bool isPersistentTableEmpty()
     {
         // The narrow usage of this function (while updating the catalog)
@@ -480,11 +564,15 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest,
 
     void nextFreeTuple(TableTuple *tuple);
     bool doCompactionWithinSubset(TBBucketMap *bucketMap);
-    void doForcedCompaction();
+    void doForcedCompaction() {
+        doBudgetedCompaction(-1);
+    }
+    void doBudgetedCompaction(int64_t budgetMicros);
 
     void insertIntoAllIndexes(TableTuple *tuple);
     void deleteFromAllIndexes(TableTuple *tuple);
     bool tryInsertOnAllIndexes(TableTuple *tuple);
+    bool tryBulkInsertOnAllIndexes(const std::vector<TableTuple> &tuples);
     bool checkUpdateOnUniqueIndexes(TableTuple &targetTupleToUpdate,
                                     const TableTuple &sourceTupleWithNewValues,
                                     std::vector<TableIndex*> const &indexesToUpdate);
@@ -504,8 +592,10 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest,
     // The source tuple is used to create the ConstraintFailureException if one
     // occurs. In case of exception, target tuple should be released, but the
     // source tuple's memory should still be retained until the exception is
-    // handled.
-    void insertTupleCommon(TableTuple &source, TableTuple &target, bool fallible, bool shouldDRStream = true);
+    // handled. The target may already have been added to the indexes, see
+    // processLoadedTuples.
+    void insertTupleCommon(TableTuple &source, TableTuple &target, bool fallible, bool shouldDRStream = true,
+                           bool alreadyIndexed = false);
     void insertTupleForUndo(char *tuple);
     void updateTupleForUndo(char* targetTupleToUpdate,
                             char* sourceTupleWithNewValues,
@@ -529,8 +619,44 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest,
                                     size_t &tupleCountPosition,
                                     bool shouldDRStreamRows);
 
+    virtual void processLoadedTuples(std::vector<TableTuple> &tuples,
+                                     ReferenceSerializeOutput *uniqueViolationOutput,
+                                     int32_t &serializedTupleCount,
+                                     size_t &tupleCountPosition,
+                                     bool shouldDRStreamRows);
+
     TBPtr allocateNextBlock();
 
+    // Note a slot written other than by an append, for refreshPaxMiniPages.
+    void notePaxTupleWritten(const TableTuple &tuple);
+
+    // Copy the slots noted since the last scan into their blocks' PAX
+    // mini-pages. Called by PaxScanner before it reads them.
+    void refreshPaxMiniPages();
+
+    // Copy source into target, a free tuple slot, with strings of the
+    // encoded columns shared from their dictionaries.
+    void copyForPersistentInsert(TableTuple &target, const TableTuple &source);
+
+    // Swap the tuple's own copies of the strings of the encoded columns,
+    // among the objects given or all of them, for the shared ones.
+    void encodeObjectColumns(TableTuple &tuple, std::vector<char*> *newObjects = NULL);
+
+    // Release the strings the tuple refers to.
+    void freeObjectColumns(TableTuple &tuple);
+
+    // Release the strings of the tuple's columns or of those dropped by an update.
+    void freeObjects(const std::vector<char*> &objects);
+
+    // The memory of the strings the tuple holds on its own, not counting
+    // those it shares through a dictionary.
+    size_t rowNonInlinedMemorySize(const TableTuple &tuple) const;
+
+    // Give each row its own copy of the column's strings, or share them
+    // through a new dictionary.
+    void decodeColumn(int column);
+    void encodeColumn(int column);
+
     // CONSTRAINTS
     std::vector<bool> m_allowNulls;
 
@@ -540,6 +666,15 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest,
     // table row count limit
     int m_tupleLimit;
 
+    // scans may read inlined columns from PAX mini-pages
+    bool m_paxLayout;
+
+    // slots written in place or reused since the last PAX scan
+    std::vector<char*> m_paxWrittenTuples;
+
+    // owned dictionaries of the dictionary encoded columns, by column
+    std::vector<StringDictionary*> m_stringDictionaries;
+
     // list of materialized views that are sourced from this table
     std::vector<MaterializedViewMetadata *> m_views;
 
@@ -573,6 +708,12 @@ class PersistentTable : public Table, public UndoQuantumReleaseInterest,
     TBMap m_data;
     int m_failedCompactionCount;
 
+    // forced compaction progress, bound and stats
+    bool m_compactionInProgress;
+    int64_t m_compactionBudgetMicros;
+    int64_t m_compactedTupleCount;
+    int64_t m_compactionStallMicros;
+
     // This is a testability feature not intended for use in product logic.
     int m_invisibleTuplesPendingDeleteCount;
 
@@ -605,6 +746,10 @@ inline PersistentTable& PersistentTableSurgeon::getTable() {
     return m_table;
 }
 
+inline void PersistentTableSurgeon::freeObjects(const std::vector<char*> &objects) {
+    m_table.freeObjects(objects);
+}
+
 inline void PersistentTableSurgeon::insertTupleForUndo(char *tuple) {
     m_table.insertTupleForUndo(tuple);
 }
@@ -787,8 +932,8 @@ inline void PersistentTable::deleteTupleStorage(TableTuple &tuple, TBPtr block)
 
     // This frees referenced strings -- when could possibly be a better time?
     if (m_schema->getUninlinedObjectColumnCount() != 0) {
-        decreaseStringMemCount(tuple.getNonInlinedMemorySize());
-        tuple.freeObjectColumns();
+        decreaseStringMemCount(rowNonInlinedMemorySize(tuple));
+        freeObjectColumns(tuple);
     }
 
     tuple.setActiveFalse();
@@ -858,6 +1003,20 @@ inline TBPtr PersistentTable::findBlock(char *tuple, TBMap &blocks, int blockSiz
     return TBPtr(NULL);
 }
 
+inline void PersistentTable::notePaxTupleWritten(const TableTuple &tuple) {
+    if (!m_paxLayout) {
+        return;
+    }
+    // Past a write per tuple, rebuilding the mini-pages costs less than patching them.
+    if (m_paxWrittenTuples.size() > static_cast<size_t>(m_tupleCount)) {
+        for (TBMapI i = m_data.begin(); i != m_data.end(); ++i) {
+            i.data()->invalidatePaxMiniPages();
+        }
+        m_paxWrittenTuples.clear();
+    }
+    m_paxWrittenTuples.push_back(tuple.address());
+}
+
 inline TBPtr PersistentTable::allocateNextBlock() {
     TBPtr block(new (ThreadLocalPool::getExact(sizeof(TupleBlock))->malloc()) TupleBlock(this, m_blocksNotPendingSnapshotLoad[0]));
     m_data.insert( block->address(), block);
@@ -404,17 +404,26 @@ void Table::loadTuplesFromNoHeader(SerializeInputBE &serialize_io,
         lengthPosition = uniqueViolationOutput->reserveBytes(4);
     }
 
-    for (int i = 0; i < tupleCount; ++i) {
-        nextFreeTuple(&target);
-        target.setActiveTrue();
-        target.setDirtyFalse();
-        target.setPendingDeleteFalse();
-        target.setPendingDeleteOnUndoReleaseFalse();
-
-        target.deserializeFrom(serialize_io, stringPool);
-
-        processLoadedTuple(target, uniqueViolationOutput, serializedTupleCount, tupleCountPosition, shouldDRStreamRow);
+    // Read all the tuples before processing any, so that they can be indexed together
+    std::vector<TableTuple> loaded;
+    loaded.reserve(tupleCount);
+    try {
+        for (int i = 0; i < tupleCount; ++i) {
+            nextFreeTuple(&target);
+            target.setActiveTrue();
+            target.setDirtyFalse();
+            target.setPendingDeleteFalse();
+            target.setPendingDeleteOnUndoReleaseFalse();
+
+            target.deserializeFrom(serialize_io, stringPool);
+            loaded.push_back(target);
+        }
+    } catch (...) {
+        // keep the tuples read before the bad one, as loading them one at a time did
+        processLoadedTuples(loaded, uniqueViolationOutput, serializedTupleCount, tupleCountPosition, shouldDRStreamRow);
+        throw;
     }
+    processLoadedTuples(loaded, uniqueViolationOutput, serializedTupleCount, tupleCountPosition, shouldDRStreamRow);
 
     //If unique constraints are being handled, write the length/size of constraints that occured
     if (uniqueViolationOutput != NULL) {
@@ -527,11 +536,9 @@ void Table::addIndex(TableIndex *index) {
     assert(!isExistingTableIndex(m_indexes, index));
 
     // fill the index with tuples... potentially the slow bit
-    TableTuple tuple(m_schema);
-    TableIterator iter = iterator();
-    while (iter.next(tuple)) {
-        index->addEntry(&tuple);
-    }
+    std::vector<TableTuple> tuples;
+    collectTuples(tuples);
+    ParallelIndexBuilder::fill(index, tuples);
 
     // add the index to the table
     if (index->isUniqueIndex()) {
@@ -540,6 +547,35 @@ void Table::addIndex(TableIndex *index) {
     m_indexes.push_back(index);
 }
 
+void Table::addIndexes(const std::vector<TableIndex*> &indexes, int maxHelperThreads) {
+    // silently ignore indexes if they've gotten this far
+    if (isExport() || indexes.empty()) {
+        return;
+    }
+
+    std::vector<TableTuple> tuples;
+    collectTuples(tuples);
+    ParallelIndexBuilder builder(maxHelperThreads);
+    builder.build(indexes, tuples);
+
+    BOOST_FOREACH(TableIndex *index, indexes) {
+        assert(!isExistingTableIndex(m_indexes, index));
+        if (index->isUniqueIndex()) {
+            m_uniqueIndexes.push_back(index);
+        }
+        m_indexes.push_back(index);
+    }
+}
+
+void Table::collectTuples(std::vector<TableTuple> &tuples) {
+    TableTuple tuple(m_schema);
+    tuples.reserve(static_cast<size_t>(activeTupleCount()));
+    TableIterator iter = iterator();
+    while (iter.next(tuple)) {
+        tuples.push_back(tuple);
+    }
+}
+
 void Table::removeIndex(TableIndex *index) {
     // silently ignore indexes if they've gotten this far
     if (isExport()) {
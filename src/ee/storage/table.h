@@ -61,6 +61,7 @@
 #include "common/Pool.hpp"
 #include "common/tabletuple.h"
 #include "common/TheHashinator.h"
+#include "indexes/ParallelIndexBuilder.h"
 #include "storage/TupleBlock.h"
 #include "stx/btree_set.h"
 #include "common/ThreadLocalPool.h"
@@ -224,6 +225,10 @@ class Table {
 
     // mutating indexes
     virtual void addIndex(TableIndex *index);
+    // Add several new indexes, building them on up to maxHelperThreads
+    // threads besides this one.
+    void addIndexes(const std::vector<TableIndex*> &indexes,
+                    int maxHelperThreads = ParallelIndexBuilder::DEFAULT_HELPER_THREADS);
     virtual void removeIndex(TableIndex *index);
     virtual void setPrimaryKeyIndex(TableIndex *index);
 
@@ -357,6 +362,22 @@ protected:
                                     bool shouldDRStreamRow) {
     };
 
+    /*
+     * Called by Table::loadTuplesFrom with all the tuples it read. Tables
+     * that can do better than processing the tuples one at a time in order
+     * override this.
+     */
+    virtual void processLoadedTuples(std::vector<TableTuple> &tuples,
+                                     ReferenceSerializeOutput *uniqueViolationOutput,
+                                     int32_t &serializedTupleCount,
+                                     size_t &tupleCountPosition,
+                                     bool shouldDRStreamRow) {
+        for (size_t ii = 0; ii < tuples.size(); ++ii) {
+            processLoadedTuple(tuples[ii], uniqueViolationOutput, serializedTupleCount, tupleCountPosition,
+                               shouldDRStreamRow);
+        }
+    }
+
     virtual void swapTuples(TableTuple &sourceTupleWithNewValues, TableTuple &destinationTuple) {
         throwFatalException("Unsupported operation");
     }
@@ -367,12 +388,19 @@ public:
     virtual voltdb::TableStats* getTableStats() = 0;
 
 protected:
+    // the active tuples, to build indexes from
+    void collectTuples(std::vector<TableTuple> &tuples);
+
     // virtual block management functions
     virtual void nextFreeTuple(TableTuple *tuple) = 0;
     virtual void freeLastScanedBlock(std::vector<TBPtr>::iterator nextBlockIterator) {
         throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
                                      "May not use freeLastScanedBlock with streamed tables or persistent tables.");
     }
+    virtual TBPtr reloadSpilledBlock(std::vector<TBPtr>::iterator blockIterator) {
+        throw SerializableEEException(VOLT_EE_EXCEPTION_TYPE_EEEXCEPTION,
+                                     "May not use reloadSpilledBlock with streamed tables or persistent tables.");
+    }
 
     Table(int tableAllocationTargetSize);
     void resetTable();
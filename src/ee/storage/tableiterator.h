@@ -81,6 +81,14 @@ public:
      * @return true if succeeded. false if no more active tuple is there.
     */
     bool next(TableTuple &out);
+
+    /**
+     * Point up to maxTuples of the given tuples at the next tuples of the
+     * table, as next() would. For a temp table they all come from one block,
+     * so they stay valid even when blocks are deleted as the scan goes.
+     * @return the number of tuples retrieved, 0 if no more active tuple is there.
+     */
+    int nextBatch(TableTuple *out, int maxTuples);
     bool hasNext();
     int getLocation() const;
 
@@ -217,6 +225,21 @@ inline bool TableIterator::next(TableTuple &out) {
     return persistentNext(out);
 }
 
+inline int TableIterator::nextBatch(TableTuple *out, int maxTuples) {
+    int count = 0;
+    while (count < maxTuples) {
+        if (count > 0 && m_tempTableIterator &&
+            m_blockOffset >= m_currentBlock->unusedTupleBoundry()) {
+            break;
+        }
+        if (!next(out[count])) {
+            break;
+        }
+        ++count;
+    }
+    return count;
+}
+
 inline bool TableIterator::persistentNext(TableTuple &out) {
     while (m_foundTuples < m_activeTuples) {
         if (m_currentBlock == NULL ||
@@ -227,6 +250,7 @@ inline bool TableIterator::persistentNext(TableTuple &out) {
 //            }
             m_dataPtr = m_blockIterator.key();
             m_currentBlock = m_blockIterator.data();
+            m_currentBlock->makeResident();
             m_blockOffset = 0;
             m_blockIterator++;
         } else {
@@ -268,6 +292,10 @@ inline bool TableIterator::tempNext(TableTuple &out) {
             }
 
             m_currentBlock = *m_tempBlockIterator;
+            if (m_currentBlock == NULL) {
+                // the block was spilled to disk; it stays resident only while scanned
+                m_currentBlock = m_table->reloadSpilledBlock(m_tempBlockIterator);
+            }
             m_dataPtr = m_currentBlock->address();
             m_blockOffset = 0;
             m_tempBlockIterator++;
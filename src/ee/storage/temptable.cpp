@@ -45,6 +45,10 @@
 
 #include "temptable.h"
 #include "common/debuglog.h"
+#include "common/executorcontext.hpp"
+#include "common/serializeio.h"
+#include "common/ValuePeeker.hpp"
+#include "storage/TempTableSpillFile.h"
 
 #define TABLE_BLOCKSIZE 131072
 
@@ -53,7 +57,9 @@ namespace voltdb {
 TempTable::TempTable()
   : Table(TABLE_BLOCKSIZE),
     m_iter(this),
-    m_limits(NULL)
+    m_limits(NULL),
+    m_spillEnabled(false),
+    m_spilledBlockCount(0)
 {
     // this happens here because m_data might not be initialized above
     m_iter.reset(m_data.begin());
@@ -89,6 +95,123 @@ bool TempTable::deleteTuple(TableTuple &, bool)
     throwFatalException("TempTable does not support deleting individual tuples");
 }
 
+void TempTable::freeAllBlocks() {
+    deleteAllTuplesNonVirtual(false);
+    for (size_t ii = 0; ii < m_data.size(); ii++) {
+        if (m_limits && m_data[ii] != NULL) {
+            m_limits->reduceAllocated(m_tableAllocationSize);
+        }
+    }
+    m_data.clear();
+}
+
+void TempTable::enableSpill() {
+    assert(m_tupleCount == 0);
+    m_spillEnabled = (m_limits != NULL && m_limits->spillEnabled());
+}
+
+void TempTable::spillResidentBlocks() {
+    if ( ! m_spillEnabled) {
+        return;
+    }
+    if (m_spillFile == NULL) {
+        m_spillFile.reset(new TempTableSpillFile(m_limits->getSpillDirectory()));
+    }
+    m_spilledBlocks.resize(m_data.size());
+    for (size_t ii = 0; ii < m_data.size(); ii++) {
+        TBPtr block = m_data[ii];
+        // an empty block is left for the next insert to fill
+        if (block == NULL || block->unusedTupleBoundry() == 0) {
+            continue;
+        }
+        SpilledBlock& spilled = m_spilledBlocks[ii];
+        spilled.m_tupleCount = block->unusedTupleBoundry();
+        spilled.m_offset = m_spillFile->write(block->address(),
+                                              static_cast<size_t>(spilled.m_tupleCount) * m_tupleLength);
+        spilled.m_objectBytes = spillObjectColumns(block, spilled.m_tupleCount);
+        m_data[ii] = NULL;
+        ++m_spilledBlockCount;
+        m_limits->reduceAllocated(m_tableAllocationSize);
+    }
+    VOLT_DEBUG("Temp table %s spilled, %d of %d blocks on disk", m_name.c_str(),
+               static_cast<int>(m_spilledBlockCount), static_cast<int>(m_data.size()));
+}
+
+TBPtr TempTable::reloadSpilledBlock(std::vector<TBPtr>::iterator blockIterator) {
+    size_t index = static_cast<size_t>(blockIterator - m_data.begin());
+    assert(index < m_spilledBlocks.size());
+    const SpilledBlock& spilled = m_spilledBlocks[index];
+    assert(spilled.m_offset >= 0);
+
+    // Not kept in m_data: the block is freed as soon as the scan moves past it.
+    TBPtr block(new (ThreadLocalPool::getExact(sizeof(TupleBlock))->malloc()) TupleBlock(this, TBBucketPtr()));
+    m_spillFile->read(spilled.m_offset, block->address(),
+                      static_cast<size_t>(spilled.m_tupleCount) * m_tupleLength);
+    block->restoreUsedTuples(spilled.m_tupleCount);
+    reloadObjectColumns(block, spilled);
+    return block;
+}
+
+size_t TempTable::spillObjectColumns(const TBPtr& block, uint32_t tupleCount) {
+    const uint16_t objectColumnCount = m_schema->getUninlinedObjectColumnCount();
+    if (objectColumnCount == 0) {
+        return 0;
+    }
+    // Each value as NValue::serializeTo writes it: its length, or -1 for NULL, then its bytes.
+    TableTuple tuple(m_schema);
+    size_t length = 0;
+    for (uint32_t slot = 0; slot < tupleCount; slot++) {
+        tuple.move(block->address() + slot * m_tupleLength);
+        for (uint16_t ii = 0; ii < objectColumnCount; ii++) {
+            NValue value = tuple.getNValue(m_schema->getUninlinedObjectColumnInfoIndex(ii));
+            length += sizeof(int32_t);
+            if ( ! value.isNull()) {
+                length += ValuePeeker::peekObjectLength_withoutNull(value);
+            }
+        }
+    }
+    m_spillObjectBuffer.resize(length);
+    ReferenceSerializeOutput output(&m_spillObjectBuffer[0], length);
+    for (uint32_t slot = 0; slot < tupleCount; slot++) {
+        tuple.move(block->address() + slot * m_tupleLength);
+        for (uint16_t ii = 0; ii < objectColumnCount; ii++) {
+            tuple.getNValue(m_schema->getUninlinedObjectColumnInfoIndex(ii)).serializeTo(output);
+        }
+    }
+    // written right after the block's rows
+    m_spillFile->write(&m_spillObjectBuffer[0], length);
+    return length;
+}
+
+void TempTable::reloadObjectColumns(const TBPtr& block, const SpilledBlock& spilled) {
+    if (spilled.m_objectBytes == 0) {
+        return;
+    }
+    m_spillObjectBuffer.resize(spilled.m_objectBytes);
+    m_spillFile->read(spilled.m_offset + static_cast<int64_t>(spilled.m_tupleCount) * m_tupleLength,
+                      &m_spillObjectBuffer[0], spilled.m_objectBytes);
+    ReferenceSerializeInputBE input(&m_spillObjectBuffer[0], spilled.m_objectBytes);
+    // Like the strings of other temp tuples, they last as long as the fragment.
+    Pool* stringPool = ExecutorContext::getTempStringPool();
+    const uint16_t objectColumnCount = m_schema->getUninlinedObjectColumnCount();
+    TableTuple tuple(m_schema);
+    for (uint32_t slot = 0; slot < spilled.m_tupleCount; slot++) {
+        tuple.move(block->address() + slot * m_tupleLength);
+        for (uint16_t ii = 0; ii < objectColumnCount; ii++) {
+            const int column = m_schema->getUninlinedObjectColumnInfoIndex(ii);
+            NValue value;
+            value.deserializeFromAllocateForStorage(m_schema->columnType(column), input, stringPool);
+            tuple.setNValue(column, value);
+        }
+    }
+}
+
+void TempTable::resetSpill() {
+    m_spilledBlocks.clear();
+    m_spilledBlockCount = 0;
+    m_spillFile->truncate();
+}
+
 std::string TempTable::tableType() const { return "TempTable"; }
 
 voltdb::TableStats* TempTable::getTableStats() { return NULL; }
@@ -53,11 +53,14 @@
 #include "storage/TempTableLimits.h"
 #include "storage/TupleBlock.h"
 
+#include "boost/scoped_ptr.hpp"
+
 namespace voltdb {
 
 class TableColumn;
 class TableFactory;
 class TableStats;
+class TempTableSpillFile;
 
 /**
  * Represents a Temporary Table to store temporary result (final
@@ -67,6 +70,15 @@ class TableStats;
  * in TempTable to make it faster, use deleteAllTuples instead.  As
  * there is no deleteTuple, there is no freelist; TempTable does a
  * efficient thing for iterating and deleteAllTuples.
+ *
+ * A temp table with spilling enabled writes its full blocks to a scratch
+ * file once the fragment's TempTableLimits ask for it, and a TableIterator
+ * brings each block back only while it is being scanned. The addresses of
+ * its tuples are therefore not stable, so spilling is only for tables
+ * whose consumer reads them strictly through iterators. The values of
+ * uninlined columns are written out after the rows of their block and
+ * read back into the fragment's temp string pool, so a spilled tuple does
+ * not depend on the strings it was inserted with outliving the scan.
  */
 class TempTable : public Table {
     friend class TableFactory;
@@ -120,6 +132,12 @@ class TempTable : public Table {
 
     void deleteAllTuplesNonVirtual(bool freeAllocatedStrings);
 
+    /**
+     * Delete all tuples and also give back the block that deleteAllTuples
+     * keeps for reuse, for a scratch table that is about to be destroyed.
+     */
+    void freeAllBlocks();
+
     /**
      * Uses the pool to do a deep copy of the tuple including allocations
      * for all uninlined columns. Used by CopyOnWriteContext to back up tuples
@@ -138,6 +156,20 @@ class TempTable : public Table {
 
     int64_t tempTableTupleCount() const { return m_tupleCount; }
 
+    /**
+     * Allow this table to spill to disk if its limits have a spill directory.
+     * Must be called while the table is empty.
+     */
+    void enableSpill();
+    bool hasSpilledBlocks() const { return m_spilledBlockCount > 0; }
+
+    /**
+     * Write out every resident block and release its memory; later inserts
+     * start a new block. For a table that will not be scanned for a while.
+     * A no-op unless spilling is enabled.
+     */
+    void spillResidentBlocks();
+
     // ------------------------------------------------------------------
     // INDEXES
     // ------------------------------------------------------------------
@@ -165,15 +197,41 @@ class TempTable : public Table {
     void nextFreeTuple(TableTuple *tuple);
 
     void freeLastScanedBlock(std::vector<TBPtr>::iterator nextBlockIterator);
+    TBPtr reloadSpilledBlock(std::vector<TBPtr>::iterator blockIterator);
     std::vector<TBPtr>::iterator getDataEndBlockIterator();
 
+    void resetSpill();
+
     virtual void onSetColumns() {
         m_data.clear();
     };
 
   private:
     // pointers to chunks of data. Specific to table impl. Don't leak this type.
+    // Blocks that have been spilled are NULL here.
     std::vector<TBPtr> m_data;
+
+    // Where a spilled block lives in the spill file, by index into m_data:
+    // its rows, followed by the values of their uninlined columns.
+    struct SpilledBlock {
+        SpilledBlock() : m_offset(-1), m_tupleCount(0), m_objectBytes(0) { }
+        int64_t m_offset;
+        uint32_t m_tupleCount;
+        size_t m_objectBytes;
+    };
+
+    // Append the uninlined column values of the block's tuples to the
+    // spill file, and return how many bytes that took.
+    size_t spillObjectColumns(const TBPtr& block, uint32_t tupleCount);
+    // Read them back into the reloaded block's tuples.
+    void reloadObjectColumns(const TBPtr& block, const SpilledBlock& spilled);
+
+    bool m_spillEnabled;
+    boost::scoped_ptr<TempTableSpillFile> m_spillFile;
+    std::vector<SpilledBlock> m_spilledBlocks;
+    size_t m_spilledBlockCount;
+    // scratch space for the uninlined column values of a block
+    std::vector<char> m_spillObjectBuffer;
 };
 
 inline void TempTable::insertTupleNonVirtualWithDeepCopy(TableTuple &source, Pool *pool) {
@@ -222,6 +280,9 @@ inline void TempTable::deleteAllTuplesNonVirtual(bool freeAllocatedStrings) {
     // Don't call deleteTuple() here.
     const uint16_t uninlinedStringColumnCount = m_schema->getUninlinedObjectColumnCount();
     if (freeAllocatedStrings && uninlinedStringColumnCount > 0) {
+        // Spilled tuples come back with copies of their strings, so only
+        // tables that don't own their strings may spill.
+        assert(m_spilledBlockCount == 0);
         TableTuple target(m_schema);
         TableIterator iter(this, m_data.begin());
         while (iter.hasNext()) {
@@ -241,13 +302,26 @@ inline void TempTable::deleteAllTuplesNonVirtual(bool freeAllocatedStrings) {
         }
     }
 
+    if (m_spilledBlockCount > 0) {
+        resetSpill();
+    }
+
     // cheap clear of the preserved first block
     if (!m_data.empty()) {
-        m_data[0]->reset();
+        if (m_data[0] == NULL) {
+            // it was spilled or deleted as we went, so there is nothing to preserve
+            m_data.clear();
+        } else {
+            m_data[0]->reset();
+        }
     }
 }
 
 inline TBPtr TempTable::allocateNextBlock() {
+    if (m_spillEnabled && m_limits->shouldSpill(m_tableAllocationSize)) {
+        spillResidentBlocks();
+    }
+
     TBPtr block(new (ThreadLocalPool::getExact(sizeof(TupleBlock))->malloc()) TupleBlock(this, TBBucketPtr()));
     m_data.push_back(block);
 
@@ -265,7 +339,7 @@ inline void TempTable::nextFreeTuple(TableTuple *tuple) {
     }
 
     TBPtr block = m_data.back();
-    if (!block->hasFreeTuples()) {
+    if (block == NULL || !block->hasFreeTuples()) {
         block = allocateNextBlock();
     }
 
@@ -279,7 +353,7 @@ inline void TempTable::freeLastScanedBlock(std::vector<TBPtr>::iterator nextBloc
     if (m_data.begin() != nextBlockIterator) {
         nextBlockIterator--;
         // somehow we preserve the first block
-        if (m_data.begin() != nextBlockIterator) {
+        if (m_data.begin() != nextBlockIterator && *nextBlockIterator != NULL) {
             *nextBlockIterator = NULL;
             if (m_limits) {
                 m_limits->reduceAllocated(m_tableAllocationSize);
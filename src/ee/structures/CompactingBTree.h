@@ -0,0 +1,1206 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPACTINGBTREE_H_
+#define COMPACTINGBTREE_H_
+
+#include "ContiguousAllocator.h"
+#include "CompactingMap.h"
+
+#include <boost/type_traits/aligned_storage.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <stdint.h>
+#include <vector>
+
+namespace voltdb {
+
+/**
+ * B+tree with the same interface as CompactingMap, for tree indexes.
+ *
+ * Entries live in leaves of about TARGET_NODE_SIZE bytes, aligned to cache
+ * lines and linked in key order, and inner nodes hold only separator keys,
+ * so a lookup touches a few wide nodes rather than a node per level of a
+ * binary tree. Like CompactingMap, leaves and inner nodes are packed into
+ * ContiguousAllocators, and a freed node is filled by moving the last one,
+ * so deletes return memory.
+ *
+ * Entries are moved around with memcpy, so KeyValuePair must not point into
+ * itself. The index key types don't. An entry is constructed once, when it
+ * is inserted, and destroyed when it is erased or the tree is destroyed.
+ *
+ * The separator in front of each child of an inner node is a bitwise copy
+ * of the first key of that child's subtree, and is replaced whenever that
+ * key is erased. Keys may refer to memory that goes away with the entry
+ * (e.g. the strings of a GenericPersistentKey), so separators are never
+ * left referring to keys no longer in the tree.
+ *
+ * With hasRank, inner nodes count the entries under each child, giving
+ * the rank operations of CompactingMap in O(log n).
+ *
+ * As with CompactingMap, iterators are invalidated by any mutation.
+ */
+template<typename KeyValuePair, typename Compare, bool hasRank=false>
+class CompactingBTree {
+    typedef typename KeyValuePair::first_type Key;
+    typedef typename KeyValuePair::second_type Data;
+
+    static const int CACHE_LINE_SIZE = 64;
+    static const int TARGET_NODE_SIZE = 512;
+    static const int NODE_HEADER_SIZE = 32;
+    static const int MIN_SLOTS = 4;
+
+    static const int LEAF_FIT = (TARGET_NODE_SIZE - NODE_HEADER_SIZE) / static_cast<int>(sizeof(KeyValuePair));
+    static const int INNER_FIT = (TARGET_NODE_SIZE - NODE_HEADER_SIZE) /
+                                 static_cast<int>(sizeof(Key) + sizeof(void*) + sizeof(int64_t));
+    static const int LEAF_SLOTS = LEAF_FIT > MIN_SLOTS ? LEAF_FIT : MIN_SLOTS;
+    static const int INNER_SLOTS = INNER_FIT > MIN_SLOTS ? INNER_FIT : MIN_SLOTS;
+    // Nodes other than the root are kept at least half full.
+    static const int LEAF_MIN = LEAF_SLOTS / 2;
+    static const int INNER_MIN = INNER_SLOTS / 2;
+
+    typedef typename boost::aligned_storage<sizeof(KeyValuePair),
+                                            boost::alignment_of<KeyValuePair>::value>::type EntryStorage;
+    typedef typename boost::aligned_storage<sizeof(Key), boost::alignment_of<Key>::value>::type KeyStorage;
+
+    struct InnerNode;
+
+    struct Node {
+        InnerNode *parent;
+        // entries of a leaf, separators of an inner node
+        int32_t count;
+    };
+
+    struct LeafNode : public Node {
+        LeafNode *prev;
+        LeafNode *next;
+        EntryStorage slots[LEAF_SLOTS];
+
+        KeyValuePair &kv(int i) { return *reinterpret_cast<KeyValuePair*>(&slots[i]); }
+        const KeyValuePair &kv(int i) const { return *reinterpret_cast<const KeyValuePair*>(&slots[i]); }
+        const Key &key(int i) const { return kv(i).getKey(); }
+    } __attribute__((aligned(CACHE_LINE_SIZE)));
+
+    struct InnerNode : public Node {
+        // 1 if the children are leaves
+        int32_t level;
+        // keys[i] is the first key under children[i + 1]
+        KeyStorage keys[INNER_SLOTS];
+        Node *children[INNER_SLOTS + 1];
+        // entries under each child, if hasRank
+        int64_t subct[INNER_SLOTS + 1];
+
+        const Key &key(int i) const { return *reinterpret_cast<const Key*>(&keys[i]); }
+        void setKey(int i, const Key &key) { ::memcpy(&keys[i], &key, sizeof(Key)); }
+    } __attribute__((aligned(CACHE_LINE_SIZE)));
+
+    int64_t m_count;
+    Node *m_root;
+    // number of inner node levels, 0 when the root is a leaf
+    int m_height;
+    ContiguousAllocator m_leafAllocator;
+    ContiguousAllocator m_innerAllocator;
+    bool m_unique;
+
+    // templated comparison function object
+    // follows STL conventions
+    Compare m_comper;
+
+public:
+    class iterator {
+        friend class CompactingBTree<KeyValuePair, Compare, hasRank>;
+    protected:
+        LeafNode *m_leaf;
+        int m_pos;
+        iterator(LeafNode *leaf, int pos) : m_leaf(leaf), m_pos(pos) {}
+    public:
+        iterator() : m_leaf(NULL), m_pos(0) {}
+        iterator(const iterator &iter) : m_leaf(iter.m_leaf), m_pos(iter.m_pos) {}
+        const Key &key() const { return m_leaf->kv(m_pos).getKey(); }
+        const Data &value() const { return m_leaf->kv(m_pos).getValue(); }
+        void setValue(const Data &value) { m_leaf->kv(m_pos).setValue(value); }
+        void moveNext() {
+            if (m_leaf == NULL) {
+                return;
+            }
+            if (++m_pos == m_leaf->count) {
+                m_leaf = m_leaf->next;
+                m_pos = 0;
+            }
+        }
+        void movePrev() {
+            if (m_leaf == NULL) {
+                return;
+            }
+            if (m_pos-- == 0) {
+                m_leaf = m_leaf->prev;
+                m_pos = m_leaf == NULL ? 0 : m_leaf->count - 1;
+            }
+        }
+        bool isEnd() const { return m_leaf == NULL; }
+        bool equals(const iterator &iter) const {
+            if (isEnd()) {
+                return iter.isEnd();
+            }
+            return m_leaf == iter.m_leaf && m_pos == iter.m_pos;
+        }
+    };
+
+    CompactingBTree(bool unique, Compare comper);
+    ~CompactingBTree();
+
+    bool insert(const Key &key, const Data &data);
+    bool erase(const Key &key);
+    bool erase(iterator &iter);
+
+    /**
+     * Inserts pointed-to KeyValuePairs already sorted by key. An empty tree
+     * is built bottom up from evenly filled leaves. Returns false, leaving
+     * the tree as it was, if a unique tree would get a duplicate key.
+     */
+    template<typename Iterator> bool insertSorted(Iterator begin, Iterator end);
+
+    iterator find(const Key &key) const;
+    iterator findRank(int64_t ith) const;
+    int64_t size() const { return m_count; }
+    iterator begin() const;
+    iterator rbegin() const;
+
+    iterator lowerBound(const Key &key) const;
+    iterator upperBound(const Key &key) const;
+
+    std::pair<iterator, iterator> equalRange(const Key &key) const {
+        return std::pair<iterator, iterator>(lowerBound(key), upperBound(key));
+    }
+
+    size_t bytesAllocated() const {
+        return m_leafAllocator.bytesAllocated() + m_innerAllocator.bytesAllocated();
+    }
+
+    // Must pass a key that already in map, or else return -1
+    int64_t rankAsc(const Key& key) const;
+    int64_t rankUpper(const Key& key) const;
+
+    /**
+     * For debugging: verify the B+tree constraints are met. SLOW.
+     */
+    bool verify() const;
+
+private:
+    static int64_t chunkSize(size_t nodeSize) {
+        const int64_t nodes = (512 * 1024) / static_cast<int64_t>(nodeSize);
+        return nodes > 16 ? nodes : 16;
+    }
+
+    /**
+     * A bitwise copy of key in storage with its pointer part (if any) set
+     * to value. Unlike the copy constructor, this leaves any memory the key
+     * owns with the key, and nothing is destroyed when storage goes away.
+     */
+    static const Key &withPointer(KeyStorage &storage, const Key &key, const void *value) {
+        ::memcpy(&storage, &key, sizeof(Key));
+        Key &copy = *reinterpret_cast<Key*>(&storage);
+        setPointerValue(copy, value);
+        return copy;
+    }
+
+    LeafNode *leftmostLeaf() const;
+    LeafNode *rightmostLeaf() const;
+    // index of the first separator of node not less than (lower) or greater than (upper) key
+    int lowerChild(const InnerNode *node, const Key &key) const;
+    int upperChild(const InnerNode *node, const Key &key) const;
+    int lowerPos(const LeafNode *leaf, const Key &key) const;
+    int upperPos(const LeafNode *leaf, const Key &key) const;
+    static int childIndex(const InnerNode *parent, const Node *child);
+    int64_t rankOf(const LeafNode *leaf, int pos) const;
+
+    LeafNode *allocLeaf();
+    InnerNode *allocInner(int32_t level);
+    // Free a node by moving the last one of its kind into it.
+    // Return where track is afterwards.
+    Node *freeLeaf(LeafNode *leaf, Node *track);
+    Node *freeInner(InnerNode *node, Node *track);
+    void setParent(Node *child, InnerNode *parent) { child->parent = parent; }
+    int64_t subtreeCount(const Node *node, int level) const;
+
+    void insertIntoParent(Node *left, const Key &separator, Node *right, int level,
+                          int64_t leftCount, int64_t rightCount);
+    void eraseAt(LeafNode *leaf, int pos);
+    // Copy the first key of leaf into the separator in front of the subtree it starts.
+    void updateSeparator(LeafNode *leaf);
+    void rebalanceLeaf(LeafNode *leaf);
+    void rebalanceInner(InnerNode *node);
+    void removeChild(InnerNode *parent, int separatorIndex);
+
+    int verify(const Node *node, int level, const Key *lower, const Key *upper, bool isRoot,
+               const LeafNode *&previousLeaf, bool &ok) const;
+};
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+CompactingBTree<KeyValuePair, Compare, hasRank>::CompactingBTree(bool unique, Compare comper)
+    : m_count(0),
+      m_root(NULL),
+      m_height(0),
+      m_leafAllocator(static_cast<int32_t>(sizeof(LeafNode)),
+                      static_cast<int32_t>(chunkSize(sizeof(LeafNode))), CACHE_LINE_SIZE),
+      m_innerAllocator(static_cast<int32_t>(sizeof(InnerNode)),
+                       static_cast<int32_t>(chunkSize(sizeof(InnerNode) * 8)), CACHE_LINE_SIZE),
+      m_unique(unique),
+      m_comper(comper)
+{
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+CompactingBTree<KeyValuePair, Compare, hasRank>::~CompactingBTree()
+{
+    for (LeafNode *leaf = leftmostLeaf(); leaf != NULL; leaf = leaf->next) {
+        for (int i = 0; i < leaf->count; i++) {
+            leaf->kv(i).~KeyValuePair();
+        }
+    }
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+typename CompactingBTree<KeyValuePair, Compare, hasRank>::LeafNode *
+CompactingBTree<KeyValuePair, Compare, hasRank>::leftmostLeaf() const
+{
+    Node *node = m_root;
+    for (int level = m_height; node != NULL && level > 0; level--) {
+        node = static_cast<InnerNode*>(node)->children[0];
+    }
+    return static_cast<LeafNode*>(node);
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+typename CompactingBTree<KeyValuePair, Compare, hasRank>::LeafNode *
+CompactingBTree<KeyValuePair, Compare, hasRank>::rightmostLeaf() const
+{
+    Node *node = m_root;
+    for (int level = m_height; node != NULL && level > 0; level--) {
+        InnerNode *inner = static_cast<InnerNode*>(node);
+        node = inner->children[inner->count];
+    }
+    return static_cast<LeafNode*>(node);
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+typename CompactingBTree<KeyValuePair, Compare, hasRank>::iterator
+CompactingBTree<KeyValuePair, Compare, hasRank>::begin() const
+{
+    return iterator(leftmostLeaf(), 0);
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+typename CompactingBTree<KeyValuePair, Compare, hasRank>::iterator
+CompactingBTree<KeyValuePair, Compare, hasRank>::rbegin() const
+{
+    LeafNode *leaf = rightmostLeaf();
+    return iterator(leaf, leaf == NULL ? 0 : leaf->count - 1);
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+inline int CompactingBTree<KeyValuePair, Compare, hasRank>::lowerChild(const InnerNode *node, const Key &key) const
+{
+    int lo = 0;
+    int hi = node->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (m_comper(node->key(mid), key) < 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+inline int CompactingBTree<KeyValuePair, Compare, hasRank>::upperChild(const InnerNode *node, const Key &key) const
+{
+    int lo = 0;
+    int hi = node->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (m_comper(node->key(mid), key) <= 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+inline int CompactingBTree<KeyValuePair, Compare, hasRank>::lowerPos(const LeafNode *leaf, const Key &key) const
+{
+    int lo = 0;
+    int hi = leaf->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (m_comper(leaf->key(mid), key) < 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+inline int CompactingBTree<KeyValuePair, Compare, hasRank>::upperPos(const LeafNode *leaf, const Key &key) const
+{
+    int lo = 0;
+    int hi = leaf->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (m_comper(leaf->key(mid), key) <= 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+inline int CompactingBTree<KeyValuePair, Compare, hasRank>::childIndex(const InnerNode *parent, const Node *child)
+{
+    int i = 0;
+    while (parent->children[i] != child) {
+        i++;
+        assert(i <= parent->count);
+    }
+    return i;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+typename CompactingBTree<KeyValuePair, Compare, hasRank>::iterator
+CompactingBTree<KeyValuePair, Compare, hasRank>::lowerBound(const Key &key) const
+{
+    if (m_root == NULL) {
+        return iterator();
+    }
+    Node *node = m_root;
+    for (int level = m_height; level > 0; level--) {
+        InnerNode *inner = static_cast<InnerNode*>(node);
+        node = inner->children[lowerChild(inner, key)];
+    }
+    LeafNode *leaf = static_cast<LeafNode*>(node);
+    int pos = lowerPos(leaf, key);
+    if (pos == leaf->count) {
+        // the first greater key starts the next leaf
+        return iterator(leaf->next, 0);
+    }
+    return iterator(leaf, pos);
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+typename CompactingBTree<KeyValuePair, Compare, hasRank>::iterator
+CompactingBTree<KeyValuePair, Compare, hasRank>::upperBound(const Key &key) const
+{
+    if (m_root == NULL) {
+        return iterator();
+    }
+    KeyStorage tmp;
+    const Key &tmpKey = withPointer(tmp, key, MAXPOINTER);
+    Node *node = m_root;
+    for (int level = m_height; level > 0; level--) {
+        InnerNode *inner = static_cast<InnerNode*>(node);
+        node = inner->children[upperChild(inner, tmpKey)];
+    }
+    LeafNode *leaf = static_cast<LeafNode*>(node);
+    int pos = upperPos(leaf, tmpKey);
+    if (pos == leaf->count) {
+        return iterator(leaf->next, 0);
+    }
+    return iterator(leaf, pos);
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+typename CompactingBTree<KeyValuePair, Compare, hasRank>::iterator
+CompactingBTree<KeyValuePair, Compare, hasRank>::find(const Key &key) const
+{
+    iterator iter = lowerBound(key);
+    if (iter.isEnd() || m_comper(iter.key(), key) != 0) {
+        return iterator();
+    }
+    return iter;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+template<typename Iterator>
+bool CompactingBTree<KeyValuePair, Compare, hasRank>::insertSorted(Iterator begin, Iterator end)
+{
+    if (m_root != NULL) {
+        for (Iterator next = begin; next != end; ++next) {
+            if ( ! insert((*next)->getKey(), (*next)->getValue())) {
+                // only unique trees fail, so the keys find what was inserted
+                while (next != begin) {
+                    --next;
+                    erase((*next)->getKey());
+                }
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const int64_t count = std::distance(begin, end);
+    if (count == 0) {
+        return true;
+    }
+    if (m_unique) {
+        Iterator prev = begin;
+        for (Iterator next = begin; ++next != end; prev = next) {
+            if (m_comper((*prev)->getKey(), (*next)->getKey()) == 0) {
+                return false;
+            }
+        }
+    }
+
+    // Spread the entries evenly over as few leaves as will hold them,
+    // which leaves each of them at least half full.
+    const int64_t leafCount = (count + LEAF_SLOTS - 1) / LEAF_SLOTS;
+    std::vector<Node*> nodes;
+    std::vector<int64_t> counts;
+    nodes.reserve(static_cast<size_t>(leafCount));
+    counts.reserve(static_cast<size_t>(leafCount));
+    Iterator next = begin;
+    LeafNode *prevLeaf = NULL;
+    for (int64_t i = 0; i < leafCount; i++) {
+        LeafNode *leaf = allocLeaf();
+        leaf->count = static_cast<int32_t>((count * (i + 1)) / leafCount - (count * i) / leafCount);
+        for (int pos = 0; pos < leaf->count; pos++, ++next) {
+            // placement new, then assign so the key can take over what it owns
+            new (&leaf->slots[pos]) KeyValuePair();
+            leaf->kv(pos).setKey((*next)->getKey());
+            leaf->kv(pos).setValue((*next)->getValue());
+        }
+        leaf->prev = prevLeaf;
+        if (prevLeaf != NULL) {
+            prevLeaf->next = leaf;
+        }
+        prevLeaf = leaf;
+        nodes.push_back(leaf);
+        counts.push_back(leaf->count);
+    }
+
+    // Then each level of inner nodes the same way, until one node is left.
+    int level = 0;
+    while (nodes.size() > 1) {
+        level++;
+        const int64_t childCount = static_cast<int64_t>(nodes.size());
+        const int64_t parentCount = (childCount + INNER_SLOTS) / (INNER_SLOTS + 1);
+        std::vector<Node*> parents;
+        std::vector<int64_t> parentCounts;
+        parents.reserve(static_cast<size_t>(parentCount));
+        parentCounts.reserve(static_cast<size_t>(parentCount));
+        int64_t child = 0;
+        for (int64_t i = 0; i < parentCount; i++) {
+            InnerNode *inner = allocInner(level);
+            const int64_t last = (childCount * (i + 1)) / parentCount;
+            int64_t entries = 0;
+            for (int c = 0; child < last; c++, child++) {
+                Node *node = nodes[static_cast<size_t>(child)];
+                inner->children[c] = node;
+                setParent(node, inner);
+                if (c > 0) {
+                    // the separator is the first key of the child's leftmost leaf
+                    Node *first = node;
+                    for (int l = level - 1; l > 0; l--) {
+                        first = static_cast<InnerNode*>(first)->children[0];
+                    }
+                    inner->setKey(c - 1, static_cast<LeafNode*>(first)->key(0));
+                    inner->count = c;
+                }
+                if (hasRank) {
+                    inner->subct[c] = counts[static_cast<size_t>(child)];
+                }
+                entries += counts[static_cast<size_t>(child)];
+            }
+            parents.push_back(inner);
+            parentCounts.push_back(entries);
+        }
+        nodes.swap(parents);
+        counts.swap(parentCounts);
+    }
+
+    m_root = nodes[0];
+    m_height = level;
+    m_count = count;
+    return true;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+typename CompactingBTree<KeyValuePair, Compare, hasRank>::LeafNode *
+CompactingBTree<KeyValuePair, Compare, hasRank>::allocLeaf()
+{
+    LeafNode *leaf = static_cast<LeafNode*>(m_leafAllocator.alloc());
+    assert(leaf);
+    leaf->parent = NULL;
+    leaf->count = 0;
+    leaf->prev = NULL;
+    leaf->next = NULL;
+    return leaf;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+typename CompactingBTree<KeyValuePair, Compare, hasRank>::InnerNode *
+CompactingBTree<KeyValuePair, Compare, hasRank>::allocInner(int32_t level)
+{
+    InnerNode *node = static_cast<InnerNode*>(m_innerAllocator.alloc());
+    assert(node);
+    node->parent = NULL;
+    node->count = 0;
+    node->level = level;
+    return node;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+typename CompactingBTree<KeyValuePair, Compare, hasRank>::Node *
+CompactingBTree<KeyValuePair, Compare, hasRank>::freeLeaf(LeafNode *leaf, Node *track)
+{
+    LeafNode *last = static_cast<LeafNode*>(m_leafAllocator.last());
+    if (leaf != last) {
+        // move the last leaf into the hole
+        ::memcpy(static_cast<void*>(leaf), static_cast<const void*>(last), sizeof(LeafNode));
+        if (leaf->prev != NULL) {
+            leaf->prev->next = leaf;
+        }
+        if (leaf->next != NULL) {
+            leaf->next->prev = leaf;
+        }
+        if (leaf->parent != NULL) {
+            leaf->parent->children[childIndex(leaf->parent, last)] = leaf;
+        }
+        else {
+            m_root = leaf;
+        }
+        if (track == last) {
+            track = leaf;
+        }
+    }
+    m_leafAllocator.trim();
+    return track;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+typename CompactingBTree<KeyValuePair, Compare, hasRank>::Node *
+CompactingBTree<KeyValuePair, Compare, hasRank>::freeInner(InnerNode *node, Node *track)
+{
+    InnerNode *last = static_cast<InnerNode*>(m_innerAllocator.last());
+    if (node != last) {
+        ::memcpy(static_cast<void*>(node), static_cast<const void*>(last), sizeof(InnerNode));
+        for (int i = 0; i <= node->count; i++) {
+            setParent(node->children[i], node);
+        }
+        if (node->parent != NULL) {
+            node->parent->children[childIndex(node->parent, last)] = node;
+        }
+        else {
+            m_root = node;
+        }
+        if (track == last) {
+            track = node;
+        }
+    }
+    m_innerAllocator.trim();
+    return track;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+int64_t CompactingBTree<KeyValuePair, Compare, hasRank>::subtreeCount(const Node *node, int level) const
+{
+    if (level == 0) {
+        return node->count;
+    }
+    const InnerNode *inner = static_cast<const InnerNode*>(node);
+    int64_t count = 0;
+    for (int i = 0; i <= inner->count; i++) {
+        count += inner->subct[i];
+    }
+    return count;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+bool CompactingBTree<KeyValuePair, Compare, hasRank>::insert(const Key &key, const Data &value)
+{
+    if (m_root == NULL) {
+        LeafNode *leaf = allocLeaf();
+        // placement new, then assign as CompactingMap does so the key can take over what it owns
+        new (&leaf->slots[0]) KeyValuePair();
+        leaf->kv(0).setKey(key);
+        leaf->kv(0).setValue(value); // for PointerKeyType, this is a little duplicating process
+        leaf->count = 1;
+        m_root = leaf;
+        m_height = 0;
+        m_count = 1;
+        return true;
+    }
+
+    Node *node = m_root;
+    for (int level = m_height; level > 0; level--) {
+        InnerNode *inner = static_cast<InnerNode*>(node);
+        node = inner->children[upperChild(inner, key)];
+    }
+    LeafNode *leaf = static_cast<LeafNode*>(node);
+    // For non-unique maps, new duplicates go after existing ones.
+    int pos = upperPos(leaf, key);
+    if (m_unique && pos > 0 && m_comper(leaf->key(pos - 1), key) == 0) {
+        return false;
+    }
+
+    if (hasRank) {
+        for (Node *child = leaf; child->parent != NULL; child = child->parent) {
+            child->parent->subct[childIndex(child->parent, child)]++;
+        }
+    }
+
+    LeafNode *target = leaf;
+    if (leaf->count == LEAF_SLOTS) {
+        // split off the upper half into a new leaf after this one
+        LeafNode *right = allocLeaf();
+        const int mid = LEAF_SLOTS / 2;
+        right->count = LEAF_SLOTS - mid;
+        ::memcpy(static_cast<void*>(&right->slots[0]), static_cast<const void*>(&leaf->slots[mid]),
+                 sizeof(EntryStorage) * right->count);
+        leaf->count = mid;
+        right->next = leaf->next;
+        right->prev = leaf;
+        if (leaf->next != NULL) {
+            leaf->next->prev = right;
+        }
+        leaf->next = right;
+        if (pos > mid) {
+            target = right;
+            pos -= mid;
+        }
+        target->count++;
+        ::memmove(static_cast<void*>(&target->slots[pos + 1]), static_cast<const void*>(&target->slots[pos]),
+                  sizeof(EntryStorage) * (target->count - 1 - pos));
+        new (&target->slots[pos]) KeyValuePair();
+        target->kv(pos).setKey(key);
+        target->kv(pos).setValue(value);
+        insertIntoParent(leaf, right->key(0), right, 1, leaf->count, right->count);
+    }
+    else {
+        ::memmove(static_cast<void*>(&leaf->slots[pos + 1]), static_cast<const void*>(&leaf->slots[pos]),
+                  sizeof(EntryStorage) * (leaf->count - pos));
+        new (&leaf->slots[pos]) KeyValuePair();
+        leaf->kv(pos).setKey(key);
+        leaf->kv(pos).setValue(value);
+        leaf->count++;
+    }
+    if (pos == 0) {
+        updateSeparator(target);
+    }
+    m_count++;
+    return true;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+void CompactingBTree<KeyValuePair, Compare, hasRank>::insertIntoParent(Node *left, const Key &separator, Node *right,
+                                                                        int level, int64_t leftCount, int64_t rightCount)
+{
+    InnerNode *parent = left->parent;
+    if (parent == NULL) {
+        // grow a new root
+        InnerNode *root = allocInner(level);
+        root->count = 1;
+        root->setKey(0, separator);
+        root->children[0] = left;
+        root->children[1] = right;
+        root->subct[0] = leftCount;
+        root->subct[1] = rightCount;
+        left->parent = root;
+        right->parent = root;
+        m_root = root;
+        m_height = level;
+        return;
+    }
+
+    const int index = childIndex(parent, left);
+    if (parent->count < INNER_SLOTS) {
+        const int moved = parent->count - index;
+        ::memmove(&parent->keys[index + 1], &parent->keys[index], sizeof(KeyStorage) * moved);
+        ::memmove(&parent->children[index + 2], &parent->children[index + 1], sizeof(Node*) * moved);
+        ::memmove(&parent->subct[index + 2], &parent->subct[index + 1], sizeof(int64_t) * moved);
+        parent->setKey(index, separator);
+        parent->children[index + 1] = right;
+        parent->subct[index] = leftCount;
+        parent->subct[index + 1] = rightCount;
+        parent->count++;
+        right->parent = parent;
+        return;
+    }
+
+    // Split a full parent: lay out its separators and children with the new
+    // ones in place, keep the lower half, move the upper half to a new node
+    // and push the middle separator up.
+    KeyStorage keys[INNER_SLOTS + 1];
+    Node *children[INNER_SLOTS + 2];
+    int64_t counts[INNER_SLOTS + 2];
+    ::memcpy(keys, parent->keys, sizeof(KeyStorage) * index);
+    ::memcpy(&keys[index], &separator, sizeof(Key));
+    ::memcpy(&keys[index + 1], &parent->keys[index], sizeof(KeyStorage) * (INNER_SLOTS - index));
+    ::memcpy(children, parent->children, sizeof(Node*) * (index + 1));
+    children[index + 1] = right;
+    ::memcpy(&children[index + 2], &parent->children[index + 1], sizeof(Node*) * (INNER_SLOTS - index));
+    ::memcpy(counts, parent->subct, sizeof(int64_t) * (index + 1));
+    counts[index] = leftCount;
+    counts[index + 1] = rightCount;
+    ::memcpy(&counts[index + 2], &parent->subct[index + 1], sizeof(int64_t) * (INNER_SLOTS - index));
+
+    const int total = INNER_SLOTS + 1;
+    const int mid = total / 2;
+    InnerNode *sibling = allocInner(parent->level);
+    parent->count = mid;
+    ::memcpy(parent->keys, keys, sizeof(KeyStorage) * mid);
+    ::memcpy(parent->children, children, sizeof(Node*) * (mid + 1));
+    ::memcpy(parent->subct, counts, sizeof(int64_t) * (mid + 1));
+    sibling->count = total - mid - 1;
+    ::memcpy(sibling->keys, &keys[mid + 1], sizeof(KeyStorage) * sibling->count);
+    ::memcpy(sibling->children, &children[mid + 1], sizeof(Node*) * (sibling->count + 1));
+    ::memcpy(sibling->subct, &counts[mid + 1], sizeof(int64_t) * (sibling->count + 1));
+    for (int i = 0; i <= parent->count; i++) {
+        setParent(parent->children[i], parent);
+    }
+    for (int i = 0; i <= sibling->count; i++) {
+        setParent(sibling->children[i], sibling);
+    }
+
+    int64_t parentCount = 0;
+    int64_t siblingCount = 0;
+    if (hasRank) {
+        parentCount = subtreeCount(parent, parent->level);
+        siblingCount = subtreeCount(sibling, sibling->level);
+    }
+    const Key &middle = *reinterpret_cast<const Key*>(&keys[mid]);
+    insertIntoParent(parent, middle, sibling, parent->level + 1, parentCount, siblingCount);
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+void CompactingBTree<KeyValuePair, Compare, hasRank>::updateSeparator(LeafNode *leaf)
+{
+    assert(leaf->count > 0);
+    Node *node = leaf;
+    while (node->parent != NULL) {
+        const int index = childIndex(node->parent, node);
+        if (index > 0) {
+            node->parent->setKey(index - 1, leaf->key(0));
+            return;
+        }
+        node = node->parent;
+    }
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+bool CompactingBTree<KeyValuePair, Compare, hasRank>::erase(const Key &key)
+{
+    iterator iter = find(key);
+    if (iter.isEnd()) {
+        return false;
+    }
+    eraseAt(iter.m_leaf, iter.m_pos);
+    return true;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+bool CompactingBTree<KeyValuePair, Compare, hasRank>::erase(iterator &iter)
+{
+    assert( ! iter.isEnd());
+    eraseAt(iter.m_leaf, iter.m_pos);
+    return true;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+void CompactingBTree<KeyValuePair, Compare, hasRank>::eraseAt(LeafNode *leaf, int pos)
+{
+    if (hasRank) {
+        for (Node *child = leaf; child->parent != NULL; child = child->parent) {
+            child->parent->subct[childIndex(child->parent, child)]--;
+        }
+    }
+    leaf->kv(pos).~KeyValuePair();
+    leaf->count--;
+    ::memmove(static_cast<void*>(&leaf->slots[pos]), static_cast<const void*>(&leaf->slots[pos + 1]),
+              sizeof(EntryStorage) * (leaf->count - pos));
+    m_count--;
+
+    if (leaf->parent == NULL) {
+        if (leaf->count == 0) {
+            freeLeaf(leaf, NULL);
+            m_root = NULL;
+        }
+        return;
+    }
+    // The separator for an emptied leaf goes when it is rebalanced.
+    if (pos == 0 && leaf->count > 0) {
+        updateSeparator(leaf);
+    }
+    if (leaf->count < LEAF_MIN) {
+        rebalanceLeaf(leaf);
+    }
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+void CompactingBTree<KeyValuePair, Compare, hasRank>::removeChild(InnerNode *parent, int separatorIndex)
+{
+    // drop the separator and the child after it, whose entries went to the child before it
+    if (hasRank) {
+        parent->subct[separatorIndex] += parent->subct[separatorIndex + 1];
+    }
+    const int moved = parent->count - separatorIndex - 1;
+    ::memmove(&parent->keys[separatorIndex], &parent->keys[separatorIndex + 1], sizeof(KeyStorage) * moved);
+    ::memmove(&parent->children[separatorIndex + 1], &parent->children[separatorIndex + 2], sizeof(Node*) * moved);
+    ::memmove(&parent->subct[separatorIndex + 1], &parent->subct[separatorIndex + 2], sizeof(int64_t) * moved);
+    parent->count--;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+void CompactingBTree<KeyValuePair, Compare, hasRank>::rebalanceLeaf(LeafNode *leaf)
+{
+    InnerNode *parent = leaf->parent;
+    const int index = childIndex(parent, leaf);
+    LeafNode *left = index > 0 ? static_cast<LeafNode*>(parent->children[index - 1]) : NULL;
+    LeafNode *right = index < parent->count ? static_cast<LeafNode*>(parent->children[index + 1]) : NULL;
+
+    if (left != NULL && left->count > LEAF_MIN) {
+        // borrow the last entry of the left sibling
+        ::memmove(static_cast<void*>(&leaf->slots[1]), static_cast<const void*>(&leaf->slots[0]),
+                  sizeof(EntryStorage) * leaf->count);
+        ::memcpy(static_cast<void*>(&leaf->slots[0]), static_cast<const void*>(&left->slots[left->count - 1]),
+                 sizeof(EntryStorage));
+        left->count--;
+        leaf->count++;
+        parent->setKey(index - 1, leaf->key(0));
+        if (hasRank) {
+            parent->subct[index - 1]--;
+            parent->subct[index]++;
+        }
+        return;
+    }
+    if (right != NULL && right->count > LEAF_MIN) {
+        // borrow the first entry of the right sibling
+        const bool wasEmpty = leaf->count == 0;
+        ::memcpy(static_cast<void*>(&leaf->slots[leaf->count]), static_cast<const void*>(&right->slots[0]),
+                 sizeof(EntryStorage));
+        leaf->count++;
+        right->count--;
+        ::memmove(static_cast<void*>(&right->slots[0]), static_cast<const void*>(&right->slots[1]),
+                  sizeof(EntryStorage) * right->count);
+        parent->setKey(index, right->key(0));
+        if (hasRank) {
+            parent->subct[index]++;
+            parent->subct[index + 1]--;
+        }
+        if (wasEmpty) {
+            updateSeparator(leaf);
+        }
+        return;
+    }
+
+    // merge with a sibling, into the left one of the two
+    LeafNode *into = left != NULL ? left : leaf;
+    LeafNode *from = left != NULL ? leaf : right;
+    const int separatorIndex = left != NULL ? index - 1 : index;
+    const bool wasEmpty = into->count == 0;
+    ::memcpy(static_cast<void*>(&into->slots[into->count]), static_cast<const void*>(&from->slots[0]),
+             sizeof(EntryStorage) * from->count);
+    into->count += from->count;
+    from->count = 0;
+    into->next = from->next;
+    if (from->next != NULL) {
+        from->next->prev = into;
+    }
+    removeChild(parent, separatorIndex);
+    if (wasEmpty) {
+        updateSeparator(into);
+    }
+    freeLeaf(from, NULL);
+
+    if (parent->parent == NULL) {
+        if (parent->count == 0) {
+            // the root has one child left, which becomes the root
+            Node *child = parent->children[0];
+            child->parent = NULL;
+            m_root = child;
+            m_height = 0;
+            freeInner(parent, NULL);
+        }
+    }
+    else if (parent->count < INNER_MIN) {
+        rebalanceInner(parent);
+    }
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+void CompactingBTree<KeyValuePair, Compare, hasRank>::rebalanceInner(InnerNode *node)
+{
+    InnerNode *parent = node->parent;
+    const int index = childIndex(parent, node);
+    InnerNode *left = index > 0 ? static_cast<InnerNode*>(parent->children[index - 1]) : NULL;
+    InnerNode *right = index < parent->count ? static_cast<InnerNode*>(parent->children[index + 1]) : NULL;
+
+    if (left != NULL && left->count > INNER_MIN) {
+        // rotate the last child of the left sibling through the parent
+        ::memmove(&node->keys[1], &node->keys[0], sizeof(KeyStorage) * node->count);
+        ::memmove(&node->children[1], &node->children[0], sizeof(Node*) * (node->count + 1));
+        ::memmove(&node->subct[1], &node->subct[0], sizeof(int64_t) * (node->count + 1));
+        ::memcpy(&node->keys[0], &parent->keys[index - 1], sizeof(KeyStorage));
+        ::memcpy(&parent->keys[index - 1], &left->keys[left->count - 1], sizeof(KeyStorage));
+        node->children[0] = left->children[left->count];
+        node->subct[0] = left->subct[left->count];
+        setParent(node->children[0], node);
+        left->count--;
+        node->count++;
+        if (hasRank) {
+            parent->subct[index - 1] -= node->subct[0];
+            parent->subct[index] += node->subct[0];
+        }
+        return;
+    }
+    if (right != NULL && right->count > INNER_MIN) {
+        // rotate the first child of the right sibling through the parent
+        ::memcpy(&node->keys[node->count], &parent->keys[index], sizeof(KeyStorage));
+        ::memcpy(&parent->keys[index], &right->keys[0], sizeof(KeyStorage));
+        node->children[node->count + 1] = right->children[0];
+        node->subct[node->count + 1] = right->subct[0];
+        setParent(node->children[node->count + 1], node);
+        node->count++;
+        if (hasRank) {
+            parent->subct[index] += right->subct[0];
+            parent->subct[index + 1] -= right->subct[0];
+        }
+        right->count--;
+        ::memmove(&right->keys[0], &right->keys[1], sizeof(KeyStorage) * right->count);
+        ::memmove(&right->children[0], &right->children[1], sizeof(Node*) * (right->count + 1));
+        ::memmove(&right->subct[0], &right->subct[1], sizeof(int64_t) * (right->count + 1));
+        return;
+    }
+
+    // merge with a sibling, pulling the separator between them down from the parent
+    InnerNode *into = left != NULL ? left : node;
+    InnerNode *from = left != NULL ? node : right;
+    const int separatorIndex = left != NULL ? index - 1 : index;
+    ::memcpy(&into->keys[into->count], &parent->keys[separatorIndex], sizeof(KeyStorage));
+    ::memcpy(&into->keys[into->count + 1], &from->keys[0], sizeof(KeyStorage) * from->count);
+    ::memcpy(&into->children[into->count + 1], &from->children[0], sizeof(Node*) * (from->count + 1));
+    ::memcpy(&into->subct[into->count + 1], &from->subct[0], sizeof(int64_t) * (from->count + 1));
+    for (int i = into->count + 1; i <= into->count + 1 + from->count; i++) {
+        setParent(into->children[i], into);
+    }
+    into->count += from->count + 1;
+    removeChild(parent, separatorIndex);
+    parent = static_cast<InnerNode*>(freeInner(from, parent));
+
+    if (parent->parent == NULL) {
+        if (parent->count == 0) {
+            Node *child = parent->children[0];
+            child->parent = NULL;
+            m_root = child;
+            m_height--;
+            freeInner(parent, NULL);
+        }
+    }
+    else if (parent->count < INNER_MIN) {
+        rebalanceInner(parent);
+    }
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+int64_t CompactingBTree<KeyValuePair, Compare, hasRank>::rankOf(const LeafNode *leaf, int pos) const
+{
+    int64_t rank = pos + 1;
+    const Node *node = leaf;
+    while (node->parent != NULL) {
+        const InnerNode *parent = node->parent;
+        const int index = childIndex(parent, node);
+        for (int i = 0; i < index; i++) {
+            rank += parent->subct[i];
+        }
+        node = parent;
+    }
+    return rank;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+int64_t CompactingBTree<KeyValuePair, Compare, hasRank>::rankAsc(const Key& key) const
+{
+    if (!hasRank) {
+        return -1;
+    }
+    // return -1 if the key passed in is not in the map
+    if (find(key).isEnd()) {
+        return -1;
+    }
+    // the rank of the first entry with the key, regardless of the pointer part
+    KeyStorage tmp;
+    iterator iter = lowerBound(withPointer(tmp, key, NULL));
+    return rankOf(iter.m_leaf, iter.m_pos);
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+int64_t CompactingBTree<KeyValuePair, Compare, hasRank>::rankUpper(const Key& key) const
+{
+    if (!hasRank) {
+        return -1;
+    }
+    if (m_unique) {
+        return rankAsc(key);
+    }
+    if (find(key).isEnd()) {
+        return -1;
+    }
+    iterator iter = upperBound(key);
+    if (iter.isEnd()) {
+        return m_count;
+    }
+    return rankOf(iter.m_leaf, iter.m_pos) - 1;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+typename CompactingBTree<KeyValuePair, Compare, hasRank>::iterator
+CompactingBTree<KeyValuePair, Compare, hasRank>::findRank(int64_t ith) const
+{
+    if ((!hasRank) || m_root == NULL || ith < 1 || ith > m_count) {
+        return iterator();
+    }
+    Node *node = m_root;
+    int64_t rank = ith;
+    for (int level = m_height; level > 0; level--) {
+        InnerNode *inner = static_cast<InnerNode*>(node);
+        int i = 0;
+        while (rank > inner->subct[i]) {
+            rank -= inner->subct[i];
+            i++;
+        }
+        node = inner->children[i];
+    }
+    return iterator(static_cast<LeafNode*>(node), static_cast<int>(rank - 1));
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+bool CompactingBTree<KeyValuePair, Compare, hasRank>::verify() const
+{
+    if (m_root == NULL) {
+        if (m_count != 0 || m_leafAllocator.count() != 0 || m_innerAllocator.count() != 0) {
+            printf("Empty tree has %ld entries\n", (long)m_count);
+            return false;
+        }
+        return true;
+    }
+    if (m_root->parent != NULL) {
+        printf("Root has a parent\n");
+        return false;
+    }
+    bool ok = true;
+    const LeafNode *previousLeaf = NULL;
+    const int64_t count = verify(m_root, m_height, NULL, NULL, true, previousLeaf, ok);
+    if (!ok) {
+        return false;
+    }
+    if (previousLeaf->next != NULL) {
+        printf("Last leaf has a next leaf\n");
+        return false;
+    }
+    if (count != m_count) {
+        printf("Found %ld entries, expected %ld\n", (long)count, (long)m_count);
+        return false;
+    }
+    return true;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+int CompactingBTree<KeyValuePair, Compare, hasRank>::verify(const Node *node, int level,
+                                                            const Key *lower, const Key *upper, bool isRoot,
+                                                            const LeafNode *&previousLeaf, bool &ok) const
+{
+    if (level == 0) {
+        const LeafNode *leaf = static_cast<const LeafNode*>(node);
+        if (leaf->count < (isRoot ? 1 : LEAF_MIN) || leaf->count > LEAF_SLOTS) {
+            printf("Leaf has %d entries\n", leaf->count);
+            ok = false;
+        }
+        if (leaf->prev != previousLeaf || (previousLeaf != NULL && previousLeaf->next != leaf)) {
+            printf("Leaves are not linked in order\n");
+            ok = false;
+        }
+        previousLeaf = leaf;
+        for (int i = 0; ok && i < leaf->count; i++) {
+            if (i > 0 && m_comper(leaf->key(i - 1), leaf->key(i)) > (m_unique ? -1 : 0)) {
+                printf("Leaf entries out of order\n");
+                ok = false;
+            }
+            if (lower != NULL && m_comper(*lower, leaf->key(i)) > 0) {
+                printf("Leaf entry is less than its separator\n");
+                ok = false;
+            }
+            if (upper != NULL && m_comper(leaf->key(i), *upper) > (m_unique ? -1 : 0)) {
+                printf("Leaf entry is greater than the next separator\n");
+                ok = false;
+            }
+        }
+        if (ok && lower != NULL && m_comper(*lower, leaf->key(0)) != 0) {
+            printf("Separator is not the first key of its subtree\n");
+            ok = false;
+        }
+        return leaf->count;
+    }
+
+    const InnerNode *inner = static_cast<const InnerNode*>(node);
+    if (inner->level != level) {
+        printf("Inner node at level %d says it is at %d\n", level, inner->level);
+        ok = false;
+        return 0;
+    }
+    if (inner->count < (isRoot ? 1 : INNER_MIN) || inner->count > INNER_SLOTS) {
+        printf("Inner node has %d separators\n", inner->count);
+        ok = false;
+        return 0;
+    }
+    int64_t count = 0;
+    for (int i = 0; ok && i <= inner->count; i++) {
+        const Node *child = inner->children[i];
+        if (child->parent != inner) {
+            printf("Child has the wrong parent\n");
+            ok = false;
+            break;
+        }
+        const Key *childLower = i == 0 ? lower : &inner->key(i - 1);
+        const Key *childUpper = i == inner->count ? upper : &inner->key(i);
+        const int64_t childCount = verify(child, level - 1, childLower, childUpper, false, previousLeaf, ok);
+        if (hasRank && childCount != inner->subct[i]) {
+            printf("Child has %ld entries, counted as %ld\n", (long)childCount, (long)inner->subct[i]);
+            ok = false;
+        }
+        count += childCount;
+    }
+    return static_cast<int>(count);
+}
+
+} // namespace voltdb
+
+#endif // COMPACTINGBTREE_H_
@@ -19,14 +19,15 @@
 #define COMPACTINGHASHTABLE_H_
 
 #include "ContiguousAllocator.h"
+#include "common/PageAllocator.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <utility>
 #include <cassert>
 #include <climits>
 #include <iostream>
 #include <cstring>
-#include <sys/mman.h>
 #include <boost/functional/hash.hpp>
 #include <stdint.h>
 
@@ -46,6 +47,9 @@ namespace voltdb {
      *    doesn't support iteration over all values.
      * 4. It allocates over a megabyte when it only contains a single value. It's not as useful for
      *    smaller, more general usage.
+     * 5. It grows and shrinks incrementally. After a resize, the old bucket array stays live and
+     *    each insert or erase migrates a few of its buckets to the new one, so no single update
+     *    pays for rehashing the whole table.
      */
     template<class K, class T, class H = boost::hash<K>, class EK = std::equal_to<K>, class ET = std::equal_to<T> >
     class CompactingHashTable {
@@ -64,11 +68,13 @@ namespace voltdb {
         // (new hash will be 30% full)
         static const uint64_t MIN_LOAD_FACTOR = 15; // %
 
-        static const uint64_t TABLE_SIZES[];
+        // old buckets moved to the new bucket array by each insert or erase during a resize
+        // (enough to finish before the next resize is due, even when shrinking)
+        static const uint64_t BUCKETS_MIGRATED_PER_UPDATE = 64;
 
 #ifndef MEMCHECK
 
-        // start with a roughly 512k hash table
+        // start with a 512k hash table
         // (includes 64k 8B pointers)
         static const uint64_t BUCKET_INITIAL_INDEX = 14;
 
@@ -113,10 +119,13 @@ namespace voltdb {
         };
 
         HashNode **m_buckets;             // the array holding the buckets
+        HashNode **m_oldBuckets;          // the array being resized away from, or NULL
         bool m_unique;                    // support unique
         uint64_t m_count;                 // number of items in the hash
         uint64_t m_uniqueCount;           // number of unique keys
-        int m_sizeIndex;                  // current bucket count (from array)
+        int m_sizeIndex;                  // current bucket count (as a power of two, see tableSize)
+        int m_oldSizeIndex;               // bucket count of m_oldBuckets
+        uint64_t m_migratedCount;         // buckets of m_oldBuckets already moved to m_buckets
         ContiguousAllocator m_allocator;  // allocator supporting compaction
         Hasher m_hasher;                  // instance of the hashing function
         KeyEqChecker m_keyEq;             // instance of the key eq checker
@@ -171,14 +180,39 @@ namespace voltdb {
         bool erase(iterator &iter);
         /** STL-ish size() method */
         size_t size() const { return m_count; }
+        /** make room for count more keys, so inserting them doesn't resize the table */
+        void reserve(size_t count);
 
         /** Return bytes used for this index */
-        size_t bytesAllocated() const { return m_allocator.bytesAllocated() + TABLE_SIZES[m_sizeIndex] * sizeof(HashNode*); }
+        size_t bytesAllocated() const
+        {
+            size_t bucketBytes = tableSize(m_sizeIndex) * sizeof(HashNode*);
+            if (m_oldBuckets) {
+                bucketBytes += tableSize(m_oldSizeIndex) * sizeof(HashNode*);
+            }
+            return m_allocator.bytesAllocated() + bucketBytes;
+        }
+
+        /** Is a resize still migrating buckets? */
+        bool isResizing() const { return m_oldBuckets != NULL; }
 
         /** verification for debugging and testing */
         bool verify();
 
     protected:
+        /** the number of buckets for a size index */
+        static uint64_t tableSize(int sizeIndex) { return 4ULL << sizeIndex; }
+        /**
+         * Bucket of a hash in a table of tableSize(sizeIndex) buckets: the top bits of the
+         * hash times 2^64/phi (Fibonacci hashing), which spreads weak hashes like the
+         * identity hash of integers without a division.
+         */
+        static uint64_t bucketIndex(uint64_t hash, int sizeIndex) {
+            return (hash * 0x9E3779B97F4A7C15ULL) >> (62 - sizeIndex);
+        }
+        /** the bucket currently holding the nodes with this hash, old or new */
+        HashNode **bucketFor(uint64_t hash) const;
+
         /** find, given a bucket/key */
         HashNode *find(const HashNode *bucket, const Key &key) const;
         /** find and exact match, given a bucket */
@@ -192,49 +226,17 @@ namespace voltdb {
         /** after remove, ensure memory for hashnodes is contiguous */
         void deleteAndFixup(HashNode *node);
 
-        /** see if the hash needs to grow or shrink */
-        void checkLoadFactor();
+        /** see if the hash needs to grow or shrink (inserts only grow it, keeping a reserve) */
+        void checkLoadFactor(bool mayShrink = true);
         /** grow/shrink the hash table */
         void resize(int newSizeIndex);
+        /** move up to bucketCount old buckets to the new bucket array */
+        void migrate(uint64_t bucketCount);
+        /** free the nodes chained from a bucket array, and the array */
+        void freeBuckets(HashNode **buckets, int sizeIndex);
+        bool verifyBuckets(HashNode **buckets, uint64_t first, uint64_t end, size_t &count);
     };
 
-    template<class K, class T, class H, class EK, class ET>
-    const uint64_t CompactingHashTable<K, T, H, EK, ET>::TABLE_SIZES[] = {
-        3,
-        7,
-        13,
-        31,
-        61,
-        127,
-        251,
-        509,
-        1021,
-        2039,
-        4093,
-        8191,
-        16381,
-        32749,
-        65521,
-        131071,
-        262139,
-        524287,
-        1048573,
-        2097143,
-        4194301,
-        8388593,
-        16777213,
-        33554393,
-        67108859,
-        134217689,
-        268435399,
-        536870909,
-        1073741789,
-        2147483647,
-        4294967291,
-        8589934583
-    };
-
-
     ///////////////////////////////////////////
     //
     // COMPACTING HASH TABLE CODE
@@ -243,32 +245,46 @@ namespace voltdb {
 
     template<class K, class T, class H, class EK, class ET>
     CompactingHashTable<K, T, H, EK, ET>::CompactingHashTable(bool unique, Hasher hasher, KeyEqChecker keyEq, DataEqChecker dataEq)
-    : m_unique(unique),
+    : m_oldBuckets(NULL),
+    m_unique(unique),
     m_count(0),
     m_uniqueCount(0),
     m_sizeIndex(BUCKET_INITIAL_INDEX),
+    m_oldSizeIndex(0),
+    m_migratedCount(0),
     m_allocator((int32_t)(unique ? sizeof(HashNodeSmall) : sizeof(HashNode)), ALLOCATOR_CHUNK_SIZE),
     m_hasher(hasher),
     m_keyEq(keyEq),
     m_dataEq(dataEq)
     {
         // allocate the hash table and bzero it (bzero is crucial)
-        void *memory = mmap(NULL, sizeof(HashNode*) * TABLE_SIZES[m_sizeIndex], PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        void *memory = PageAllocator::allocate(sizeof(HashNode*) * tableSize(m_sizeIndex));
         assert(memory);
         m_buckets = reinterpret_cast<HashNode**>(memory);
-        memset(m_buckets, 0, sizeof(HashNode*) * TABLE_SIZES[m_sizeIndex]);
+        memset(m_buckets, 0, sizeof(HashNode*) * tableSize(m_sizeIndex));
     }
 
     template<class K, class T, class H, class EK, class ET>
     CompactingHashTable<K, T, H, EK, ET>::~CompactingHashTable() {
         // unlink all of the nodes, which will call destructors correctly
-        for (size_t i = 0; i < TABLE_SIZES[m_sizeIndex]; ++i) {
-            while (m_buckets[i]) {
-                HashNode *node = m_buckets[i];
+        freeBuckets(m_buckets, m_sizeIndex);
+        if (m_oldBuckets) {
+            freeBuckets(m_oldBuckets, m_oldSizeIndex);
+        }
+
+        // when the allocator gets cleaned up, it will
+        // free the memory used for nodes
+    }
+
+    template<class K, class T, class H, class EK, class ET>
+    void CompactingHashTable<K, T, H, EK, ET>::freeBuckets(HashNode **buckets, int sizeIndex) {
+        for (size_t i = 0; i < tableSize(sizeIndex); ++i) {
+            while (buckets[i]) {
+                HashNode *node = buckets[i];
                 if (m_unique)
-                    removeUnique(&(m_buckets[i]), NULL, node);
+                    removeUnique(&(buckets[i]), NULL, node);
                 else
-                    remove(&(m_buckets[i]), NULL, node, NULL, node);
+                    remove(&(buckets[i]), NULL, node, NULL, node);
                 // safe to call the small destructor because the extra field
                 //  for the larger HashNode isn't involved
                 (reinterpret_cast<HashNodeSmall*>(node))->~HashNodeSmall();
@@ -276,46 +292,57 @@ namespace voltdb {
         }
 
         // delete the hashtable
-        munmap(m_buckets, sizeof(HashNode*) * TABLE_SIZES[m_sizeIndex]);
+        PageAllocator::release(buckets, sizeof(HashNode*) * tableSize(sizeIndex));
+    }
 
-        // when the allocator gets cleaned up, it will
-        // free the memory used for nodes
+    template<class K, class T, class H, class EK, class ET>
+    typename CompactingHashTable<K, T, H, EK, ET>::HashNode **CompactingHashTable<K, T, H, EK, ET>::bucketFor(uint64_t hash) const {
+        // old buckets below m_migratedCount are empty, their nodes have moved to the new array
+        if (m_oldBuckets) {
+            uint64_t oldOffset = bucketIndex(hash, m_oldSizeIndex);
+            if (oldOffset >= m_migratedCount) {
+                return &(m_oldBuckets[oldOffset]);
+            }
+        }
+        return &(m_buckets[bucketIndex(hash, m_sizeIndex)]);
     }
 
     template<class K, class T, class H, class EK, class ET>
     typename CompactingHashTable<K, T, H, EK, ET>::iterator CompactingHashTable<K, T, H, EK, ET>::find(const Key &key) const {
         uint64_t hash = m_hasher(key);
-        uint64_t bucketOffset = hash % TABLE_SIZES[m_sizeIndex];
-        const HashNode *foundNode = find(m_buckets[bucketOffset], key);
+        const HashNode *foundNode = find(*bucketFor(hash), key);
         return iterator(foundNode);
     }
 
     template<class K, class T, class H, class EK, class ET>
     typename CompactingHashTable<K, T, H, EK, ET>::iterator CompactingHashTable<K, T, H, EK, ET>::find(const Key &key, const Data &value) const {
         uint64_t hash = m_hasher(key);
-        uint64_t bucketOffset = hash % TABLE_SIZES[m_sizeIndex];
-        const HashNode *foundNode = find(m_buckets[bucketOffset], key, value);
+        const HashNode *foundNode = find(*bucketFor(hash), key, value);
         return iterator(foundNode);
     }
 
     template<class K, class T, class H, class EK, class ET>
     bool CompactingHashTable<K, T, H, EK, ET>::insert(const Key &key, const Data &value) {
+        if (m_oldBuckets) {
+            migrate(BUCKETS_MIGRATED_PER_UPDATE);
+        }
         uint64_t hash = m_hasher(key);
-
-        uint64_t bucketOffset = hash % TABLE_SIZES[m_sizeIndex];
-        return insert(&(m_buckets[bucketOffset]), hash, key, value);
+        return insert(bucketFor(hash), hash, key, value);
     }
 
     template<class K, class T, class H, class EK, class ET>
     bool CompactingHashTable<K, T, H, EK, ET>::erase(const Key &key) {
         assert(m_unique);
+        if (m_oldBuckets) {
+            migrate(BUCKETS_MIGRATED_PER_UPDATE);
+        }
         HashNode *prevBucketNode = NULL;
         uint64_t hash = m_hasher(key);
-        uint64_t bucketOffset = hash % TABLE_SIZES[m_sizeIndex];
+        HashNode **bucket = bucketFor(hash);
 
-        for (HashNode *node = m_buckets[bucketOffset]; node; node = node->nextInBucket) {
+        for (HashNode *node = *bucket; node; node = node->nextInBucket) {
             if (m_keyEq(node->key, key)) {
-                removeUnique(&(m_buckets[bucketOffset]), prevBucketNode, node);
+                removeUnique(bucket, prevBucketNode, node);
                 deleteAndFixup(node);
                 checkLoadFactor();
                 return true;
@@ -328,15 +355,18 @@ namespace voltdb {
 
     template<class K, class T, class H, class EK, class ET>
     bool CompactingHashTable<K, T, H, EK, ET>::erase(const Key &key, const Data &value) {
+        if (m_oldBuckets) {
+            migrate(BUCKETS_MIGRATED_PER_UPDATE);
+        }
         HashNode *prevBucketNode = NULL, *keyHeadNode = NULL, *prevKeyNode = NULL;
         uint64_t hash = m_hasher(key);
-        uint64_t bucketOffset = hash % TABLE_SIZES[m_sizeIndex];
+        HashNode **bucket = bucketFor(hash);
 
-        for (HashNode *node = m_buckets[bucketOffset]; node; node = node->nextInBucket) {
+        for (HashNode *node = *bucket; node; node = node->nextInBucket) {
             if (m_keyEq(node->key, key)) {
                 if (m_unique) {
                     if (!m_dataEq(node->value, value)) return false;
-                    removeUnique(&(m_buckets[bucketOffset]), prevBucketNode, node);
+                    removeUnique(bucket, prevBucketNode, node);
                     deleteAndFixup(node);
                     checkLoadFactor();
                     return true;
@@ -344,7 +374,7 @@ namespace voltdb {
                 keyHeadNode = node;
                 for (node = keyHeadNode; node; node = node->nextWithKey) {
                     if (m_dataEq(node->value, value)) {
-                        remove(&(m_buckets[bucketOffset]), prevBucketNode, keyHeadNode, prevKeyNode, node);
+                        remove(bucket, prevBucketNode, keyHeadNode, prevKeyNode, node);
                         deleteAndFixup(node);
                         checkLoadFactor();
                         return true;
@@ -423,7 +453,7 @@ namespace voltdb {
             m_uniqueCount++;
         }
 
-        checkLoadFactor();
+        checkLoadFactor(false);
         return true;
     }
 
@@ -510,11 +540,11 @@ namespace voltdb {
         }
 
         // find the bucket for the last node
-        uint64_t bucketOffset = last->hash % TABLE_SIZES[m_sizeIndex];
+        HashNode **bucket = bucketFor(last->hash);
 
         // find the last node and what points to it
         HashNode *prevBucketNode = NULL, *keyHeadNode = NULL, *prevKeyNode = NULL;
-        for (HashNode *n = m_buckets[bucketOffset]; n; n = n->nextInBucket) {
+        for (HashNode *n = *bucket; n; n = n->nextInBucket) {
             prevKeyNode = NULL;
             keyHeadNode = n;
             if (m_unique) {
@@ -528,7 +558,7 @@ namespace voltdb {
                     prevBucketNode->nextInBucket = node;
                 }
                 else {
-                    m_buckets[bucketOffset] = node;
+                    *bucket = node;
                 }
 
                 // copy the last node over the deleted node
@@ -562,7 +592,7 @@ namespace voltdb {
                             prevBucketNode->nextInBucket = node;
                         }
                         else {
-                            m_buckets[bucketOffset] = node;
+                            *bucket = node;
                         }
                     }
 
@@ -590,13 +620,26 @@ namespace voltdb {
     }
 
     template<class K, class T, class H, class EK, class ET>
-    void CompactingHashTable<K, T, H, EK, ET>::checkLoadFactor() {
-        uint64_t lf = (m_uniqueCount * 100) / TABLE_SIZES[m_sizeIndex];
+    void CompactingHashTable<K, T, H, EK, ET>::reserve(size_t count) {
+        int newSizeIndex = m_sizeIndex;
+        while (((m_uniqueCount + count) * 100) / tableSize(newSizeIndex) > MAX_LOAD_FACTOR) {
+            newSizeIndex++;
+        }
+        if (newSizeIndex != m_sizeIndex) {
+            resize(newSizeIndex);
+            // the inserts to come would each wait on migration, so finish it now
+            migrate(tableSize(m_oldSizeIndex));
+        }
+    }
+
+    template<class K, class T, class H, class EK, class ET>
+    void CompactingHashTable<K, T, H, EK, ET>::checkLoadFactor(bool mayShrink) {
+        uint64_t lf = (m_uniqueCount * 100) / tableSize(m_sizeIndex);
         int newSizeIndex = m_sizeIndex;
         if (lf > MAX_LOAD_FACTOR) {
             newSizeIndex++;
         }
-        else if(lf < MIN_LOAD_FACTOR) {
+        else if (mayShrink && lf < MIN_LOAD_FACTOR) {
             // make sure the hash doesn't over-shrink
             if (newSizeIndex != BUCKET_INITIAL_INDEX) {
                 newSizeIndex--;
@@ -609,69 +652,82 @@ namespace voltdb {
 
     template<class K, class T, class H, class EK, class ET>
     void CompactingHashTable<K, T, H, EK, ET>::resize(int newSizeIndex) {
-        //std::cout << "DEBUG SIZING BUFFER" << newSizeIndex << std::endl;
-        //std::cout.flush();
+        // a resize due before the previous one is done finishes the previous one at once
+        if (m_oldBuckets) {
+            migrate(tableSize(m_oldSizeIndex));
+        }
 
-        // create new double size buffer
-        void *memory = mmap(NULL, sizeof(HashNode*) * TABLE_SIZES[newSizeIndex], PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        // create new double (or half) size buffer
+        void *memory = PageAllocator::allocate(sizeof(HashNode*) * tableSize(newSizeIndex));
         assert(memory);
         HashNode **newBuckets = reinterpret_cast<HashNode**>(memory);
-        memset(newBuckets, 0, TABLE_SIZES[newSizeIndex] * sizeof(HashNode*));
+        memset(newBuckets, 0, tableSize(newSizeIndex) * sizeof(HashNode*));
 
-        // move all of the existing values
-        for (uint32_t i = 0; i < TABLE_SIZES[m_sizeIndex]; ++i) {
-            while (m_buckets[i]) {
-                HashNode *node = m_buckets[i];
-                m_buckets[i] = node->nextInBucket;
+        // the existing values move over a few buckets at a time, see migrate
+        m_oldBuckets = m_buckets;
+        m_oldSizeIndex = m_sizeIndex;
+        m_migratedCount = 0;
+        m_buckets = newBuckets;
+        m_sizeIndex = newSizeIndex;
+    }
 
-                uint64_t bucketOffset = node->hash % TABLE_SIZES[newSizeIndex];
-                node->nextInBucket = newBuckets[bucketOffset];
-                newBuckets[bucketOffset] = node;
+    template<class K, class T, class H, class EK, class ET>
+    void CompactingHashTable<K, T, H, EK, ET>::migrate(uint64_t bucketCount) {
+        assert(m_oldBuckets);
+        const uint64_t oldSize = tableSize(m_oldSizeIndex);
+        const uint64_t end = std::min(m_migratedCount + bucketCount, oldSize);
+
+        for (; m_migratedCount < end; ++m_migratedCount) {
+            HashNode **oldBucket = &(m_oldBuckets[m_migratedCount]);
+            while (*oldBucket) {
+                HashNode *node = *oldBucket;
+                *oldBucket = node->nextInBucket;
+
+                uint64_t bucketOffset = bucketIndex(node->hash, m_sizeIndex);
+                node->nextInBucket = m_buckets[bucketOffset];
+                m_buckets[bucketOffset] = node;
             }
         }
 
-        // swap the table buffers
-        munmap(m_buckets, TABLE_SIZES[m_sizeIndex] * sizeof(HashNode*));
-        m_buckets = newBuckets;
-        m_sizeIndex = newSizeIndex;
+        if (m_migratedCount == oldSize) {
+            PageAllocator::release(m_oldBuckets, oldSize * sizeof(HashNode*));
+            m_oldBuckets = NULL;
+        }
     }
 
     template<class K, class T, class H, class EK, class ET>
-    bool CompactingHashTable<K, T, H, EK, ET> ::verify() {
-        size_t manualCount = 0;
-
-        for (uint64_t bucketi = 0; bucketi < TABLE_SIZES[m_sizeIndex]; ++bucketi) {
-            for (HashNode *node = m_buckets[bucketi]; node; node = node->nextInBucket) {
-                if (m_unique) {
-                    uint64_t hash = m_hasher(node->key);
-                    if (hash != node->hash) {
+    bool CompactingHashTable<K, T, H, EK, ET>::verifyBuckets(HashNode **buckets, uint64_t first, uint64_t end, size_t &count) {
+        for (uint64_t bucketi = first; bucketi < end; ++bucketi) {
+            for (HashNode *node = buckets[bucketi]; node; node = node->nextInBucket) {
+                for (HashNode *node2 = node; node2; node2 = (m_unique ? NULL : node2->nextWithKey)) {
+                    uint64_t hash = m_hasher(node2->key);
+                    if (hash != node2->hash) {
                         printf("Node hash doesn't match expected value.\n");
                         return false;
                     }
-                    if ((hash % TABLE_SIZES[m_sizeIndex]) != bucketi) {
+                    if (bucketFor(hash) != &(buckets[bucketi])) {
                         printf("Node hash doesn't match expected bucket index.\n");
                         return false;
                     }
 
-                    ++manualCount;
-                }
-                else {
-                    for (HashNode *node2 = node; node2; node2 = node2->nextWithKey) {
-                        uint64_t hash = m_hasher(node2->key);
-                        if (hash != node2->hash) {
-                            printf("Node hash doesn't match expected value.\n");
-                            return false;
-                        }
-                        if ((hash % TABLE_SIZES[m_sizeIndex]) != bucketi) {
-                            printf("Node hash doesn't match expected bucket index.\n");
-                            return false;
-                        }
-
-                        ++manualCount;
-                    }
+                    ++count;
                 }
             }
         }
+        return true;
+    }
+
+    template<class K, class T, class H, class EK, class ET>
+    bool CompactingHashTable<K, T, H, EK, ET> ::verify() {
+        size_t manualCount = 0;
+
+        if ( ! verifyBuckets(m_buckets, 0, tableSize(m_sizeIndex), manualCount)) {
+            return false;
+        }
+        if (m_oldBuckets &&
+            ! verifyBuckets(m_oldBuckets, m_migratedCount, tableSize(m_oldSizeIndex), manualCount)) {
+            return false;
+        }
 
         if (manualCount != m_count) {
             printf("Found %d nodes by walking all buffers, but expected %d nodes.\n",
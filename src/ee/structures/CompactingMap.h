@@ -20,8 +20,10 @@
 
 #include "ContiguousAllocator.h"
 
+#include <cstdio>
 #include <cstdlib>
 #include <stdint.h>
+#include <iterator>
 #include <utility>
 #include <limits>
 #include <cassert>
@@ -162,6 +164,14 @@ public:
     bool erase(const Key &key);
     bool erase(iterator &iter);
 
+    /**
+     * Inserts pointed-to KeyValuePairs already sorted by key. An empty map
+     * is built bottom up, with its nodes allocated in key order. Returns
+     * false, leaving the map as it was, if a unique map would get a
+     * duplicate key.
+     */
+    template<typename Iterator> bool insertSorted(Iterator begin, Iterator end);
+
     iterator find(const Key &key) const { return iterator(this, lookup(key)); }
     iterator findRank(int64_t ith) const { return iterator(this, lookupRank(ith)); }
     int64_t size() const { return m_count; }
@@ -202,6 +212,8 @@ protected:
     void erase(TreeNode *z);
     TreeNode *lookup(const Key &key) const;
     TreeNode *lookupRank(int64_t ith) const;
+    template<typename Iterator>
+    TreeNode *buildSorted(Iterator &next, int64_t count, int depth, int redDepth);
 
     inline int64_t getSubct(const TreeNode* x) const;
     inline void incSubct(TreeNode* x);
@@ -361,6 +373,87 @@ bool CompactingMap<KeyValuePair, Compare, hasRank>::insert(const Key &key, const
     return true;
 }
 
+template<typename KeyValuePair, typename Compare, bool hasRank>
+template<typename Iterator>
+bool CompactingMap<KeyValuePair, Compare, hasRank>::insertSorted(Iterator begin, Iterator end)
+{
+    if (m_root != &NIL) {
+        for (Iterator next = begin; next != end; ++next) {
+            if ( ! insert((*next)->getKey(), (*next)->getValue())) {
+                // only unique maps fail, so the keys find what was inserted
+                while (next != begin) {
+                    --next;
+                    erase((*next)->getKey());
+                }
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int64_t count = std::distance(begin, end);
+    if (count == 0) {
+        return true;
+    }
+    if (m_unique) {
+        Iterator prev = begin;
+        for (Iterator next = begin; ++next != end; prev = next) {
+            if (m_comper((*prev)->getKey(), (*next)->getKey()) == 0) {
+                return false;
+            }
+        }
+    }
+
+    // Splitting at the middle fills every level but the deepest, so making
+    // only the deepest nodes red gives all paths the same black height.
+    int redDepth = 0;
+    while ((static_cast<int64_t>(2) << redDepth) <= count) {
+        redDepth++;
+    }
+    Iterator next = begin;
+    m_root = buildSorted(next, count, 0, redDepth);
+    m_count = count;
+    assert(m_allocator.count() == m_count);
+    return true;
+}
+
+template<typename KeyValuePair, typename Compare, bool hasRank>
+template<typename Iterator>
+typename CompactingMap<KeyValuePair, Compare, hasRank>::TreeNode *
+CompactingMap<KeyValuePair, Compare, hasRank>::buildSorted(Iterator &next, int64_t count, int depth, int redDepth)
+{
+    if (count == 0) {
+        return &NIL;
+    }
+    // allocate the left subtree, this node and then the right subtree,
+    // so that the nodes are laid out in key order
+    TreeNode *left = buildSorted(next, count / 2, depth + 1, redDepth);
+
+    void *memory = m_allocator.alloc();
+    assert(memory);
+    // placement new
+    TreeNode *z = new(memory) TreeNode();
+    z->setKey((*next)->getKey());
+    z->setValue((*next)->getValue());
+    ++next;
+
+    TreeNode *right = buildSorted(next, count - 1 - count / 2, depth + 1, redDepth);
+    z->left = left;
+    z->right = right;
+    z->parent = &NIL;
+    if (left != &NIL) {
+        left->parent = z;
+    }
+    if (right != &NIL) {
+        right->parent = z;
+    }
+    z->color = (depth > 0 && depth == redDepth) ? RED : BLACK;
+    if (hasRank) {
+        z->subct = (count <= SUBCTMAX) ? static_cast<NodeCount>(count) : INVALIDCT;
+    }
+    return z;
+}
+
 template<typename KeyValuePair, typename Compare, bool hasRank>
 typename CompactingMap<KeyValuePair, Compare, hasRank>::iterator
 CompactingMap<KeyValuePair, Compare, hasRank>::lowerBound(const Key &key) const
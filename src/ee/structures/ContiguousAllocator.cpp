@@ -16,22 +16,64 @@
  */
 
 #include "ContiguousAllocator.h"
+#include "common/PageAllocator.h"
 
 #include <cassert>
 
 using namespace voltdb;
 
-ContiguousAllocator::ContiguousAllocator(int32_t allocSize, int32_t chunkSize)
-: m_count(0), m_allocSize(allocSize), m_chunkSize(chunkSize), m_tail(NULL), m_blockCount(0) {}
+ContiguousAllocator::ContiguousAllocator(int32_t allocSize, int32_t chunkSize, int32_t alignment)
+: m_count(0), m_allocSize(allocSize), m_chunkSize(chunkSize), m_tail(NULL), m_blockCount(0),
+  m_alignment(alignment),
+  m_dataOffset(alignment > static_cast<int32_t>(sizeof(Buffer)) ? alignment : static_cast<int32_t>(sizeof(Buffer))),
+#ifndef MEMCHECK
+  m_mapped(PageAllocator::hasPolicy())
+#else
+  // for debugging with valgrind
+  m_mapped(false)
+#endif
+{
+    assert(alignment == 0 || (alignment & (alignment - 1)) == 0);
+}
 
 ContiguousAllocator::~ContiguousAllocator() {
     while (m_tail) {
         Buffer *buf = m_tail->prev;
-        free(m_tail);
+        freeBuffer(m_tail);
         m_tail = buf;
     }
 }
 
+size_t ContiguousAllocator::bufferSize() const {
+    return static_cast<size_t>(m_dataOffset) + static_cast<size_t>(m_allocSize) * static_cast<size_t>(m_chunkSize);
+}
+
+void *ContiguousAllocator::allocBuffer() const {
+    if (m_mapped) {
+        // Buffers are mapped as the engine's PageAllocator was configured to, page aligned,
+        // which satisfies any alignment asked for.
+        assert(m_alignment <= 4096);
+        return PageAllocator::allocate(bufferSize());
+    }
+    void *memory;
+    if (m_alignment == 0) {
+        memory = malloc(bufferSize());
+    }
+    else if (posix_memalign(&memory, m_alignment, bufferSize()) != 0) {
+        memory = NULL;
+    }
+    return memory;
+}
+
+void ContiguousAllocator::freeBuffer(Buffer *buf) const {
+    if (m_mapped) {
+        PageAllocator::release(buf, bufferSize());
+    }
+    else {
+        free(buf);
+    }
+}
+
 void *ContiguousAllocator::alloc() {
     m_count++;
 
@@ -40,9 +82,7 @@ void *ContiguousAllocator::alloc() {
 
     // if a new block is needed...
     if (blockOffset == 0) {
-        void *memory = malloc(sizeof(Buffer) + m_allocSize * m_chunkSize);
-
-        Buffer *buf = reinterpret_cast<Buffer*>(memory);
+        Buffer *buf = reinterpret_cast<Buffer*>(allocBuffer());
 
         // for debugging
         //memset(buf, 0, sizeof(sizeof(ChainedBuffer) + m_allocSize * m_chunkSize));
@@ -53,7 +93,7 @@ void *ContiguousAllocator::alloc() {
     }
 
     // get a pointer to where the new alloc will live
-    void *retval = m_tail->data + (m_allocSize * blockOffset);
+    void *retval = data(m_tail) + (m_allocSize * blockOffset);
     assert(retval == last());
     return retval;
 }
@@ -64,7 +104,7 @@ void *ContiguousAllocator::last() const {
 
     // determine where in the current block the last alloc is
     int64_t blockOffset = (m_count - 1) % m_chunkSize;
-    return m_tail->data + (m_allocSize * blockOffset);
+    return data(m_tail) + (m_allocSize * blockOffset);
 }
 
 void ContiguousAllocator::trim() {
@@ -82,7 +122,7 @@ void ContiguousAllocator::trim() {
     // yay! kill a block
     if (blockOffset == 0) {
         Buffer *buf = m_tail->prev;
-        free(m_tail);
+        freeBuffer(m_tail);
         m_tail = buf;
         m_blockCount--;
     }
@@ -30,9 +30,9 @@ namespace voltdb {
  * Note, there are few checks here when running in release mode.
  */
 class ContiguousAllocator {
+    // Allocations start m_dataOffset bytes into each buffer.
     struct Buffer {
         Buffer *prev;
-        char data[0];
     };
 
     int64_t m_count;
@@ -40,13 +40,25 @@ class ContiguousAllocator {
     int32_t m_chunkSize;
     Buffer *m_tail;
     int32_t m_blockCount;
+    int32_t m_alignment;
+    int32_t m_dataOffset;
+    // Whether buffers come from the PageAllocator, as they do when the engine
+    // that created this has a page allocation policy, or from malloc.
+    const bool m_mapped;
+
+    char *data(Buffer *buf) const { return reinterpret_cast<char*>(buf) + m_dataOffset; }
+    size_t bufferSize() const;
+    void *allocBuffer() const;
+    void freeBuffer(Buffer *buf) const;
 
 public:
     /**
      * @param allocSize is the size in bytes of individual allocations.
      * @param chunkSize is the number of allocations per buffer (not bytes).
+     * @param alignment if not 0, is the power of two that allocations are
+     *        aligned to. allocSize should be a multiple of it.
      */
-    ContiguousAllocator(int32_t allocSize, int32_t chunkSize);
+    ContiguousAllocator(int32_t allocSize, int32_t chunkSize, int32_t alignment = 0);
     ~ContiguousAllocator();
 
     void *alloc();
@@ -0,0 +1,419 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENADDRESSINGHASHTABLE_H_
+#define OPENADDRESSINGHASHTABLE_H_
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include "common/PageAllocator.h"
+#include <boost/functional/hash.hpp>
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace voltdb {
+
+    /**
+     * OpenAddressingHashTable is a unique map that keeps its entries in one array of slots
+     * instead of chaining separately allocated nodes. Next to the slots is an array of
+     * control bytes, one per slot, holding 7 bits of the slot's hash or marking it empty
+     * or deleted. Lookups probe 16 control bytes at a time (with SSE2 where available)
+     * and only compare the keys of the slots whose hash bits match, so a lookup usually
+     * touches one cache line of control bytes and one slot.
+     *
+     * Like CompactingHashTable it gives memory back as entries are removed: when the
+     * table is mostly empty it is rebuilt at half the size and the old arrays are unmapped.
+     *
+     * It suits small keys that are cheap to hash and compare. Keys and values are moved
+     * when the table is rebuilt, so iterators are only good until the next insert or erase.
+     */
+    template<class K, class T, class H = boost::hash<K>, class EK = std::equal_to<K> >
+    class OpenAddressingHashTable {
+    public:
+        typedef K Key;            // key type
+        typedef T Data;           // value type
+        typedef H Hasher;         // hash a value to a uint64_t
+        typedef EK KeyEqChecker;  // compare two keys
+
+        // rebuild when 7/8 of the slots are used or deleted
+        static const uint64_t MAX_LOAD_FACTOR = 87; // %
+        // shrink when less than 1/8 of the slots are used
+        static const uint64_t MIN_LOAD_FACTOR = 12; // %
+
+        // control bytes probed at once
+        static const uint64_t GROUP_WIDTH = 16;
+        // 1024 slots to start with, and never fewer
+        static const int INITIAL_SIZE_INDEX = 10;
+
+    protected:
+        static const int8_t CTRL_EMPTY = -128;  // 0b10000000
+        static const int8_t CTRL_DELETED = -2;  // 0b11111110
+        // a full slot's control byte is the low 7 bits of its hash, 0b0hhhhhhh
+
+        struct Slot {
+            Key key;
+            Data value;
+        };
+
+        /** The control bytes of one group of slots, and the slots among them that match. */
+        class Group {
+        public:
+#ifdef __SSE2__
+            explicit Group(const int8_t *ctrl)
+                : m_ctrl(_mm_load_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+            uint32_t match(int8_t ctrl) const {
+                return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(ctrl), m_ctrl));
+            }
+            // empty and deleted are the control bytes with the sign bit set
+            uint32_t matchEmptyOrDeleted() const { return _mm_movemask_epi8(m_ctrl); }
+        private:
+            __m128i m_ctrl;
+#else
+            explicit Group(const int8_t *ctrl) : m_ctrl(ctrl) {}
+
+            uint32_t match(int8_t ctrl) const {
+                uint32_t mask = 0;
+                for (int i = 0; i < GROUP_WIDTH; ++i) {
+                    mask |= (uint32_t)(m_ctrl[i] == ctrl) << i;
+                }
+                return mask;
+            }
+            uint32_t matchEmptyOrDeleted() const {
+                uint32_t mask = 0;
+                for (int i = 0; i < GROUP_WIDTH; ++i) {
+                    mask |= (uint32_t)(m_ctrl[i] < 0) << i;
+                }
+                return mask;
+            }
+        private:
+            const int8_t *m_ctrl;
+#endif
+        public:
+            uint32_t matchEmpty() const { return match(CTRL_EMPTY); }
+        };
+
+        int8_t *m_ctrl;                   // a control byte per slot, 16 byte aligned
+        Slot *m_slots;                    // the slots
+        uint64_t m_count;                 // number of items in the hash
+        uint64_t m_deleted;               // number of deleted slots not yet reused
+        int m_sizeIndex;                  // log2 of the slot count
+        Hasher m_hasher;                  // instance of the hashing function
+        KeyEqChecker m_keyEq;             // instance of the key eq checker
+
+    public:
+        /**
+         * Iterator over the (at most one) entry with a key.
+         */
+        class iterator {
+            friend class OpenAddressingHashTable;
+        protected:
+            Slot *m_slot;
+
+            iterator(const Slot *slot) : m_slot(const_cast<Slot*>(slot)) {}
+
+        public:
+            iterator() : m_slot(NULL) {}
+            iterator(const iterator &iter) : m_slot(iter.m_slot) {}
+
+            Key &key() const { return m_slot->key; }
+            Data &value() const { return m_slot->value; }
+            void setValue(const Data &value) { m_slot->value = value; }
+
+            // keys are unique, so there is never a next value with the same key
+            void moveNext() { m_slot = NULL; }
+            // equivalent to == containter.end() in STL-speak
+            bool isEnd() const { return (!m_slot); }
+            // do two iterators point to the same slot
+            bool equals(iterator &iter) const { return m_slot == iter.m_slot; }
+        };
+
+        OpenAddressingHashTable(Hasher hasher = Hasher(), KeyEqChecker keyEq = KeyEqChecker());
+        ~OpenAddressingHashTable();
+
+        /** simple find */
+        iterator find(const Key &key) const;
+        /** insert unless the key is already present */
+        bool insert(const Key &key, const Data &value);
+        /** delete by key */
+        bool erase(const Key &key);
+        /** delete from iterator */
+        bool erase(iterator &iter) { return erase(iter.key()); }
+        /** STL-ish size() method */
+        size_t size() const { return m_count; }
+        /** make room for count more entries, so inserting them doesn't rehash the table */
+        void reserve(size_t count);
+
+        /** Return bytes used for this index */
+        size_t bytesAllocated() const { return allocationSize(m_sizeIndex); }
+
+        /** verification for debugging and testing */
+        bool verify() const;
+
+    protected:
+        static uint64_t tableSize(int sizeIndex) { return 1ULL << sizeIndex; }
+        static size_t ctrlBytes(int sizeIndex) {
+            // a multiple of GROUP_WIDTH, so the slots that follow stay 16 byte aligned
+            return (size_t)tableSize(sizeIndex);
+        }
+        static size_t allocationSize(int sizeIndex) {
+            return ctrlBytes(sizeIndex) + tableSize(sizeIndex) * sizeof(Slot);
+        }
+        /** mix the hash so that weak hashes (like the identity hash of integers) spread out */
+        uint64_t hashOf(const Key &key) const {
+            uint64_t hash = m_hasher(key);
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdULL;
+            hash ^= hash >> 33;
+            hash *= 0xc4ceb9fe1a85ec53ULL;
+            hash ^= hash >> 33;
+            return hash;
+        }
+        static int8_t ctrlOf(uint64_t hash) { return (int8_t)(hash & 0x7f); }
+        /** the first group probed for a hash */
+        uint64_t firstGroup(uint64_t hash) const {
+            return (hash >> 7) & ((tableSize(m_sizeIndex) / GROUP_WIDTH) - 1);
+        }
+        /** the group probed after the probeCount-th one (triangular probing visits every group) */
+        uint64_t nextGroup(uint64_t group, uint64_t probeCount) const {
+            return (group + probeCount) & ((tableSize(m_sizeIndex) / GROUP_WIDTH) - 1);
+        }
+        static int lowestBit(uint32_t mask) { return __builtin_ctz(mask); }
+
+        /** the slot holding key, or -1 */
+        int64_t findSlot(const Key &key, uint64_t hash) const;
+        /** the first empty or deleted slot on the probe sequence for hash */
+        uint64_t findFreeSlot(uint64_t hash) const;
+        void setCtrl(uint64_t slot, int8_t ctrl) { m_ctrl[slot] = ctrl; }
+
+        /** allocate empty control bytes and slots for 2^sizeIndex entries */
+        void allocate(int sizeIndex);
+        /** see if the table needs to grow, shrink or drop its deleted slots (inserts don't shrink it) */
+        void checkLoadFactor(bool mayShrink = true);
+        /** move all the entries to new arrays of 2^newSizeIndex slots */
+        void rehash(int newSizeIndex);
+    };
+
+    ///////////////////////////////////////////
+    //
+    // OPEN ADDRESSING HASH TABLE CODE
+    //
+    ///////////////////////////////////////////
+
+    template<class K, class T, class H, class EK>
+    OpenAddressingHashTable<K, T, H, EK>::OpenAddressingHashTable(Hasher hasher, KeyEqChecker keyEq)
+    : m_ctrl(NULL),
+    m_slots(NULL),
+    m_count(0),
+    m_deleted(0),
+    m_sizeIndex(INITIAL_SIZE_INDEX),
+    m_hasher(hasher),
+    m_keyEq(keyEq)
+    {
+        allocate(m_sizeIndex);
+    }
+
+    template<class K, class T, class H, class EK>
+    OpenAddressingHashTable<K, T, H, EK>::~OpenAddressingHashTable() {
+        for (uint64_t i = 0; i < tableSize(m_sizeIndex); ++i) {
+            if (m_ctrl[i] >= 0) {
+                m_slots[i].~Slot();
+            }
+        }
+        PageAllocator::release(m_ctrl, allocationSize(m_sizeIndex));
+    }
+
+    template<class K, class T, class H, class EK>
+    void OpenAddressingHashTable<K, T, H, EK>::allocate(int sizeIndex) {
+        // mapped memory is page aligned, and goes straight back to the OS when the table shrinks
+        void *memory = PageAllocator::allocate(allocationSize(sizeIndex));
+        m_ctrl = reinterpret_cast<int8_t*>(memory);
+        memset(m_ctrl, CTRL_EMPTY, ctrlBytes(sizeIndex));
+        m_slots = reinterpret_cast<Slot*>(m_ctrl + ctrlBytes(sizeIndex));
+        m_sizeIndex = sizeIndex;
+    }
+
+    template<class K, class T, class H, class EK>
+    int64_t OpenAddressingHashTable<K, T, H, EK>::findSlot(const Key &key, uint64_t hash) const {
+        const int8_t ctrl = ctrlOf(hash);
+        uint64_t group = firstGroup(hash);
+        for (uint64_t probeCount = 1; ; ++probeCount) {
+            const uint64_t base = group * GROUP_WIDTH;
+            Group g(m_ctrl + base);
+            for (uint32_t mask = g.match(ctrl); mask; mask &= mask - 1) {
+                const uint64_t slot = base + lowestBit(mask);
+                if (m_keyEq(m_slots[slot].key, key)) {
+                    return (int64_t)slot;
+                }
+            }
+            // an insert would have used this empty slot rather than probe further
+            if (g.matchEmpty()) {
+                return -1;
+            }
+            group = nextGroup(group, probeCount);
+        }
+    }
+
+    template<class K, class T, class H, class EK>
+    uint64_t OpenAddressingHashTable<K, T, H, EK>::findFreeSlot(uint64_t hash) const {
+        uint64_t group = firstGroup(hash);
+        for (uint64_t probeCount = 1; ; ++probeCount) {
+            const uint64_t base = group * GROUP_WIDTH;
+            uint32_t mask = Group(m_ctrl + base).matchEmptyOrDeleted();
+            if (mask) {
+                return base + lowestBit(mask);
+            }
+            group = nextGroup(group, probeCount);
+        }
+    }
+
+    template<class K, class T, class H, class EK>
+    typename OpenAddressingHashTable<K, T, H, EK>::iterator OpenAddressingHashTable<K, T, H, EK>::find(const Key &key) const {
+        int64_t slot = findSlot(key, hashOf(key));
+        return iterator(slot < 0 ? NULL : &(m_slots[slot]));
+    }
+
+    template<class K, class T, class H, class EK>
+    bool OpenAddressingHashTable<K, T, H, EK>::insert(const Key &key, const Data &value) {
+        uint64_t hash = hashOf(key);
+        if (findSlot(key, hash) >= 0) {
+            return false;
+        }
+
+        uint64_t slot = findFreeSlot(hash);
+        if (m_ctrl[slot] == CTRL_DELETED) {
+            --m_deleted;
+        }
+        setCtrl(slot, ctrlOf(hash));
+        new (&(m_slots[slot])) Slot();
+        m_slots[slot].key = key;
+        m_slots[slot].value = value;
+        ++m_count;
+
+        checkLoadFactor(false);
+        return true;
+    }
+
+    template<class K, class T, class H, class EK>
+    bool OpenAddressingHashTable<K, T, H, EK>::erase(const Key &key) {
+        int64_t slot = findSlot(key, hashOf(key));
+        if (slot < 0) {
+            return false;
+        }
+
+        m_slots[slot].~Slot();
+        // A group with an empty slot has never been full since the table was last rebuilt,
+        // so no probe has gone past it and the slot can be empty again. Otherwise probes for
+        // other keys may have to continue past it.
+        const uint64_t base = (slot / GROUP_WIDTH) * GROUP_WIDTH;
+        if (Group(m_ctrl + base).matchEmpty()) {
+            setCtrl(slot, CTRL_EMPTY);
+        }
+        else {
+            setCtrl(slot, CTRL_DELETED);
+            ++m_deleted;
+        }
+        --m_count;
+
+        checkLoadFactor();
+        return true;
+    }
+
+    template<class K, class T, class H, class EK>
+    void OpenAddressingHashTable<K, T, H, EK>::reserve(size_t count) {
+        int newSizeIndex = m_sizeIndex;
+        while ((m_count + count) * 100 > tableSize(newSizeIndex) * MAX_LOAD_FACTOR) {
+            newSizeIndex++;
+        }
+        if (newSizeIndex != m_sizeIndex) {
+            rehash(newSizeIndex);
+        }
+    }
+
+    template<class K, class T, class H, class EK>
+    void OpenAddressingHashTable<K, T, H, EK>::checkLoadFactor(bool mayShrink) {
+        const uint64_t size = tableSize(m_sizeIndex);
+        if ((m_count + m_deleted) * 100 > size * MAX_LOAD_FACTOR) {
+            // grow, unless dropping the deleted slots at the same size frees enough of them
+            rehash(m_count * 100 > size * MAX_LOAD_FACTOR / 2 ? m_sizeIndex + 1 : m_sizeIndex);
+        }
+        else if (mayShrink && m_count * 100 < size * MIN_LOAD_FACTOR && m_sizeIndex > INITIAL_SIZE_INDEX) {
+            rehash(m_sizeIndex - 1);
+        }
+    }
+
+    template<class K, class T, class H, class EK>
+    void OpenAddressingHashTable<K, T, H, EK>::rehash(int newSizeIndex) {
+        int8_t *oldCtrl = m_ctrl;
+        Slot *oldSlots = m_slots;
+        const int oldSizeIndex = m_sizeIndex;
+
+        allocate(newSizeIndex);
+        for (uint64_t i = 0; i < tableSize(oldSizeIndex); ++i) {
+            if (oldCtrl[i] < 0) {
+                continue;
+            }
+            uint64_t hash = hashOf(oldSlots[i].key);
+            uint64_t slot = findFreeSlot(hash);
+            setCtrl(slot, ctrlOf(hash));
+            new (&(m_slots[slot])) Slot(oldSlots[i]);
+            oldSlots[i].~Slot();
+        }
+        m_deleted = 0;
+
+        PageAllocator::release(oldCtrl, allocationSize(oldSizeIndex));
+    }
+
+    template<class K, class T, class H, class EK>
+    bool OpenAddressingHashTable<K, T, H, EK>::verify() const {
+        uint64_t manualCount = 0;
+        uint64_t manualDeleted = 0;
+
+        for (uint64_t i = 0; i < tableSize(m_sizeIndex); ++i) {
+            if (m_ctrl[i] == CTRL_DELETED) {
+                ++manualDeleted;
+                continue;
+            }
+            if (m_ctrl[i] < 0) {
+                continue;
+            }
+            uint64_t hash = hashOf(m_slots[i].key);
+            if (ctrlOf(hash) != m_ctrl[i]) {
+                printf("Slot control byte doesn't match the hash of its key.\n");
+                return false;
+            }
+            if (findSlot(m_slots[i].key, hash) != (int64_t)i) {
+                printf("Slot isn't found by probing for its key.\n");
+                return false;
+            }
+            ++manualCount;
+        }
+
+        if (manualCount != m_count || manualDeleted != m_deleted) {
+            printf("Found %d entries and %d deleted slots, but expected %d and %d.\n",
+                   (int) manualCount, (int) manualDeleted, (int) m_count, (int) m_deleted);
+            return false;
+        }
+        return true;
+    }
+}
+
+#endif // OPENADDRESSINGHASHTABLE_H_
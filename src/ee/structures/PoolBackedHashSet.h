@@ -0,0 +1,205 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POOLBACKEDHASHSET_H_
+#define POOLBACKEDHASHSET_H_
+
+#include <cstring>
+#include <functional>
+#include <new>
+#include <utility>
+#include "common/Pool.hpp"
+#include <boost/functional/hash.hpp>
+#include <stdint.h>
+
+namespace voltdb {
+
+    /**
+     * PoolBackedHashSet is an insert only set for de-duplicating values while a
+     * query runs, as DISTINCT does. Like OpenAddressingHashTable it keeps its keys
+     * in one array of slots next to a control byte per slot holding 7 bits of the
+     * slot's hash, so a lookup compares only the keys whose hash bits match. It
+     * probes linearly from the slot a key hashes to.
+     *
+     * Its arrays come from a Pool instead of the heap, so a set living in pooled
+     * memory (as the aggregates do) needs no destructor and can't leak outside the
+     * pool. The arrays a set outgrows stay in the pool until the pool is purged.
+     * clear() empties the set but keeps its slots, so a set reused for each
+     * execution stops allocating once it has grown to fit.
+     *
+     * Keys are copied into the slots, and moved when the set grows, and never
+     * destroyed, so they must be plain values like NValue or TableTuple.
+     */
+    template<class K, class H = boost::hash<K>, class EK = std::equal_to<K> >
+    class PoolBackedHashSet {
+    public:
+        typedef K Key;            // key type
+        typedef H Hasher;         // hash a value to a size_t
+        typedef EK KeyEqChecker;  // compare two keys
+
+        // grow when 7/8 of the slots are used
+        static const uint64_t MAX_LOAD_FACTOR = 87; // %
+        // slots allocated by the first insert
+        static const uint64_t INITIAL_SIZE = 8;
+
+        PoolBackedHashSet(Pool *pool, Hasher hasher = Hasher(), KeyEqChecker keyEq = KeyEqChecker());
+
+        /**
+         * Add key unless an equal key is already present. Return the key held by
+         * the set and whether it was just added. The caller may overwrite a key it
+         * just added with an equal one, e.g. one copied to storage that lasts.
+         */
+        std::pair<Key*, bool> insert(const Key &key);
+        /** the key equal to key held by the set, or NULL */
+        const Key *find(const Key &key) const;
+        /** STL-ish size() method */
+        size_t size() const { return m_count; }
+        /** remove every key, keeping the slots for the keys to come */
+        void clear();
+
+        /** Return bytes of the pool used by the current slots */
+        size_t bytesAllocated() const { return allocationSize(m_size); }
+
+    private:
+        static const int8_t CTRL_EMPTY = -128;  // 0b10000000
+        // a full slot's control byte is the low 7 bits of its hash, 0b0hhhhhhh
+
+        static size_t allocationSize(uint64_t size) {
+            // size is a power of two, at least 8, so the keys after the control bytes stay aligned
+            return (size_t)size + (size_t)size * sizeof(Key);
+        }
+        /** mix the hash so that weak hashes (like the identity hash of integers) spread out */
+        uint64_t hashOf(const Key &key) const {
+            uint64_t hash = m_hasher(key);
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdULL;
+            hash ^= hash >> 33;
+            hash *= 0xc4ceb9fe1a85ec53ULL;
+            hash ^= hash >> 33;
+            return hash;
+        }
+        static int8_t ctrlOf(uint64_t hash) { return (int8_t)(hash & 0x7f); }
+        uint64_t firstSlot(uint64_t hash) const { return (hash >> 7) & (m_size - 1); }
+
+        /** the slot holding key, or the empty slot where it belongs */
+        uint64_t findSlot(const Key &key, uint64_t hash) const;
+        /** move the keys to new arrays of newSize slots */
+        void rehash(uint64_t newSize);
+
+        // No implicit copies
+        PoolBackedHashSet(const PoolBackedHashSet&);
+        PoolBackedHashSet& operator=(const PoolBackedHashSet&);
+
+        Pool *m_pool;                     // where the arrays come from
+        int8_t *m_ctrl;                   // a control byte per slot, NULL until the first insert
+        Key *m_keys;                      // the slots
+        uint64_t m_size;                  // number of slots, a power of two
+        uint64_t m_count;                 // number of keys in the set
+        Hasher m_hasher;                  // instance of the hashing function
+        KeyEqChecker m_keyEq;             // instance of the key eq checker
+    };
+
+    ///////////////////////////////////////////
+    //
+    // POOL BACKED HASH SET CODE
+    //
+    ///////////////////////////////////////////
+
+    template<class K, class H, class EK>
+    PoolBackedHashSet<K, H, EK>::PoolBackedHashSet(Pool *pool, Hasher hasher, KeyEqChecker keyEq)
+    : m_pool(pool),
+    m_ctrl(NULL),
+    m_keys(NULL),
+    m_size(0),
+    m_count(0),
+    m_hasher(hasher),
+    m_keyEq(keyEq)
+    {}
+
+    template<class K, class H, class EK>
+    uint64_t PoolBackedHashSet<K, H, EK>::findSlot(const Key &key, uint64_t hash) const {
+        const int8_t ctrl = ctrlOf(hash);
+        // the load factor leaves an empty slot to stop at
+        for (uint64_t slot = firstSlot(hash); ; slot = (slot + 1) & (m_size - 1)) {
+            if (m_ctrl[slot] == CTRL_EMPTY ||
+                (m_ctrl[slot] == ctrl && m_keyEq(m_keys[slot], key))) {
+                return slot;
+            }
+        }
+    }
+
+    template<class K, class H, class EK>
+    std::pair<K*, bool> PoolBackedHashSet<K, H, EK>::insert(const Key &key) {
+        if ((m_count + 1) * 100 > m_size * MAX_LOAD_FACTOR) {
+            rehash(m_size == 0 ? INITIAL_SIZE : m_size * 2);
+        }
+        const uint64_t hash = hashOf(key);
+        const uint64_t slot = findSlot(key, hash);
+        if (m_ctrl[slot] != CTRL_EMPTY) {
+            return std::pair<Key*, bool>(&m_keys[slot], false);
+        }
+        m_ctrl[slot] = ctrlOf(hash);
+        new (&m_keys[slot]) Key(key);
+        ++m_count;
+        return std::pair<Key*, bool>(&m_keys[slot], true);
+    }
+
+    template<class K, class H, class EK>
+    const K *PoolBackedHashSet<K, H, EK>::find(const Key &key) const {
+        if (m_count == 0) {
+            return NULL;
+        }
+        const uint64_t slot = findSlot(key, hashOf(key));
+        return m_ctrl[slot] == CTRL_EMPTY ? NULL : &m_keys[slot];
+    }
+
+    template<class K, class H, class EK>
+    void PoolBackedHashSet<K, H, EK>::clear() {
+        if (m_count > 0) {
+            ::memset(m_ctrl, CTRL_EMPTY, (size_t)m_size);
+            m_count = 0;
+        }
+    }
+
+    template<class K, class H, class EK>
+    void PoolBackedHashSet<K, H, EK>::rehash(uint64_t newSize) {
+        int8_t *oldCtrl = m_ctrl;
+        Key *oldKeys = m_keys;
+        const uint64_t oldSize = m_size;
+
+        // the old arrays are left to the pool
+        m_ctrl = reinterpret_cast<int8_t*>(m_pool->allocate(allocationSize(newSize)));
+        ::memset(m_ctrl, CTRL_EMPTY, (size_t)newSize);
+        m_keys = reinterpret_cast<Key*>(m_ctrl + newSize);
+        m_size = newSize;
+        for (uint64_t i = 0; i < oldSize; ++i) {
+            if (oldCtrl[i] == CTRL_EMPTY) {
+                continue;
+            }
+            // the keys are unique, so any empty slot on the probe sequence will do
+            const uint64_t hash = hashOf(oldKeys[i]);
+            uint64_t slot = firstSlot(hash);
+            while (m_ctrl[slot] != CTRL_EMPTY) {
+                slot = (slot + 1) & (m_size - 1);
+            }
+            m_ctrl[slot] = ctrlOf(hash);
+            new (&m_keys[slot]) Key(oldKeys[i]);
+        }
+    }
+}
+
+#endif // POOLBACKEDHASHSET_H_
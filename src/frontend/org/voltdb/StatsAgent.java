@@ -373,6 +373,9 @@ public class StatsAgent extends OpsAgent
         case INDEX:
             stats = collectIndexStats(interval);
             break;
+        case STRINGSTORAGE:
+            stats = collectStringStorageStats(interval);
+            break;
         case PROCEDURE:
         case PROCEDUREINPUT:
         case PROCEDUREOUTPUT:
@@ -545,6 +548,19 @@ public class StatsAgent extends OpsAgent
         return stats;
     }
 
+    private VoltTable[] collectStringStorageStats(boolean interval)
+    {
+        Long now = System.currentTimeMillis();
+        VoltTable[] stats = null;
+
+        VoltTable sStats = getStatsAggregate(StatsSelector.STRINGSTORAGE, interval, now);
+        if (sStats != null) {
+            stats = new VoltTable[1];
+            stats[0] = sStats;
+        }
+        return stats;
+    }
+
     private VoltTable[] collectProcedureStats(boolean interval)
     {
         Long now = System.currentTimeMillis();
@@ -46,5 +46,8 @@ public enum StatsSelector {
     TOPO,           // return leader and site info for iv2
     REBALANCE,      // return elastic rebalance progress
     KSAFETY,         // return ksafety coverage information
-    CPU // Return CPU Stats
+    CPU, // Return CPU Stats
+    // The EE's StatisticsSelectorType values are the ordinals of these, so
+    // add new ones at the end.
+    STRINGSTORAGE // invoked as @stat stringstorage, EE string storage by size class
 }
@@ -48,5 +48,15 @@ public class TableStats extends SiteStatsSource {
         columns.add(new ColumnInfo("STRING_DATA_MEMORY", VoltType.INTEGER));
         columns.add(new ColumnInfo("TUPLE_LIMIT", VoltType.INTEGER));
         columns.add(new ColumnInfo("PERCENT_FULL", VoltType.INTEGER));
+        columns.add(new ColumnInfo("COMPACTED_TUPLE_COUNT", VoltType.BIGINT));
+        columns.add(new ColumnInfo("COMPACTION_PENDING_TUPLE_COUNT", VoltType.BIGINT));
+        // microseconds
+        columns.add(new ColumnInfo("COMPACTION_STALL_TIME", VoltType.BIGINT));
+        // KB of the table's blocks in huge pages, and placed on the site's NUMA node
+        columns.add(new ColumnInfo("HUGE_PAGE_MEMORY", VoltType.INTEGER));
+        columns.add(new ColumnInfo("NUMA_NODE_MEMORY", VoltType.INTEGER));
+        // the table's cold blocks held compressed, and KB of their compressed tuples
+        columns.add(new ColumnInfo("COMPRESSED_BLOCK_COUNT", VoltType.INTEGER));
+        columns.add(new ColumnInfo("COMPRESSED_MEMORY", VoltType.INTEGER));
     }
 }
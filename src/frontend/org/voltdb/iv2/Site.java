@@ -55,6 +55,7 @@ import org.voltdb.SnapshotTableTask;
 import org.voltdb.StartAction;
 import org.voltdb.StatsAgent;
 import org.voltdb.StatsSelector;
+import org.voltdb.StringStorageStats;
 import org.voltdb.SystemProcedureExecutionContext;
 import org.voltdb.TableStats;
 import org.voltdb.TableStreamType;
@@ -142,6 +143,7 @@ public class Site implements Runnable, SiteProcedureConnection, SiteSnapshotConn
     // Stats
     final TableStats m_tableStats;
     final IndexStats m_indexStats;
+    final StringStorageStats m_stringStorageStats;
     final MemoryStats m_memStats;
 
     // Each execution site manages snapshot using a SnapshotSiteProcessor
@@ -417,11 +419,16 @@ public class Site implements Runnable, SiteProcedureConnection, SiteSnapshotConn
             agent.registerStatsSource(StatsSelector.INDEX,
                                       m_siteId,
                                       m_indexStats);
+            m_stringStorageStats = new StringStorageStats(m_siteId);
+            agent.registerStatsSource(StatsSelector.STRINGSTORAGE,
+                                      m_siteId,
+                                      m_stringStorageStats);
             m_memStats = memStats;
         } else {
             // MPI doesn't need to track these stats
             m_tableStats = null;
             m_indexStats = null;
+            m_stringStorageStats = null;
             m_memStats = null;
         }
     }
@@ -973,6 +980,13 @@ public class Site implements Runnable, SiteProcedureConnection, SiteSnapshotConn
                 m_indexStats.setStatsTable(stats);
             }
 
+            // update string storage stats, a row per size class
+            final VoltTable[] s3 =
+                m_ee.getStats(StatsSelector.STRINGSTORAGE, new int[0], false, time);
+            if ((s3 != null) && (s3.length > 0)) {
+                m_stringStorageStats.setStatsTable(s3[0]);
+            }
+
             // update the rolled up memory statistics
             if (m_memStats != null) {
                 m_memStats.eeUpdateMemStats(m_siteId,
@@ -107,6 +107,9 @@ public enum ExpressionType {
     AGGREGATE_MIN                 (AggregateExpression.class, 43, "MIN"),
     AGGREGATE_MAX                 (AggregateExpression.class, 44, "MAX"),
     AGGREGATE_AVG                 (AggregateExpression.class, 45, "AVG"),
+    AGGREGATE_APPROX_COUNT_DISTINCT (AggregateExpression.class, 46, "APPROX_COUNT_DISTINCT"),
+    AGGREGATE_VALS_TO_HYPERLOGLOG (AggregateExpression.class, 47, "VALS_TO_HYPERLOGLOG"),
+    AGGREGATE_HYPERLOGLOGS_TO_CARD (AggregateExpression.class, 48, "HYPERLOGLOGS_TO_CARD"),
 
     // ----------------------------
     // Function
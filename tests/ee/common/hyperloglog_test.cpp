@@ -0,0 +1,148 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <stdint.h>
+#include "harness.h"
+#include "common/HyperLogLog.h"
+#include "common/SerializableEEException.h"
+#include "murmur3/MurmurHash3.h"
+
+using namespace voltdb;
+
+class HyperLogLogTest : public Test {
+public:
+    HyperLogLogTest() {}
+
+    static void addRange(HyperLogLog &hll, int64_t begin, int64_t end) {
+        for (int64_t ii = begin; ii < end; ii++) {
+            hll.add(MurmurHash3_x64_128(ii));
+        }
+    }
+
+    static bool withinError(int64_t estimate, int64_t actual, double error) {
+        const double difference = static_cast<double>(estimate - actual);
+        return difference <= actual * error && -difference <= actual * error;
+    }
+
+    static bool sameSketch(const HyperLogLog &a, const HyperLogLog &b) {
+        char serializedA[HyperLogLog::SERIALIZED_SIZE];
+        char serializedB[HyperLogLog::SERIALIZED_SIZE];
+        a.serializeTo(serializedA);
+        b.serializeTo(serializedB);
+        return ::memcmp(serializedA, serializedB, HyperLogLog::SERIALIZED_SIZE) == 0;
+    }
+};
+
+TEST_F(HyperLogLogTest, Empty) {
+    HyperLogLog hll;
+    ASSERT_EQ(0, hll.estimate());
+}
+
+TEST_F(HyperLogLogTest, Estimates) {
+    const int64_t counts[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+    for (int ii = 0; ii < sizeof(counts) / sizeof(counts[0]); ii++) {
+        HyperLogLog hll;
+        addRange(hll, 0, counts[ii]);
+        // about three standard errors
+        ASSERT_TRUE(withinError(hll.estimate(), counts[ii], 0.05));
+    }
+}
+
+TEST_F(HyperLogLogTest, DuplicatesIgnored) {
+    HyperLogLog once;
+    HyperLogLog thrice;
+    addRange(once, 0, 5000);
+    for (int ii = 0; ii < 3; ii++) {
+        addRange(thrice, 0, 5000);
+    }
+    ASSERT_TRUE(sameSketch(once, thrice));
+    ASSERT_EQ(once.estimate(), thrice.estimate());
+}
+
+TEST_F(HyperLogLogTest, Clear) {
+    HyperLogLog hll;
+    addRange(hll, 0, 5000);
+    hll.clear();
+    ASSERT_EQ(0, hll.estimate());
+    ASSERT_TRUE(sameSketch(HyperLogLog(), hll));
+}
+
+TEST_F(HyperLogLogTest, Merge) {
+    // Overlapping parts, as the partitions of a replicated table would be
+    HyperLogLog whole;
+    HyperLogLog first;
+    HyperLogLog second;
+    addRange(whole, 0, 30000);
+    addRange(first, 0, 20000);
+    addRange(second, 10000, 30000);
+
+    HyperLogLog merged;
+    merged.merge(first);
+    merged.merge(second);
+    ASSERT_TRUE(sameSketch(whole, merged));
+
+    char serialized[HyperLogLog::SERIALIZED_SIZE];
+    HyperLogLog mergedSerialized;
+    first.serializeTo(serialized);
+    mergedSerialized.mergeSerialized(serialized, HyperLogLog::SERIALIZED_SIZE);
+    second.serializeTo(serialized);
+    mergedSerialized.mergeSerialized(serialized, HyperLogLog::SERIALIZED_SIZE);
+    ASSERT_TRUE(sameSketch(whole, mergedSerialized));
+    ASSERT_EQ(whole.estimate(), mergedSerialized.estimate());
+}
+
+TEST_F(HyperLogLogTest, RejectsBadSketches) {
+    HyperLogLog hll;
+    addRange(hll, 0, 100);
+    char serialized[HyperLogLog::SERIALIZED_SIZE];
+    hll.serializeTo(serialized);
+
+    HyperLogLog target;
+    bool threw = false;
+    try {
+        target.mergeSerialized(serialized, HyperLogLog::SERIALIZED_SIZE - 1);
+    } catch (SerializableEEException &e) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+
+    // the wrong precision
+    serialized[1] = HyperLogLog::PRECISION + 1;
+    threw = false;
+    try {
+        target.mergeSerialized(serialized, HyperLogLog::SERIALIZED_SIZE);
+    } catch (SerializableEEException &e) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+
+    // a rank no hash could produce
+    serialized[1] = HyperLogLog::PRECISION;
+    serialized[2] = 32;
+    threw = false;
+    try {
+        target.mergeSerialized(serialized, HyperLogLog::SERIALIZED_SIZE);
+    } catch (SerializableEEException &e) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,193 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sys/time.h>
+#include <boost/functional/hash.hpp>
+#include "harness.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "common/ThreadLocalPool.h"
+
+using namespace voltdb;
+using namespace std;
+
+class NValueHashTest : public Test {
+public:
+    NValueHashTest() {}
+
+    static size_t hashOf(const NValue &value) {
+        size_t seed = 0;
+        value.hashCombine(seed);
+        return seed;
+    }
+
+    /**
+     * String hashing as NValue::hashCombine did it before hashing in place:
+     * VARCHAR through a std::string copy, VARBINARY a byte at a time.
+     */
+    static size_t copyingHashOf(const NValue &value) {
+        size_t seed = 0;
+        const char *data = static_cast<const char*>(ValuePeeker::peekObjectValue_withoutNull(value));
+        const int32_t length = ValuePeeker::peekObjectLength_withoutNull(value);
+        if (ValuePeeker::peekValueType(value) == VALUE_TYPE_VARCHAR) {
+            boost::hash_combine(seed, std::string(data, length));
+        }
+        else {
+            for (int32_t i = 0; i < length; i++) {
+                boost::hash_combine(seed, data[i]);
+            }
+        }
+        return seed;
+    }
+
+    /** count strings "key<n>" padded to length, in the pool */
+    static vector<NValue> makeKeys(int count, int length, ValueType type, Pool *pool) {
+        vector<NValue> keys;
+        char buffer[32];
+        for (int i = 0; i < count; i++) {
+            snprintf(buffer, sizeof(buffer), "key%d", i);
+            string key(buffer);
+            key.resize(length, 'x');
+            if (type == VALUE_TYPE_VARCHAR) {
+                keys.push_back(ValueFactory::getStringValue(key, pool));
+            }
+            else {
+                keys.push_back(ValueFactory::getBinaryValue(
+                        reinterpret_cast<const unsigned char*>(key.data()), length, pool));
+            }
+        }
+        return keys;
+    }
+
+    static int64_t nowMicros() {
+        timeval tp;
+        gettimeofday(&tp, NULL);
+        return (int64_t)tp.tv_sec * 1000000 + tp.tv_usec;
+    }
+
+    /**
+     * Chi-square of the hashes of keys over buckets buckets. Uniform hashes
+     * come out close to the number of buckets.
+     */
+    static double chiSquare(const vector<size_t> &hashes, size_t buckets) {
+        vector<int> counts(buckets, 0);
+        for (size_t i = 0; i < hashes.size(); i++) {
+            counts[hashes[i] % buckets]++;
+        }
+        const double expected = (double)hashes.size() / buckets;
+        double result = 0;
+        for (size_t i = 0; i < buckets; i++) {
+            result += (counts[i] - expected) * (counts[i] - expected) / expected;
+        }
+        return result;
+    }
+
+private:
+    ThreadLocalPool m_pool;
+};
+
+TEST_F(NValueHashTest, EqualStringsHashEqual) {
+    Pool pool;
+    NValue pooled = ValueFactory::getStringValue("a string to hash", &pool);
+    NValue allocated = ValueFactory::getStringValue("a string to hash");
+    NValue other = ValueFactory::getStringValue("a string to hasH", &pool);
+    EXPECT_EQ(hashOf(pooled), hashOf(allocated));
+    EXPECT_NE(hashOf(pooled), hashOf(other));
+
+    NValue binary = ValueFactory::getBinaryValue(
+            reinterpret_cast<const unsigned char*>("\x01\x02\x03"), 3, &pool);
+    NValue sameBinary = ValueFactory::getBinaryValue(
+            reinterpret_cast<const unsigned char*>("\x01\x02\x03"), 3, &pool);
+    EXPECT_EQ(hashOf(binary), hashOf(sameBinary));
+
+    // NULL hashes the same every time
+    NValue null = ValueFactory::getNullStringValue();
+    EXPECT_EQ(hashOf(null), hashOf(ValueFactory::getNullStringValue()));
+
+    // combining keeps the order of the values
+    size_t ab = 0;
+    pooled.hashCombine(ab);
+    other.hashCombine(ab);
+    size_t ba = 0;
+    other.hashCombine(ba);
+    pooled.hashCombine(ba);
+    EXPECT_NE(ab, ba);
+
+    allocated.free();
+}
+
+TEST_F(NValueHashTest, Benchmark) {
+    const int KEYS = 40000;
+    const int ROUNDS = 25;
+    const size_t BUCKETS = 1024;
+    const int LENGTHS[] = { 8, 32, 128, 512 };
+    const ValueType TYPES[] = { VALUE_TYPE_VARCHAR, VALUE_TYPE_VARBINARY };
+
+    for (int t = 0; t < 2; t++) {
+        for (int l = 0; l < 4; l++) {
+            Pool pool;
+            vector<NValue> keys = makeKeys(KEYS, LENGTHS[l], TYPES[t], &pool);
+
+            size_t sink = 0;
+            int64_t start = nowMicros();
+            for (int r = 0; r < ROUNDS; r++) {
+                for (int i = 0; i < KEYS; i++) {
+                    sink += copyingHashOf(keys[i]);
+                }
+            }
+            const int64_t copyingMicros = nowMicros() - start + 1;
+
+            start = nowMicros();
+            for (int r = 0; r < ROUNDS; r++) {
+                for (int i = 0; i < KEYS; i++) {
+                    sink += hashOf(keys[i]);
+                }
+            }
+            const int64_t inPlaceMicros = nowMicros() - start + 1;
+
+            vector<size_t> copyingHashes;
+            vector<size_t> inPlaceHashes;
+            for (int i = 0; i < KEYS; i++) {
+                copyingHashes.push_back(copyingHashOf(keys[i]));
+                inPlaceHashes.push_back(hashOf(keys[i]));
+            }
+            const double copyingChiSquare = chiSquare(copyingHashes, BUCKETS);
+            const double inPlaceChiSquare = chiSquare(inPlaceHashes, BUCKETS);
+
+            const double megabytes = (double)KEYS * ROUNDS * LENGTHS[l] / (1024 * 1024);
+            printf("%s %4d bytes: copying %8.1f MB/s chi2 %7.1f, in place %8.1f MB/s chi2 %7.1f (%lu)\n",
+                   getTypeName(TYPES[t]).c_str(), LENGTHS[l],
+                   megabytes * 1000000 / copyingMicros, copyingChiSquare,
+                   megabytes * 1000000 / inPlaceMicros, inPlaceChiSquare,
+                   (unsigned long)(sink & 0xf));
+
+            // Only the distribution is checked, timings vary too much from
+            // machine to machine. A uniform hash lands within a few standard
+            // deviations (sqrt(2 * BUCKETS)) of BUCKETS.
+            EXPECT_TRUE(inPlaceChiSquare < BUCKETS * 1.25);
+        }
+    }
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -2531,6 +2531,40 @@ TEST_F(NValueTest, TestInList)
     delete testPool;
 }
 
+TEST_F(NValueTest, TestLongInList)
+{
+    assert(ExecutorContext::getExecutorContext() == NULL);
+    Pool* testPool = new Pool();
+    UndoQuantum* wantNoQuantum = NULL;
+    Topend* topless = NULL;
+    ExecutorContext* poolHolder =
+        new ExecutorContext(0, 0, wantNoQuantum, topless, testPool, NULL, false, "", 0, NULL);
+
+    // Long enough to be binary searched, out of order and with duplicates:
+    // the odd numbers from 199 down to 1, each listed twice.
+    const size_t int_length = 200;
+    int int_set[int_length];
+    for (size_t ii = 0; ii < int_length; ++ii) {
+        int_set[ii] = 199 - 2 * (int)(ii % 100);
+    }
+    NValue int_NV_set[int_length];
+    initNValueArray(int_NV_set, int_set, int_length);
+    NValue int_list =
+        streamNValueArrayintoInList(VALUE_TYPE_INTEGER, int_NV_set, int_length, testPool);
+    EXPECT_EQ(100, int_list.arrayLength());
+
+    for (int ii = -2; ii <= 202; ++ii) {
+        EXPECT_EQ(ii > 0 && ii < 200 && ii % 2 == 1,
+                  ValueFactory::getIntegerValue(ii).inList(int_list));
+        EXPECT_EQ(ii > 0 && ii < 200 && ii % 2 == 1,
+                  ValueFactory::getBigIntValue(ii).inList(int_list));
+    }
+    EXPECT_FALSE(NValue::getNullValue(VALUE_TYPE_INTEGER).inList(int_list));
+
+    delete poolHolder;
+    delete testPool;
+}
+
 bool checkValueVector(vector<NValue> &values) {
     // check the array by verifying all values are larger than the previous value
     // this checks order and the lack of duplicates
@@ -0,0 +1,150 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <stdint.h>
+#include <pthread.h>
+#include "harness.h"
+#include "common/PageAllocator.h"
+#include "structures/ContiguousAllocator.h"
+
+using namespace voltdb;
+
+class PageAllocatorTest : public Test {
+public:
+    PageAllocatorTest() {}
+
+    static bool isZeroed(const char *memory, size_t size) {
+        for (size_t ii = 0; ii < size; ii++) {
+            if (memory[ii] != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Runs first, while the test thread has not been configured yet.
+TEST_F(PageAllocatorTest, Unconfigured) {
+    const size_t size = 3 * PageAllocator::HUGE_PAGE_SIZE;
+    char *memory = static_cast<char*>(PageAllocator::allocate(size));
+    ASSERT_TRUE(isZeroed(memory, size));
+    memset(memory, 1, size);
+    PageAllocator::release(memory, size);
+    ASSERT_EQ(0, PageAllocator::getStats().bytesAllocated);
+}
+
+TEST_F(PageAllocatorTest, ContiguousAllocatorWithoutPolicy) {
+    // Without a policy the buffers come from malloc, not mapped pages.
+    PageAllocator::configure(PageAllocator::HUGE_PAGES_NONE, -1);
+    ASSERT_FALSE(PageAllocator::hasPolicy());
+    {
+        ContiguousAllocator allocator(64, 1024);
+        memset(allocator.alloc(), 1, 64);
+        ASSERT_EQ(0, PageAllocator::getStats().bytesAllocated);
+    }
+
+    PageAllocator::configure(PageAllocator::HUGE_PAGES_TRANSPARENT, -1);
+    ASSERT_TRUE(PageAllocator::hasPolicy());
+    {
+        ContiguousAllocator allocator(64, 1024);
+        memset(allocator.alloc(), 1, 64);
+        ASSERT_TRUE(PageAllocator::getStats().bytesAllocated >= 64 * 1024);
+    }
+    ASSERT_EQ(0, PageAllocator::getStats().bytesAllocated);
+    PageAllocator::configure(PageAllocator::HUGE_PAGES_NONE, -1);
+}
+
+TEST_F(PageAllocatorTest, TransparentHugePages) {
+    PageAllocator::configure(PageAllocator::HUGE_PAGES_TRANSPARENT, -1);
+    const size_t bigSize = 2 * PageAllocator::HUGE_PAGE_SIZE + 4096;
+    const size_t smallSize = 64 * 1024;
+    char *big = static_cast<char*>(PageAllocator::allocate(bigSize));
+    char *small = static_cast<char*>(PageAllocator::allocate(smallSize));
+
+    // big allocations start on a huge page, small ones are left alone
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(big) % PageAllocator::HUGE_PAGE_SIZE);
+    ASSERT_TRUE(isZeroed(big, bigSize));
+    ASSERT_TRUE(isZeroed(small, smallSize));
+    memset(big, 1, bigSize);
+    memset(small, 1, smallSize);
+    PageAllocator::Stats stats = PageAllocator::getStats();
+    ASSERT_EQ(bigSize + smallSize, stats.bytesAllocated);
+    ASSERT_EQ(bigSize, stats.hugePageBytes);
+    ASSERT_EQ(0, stats.numaBoundBytes);
+
+    PageAllocator::release(big, bigSize);
+    PageAllocator::release(small, smallSize);
+    stats = PageAllocator::getStats();
+    ASSERT_EQ(0, stats.bytesAllocated);
+    ASSERT_EQ(0, stats.hugePageBytes);
+}
+
+TEST_F(PageAllocatorTest, ExplicitHugePages) {
+    // without reserved huge pages this falls back to transparent ones
+    PageAllocator::configure(PageAllocator::HUGE_PAGES_EXPLICIT, -1);
+    const size_t size = 2 * PageAllocator::HUGE_PAGE_SIZE;
+    char *memory = static_cast<char*>(PageAllocator::allocate(size));
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(memory) % PageAllocator::HUGE_PAGE_SIZE);
+    ASSERT_TRUE(isZeroed(memory, size));
+    memset(memory, 1, size);
+    ASSERT_EQ(size, PageAllocator::getStats().hugePageBytes);
+    PageAllocator::release(memory, size);
+    ASSERT_EQ(0, PageAllocator::getStats().hugePageBytes);
+}
+
+TEST_F(PageAllocatorTest, NumaNode) {
+    PageAllocator::configure(PageAllocator::HUGE_PAGES_NONE, 0);
+    const size_t size = PageAllocator::HUGE_PAGE_SIZE;
+    char *memory = static_cast<char*>(PageAllocator::allocate(size));
+    memset(memory, 1, size);
+    PageAllocator::Stats stats = PageAllocator::getStats();
+    ASSERT_EQ(size, stats.bytesAllocated);
+    ASSERT_EQ(0, stats.hugePageBytes);
+    // node 0 always exists, but the host may not let us place memory on it
+    ASSERT_TRUE(stats.numaBoundBytes == 0 || stats.numaBoundBytes == size);
+    PageAllocator::release(memory, size);
+    ASSERT_EQ(0, PageAllocator::getStats().numaBoundBytes);
+    PageAllocator::configure(PageAllocator::HUGE_PAGES_NONE, -1);
+}
+
+static void *releaseBig(void *memory) {
+    PageAllocator::release(memory, 2 * PageAllocator::HUGE_PAGE_SIZE);
+    return NULL;
+}
+
+TEST_F(PageAllocatorTest, ReleasedOnAnotherThread) {
+    PageAllocator::configure(PageAllocator::HUGE_PAGES_TRANSPARENT, -1);
+    const size_t size = 2 * PageAllocator::HUGE_PAGE_SIZE;
+    int backing = 0;
+    void *memory = PageAllocator::allocate(size, &backing);
+    ASSERT_EQ(PageAllocator::BACKED_HUGE, backing);
+    ASSERT_EQ(size, PageAllocator::getStats().hugePageBytes);
+
+    // The counters are the process's, so they go down on any thread.
+    pthread_t thread;
+    ASSERT_EQ(0, pthread_create(&thread, NULL, releaseBig, memory));
+    ASSERT_EQ(0, pthread_join(thread, NULL));
+    PageAllocator::Stats stats = PageAllocator::getStats();
+    ASSERT_EQ(0, stats.bytesAllocated);
+    ASSERT_EQ(0, stats.hugePageBytes);
+    PageAllocator::configure(PageAllocator::HUGE_PAGES_NONE, -1);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
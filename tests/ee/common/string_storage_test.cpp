@@ -0,0 +1,131 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <vector>
+#include "harness.h"
+#include "common/CompactingStringStorage.h"
+#include "common/StringRef.h"
+#include "common/ThreadLocalPool.h"
+
+using namespace voltdb;
+using namespace std;
+
+class StringStorageTest : public Test {
+public:
+    StringStorageTest() {}
+
+    StringRef *createString(size_t length, char fill) {
+        StringRef *sref = StringRef::create(length, NULL);
+        memset(sref->get(), fill, length);
+        return sref;
+    }
+
+    void checkString(const StringRef *sref, size_t length, char fill) {
+        for (size_t ii = 0; ii < length; ii++) {
+            ASSERT_EQ(fill, sref->get()[ii]);
+        }
+    }
+
+    ThreadLocalPool m_pool;
+};
+
+TEST_F(StringStorageTest, SizeClasses) {
+    // every size gets the smallest class that holds it
+    size_t previousClassSize = 0;
+    for (int ii = 0; ii < CompactingStringStorage::CLASS_COUNT; ii++) {
+        size_t classSize = CompactingStringStorage::getClassSize(ii);
+        ASSERT_TRUE(classSize > previousClassSize);
+        ASSERT_EQ(0, classSize % 8);
+        ASSERT_EQ(ii, CompactingStringStorage::getSizeClass(classSize));
+        ASSERT_EQ(ii, CompactingStringStorage::getSizeClass(previousClassSize + 1));
+        // no more than a third of a slot goes to waste
+        if (ii > 0) {
+            ASSERT_TRUE((classSize - previousClassSize - 1) * 3 <= classSize);
+        }
+        previousClassSize = classSize;
+    }
+    ASSERT_TRUE(previousClassSize >= CompactingStringStorage::MAX_ALLOCATION_SIZE);
+    ASSERT_EQ(24, CompactingStringStorage::getAllocationSize(17));
+    ASSERT_EQ(32, CompactingStringStorage::getAllocationSize(25));
+    ASSERT_EQ(0, CompactingStringStorage::getAllocationSize(CompactingStringStorage::MAX_ALLOCATION_SIZE + 1));
+}
+
+TEST_F(StringStorageTest, FreedSlotsAreReused) {
+    CompactingStringStorage *storage = ThreadLocalPool::getStringPool();
+    vector<StringRef*> strings;
+    for (int ii = 0; ii < 100; ii++) {
+        strings.push_back(createString(20, 'a'));
+    }
+    size_t allocated = storage->getPoolAllocationSize();
+    StringRef::destroy(strings[10]);
+    StringRef::destroy(strings[50]);
+    strings[10] = createString(20, 'b');
+    strings[50] = createString(20, 'c');
+    ASSERT_EQ(allocated, storage->getPoolAllocationSize());
+
+    vector<CompactingStringStorage::ClassStats> stats = storage->getClassStats();
+    ASSERT_EQ(1, stats.size());
+    ASSERT_EQ(CompactingStringStorage::getAllocationSize(20 + sizeof(StringRef*)), stats[0].classSize);
+    ASSERT_EQ(100, stats[0].liveCount);
+    ASSERT_EQ(0, stats[0].freeCount);
+
+    checkString(strings[10], 20, 'b');
+    checkString(strings[50], 20, 'c');
+    for (int ii = 0; ii < 100; ii++) {
+        StringRef::destroy(strings[ii]);
+    }
+    ASSERT_EQ(0, storage->getPoolAllocationSize());
+}
+
+TEST_F(StringStorageTest, Compaction) {
+    CompactingStringStorage *storage = ThreadLocalPool::getStringPool();
+    // large enough for a few strings per buffer, so that freeing some of
+    // them compacts the pool before the rest are freed
+    const size_t length = 300000;
+    vector<StringRef*> strings;
+    for (int ii = 0; ii < 40; ii++) {
+        strings.push_back(createString(length, static_cast<char>('a' + ii % 26)));
+    }
+    size_t allocated = storage->getPoolAllocationSize();
+
+    // free every other string, moving strings from the end into the holes
+    for (int ii = 0; ii < 40; ii += 2) {
+        StringRef::destroy(strings[ii]);
+        strings[ii] = NULL;
+    }
+    storage->compact();
+    ASSERT_TRUE(storage->getPoolAllocationSize() < allocated);
+    vector<CompactingStringStorage::ClassStats> stats = storage->getClassStats();
+    ASSERT_EQ(1, stats.size());
+    ASSERT_EQ(20, stats[0].liveCount);
+    ASSERT_EQ(0, stats[0].freeCount);
+    ASSERT_TRUE(stats[0].bytesAllocated <= 2 * (20 * stats[0].classSize));
+
+    // the strings that moved still read back through their StringRefs
+    for (int ii = 1; ii < 40; ii += 2) {
+        checkString(strings[ii], length, static_cast<char>('a' + ii % 26));
+    }
+    for (int ii = 1; ii < 40; ii += 2) {
+        StringRef::destroy(strings[ii]);
+    }
+    ASSERT_EQ(0, storage->getPoolAllocationSize());
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -461,6 +461,23 @@ TEST_F(AddDropTableTest, StatsWithDropTable)
     ASSERT_TRUE(statresult == 1);
 }
 
+/*
+ * Test on engine.
+ * Verify the string storage stats need no table locators and
+ * stay functional across catalog updates.
+ */
+TEST_F(AddDropTableTest, StringStorageStats)
+{
+    int statresult = m_engine->getStats(STATISTICS_SELECTOR_TYPE_STRING_STORAGE, NULL, 0, false, 1L);
+    ASSERT_TRUE(statresult == 1);
+
+    bool result = m_engine->updateCatalog( 0, tableACmds());
+    ASSERT_TRUE(result);
+
+    statresult = m_engine->getStats(STATISTICS_SELECTOR_TYPE_STRING_STORAGE, NULL, 0, false, 1L);
+    ASSERT_TRUE(statresult == 1);
+}
+
 /*
  * Test on engine.
  * Remove a non-existent table.
@@ -0,0 +1,99 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "harness.h"
+#include "executors/PlanExecutionTest.h"
+
+using namespace std;
+
+static const int64_t TEMP_TABLE_MEMORY = 4 * 1024 * 1024;
+static const int GROUP_COUNT = 300000;
+
+/*
+ * T holds two rows (g, 1) and (g, g) of each of GROUP_COUNT groups, far
+ * more groups than a quarter of the fragment memory holds, so the hash
+ * aggregate spills partitions that spill again when they are aggregated.
+ */
+class HashAggregateExecutorTest : public PlanExecutionTest {
+public:
+    HashAggregateExecutorTest() : PlanExecutionTest(TEMP_TABLE_MEMORY) {
+        m_engine->setTempTableSpillDirectory(m_spillDir.name());
+        addTable("T", 2);
+        EXPECT_TRUE(loadCatalog());
+
+        vector<int32_t> cells;
+        for (int group = 0; group < GROUP_COUNT; group++) {
+            cells.push_back(group);
+            cells.push_back(1);
+            cells.push_back(group);
+            cells.push_back(group);
+        }
+        insertRows("T", &cells[0], GROUP_COUNT * 2, 2);
+    }
+
+    /** SELECT C0, SUM(C1) FROM T GROUP BY C0 */
+    static string hashAggregatePlan() {
+        vector<string> output;
+        output.push_back(columnJson(0, 0));
+        output.push_back("{\"TYPE\":32,\"VALUE_TYPE\":6,\"VALUE_SIZE\":8,\"TABLE_IDX\":0,\"COLUMN_IDX\":1}");
+        vector<string> nodes;
+        nodes.push_back("{\"ID\":1,\"PLAN_NODE_TYPE\":\"SEND\",\"CHILDREN_IDS\":[2]}");
+        nodes.push_back("{\"ID\":2,\"PLAN_NODE_TYPE\":\"HASHAGGREGATE\",\"CHILDREN_IDS\":[3]," +
+                        outputSchemaJson(output) + "," +
+                        "\"AGGREGATE_COLUMNS\":[{\"AGGREGATE_TYPE\":\"AGGREGATE_SUM\"," +
+                        "\"AGGREGATE_DISTINCT\":0,\"AGGREGATE_OUTPUT_COLUMN\":1," +
+                        "\"AGGREGATE_EXPRESSION\":" + columnJson(0, 1) + "}]," +
+                        "\"GROUPBY_EXPRESSIONS\":[" + columnJson(0, 0) + "]}");
+        nodes.push_back("{\"ID\":3,\"PLAN_NODE_TYPE\":\"SEQSCAN\"," + tableSchemaJson(2) +
+                        ",\"TARGET_TABLE_NAME\":\"T\",\"TARGET_TABLE_ALIAS\":\"T\"}");
+        return fragmentJson(nodes, "3,2,1");
+    }
+
+    stupidunit::ChTempDir m_spillDir;
+};
+
+TEST_F(HashAggregateExecutorTest, RepartitionsSpilledGroups) {
+    vector<string> rows;
+    ASSERT_TRUE(executePlan(hashAggregatePlan(), rows));
+    sort(rows.begin(), rows.end());
+
+    vector<string> expected;
+    for (int group = 0; group < GROUP_COUNT; group++) {
+        ostringstream row;
+        row << group << "," << (group + 1);
+        expected.push_back(row.str());
+    }
+    sort(expected.begin(), expected.end());
+    ASSERT_EQ(expected.size(), rows.size());
+    for (int ii = 0; ii < rows.size(); ii++) {
+        EXPECT_EQ(expected[ii], rows[ii]);
+    }
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,125 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "harness.h"
+#include "executors/PlanExecutionTest.h"
+
+using namespace std;
+
+/*
+ * The hash join builds its table from the smaller input, so L JOIN R
+ * hashes the inner table R and S JOIN R hashes the outer table S.
+ * Every table has duplicate and NULL join keys in C0:
+ *   L: (1,10) (2,20) (2,21) (3,30) (NULL,40) (5,50)
+ *   R: (1,100) (2,200) (2,201) (3,300) (4,400) (NULL,500)
+ *   S: (2,60) (2,61) (NULL,62) (7,63)
+ */
+class HashJoinExecutorTest : public PlanExecutionTest {
+public:
+    HashJoinExecutorTest() {
+        addTable("L", 2);
+        addTable("R", 2);
+        addTable("S", 2);
+        EXPECT_TRUE(loadCatalog());
+
+        const int32_t left[] = { 1, 10,  2, 20,  2, 21,  3, 30,  NULL_CELL, 40,  5, 50 };
+        insertRows("L", left, 6, 2);
+        const int32_t right[] = { 2, 200,  4, 400,  1, 100,  NULL_CELL, 500,  3, 300,  2, 201 };
+        insertRows("R", right, 6, 2);
+        const int32_t small[] = { 2, 60,  NULL_CELL, 62,  7, 63,  2, 61 };
+        insertRows("S", small, 4, 2);
+    }
+
+    static string seqScanJson(int id, const string& table) {
+        ostringstream json;
+        json << "{\"ID\":" << id << ",\"PLAN_NODE_TYPE\":\"SEQSCAN\"," << tableSchemaJson(2)
+             << ",\"TARGET_TABLE_NAME\":\"" << table << "\",\"TARGET_TABLE_ALIAS\":\"" << table << "\"}";
+        return json.str();
+    }
+
+    /** SELECT * FROM outer <joinType> JOIN R ON outer.C0 = R.C0 */
+    static string hashJoinPlan(const string& joinType, const string& outer) {
+        // Like the nest loop join, the hash join outputs the outer columns
+        // followed by the inner ones.
+        vector<string> output;
+        output.push_back(columnJson(0, 0));
+        output.push_back(columnJson(0, 1));
+        output.push_back(columnJson(1, 0));
+        output.push_back(columnJson(1, 1));
+        vector<string> nodes;
+        nodes.push_back("{\"ID\":1,\"PLAN_NODE_TYPE\":\"SEND\",\"CHILDREN_IDS\":[2]}");
+        nodes.push_back("{\"ID\":2,\"PLAN_NODE_TYPE\":\"HASHJOIN\",\"CHILDREN_IDS\":[3,4]," +
+                        outputSchemaJson(output) + ",\"JOIN_TYPE\":\"" + joinType + "\"," +
+                        "\"OUTER_HASH_KEYS\":[" + columnJson(0, 0) + "]," +
+                        "\"INNER_HASH_KEYS\":[" + columnJson(1, 0) + "]}");
+        nodes.push_back(seqScanJson(3, outer));
+        nodes.push_back(seqScanJson(4, "R"));
+        return fragmentJson(nodes, "3,4,2,1");
+    }
+
+    void checkJoin(const string& plan, const char* expected[], size_t expectedCount) {
+        vector<string> rows;
+        ASSERT_TRUE(executePlan(plan, rows));
+        sort(rows.begin(), rows.end());
+        ASSERT_EQ(expectedCount, rows.size());
+        for (int ii = 0; ii < rows.size(); ii++) {
+            EXPECT_EQ(string(expected[ii]), rows[ii]);
+        }
+    }
+};
+
+TEST_F(HashJoinExecutorTest, InnerJoinHashingInner) {
+    const char* expected[] = { "1,10,1,100",
+                               "2,20,2,200", "2,20,2,201", "2,21,2,200", "2,21,2,201",
+                               "3,30,3,300" };
+    checkJoin(hashJoinPlan("INNER", "L"), expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+TEST_F(HashJoinExecutorTest, LeftJoinHashingInner) {
+    const char* expected[] = { "1,10,1,100",
+                               "2,20,2,200", "2,20,2,201", "2,21,2,200", "2,21,2,201",
+                               "3,30,3,300",
+                               "5,50,NULL,NULL",
+                               "NULL,40,NULL,NULL" };
+    checkJoin(hashJoinPlan("LEFT", "L"), expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+TEST_F(HashJoinExecutorTest, InnerJoinHashingOuter) {
+    const char* expected[] = { "2,60,2,200", "2,60,2,201", "2,61,2,200", "2,61,2,201" };
+    checkJoin(hashJoinPlan("INNER", "S"), expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+TEST_F(HashJoinExecutorTest, LeftJoinHashingOuter) {
+    const char* expected[] = { "2,60,2,200", "2,60,2,201", "2,61,2,200", "2,61,2,201",
+                               "7,63,NULL,NULL",
+                               "NULL,62,NULL,NULL" };
+    checkJoin(hashJoinPlan("LEFT", "S"), expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
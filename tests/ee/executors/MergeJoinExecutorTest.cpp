@@ -0,0 +1,132 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "harness.h"
+#include "executors/PlanExecutionTest.h"
+
+using namespace std;
+
+/*
+ * L and R both have duplicate and NULL join keys in C0:
+ *   L: (1,10) (2,20) (2,21) (3,30) (NULL,40) (5,50)
+ *   R: (1,100) (2,200) (2,201) (3,300) (4,400) (NULL,500)
+ */
+class MergeJoinExecutorTest : public PlanExecutionTest {
+public:
+    MergeJoinExecutorTest() {
+        addTable("L", 2);
+        addTable("R", 2);
+        addIndex("L", "L_C0", vector<int>(1, 0));
+        addIndex("R", "R_C0", vector<int>(1, 0));
+        addIndex("R", "R_C1", vector<int>(1, 1));
+        EXPECT_TRUE(loadCatalog());
+
+        const int32_t left[] = { 1, 10,  2, 20,  2, 21,  3, 30,  NULL_CELL, 40,  5, 50 };
+        insertRows("L", left, 6, 2);
+        const int32_t right[] = { 2, 200,  4, 400,  1, 100,  NULL_CELL, 500,  3, 300,  2, 201 };
+        insertRows("R", right, 6, 2);
+    }
+
+    static string indexScanJson(int id, const string& table, const string& index,
+                                const string& sortDirection) {
+        return "{\"ID\":" + intString(id) + ",\"PLAN_NODE_TYPE\":\"INDEXSCAN\"," +
+            tableSchemaJson(2) + ",\"TARGET_TABLE_NAME\":\"" + table + "\"," +
+            "\"TARGET_TABLE_ALIAS\":\"" + table + "\",\"LOOKUP_TYPE\":\"GTE\"," +
+            "\"SORT_DIRECTION\":\"" + sortDirection + "\",\"TARGET_INDEX_NAME\":\"" + index + "\"}";
+    }
+
+    /** SELECT L.C0, L.C1, R.C1 FROM L <joinType> JOIN R ON L.C0 = R.<innerKey> */
+    static string mergeJoinPlan(const string& joinType, const string& innerIndex, int innerKey,
+                                const string& innerSortDirection = "ASC") {
+        vector<string> output;
+        output.push_back(columnJson(0, 0));
+        output.push_back(columnJson(0, 1));
+        output.push_back(columnJson(1, 1));
+        vector<string> nodes;
+        nodes.push_back("{\"ID\":1,\"PLAN_NODE_TYPE\":\"SEND\",\"CHILDREN_IDS\":[2]}");
+        nodes.push_back("{\"ID\":2,\"PLAN_NODE_TYPE\":\"MERGEJOIN\"," + outputSchemaJson(output) +
+                        ",\"JOIN_TYPE\":\"" + joinType + "\"," +
+                        "\"OUTER_INDEX_SCAN\":" + indexScanJson(3, "L", "L_C0", "ASC") + "," +
+                        "\"INLINE_NODES\":[" + indexScanJson(4, "R", innerIndex, innerSortDirection) + "]," +
+                        "\"OUTER_JOIN_KEYS\":[" + columnJson(0, 0) + "]," +
+                        "\"INNER_JOIN_KEYS\":[" + columnJson(1, innerKey) + "]}");
+        return fragmentJson(nodes, "2,1");
+    }
+
+    static string intString(int value) {
+        ostringstream oss;
+        oss << value;
+        return oss.str();
+    }
+};
+
+TEST_F(MergeJoinExecutorTest, InnerJoinWithDuplicateKeys) {
+    vector<string> rows;
+    ASSERT_TRUE(executePlan(mergeJoinPlan("INNER", "R_C0", 0), rows));
+    sort(rows.begin(), rows.end());
+
+    const char* expected[] = { "1,10,100",
+                               "2,20,200", "2,20,201", "2,21,200", "2,21,201",
+                               "3,30,300" };
+    ASSERT_EQ(sizeof(expected) / sizeof(expected[0]), rows.size());
+    for (int ii = 0; ii < rows.size(); ii++) {
+        EXPECT_EQ(string(expected[ii]), rows[ii]);
+    }
+}
+
+TEST_F(MergeJoinExecutorTest, LeftJoinKeepsUnmatchedAndNullKeys) {
+    vector<string> rows;
+    ASSERT_TRUE(executePlan(mergeJoinPlan("LEFT", "R_C0", 0), rows));
+    sort(rows.begin(), rows.end());
+
+    const char* expected[] = { "1,10,100",
+                               "2,20,200", "2,20,201", "2,21,200", "2,21,201",
+                               "3,30,300",
+                               "5,50,NULL",
+                               "NULL,40,NULL" };
+    ASSERT_EQ(sizeof(expected) / sizeof(expected[0]), rows.size());
+    for (int ii = 0; ii < rows.size(); ii++) {
+        EXPECT_EQ(string(expected[ii]), rows[ii]);
+    }
+}
+
+TEST_F(MergeJoinExecutorTest, RejectsKeysNotLeadingTheIndex) {
+    vector<string> rows;
+    // The inner key R.C1 is not the leading column of R_C0.
+    EXPECT_FALSE(executePlan(mergeJoinPlan("INNER", "R_C0", 1), rows));
+    // The inner key R.C0 is not the leading column of R_C1.
+    EXPECT_FALSE(executePlan(mergeJoinPlan("INNER", "R_C1", 0), rows));
+}
+
+TEST_F(MergeJoinExecutorTest, RejectsDescendingScan) {
+    vector<string> rows;
+    EXPECT_FALSE(executePlan(mergeJoinPlan("INNER", "R_C0", 0, "DESC"), rows));
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,184 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "harness.h"
+#include "executors/PlanExecutionTest.h"
+
+using namespace std;
+
+/*
+ * ORDER BY with an inlined LIMIT keeps the top limit + offset tuples in a
+ * heap. T has ties in C0, and its row (0,60) is where 60 / C0 divides by
+ * zero, which a descending scan of T_C0 reaches last:
+ *   T: (3,30) (1,10) (4,40) (1,11) (5,50) (0,60) (3,31) (2,20)
+ */
+class OrderByExecutorTest : public PlanExecutionTest {
+public:
+    OrderByExecutorTest() {
+        addTable("T", 2);
+        addIndex("T", "T_C0", vector<int>(1, 0));
+        EXPECT_TRUE(loadCatalog());
+
+        const int32_t cells[] = { 3, 30,  1, 10,  4, 40,  1, 11,  5, 50,  0, 60,  3, 31,  2, 20 };
+        insertRows("T", cells, 8, 2);
+    }
+
+    static string compareJson(int type, const string& left, const string& right) {
+        ostringstream json;
+        json << "{\"TYPE\":" << type << ",\"VALUE_TYPE\":23,\"VALUE_SIZE\":1,\"LEFT\":" << left
+             << ",\"RIGHT\":" << right << "}";
+        return json.str();
+    }
+
+    /** C1 > 0, true of every row, so that the scan pushes its output. */
+    static string positiveJson() {
+        return compareJson(13, columnJson(0, 1), integerJson(0));
+    }
+
+    /** 60 / C0 > 0, which divides by zero on the row (0,60). */
+    static string quotientJson() {
+        const string divide = "{\"TYPE\":4,\"VALUE_TYPE\":6,\"VALUE_SIZE\":8,\"LEFT\":" +
+            integerJson(60) + ",\"RIGHT\":" + columnJson(0, 0) + "}";
+        return compareJson(13, divide, integerJson(0));
+    }
+
+    static string seqScanJson(int id) {
+        return "{\"ID\":" + intString(id) + ",\"PLAN_NODE_TYPE\":\"SEQSCAN\"," + tableSchemaJson(2) +
+            ",\"TARGET_TABLE_NAME\":\"T\",\"TARGET_TABLE_ALIAS\":\"T\",\"PREDICATE\":" +
+            positiveJson() + "}";
+    }
+
+    static string indexScanJson(int id, const string& sortDirection, const string& predicate) {
+        return "{\"ID\":" + intString(id) + ",\"PLAN_NODE_TYPE\":\"INDEXSCAN\"," + tableSchemaJson(2) +
+            ",\"TARGET_TABLE_NAME\":\"T\",\"TARGET_TABLE_ALIAS\":\"T\",\"LOOKUP_TYPE\":\"GTE\"," +
+            "\"SORT_DIRECTION\":\"" + sortDirection + "\",\"TARGET_INDEX_NAME\":\"T_C0\"," +
+            "\"PREDICATE\":" + predicate + "}";
+    }
+
+    static string sortColumnJson(int column, const string& direction) {
+        return "{\"SORT_EXPRESSION\":" + columnJson(0, column) + ",\"SORT_DIRECTION\":\"" + direction + "\"}";
+    }
+
+    /** SELECT * FROM <scan> ORDER BY <sortColumns> LIMIT <limit> OFFSET <offset> */
+    static string orderByPlan(const string& scan, const string& sortColumns, int limit, int offset) {
+        vector<string> nodes;
+        nodes.push_back("{\"ID\":1,\"PLAN_NODE_TYPE\":\"SEND\",\"CHILDREN_IDS\":[2]}");
+        nodes.push_back("{\"ID\":2,\"PLAN_NODE_TYPE\":\"ORDERBY\",\"CHILDREN_IDS\":[3]," +
+                        string("\"SORT_COLUMNS\":[") + sortColumns + "]," +
+                        "\"INLINE_NODES\":[{\"ID\":4,\"PLAN_NODE_TYPE\":\"LIMIT\",\"LIMIT\":" +
+                        intString(limit) + ",\"OFFSET\":" + intString(offset) + "}]}");
+        nodes.push_back(scan);
+        return fragmentJson(nodes, "3,2,1");
+    }
+
+    static string intString(int value) {
+        ostringstream oss;
+        oss << value;
+        return oss.str();
+    }
+
+    void checkRows(const string& plan, const char* expected[], size_t expectedCount) {
+        vector<string> rows;
+        ASSERT_TRUE(executePlan(plan, rows));
+        ASSERT_EQ(expectedCount, rows.size());
+        for (int ii = 0; ii < rows.size(); ii++) {
+            EXPECT_EQ(string(expected[ii]), rows[ii]);
+        }
+    }
+};
+
+TEST_F(OrderByExecutorTest, OffsetPastTheHeap) {
+    const string byC0C1 = sortColumnJson(0, "ASC") + "," + sortColumnJson(1, "ASC");
+    vector<string> rows;
+    ASSERT_TRUE(executePlan(orderByPlan(seqScanJson(3), byC0C1, 2, 10), rows));
+    EXPECT_EQ(0, rows.size());
+
+    // The offset leaves the last tuple of the heap
+    const char* expected[] = { "5,50" };
+    checkRows(orderByPlan(seqScanJson(3), byC0C1, 2, 7), expected, 1);
+}
+
+TEST_F(OrderByExecutorTest, LimitZero) {
+    const string byC0 = sortColumnJson(0, "ASC");
+    vector<string> rows;
+    ASSERT_TRUE(executePlan(orderByPlan(seqScanJson(3), byC0, 0, 0), rows));
+    EXPECT_EQ(0, rows.size());
+    ASSERT_TRUE(executePlan(orderByPlan(seqScanJson(3), byC0, 0, 3), rows));
+    EXPECT_EQ(0, rows.size());
+}
+
+TEST_F(OrderByExecutorTest, Ties) {
+    const char* byBoth[] = { "0,60", "1,11", "1,10" };
+    checkRows(orderByPlan(seqScanJson(3), sortColumnJson(0, "ASC") + "," + sortColumnJson(1, "DESC"), 3, 0),
+              byBoth, 3);
+
+    // The offset cuts through the tied 1s and the limit through the tied
+    // 3s, so either of each may come out.
+    vector<string> rows;
+    ASSERT_TRUE(executePlan(orderByPlan(seqScanJson(3), sortColumnJson(0, "ASC"), 3, 2), rows));
+    ASSERT_EQ(3, rows.size());
+    EXPECT_TRUE(rows[0] == "1,10" || rows[0] == "1,11");
+    EXPECT_EQ("2,20", rows[1]);
+    EXPECT_TRUE(rows[2] == "3,30" || rows[2] == "3,31");
+}
+
+TEST_F(OrderByExecutorTest, LimitTooLargeForTheHeap) {
+    // Far more tuples than a sorted run holds: the input is gathered and sorted.
+    const char* expected[] = { "1,11", "2,20", "3,30", "3,31", "4,40", "5,50" };
+    checkRows(orderByPlan(seqScanJson(3), sortColumnJson(0, "ASC") + "," + sortColumnJson(1, "ASC"),
+                          100000000, 2),
+              expected, 6);
+}
+
+TEST_F(OrderByExecutorTest, DescendingIndexScanFeedsTheHeap) {
+    // The scan is in sort order, so it stops once the heap is full, before
+    // it reaches the row (0,60).
+    const char* expected[] = { "5,50", "4,40" };
+    checkRows(orderByPlan(indexScanJson(3, "DESC", quotientJson()), sortColumnJson(0, "DESC"), 2, 0),
+              expected, 2);
+
+    const char* offset[] = { "3,30", "3,31" };
+    vector<string> rows;
+    ASSERT_TRUE(executePlan(orderByPlan(indexScanJson(3, "DESC", quotientJson()),
+                                        sortColumnJson(0, "DESC"), 2, 2), rows));
+    ASSERT_EQ(2, rows.size());
+    sort(rows.begin(), rows.end());
+    EXPECT_EQ(string(offset[0]), rows[0]);
+    EXPECT_EQ(string(offset[1]), rows[1]);
+
+    // Against the direction of the scan, the heap takes every row.
+    const char* ascending[] = { "0,60", "1,10" };
+    checkRows(orderByPlan(indexScanJson(3, "DESC", positiveJson()),
+                          sortColumnJson(0, "ASC") + "," + sortColumnJson(1, "ASC"), 2, 0),
+              ascending, 2);
+    EXPECT_FALSE(executePlan(orderByPlan(indexScanJson(3, "DESC", quotientJson()),
+                                         sortColumnJson(0, "ASC"), 2, 0), rows));
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,160 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "harness.h"
+#include "executors/PlanExecutionTest.h"
+
+using namespace std;
+
+/*
+ * Scans with a predicate, projections, nest loops and limits push their
+ * output straight into a parent projection or limit. The rows of L come
+ * out of a scan in the order they were inserted, and the row (0,60) is
+ * where 60 / C0 divides by zero, so a plan only gets past it if the
+ * limit above stopped the producers before they evaluated it.
+ *   L: (1,10) (2,20) (5,50) (0,60) (4,40)
+ *   R: (30,300) (12,120) (60,600)
+ */
+class PipelinedExecutorTest : public PlanExecutionTest {
+public:
+    PipelinedExecutorTest() {
+        addTable("L", 2);
+        addTable("R", 2);
+        EXPECT_TRUE(loadCatalog());
+
+        const int32_t left[] = { 1, 10,  2, 20,  5, 50,  0, 60,  4, 40 };
+        insertRows("L", left, 5, 2);
+        const int32_t right[] = { 30, 300,  12, 120,  60, 600 };
+        insertRows("R", right, 3, 2);
+    }
+
+    /** A scan of all rows with the predicate C1 > 0, which lets it push its output. */
+    static string seqScanJson(int id, const string& table) {
+        ostringstream json;
+        json << "{\"ID\":" << id << ",\"PLAN_NODE_TYPE\":\"SEQSCAN\"," << tableSchemaJson(2)
+             << ",\"TARGET_TABLE_NAME\":\"" << table << "\",\"TARGET_TABLE_ALIAS\":\"" << table << "\""
+             << ",\"PREDICATE\":" << compareJson(13, columnJson(0, 1), integerJson(0)) << "}";
+        return json.str();
+    }
+
+    static string compareJson(int type, const string& left, const string& right) {
+        ostringstream json;
+        json << "{\"TYPE\":" << type << ",\"VALUE_TYPE\":23,\"VALUE_SIZE\":1,\"LEFT\":" << left
+             << ",\"RIGHT\":" << right << "}";
+        return json.str();
+    }
+
+    /** 60 / C0 of the outer tuple, as a BIGINT */
+    static string divideJson() {
+        return "{\"TYPE\":4,\"VALUE_TYPE\":6,\"VALUE_SIZE\":8,\"LEFT\":" + integerJson(60) +
+            ",\"RIGHT\":" + columnJson(0, 0) + "}";
+    }
+
+    static string limitJson(int id, int child, int limit, int offset) {
+        ostringstream json;
+        json << "{\"ID\":" << id << ",\"PLAN_NODE_TYPE\":\"LIMIT\",\"CHILDREN_IDS\":[" << child
+             << "],\"LIMIT\":" << limit << ",\"OFFSET\":" << offset << "}";
+        return json.str();
+    }
+
+    /** SELECT C0, <second> FROM L LIMIT <limit> OFFSET <offset> */
+    static string projectionLimitPlan(const string& second, int limit, int offset) {
+        vector<string> output;
+        output.push_back(columnJson(0, 0));
+        output.push_back(second);
+        vector<string> nodes;
+        nodes.push_back("{\"ID\":1,\"PLAN_NODE_TYPE\":\"SEND\",\"CHILDREN_IDS\":[2]}");
+        nodes.push_back(limitJson(2, 3, limit, offset));
+        nodes.push_back("{\"ID\":3,\"PLAN_NODE_TYPE\":\"PROJECTION\",\"CHILDREN_IDS\":[4]," +
+                        outputSchemaJson(output) + "}");
+        nodes.push_back(seqScanJson(4, "L"));
+        return fragmentJson(nodes, "4,3,2,1");
+    }
+
+    /** SELECT * FROM L JOIN R ON 60 / L.C0 = R.C0 LIMIT <limit> OFFSET <offset> */
+    static string nestLoopLimitPlan(int limit, int offset) {
+        vector<string> output;
+        output.push_back(columnJson(0, 0));
+        output.push_back(columnJson(0, 1));
+        output.push_back(columnJson(1, 0));
+        output.push_back(columnJson(1, 1));
+        vector<string> nodes;
+        nodes.push_back("{\"ID\":1,\"PLAN_NODE_TYPE\":\"SEND\",\"CHILDREN_IDS\":[2]}");
+        nodes.push_back(limitJson(2, 3, limit, offset));
+        nodes.push_back("{\"ID\":3,\"PLAN_NODE_TYPE\":\"NESTLOOP\",\"CHILDREN_IDS\":[4,5]," +
+                        outputSchemaJson(output) + ",\"JOIN_TYPE\":\"INNER\"," +
+                        "\"JOIN_PREDICATE\":" + compareJson(10, divideJson(), columnJson(1, 0)) + "}");
+        nodes.push_back(seqScanJson(4, "L"));
+        nodes.push_back(seqScanJson(5, "R"));
+        return fragmentJson(nodes, "4,5,3,2,1");
+    }
+
+    void checkRows(const string& plan, const char* expected[], size_t expectedCount) {
+        vector<string> rows;
+        ASSERT_TRUE(executePlan(plan, rows));
+        ASSERT_EQ(expectedCount, rows.size());
+        for (int ii = 0; ii < rows.size(); ii++) {
+            EXPECT_EQ(string(expected[ii]), rows[ii]);
+        }
+    }
+};
+
+TEST_F(PipelinedExecutorTest, ScanProjectionLimitWithOffset) {
+    const char* expected[] = { "2,20", "5,50" };
+    checkRows(projectionLimitPlan(columnJson(0, 1), 2, 1), expected, 2);
+
+    // An offset past the end outputs nothing
+    vector<string> rows;
+    ASSERT_TRUE(executePlan(projectionLimitPlan(columnJson(0, 1), 2, 5), rows));
+    EXPECT_EQ(0, rows.size());
+}
+
+TEST_F(PipelinedExecutorTest, PushedLimitStopsTheScan) {
+    const char* expected[] = { "1,60", "2,30", "5,12" };
+    checkRows(projectionLimitPlan(divideJson(), 3, 0), expected, 3);
+
+    // One more row reaches the division by zero
+    vector<string> rows;
+    EXPECT_FALSE(executePlan(projectionLimitPlan(divideJson(), 4, 0), rows));
+}
+
+TEST_F(PipelinedExecutorTest, NestLoopPushesIntoLimit) {
+    const char* expected[] = { "2,20,30,300", "5,50,12,120" };
+    checkRows(nestLoopLimitPlan(2, 1), expected, 2);
+
+    // L's (1,10) joins the last row of R, and the join stops right after it.
+    const char* first[] = { "1,10,60,600" };
+    checkRows(nestLoopLimitPlan(1, 0), first, 1);
+
+    // One more row reaches the division by zero
+    vector<string> rows;
+    EXPECT_FALSE(executePlan(nestLoopLimitPlan(4, 0), rows));
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,271 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLANEXECUTIONTEST_H_
+#define PLANEXECUTIONTEST_H_
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "harness.h"
+#include "common/Topend.h"
+#include "common/ValueFactory.hpp"
+#include "common/serializeio.h"
+#include "execution/VoltDBEngine.h"
+#include "storage/persistenttable.h"
+
+/** Marks a NULL cell in the rows given to insertRows(). */
+static const int32_t NULL_CELL = INT32_MIN;
+
+/** A topend that hands out the JSON plans registered by the test. */
+class PlanTestTopend : public voltdb::DummyTopend {
+public:
+    std::string planForFragmentId(int64_t fragmentId) {
+        return m_plans[fragmentId];
+    }
+
+    std::map<int64_t, std::string> m_plans;
+};
+
+/**
+ * Runs hand written JSON plan fragments through the engine, the way the
+ * planner's fragments are run, against tables of nullable INTEGER columns
+ * C0, C1, ... declared with addTable() and addIndex().
+ */
+class PlanExecutionTest : public Test {
+public:
+    explicit PlanExecutionTest(int64_t tempTableMemory = voltdb::DEFAULT_TEMP_TABLE_MEMORY)
+        : m_engine(new voltdb::VoltDBEngine(&m_topend))
+        , m_resultBuffer(new char[RESULT_BUFFER_SIZE])
+        , m_exceptionBuffer(new char[EXCEPTION_BUFFER_SIZE])
+        , m_nextFragmentId(100)
+        , m_undoToken(0)
+    {
+        m_engine->setBuffers(NULL, 0, m_resultBuffer, RESULT_BUFFER_SIZE,
+                             m_exceptionBuffer, EXCEPTION_BUFFER_SIZE);
+        m_engine->resetReusedResultOutputBuffer();
+        int partitionCount = 1;
+        m_engine->initialize(0, 0, 0, 0, "", tempTableMemory);
+        m_engine->updateHashinator(voltdb::HASHINATOR_LEGACY, (char*)&partitionCount, NULL, 0);
+        m_catalog << "add / clusters cluster\n"
+                  << "add /clusters[cluster] databases database\n"
+                  << "add /clusters[cluster]/databases[database] programs program\n";
+    }
+
+    ~PlanExecutionTest() {
+        delete m_engine;
+        delete [] m_resultBuffer;
+        delete [] m_exceptionBuffer;
+    }
+
+protected:
+    static const int RESULT_BUFFER_SIZE = 8 * 1024 * 1024;
+    static const int EXCEPTION_BUFFER_SIZE = 4096;
+
+    void addTable(const std::string& table, int columnCount) {
+        const std::string path = "/clusters[cluster]/databases[database]/tables[" + table + "]";
+        m_catalog << "add /clusters[cluster]/databases[database] tables " << table << "\n"
+                  << "set " << path << " type 0\n"
+                  << "set " << path << " isreplicated false\n"
+                  << "set " << path << " partitioncolumn 0\n"
+                  << "set " << path << " estimatedtuplecount 0\n"
+                  << "set " << path << " tuplelimit 2147483647\n";
+        for (int ii = 0; ii < columnCount; ii++) {
+            std::ostringstream column;
+            column << path << "/columns[C" << ii << "]";
+            m_catalog << "add " << path << " columns C" << ii << "\n"
+                      << "set " << column.str() << " index " << ii << "\n"
+                      << "set " << column.str() << " type " << voltdb::VALUE_TYPE_INTEGER << "\n"
+                      << "set " << column.str() << " size 0\n"
+                      << "set " << column.str() << " nullable true\n"
+                      << "set " << column.str() << " name \"C" << ii << "\"\n";
+        }
+    }
+
+    /** Add a non-unique tree index on the given columns, in that order. */
+    void addIndex(const std::string& table, const std::string& index, const std::vector<int>& columns) {
+        const std::string tablePath = "/clusters[cluster]/databases[database]/tables[" + table + "]";
+        const std::string path = tablePath + "/indexes[" + index + "]";
+        m_catalog << "add " << tablePath << " indexes " << index << "\n"
+                  << "set " << path << " unique false\n"
+                  << "set " << path << " type " << voltdb::BALANCED_TREE_INDEX << "\n";
+        for (int ii = 0; ii < columns.size(); ii++) {
+            std::ostringstream column;
+            column << "C" << columns[ii];
+            m_catalog << "add " << path << " columns " << column.str() << "\n"
+                      << "set " << path << "/columns[" << column.str() << "] index " << ii << "\n"
+                      << "set " << path << "/columns[" << column.str() << "] column "
+                      << tablePath << "/columns[" << column.str() << "]\n";
+        }
+    }
+
+    bool loadCatalog() {
+        return m_engine->loadCatalog(-2, m_catalog.str());
+    }
+
+    /** Insert rowCount rows of columnCount cells each, NULL_CELL for NULL. */
+    void insertRows(const std::string& table, const int32_t* cells, int rowCount, int columnCount) {
+        voltdb::PersistentTable* target = dynamic_cast<voltdb::PersistentTable*>(m_engine->getTable(table));
+        ASSERT_TRUE(target != NULL);
+        m_engine->setUndoToken(++m_undoToken);
+        m_engine->updateExecutorContextUndoQuantumForTest();
+        voltdb::TableTuple tuple = target->tempTuple();
+        for (int row = 0; row < rowCount; row++) {
+            for (int col = 0; col < columnCount; col++) {
+                tuple.setNValue(col, voltdb::ValueFactory::getIntegerValue(cells[row * columnCount + col]));
+            }
+            target->insertTuple(tuple);
+        }
+        m_engine->releaseUndoToken(m_undoToken);
+    }
+
+    /**
+     * Execute a plan fragment and return its result rows, one comma separated
+     * string of cells per row. Return false if the fragment failed.
+     */
+    bool executePlan(const std::string& plan, std::vector<std::string>& rows) {
+        const int64_t fragmentId = m_nextFragmentId++;
+        m_topend.m_plans[fragmentId] = plan;
+
+        // No parameters
+        char params[2] = { 0, 0 };
+        voltdb::ReferenceSerializeInputBE paramInput(params, sizeof(params));
+        m_engine->resetReusedResultOutputBuffer();
+        ++m_undoToken;
+        int64_t fragmentIds[1] = { fragmentId };
+        if (m_engine->executePlanFragments(1, fragmentIds, NULL, paramInput,
+                                           m_undoToken, m_undoToken, m_undoToken - 1,
+                                           m_undoToken, m_undoToken) != 0) {
+            return false;
+        }
+        m_engine->releaseUndoToken(m_undoToken);
+
+        voltdb::ReferenceSerializeInputBE result(m_resultBuffer, m_engine->getResultsSize());
+        result.readInt();  // batch size
+        result.readByte(); // dirty flag
+        result.readInt();  // dependency count
+        result.readInt();  // output id placeholder
+        result.readInt();  // table size
+        result.readInt();  // header size
+        result.readByte(); // status
+        int16_t columnCount = result.readShort();
+        std::vector<voltdb::ValueType> types;
+        for (int ii = 0; ii < columnCount; ii++) {
+            types.push_back(static_cast<voltdb::ValueType>(result.readByte()));
+        }
+        for (int ii = 0; ii < columnCount; ii++) {
+            result.readTextString();
+        }
+        rows.clear();
+        int32_t rowCount = result.readInt();
+        for (int row = 0; row < rowCount; row++) {
+            result.readInt(); // row size
+            std::ostringstream cells;
+            for (int col = 0; col < columnCount; col++) {
+                int64_t value;
+                bool isNull;
+                if (types[col] == voltdb::VALUE_TYPE_BIGINT) {
+                    value = result.readLong();
+                    isNull = (value == INT64_MIN);
+                }
+                else {
+                    EXPECT_EQ(voltdb::VALUE_TYPE_INTEGER, types[col]);
+                    value = result.readInt();
+                    isNull = (value == INT32_MIN);
+                }
+                cells << (col == 0 ? "" : ",");
+                if (isNull) {
+                    cells << "NULL";
+                }
+                else {
+                    cells << value;
+                }
+            }
+            rows.push_back(cells.str());
+        }
+        return true;
+    }
+
+    //
+    // JSON snippets for the plans
+    //
+
+    /** An INTEGER column of the outer (0) or inner (1) tuple. */
+    static std::string columnJson(int tableIdx, int columnIdx) {
+        std::ostringstream json;
+        json << "{\"TYPE\":32,\"VALUE_TYPE\":5,\"VALUE_SIZE\":4,\"TABLE_IDX\":" << tableIdx
+             << ",\"COLUMN_IDX\":" << columnIdx << "}";
+        return json.str();
+    }
+
+    static std::string integerJson(int32_t value) {
+        std::ostringstream json;
+        json << "{\"TYPE\":30,\"VALUE_TYPE\":5,\"VALUE_SIZE\":4,\"ISNULL\":false,\"VALUE\":" << value << "}";
+        return json.str();
+    }
+
+    /** An OUTPUT_SCHEMA of the given expressions. */
+    static std::string outputSchemaJson(const std::vector<std::string>& expressions) {
+        std::ostringstream json;
+        json << "\"OUTPUT_SCHEMA\":[";
+        for (int ii = 0; ii < expressions.size(); ii++) {
+            json << (ii == 0 ? "" : ",") << "{\"COLUMN_NAME\":\"C" << ii << "\",\"EXPRESSION\":"
+                 << expressions[ii] << "}";
+        }
+        json << "]";
+        return json.str();
+    }
+
+    /** The OUTPUT_SCHEMA of all columns of a table. */
+    static std::string tableSchemaJson(int columnCount) {
+        std::vector<std::string> columns;
+        for (int ii = 0; ii < columnCount; ii++) {
+            columns.push_back(columnJson(0, ii));
+        }
+        return outputSchemaJson(columns);
+    }
+
+    /** A fragment of the given plan nodes, executed in the given order. */
+    static std::string fragmentJson(const std::vector<std::string>& nodes, const std::string& executeList) {
+        std::ostringstream json;
+        json << "{\"PLAN_NODES\":[";
+        for (int ii = 0; ii < nodes.size(); ii++) {
+            json << (ii == 0 ? "" : ",") << nodes[ii];
+        }
+        json << "],\"EXECUTE_LIST\":[" << executeList << "]}";
+        return json.str();
+    }
+
+    PlanTestTopend m_topend;
+    voltdb::VoltDBEngine* m_engine;
+    char* m_resultBuffer;
+    char* m_exceptionBuffer;
+    std::ostringstream m_catalog;
+    int64_t m_nextFragmentId;
+    int64_t m_undoToken;
+};
+
+#endif // PLANEXECUTIONTEST_H_
@@ -61,6 +61,7 @@
 
 #include "expressions/abstractexpression.h"
 #include "expressions/expressions.h"
+#include "expressions/fusedpredicateexpression.h"
 #include "common/types.h"
 #include "common/ValuePeeker.hpp"
 #include "common/PlannerDomValue.h"
@@ -291,8 +292,7 @@ AE * makeTree(AE *tree, queue<AE*> &q) {
 /* boilerplate to turn the queue into a real AbstractExpression tree;
    return the generated AE tree by reference to allow deletion (the queue
    is emptied by the tree building process) */
-AbstractExpression * convertToExpression(queue<AE*> &e) {
-    AE *tree = makeTree(NULL, e);
+AbstractExpression * convertToExpression(AE *tree) {
     Json::Value json = tree->serializeValue();
     Json::FastWriter writer;
     std::string jsonText = writer.write(json);
@@ -304,6 +304,10 @@ AbstractExpression * convertToExpression(queue<AE*> &e) {
     return exp;
 }
 
+AbstractExpression * convertToExpression(queue<AE*> &e) {
+    return convertToExpression(makeTree(NULL, e));
+}
+
 
 class ExpressionTest : public Test {
     public:
@@ -453,6 +457,161 @@ TEST_F(ExpressionTest, Timestamp) {
 
 }
 
+AE * columnCompare(ExpressionType et, ValueType vt, int column, int64_t value) {
+    return join(new AE(et, VALUE_TYPE_BOOLEAN, 1),
+                new TV(EXPRESSION_TYPE_VALUE_TUPLE, vt, 8, column, "t", "c", "c"),
+                new CV(EXPRESSION_TYPE_VALUE_CONSTANT, VALUE_TYPE_BIGINT, 8, value));
+}
+
+/*
+ * Show that evaluating a predicate on a batch of tuples selects the same
+ * tuples as evaluating it on one tuple at a time, with and without kernels.
+ */
+TEST_F(ExpressionTest, EvalBatch) {
+    vector<int32_t> columnSizes;
+    columnSizes.push_back(8);
+    columnSizes.push_back(4);
+    columnSizes.push_back(1);
+
+    vector<bool> allowNull(3, true);
+
+    vector<voltdb::ValueType> types;
+    types.push_back(voltdb::VALUE_TYPE_BIGINT);
+    types.push_back(voltdb::VALUE_TYPE_INTEGER);
+    types.push_back(voltdb::VALUE_TYPE_TINYINT);
+
+    TupleSchema *schema = TupleSchema::createTupleSchemaForTest(types,columnSizes,allowNull);
+
+    const int tupleCount = 1000;
+    const int tupleLength = schema->tupleLength() + TUPLE_HEADER_SIZE;
+    boost::scoped_array<char> tupleStorage(new char[tupleCount * tupleLength]);
+    vector<TableTuple> tuples;
+    srand(static_cast<unsigned int>(time(NULL)));
+    for (int ii = 0; ii < tupleCount; ii++) {
+        TableTuple t(tupleStorage.get() + ii * tupleLength, schema);
+        t.setNValue(0, (rand() % 10 == 0) ? NValue::getNullValue(VALUE_TYPE_BIGINT) :
+                    ValueFactory::getBigIntValue(rand() % 100));
+        t.setNValue(1, (rand() % 10 == 0) ? NValue::getNullValue(VALUE_TYPE_INTEGER) :
+                    ValueFactory::getIntegerValue(rand() % 5));
+        t.setNValue(2, ValueFactory::getTinyIntValue(static_cast<int8_t>(rand() % 20)));
+        tuples.push_back(t);
+    }
+
+    vector<AbstractExpression*> predicates;
+    // c0 > 50
+    predicates.push_back(convertToExpression(
+        columnCompare(EXPRESSION_TYPE_COMPARE_GREATERTHAN, VALUE_TYPE_BIGINT, 0, 50)));
+    // c1 = 3 AND c0 <= 70
+    predicates.push_back(convertToExpression(
+        join(new AE(EXPRESSION_TYPE_CONJUNCTION_AND, VALUE_TYPE_BOOLEAN, 1),
+             columnCompare(EXPRESSION_TYPE_COMPARE_EQUAL, VALUE_TYPE_INTEGER, 1, 3),
+             columnCompare(EXPRESSION_TYPE_COMPARE_LESSTHANOREQUALTO, VALUE_TYPE_BIGINT, 0, 70))));
+    // c2 < 10 OR c0 >= 90
+    predicates.push_back(convertToExpression(
+        join(new AE(EXPRESSION_TYPE_CONJUNCTION_OR, VALUE_TYPE_BOOLEAN, 1),
+             columnCompare(EXPRESSION_TYPE_COMPARE_LESSTHAN, VALUE_TYPE_TINYINT, 2, 10),
+             columnCompare(EXPRESSION_TYPE_COMPARE_GREATERTHANOREQUALTO, VALUE_TYPE_BIGINT, 0, 90))));
+    // c0 + 1 <> 20, which has no kernel
+    predicates.push_back(convertToExpression(
+        join(new AE(EXPRESSION_TYPE_COMPARE_NOTEQUAL, VALUE_TYPE_BOOLEAN, 1),
+             join(new AE(EXPRESSION_TYPE_OPERATOR_PLUS, VALUE_TYPE_BIGINT, 8),
+                  new TV(EXPRESSION_TYPE_VALUE_TUPLE, VALUE_TYPE_BIGINT, 8, 0, "t", "c", "c"),
+                  new CV(EXPRESSION_TYPE_VALUE_CONSTANT, VALUE_TYPE_BIGINT, 8, (int64_t)1)),
+             new CV(EXPRESSION_TYPE_VALUE_CONSTANT, VALUE_TYPE_BIGINT, 8, (int64_t)20))));
+
+    for (int pp = 0; pp < predicates.size(); pp++) {
+        // start from every other tuple to show the selection is honored
+        vector<int> selection;
+        for (int ii = 0; ii < tupleCount; ii += 2) {
+            selection.push_back(ii);
+        }
+        int count = predicates[pp]->evalBatch(&tuples[0], &selection[0], static_cast<int>(selection.size()));
+        int expected = 0;
+        for (int ii = 0; ii < tupleCount; ii += 2) {
+            if (predicates[pp]->eval(&tuples[ii], NULL).isTrue()) {
+                ASSERT_TRUE(expected < count);
+                EXPECT_EQ(ii, selection[expected]);
+                ++expected;
+            }
+        }
+        EXPECT_EQ(expected, count);
+        delete predicates[pp];
+    }
+    TupleSchema::freeTupleSchema(schema);
+}
+
+/*
+ * Show that a predicate specialized for a schema agrees with the generic
+ * tree it came from, one tuple at a time and in batches.
+ */
+TEST_F(ExpressionTest, FusedPredicate) {
+    vector<int32_t> columnSizes;
+    columnSizes.push_back(8);
+    columnSizes.push_back(4);
+    columnSizes.push_back(8);
+
+    vector<bool> allowNull(3, true);
+
+    vector<voltdb::ValueType> types;
+    types.push_back(voltdb::VALUE_TYPE_BIGINT);
+    types.push_back(voltdb::VALUE_TYPE_INTEGER);
+    types.push_back(voltdb::VALUE_TYPE_VARCHAR);
+
+    TupleSchema *schema = TupleSchema::createTupleSchemaForTest(types,columnSizes,allowNull);
+
+    const int tupleCount = 500;
+    const int tupleLength = schema->tupleLength() + TUPLE_HEADER_SIZE;
+    boost::scoped_array<char> tupleStorage(new char[tupleCount * tupleLength]);
+    vector<TableTuple> tuples;
+    for (int ii = 0; ii < tupleCount; ii++) {
+        TableTuple t(tupleStorage.get() + ii * tupleLength, schema);
+        t.setNValue(0, (ii % 7 == 0) ? NValue::getNullValue(VALUE_TYPE_BIGINT) :
+                    ValueFactory::getBigIntValue(ii % 100));
+        t.setNValue(1, (ii % 11 == 0) ? NValue::getNullValue(VALUE_TYPE_INTEGER) :
+                    ValueFactory::getIntegerValue(ii % 5));
+        t.setNValue(2, NValue::getNullValue(VALUE_TYPE_VARCHAR));
+        tuples.push_back(t);
+    }
+
+    // 20 < c0 AND c1 <> 2 AND c0 <= 80
+    auto_ptr<AbstractExpression> generic(convertToExpression(
+        join(new AE(EXPRESSION_TYPE_CONJUNCTION_AND, VALUE_TYPE_BOOLEAN, 1),
+             join(new AE(EXPRESSION_TYPE_CONJUNCTION_AND, VALUE_TYPE_BOOLEAN, 1),
+                  join(new AE(EXPRESSION_TYPE_COMPARE_LESSTHAN, VALUE_TYPE_BOOLEAN, 1),
+                       new CV(EXPRESSION_TYPE_VALUE_CONSTANT, VALUE_TYPE_BIGINT, 8, (int64_t)20),
+                       new TV(EXPRESSION_TYPE_VALUE_TUPLE, VALUE_TYPE_BIGINT, 8, 0, "t", "c", "c")),
+                  columnCompare(EXPRESSION_TYPE_COMPARE_NOTEQUAL, VALUE_TYPE_INTEGER, 1, 2)),
+             columnCompare(EXPRESSION_TYPE_COMPARE_LESSTHANOREQUALTO, VALUE_TYPE_BIGINT, 0, 80))));
+    auto_ptr<FusedPredicateExpression> fused(FusedPredicateExpression::specialize(generic.get(), schema));
+    ASSERT_TRUE(fused.get() != NULL);
+
+    vector<int> selection;
+    for (int ii = 0; ii < tupleCount; ii++) {
+        NValue expected = generic->eval(&tuples[ii], NULL);
+        NValue actual = fused->eval(&tuples[ii], NULL);
+        EXPECT_EQ(expected.isTrue(), actual.isTrue());
+        EXPECT_EQ(expected.isNull(), actual.isNull());
+        selection.push_back(ii);
+    }
+    int count = fused->evalBatch(&tuples[0], &selection[0], tupleCount);
+    int expected = 0;
+    for (int ii = 0; ii < tupleCount; ii++) {
+        if (generic->eval(&tuples[ii], NULL).isTrue()) {
+            ASSERT_TRUE(expected < count);
+            EXPECT_EQ(ii, selection[expected]);
+            ++expected;
+        }
+    }
+    EXPECT_EQ(expected, count);
+
+    // A varchar column has no specialized comparison.
+    auto_ptr<AbstractExpression> varchar(convertToExpression(
+        columnCompare(EXPRESSION_TYPE_COMPARE_EQUAL, VALUE_TYPE_VARCHAR, 2, 1)));
+    EXPECT_TRUE(FusedPredicateExpression::specialize(varchar.get(), schema) == NULL);
+
+    TupleSchema::freeTupleSchema(schema);
+}
+
 int main() {
      return TestSuite::globalInstance()->runAll();
 }
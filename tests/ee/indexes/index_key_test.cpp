@@ -21,6 +21,11 @@
  * OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+#include <boost/scoped_array.hpp>
 #include "harness.h"
 #include "indexes/indexkey.h"
 #include "common/NValue.hpp"
@@ -443,6 +448,169 @@ TEST_F(IndexKeyTest, Int64Packing2Int32sWithSecondNull) {
     voltdb::TupleSchema::freeTupleSchema(keySchema);
 }
 
+TEST_F(IndexKeyTest, NormalizedKeyDecimal) {
+    std::vector<voltdb::ValueType> columnTypes;
+    std::vector<int32_t> columnLengths;
+    std::vector<bool> columnAllowNull(2, true);
+    columnTypes.push_back(voltdb::VALUE_TYPE_DECIMAL);
+    columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_DECIMAL));
+    columnTypes.push_back(voltdb::VALUE_TYPE_BIGINT);
+    columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_BIGINT));
+    voltdb::TupleSchema *keySchema = voltdb::TupleSchema::createTupleSchemaForTest(columnTypes, columnLengths, columnAllowNull);
+
+    const char *texts[] = { "0", "-0.000000000001", "0.000000000001", "1", "-1", "1.5", "-1.5",
+                            "99999999999999999999999999.999999999999",
+                            "-99999999999999999999999999.999999999999",
+                            "123456789012345678.5", "-123456789012345678.5" };
+    std::vector<NValue> values;
+    values.push_back(NValue::getNullValue(VALUE_TYPE_DECIMAL));
+    for (size_t ii = 0; ii < sizeof(texts) / sizeof(texts[0]); ++ii) {
+        values.push_back(ValueFactory::getDecimalValueFromString(texts[ii]));
+    }
+    ASSERT_TRUE(normalizedKeySize(keySchema) <= 32);
+
+    NormalizedKey<32>::KeyComparator normalizedComparator(keySchema);
+    GenericKey<32>::KeyComparator genericComparator(keySchema);
+    std::vector<char*> storage;
+    std::vector<NormalizedKey<32> > normalizedKeys;
+    std::vector<GenericKey<32> > genericKeys;
+    for (size_t ii = 0; ii < values.size(); ++ii) {
+        TableTuple tuple(keySchema);
+        storage.push_back(new char[tuple.tupleLength()]);
+        tuple.move(storage.back());
+        tuple.setNValue(0, values[ii]);
+        tuple.setNValue(1, ValueFactory::getBigIntValue(static_cast<int64_t>(ii % 3)));
+        normalizedKeys.push_back(NormalizedKey<32>(&tuple));
+        genericKeys.push_back(GenericKey<32>(&tuple));
+    }
+
+    // The normalized keys order exactly as the key tuples do.
+    for (size_t ii = 0; ii < genericKeys.size(); ++ii) {
+        for (size_t jj = 0; jj < genericKeys.size(); ++jj) {
+            EXPECT_EQ(genericComparator(genericKeys[ii], genericKeys[jj]),
+                      normalizedComparator(normalizedKeys[ii], normalizedKeys[jj]));
+        }
+    }
+
+    for (size_t ii = 0; ii < storage.size(); ++ii) {
+        delete [] storage[ii];
+    }
+    voltdb::TupleSchema::freeTupleSchema(keySchema);
+}
+
+TEST_F(IndexKeyTest, NormalizedKeyMixedColumns) {
+    std::vector<voltdb::ValueType> columnTypes;
+    std::vector<int32_t> columnLengths;
+    std::vector<bool> columnAllowNull(5, true);
+    std::vector<bool> columnInBytes(5, true);
+    columnTypes.push_back(voltdb::VALUE_TYPE_SMALLINT);
+    columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_SMALLINT));
+    columnTypes.push_back(voltdb::VALUE_TYPE_VARCHAR);
+    columnLengths.push_back(6);
+    columnTypes.push_back(voltdb::VALUE_TYPE_DOUBLE);
+    columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_DOUBLE));
+    columnTypes.push_back(voltdb::VALUE_TYPE_VARBINARY);
+    columnLengths.push_back(3);
+    columnTypes.push_back(voltdb::VALUE_TYPE_DECIMAL);
+    columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_DECIMAL));
+    voltdb::TupleSchema *keySchema = voltdb::TupleSchema::createTupleSchema(columnTypes, columnLengths,
+                                                                           columnAllowNull, columnInBytes);
+    ASSERT_TRUE(normalizedKeySize(keySchema) <= 64);
+
+    NormalizedKey<64>::KeyComparator normalizedComparator(keySchema);
+    GenericKey<64>::KeyComparator genericComparator(keySchema);
+
+    // Few enough values per column that many keys share leading columns.
+    const char alphabet[] = { 'a', '\0', '\xff' };
+    const double doubles[] = { 0.0, -0.0, 1.5, -1.5, std::numeric_limits<double>::quiet_NaN(),
+                               std::numeric_limits<double>::max(), -std::numeric_limits<double>::max() };
+    const char *decimals[] = { "0", "-1.5", "2" };
+    std::vector<char*> storage;
+    std::vector<NValue> strings;
+    std::vector<NormalizedKey<64> > normalizedKeys;
+    std::vector<GenericKey<64> > genericKeys;
+    srand(11);
+    for (int ii = 0; ii < 400; ++ii) {
+        TableTuple tuple(keySchema);
+        storage.push_back(new char[tuple.tupleLength()]);
+        tuple.move(storage.back());
+        tuple.setNValue(0, rand() % 5 == 0 ? NValue::getNullValue(VALUE_TYPE_SMALLINT) :
+                        ValueFactory::getSmallIntValue(static_cast<int16_t>(rand() % 3 - 1)));
+        std::string text;
+        const int textLength = rand() % 4;
+        for (int jj = 0; jj < textLength; ++jj) {
+            text += alphabet[rand() % sizeof(alphabet)];
+        }
+        strings.push_back(rand() % 7 == 0 ? NValue::getNullValue(VALUE_TYPE_VARCHAR) :
+                          ValueFactory::getStringValue(text));
+        tuple.setNValue(1, strings.back());
+        tuple.setNValue(2, rand() % 9 == 0 ? NValue::getNullValue(VALUE_TYPE_DOUBLE) :
+                        ValueFactory::getDoubleValue(doubles[rand() % (sizeof(doubles) / sizeof(doubles[0]))]));
+        const unsigned char bytes[] = { static_cast<unsigned char>(rand() % 2), 0, 1 };
+        strings.push_back(rand() % 7 == 0 ? NValue::getNullValue(VALUE_TYPE_VARBINARY) :
+                          ValueFactory::getBinaryValue(bytes, rand() % 4));
+        tuple.setNValue(3, strings.back());
+        tuple.setNValue(4, rand() % 5 == 0 ? NValue::getNullValue(VALUE_TYPE_DECIMAL) :
+                        ValueFactory::getDecimalValueFromString(decimals[rand() % 3]));
+        normalizedKeys.push_back(NormalizedKey<64>(&tuple));
+        genericKeys.push_back(GenericKey<64>(&tuple));
+    }
+
+    // The normalized keys order exactly as the key tuples do.
+    for (size_t ii = 0; ii < genericKeys.size(); ++ii) {
+        for (size_t jj = 0; jj < genericKeys.size(); ++jj) {
+            EXPECT_EQ(genericComparator(genericKeys[ii], genericKeys[jj]),
+                      normalizedComparator(normalizedKeys[ii], normalizedKeys[jj]));
+        }
+    }
+
+    for (size_t ii = 0; ii < storage.size(); ++ii) {
+        delete [] storage[ii];
+    }
+    for (size_t ii = 0; ii < strings.size(); ++ii) {
+        strings[ii].free();
+    }
+    voltdb::TupleSchema::freeTupleSchema(keySchema);
+}
+
+TEST_F(IndexKeyTest, NormalizedKeyTooLong) {
+    std::vector<voltdb::ValueType> columnTypes;
+    std::vector<int32_t> columnLengths;
+    std::vector<bool> columnAllowNull(2, true);
+    std::vector<bool> columnInBytes(2, true);
+    columnTypes.push_back(voltdb::VALUE_TYPE_VARCHAR);
+    columnLengths.push_back(100);
+    columnTypes.push_back(voltdb::VALUE_TYPE_INTEGER);
+    columnLengths.push_back(NValue::getTupleStorageSize(voltdb::VALUE_TYPE_INTEGER));
+    voltdb::TupleSchema *keySchema = voltdb::TupleSchema::createTupleSchema(columnTypes, columnLengths,
+                                                                           columnAllowNull, columnInBytes);
+    TableTuple tuple(keySchema);
+    boost::scoped_array<char> storage(new char[tuple.tupleLength()]);
+    tuple.move(storage.get());
+    tuple.setNValue(1, ValueFactory::getIntegerValue(7));
+
+    // A string and the integer after it just fit in 32 bytes ...
+    NValue fits = ValueFactory::getStringValue(std::string(32 - 1 - 1 - 4 - 4, 'a'));
+    tuple.setNValue(0, fits);
+    NormalizedKey<32> key(&tuple);
+    ASSERT_EQ('a', key.data[1]);
+
+    // ... but a longer one is refused rather than written past the key.
+    NValue tooLong = ValueFactory::getStringValue(std::string(32 - 1 - 1 - 4 - 4 + 1, 'a'));
+    tuple.setNValue(0, tooLong);
+    bool thrown = false;
+    try {
+        NormalizedKey<32> overflowed(&tuple);
+    } catch (const SQLException &e) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+
+    fits.free();
+    tooLong.free();
+    voltdb::TupleSchema::freeTupleSchema(keySchema);
+}
+
 int main() {
     return TestSuite::globalInstance()->runAll();
 }
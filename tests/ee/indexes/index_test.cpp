@@ -49,6 +49,7 @@
  * OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <boost/foreach.hpp>
 #include <boost/scoped_ptr.hpp>
 
@@ -56,6 +57,7 @@
 #include "common/common.h"
 #include "common/NValue.hpp"
 #include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
 #include "common/debuglog.h"
 #include "common/SerializableEEException.h"
 #include "common/tabletuple.h"
@@ -1117,6 +1119,436 @@ TEST_F(IndexTest, ReentrantHashMultiple) {
 }
 
 
+TEST_F(IndexTest, StringKeyedHash) {
+    // An id, a short string stored in the tuple and a long string stored out of line.
+    vector<ValueType> columnTypes;
+    vector<int32_t> columnLengths;
+    columnTypes.push_back(VALUE_TYPE_BIGINT);
+    columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+    columnTypes.push_back(VALUE_TYPE_VARCHAR);
+    columnLengths.push_back(8);
+    columnTypes.push_back(VALUE_TYPE_VARCHAR);
+    columnLengths.push_back(300);
+    vector<bool> columnAllowNull(3, true);
+    vector<string> columnNames;
+    columnNames.push_back("ID");
+    columnNames.push_back("SHORT_NAME");
+    columnNames.push_back("LONG_NAME");
+    TupleSchema* schema =
+        TupleSchema::createTupleSchemaForTest(columnTypes, columnLengths, columnAllowNull);
+
+    m_engine = new VoltDBEngine();
+    m_exceptionBuffer = new char[4096];
+    m_engine->setBuffers(NULL, 0, NULL, 0, m_exceptionBuffer, 4096);
+    int partitionCount = 1;
+    m_engine->initialize(0, 0, 0, 0, "", DEFAULT_TEMP_TABLE_MEMORY);
+    m_engine->updateHashinator(HASHINATOR_LEGACY, (char*)&partitionCount, NULL, 0);
+    table = dynamic_cast<PersistentTable*>(
+        TableFactory::getPersistentTable(1000, "string_table", schema, columnNames,
+                                         signature, &drStream, false));
+
+    vector<int> uniqueColumns(1, 2);
+    TableIndexScheme uniqueScheme("ixh_long", HASH_TABLE_INDEX,
+                                  uniqueColumns, TableIndex::simplyIndexColumns(),
+                                  true, false, schema);
+    TableIndex* uniqueIndex = TableIndexFactory::getInstance(uniqueScheme);
+    EXPECT_EQ("CompactingHashUniqueIndex", uniqueIndex->getTypeName());
+    table->addIndex(uniqueIndex);
+
+    vector<int> multiColumns;
+    multiColumns.push_back(1);
+    multiColumns.push_back(0);
+    TableIndexScheme multiScheme("ixh_short", HASH_TABLE_INDEX,
+                                 multiColumns, TableIndex::simplyIndexColumns(),
+                                 false, false, schema);
+    TableIndex* multiIndex = TableIndexFactory::getInstance(multiScheme);
+    EXPECT_EQ("CompactingHashMultiMapIndex", multiIndex->getTypeName());
+    table->addIndex(multiIndex);
+
+    const int rows = 1000;
+    char buffer[64];
+    for (int ii = 0; ii < rows; ++ii) {
+        TableTuple &tuple = table->tempTuple();
+        NValue shortName = ValueFactory::getStringValue(ii % 7 == 0 ? "seven" : "other");
+        snprintf(buffer, sizeof(buffer), "session-token-%08d", ii);
+        NValue longName = ValueFactory::getStringValue(buffer);
+        tuple.setNValue(0, ValueFactory::getBigIntValue(ii));
+        tuple.setNValue(1, shortName);
+        tuple.setNValue(2, longName);
+        EXPECT_TRUE(table->insertTuple(tuple));
+        shortName.free();
+        longName.free();
+    }
+    // A NULL key is distinct from every string, including the empty one.
+    TableTuple &nullTuple = table->tempTuple();
+    nullTuple.setNValue(0, ValueFactory::getBigIntValue(rows));
+    nullTuple.setNValue(1, ValueFactory::getNullStringValue());
+    nullTuple.setNValue(2, ValueFactory::getNullStringValue());
+    EXPECT_TRUE(table->insertTuple(nullTuple));
+    EXPECT_EQ(rows + 1, uniqueIndex->getSize());
+
+    TupleSchema* keySchema = TupleSchema::createTupleSchema(uniqueIndex->getKeySchema());
+    TableTuple searchkey(keySchema);
+    searchkey.move(new char[searchkey.tupleLength()]);
+    IndexCursor cursor(uniqueIndex->getTupleSchema());
+    for (int ii = 0; ii < rows; ii += 37) {
+        snprintf(buffer, sizeof(buffer), "session-token-%08d", ii);
+        NValue longName = ValueFactory::getStringValue(buffer);
+        searchkey.setNValue(0, longName);
+        EXPECT_TRUE(uniqueIndex->moveToKey(&searchkey, cursor));
+        TableTuple found = uniqueIndex->nextValueAtKey(cursor);
+        EXPECT_FALSE(found.isNullTuple());
+        EXPECT_EQ(ii, ValuePeeker::peekAsBigInt(found.getNValue(0)));
+        longName.free();
+    }
+    NValue missing = ValueFactory::getStringValue("session-token-");
+    searchkey.setNValue(0, missing);
+    EXPECT_FALSE(uniqueIndex->hasKey(&searchkey));
+    missing.free();
+    NValue empty = ValueFactory::getStringValue("");
+    searchkey.setNValue(0, empty);
+    EXPECT_FALSE(uniqueIndex->hasKey(&searchkey));
+    empty.free();
+    searchkey.setNValue(0, ValueFactory::getNullStringValue());
+    EXPECT_TRUE(uniqueIndex->hasKey(&searchkey));
+    TupleSchema::freeTupleSchema(keySchema);
+    delete[] searchkey.address();
+
+    keySchema = TupleSchema::createTupleSchema(multiIndex->getKeySchema());
+    TableTuple multiKey(keySchema);
+    multiKey.move(new char[multiKey.tupleLength()]);
+    NValue seven = ValueFactory::getStringValue("seven");
+    multiKey.setNValue(0, seven);
+    multiKey.setNValue(1, ValueFactory::getBigIntValue(700));
+    EXPECT_TRUE(multiIndex->hasKey(&multiKey));
+    multiKey.setNValue(1, ValueFactory::getBigIntValue(701));
+    EXPECT_FALSE(multiIndex->hasKey(&multiKey));
+    seven.free();
+    TupleSchema::freeTupleSchema(keySchema);
+    delete[] multiKey.address();
+
+    // Removing entries removes exactly the matching keys.
+    TableIterator iterator = table->iterator();
+    TableTuple tuple(table->schema());
+    int deleted = 0;
+    while (iterator.next(tuple)) {
+        if (ValuePeeker::peekAsBigInt(tuple.getNValue(0)) % 2 == 0) {
+            EXPECT_TRUE(uniqueIndex->deleteEntry(&tuple));
+            EXPECT_TRUE(multiIndex->deleteEntry(&tuple));
+            EXPECT_FALSE(uniqueIndex->exists(&tuple));
+            ++deleted;
+        }
+    }
+    EXPECT_EQ(rows + 1 - deleted, uniqueIndex->getSize());
+    EXPECT_EQ(rows + 1 - deleted, multiIndex->getSize());
+    iterator = table->iterator();
+    while (iterator.next(tuple)) {
+        const bool kept = ValuePeeker::peekAsBigInt(tuple.getNValue(0)) % 2 != 0;
+        EXPECT_EQ(kept, uniqueIndex->exists(&tuple));
+        EXPECT_EQ(kept, multiIndex->exists(&tuple));
+    }
+}
+
+TEST_F(IndexTest, OpenHashUnique) {
+    vector<int> ixm_column_indices;
+    vector<ValueType> ixm_column_types;
+    ixm_column_indices.push_back(4);
+    ixm_column_indices.push_back(2);
+    ixm_column_types.push_back(VALUE_TYPE_BIGINT);
+    ixm_column_types.push_back(VALUE_TYPE_BIGINT);
+    init("ixo1",
+         OPEN_HASH_TABLE_INDEX,
+         ixm_column_indices,
+         ixm_column_types,
+         true);
+
+    TableIndex* index = table->index("ixo1");
+    EXPECT_EQ(true, index != NULL);
+    EXPECT_EQ("OpenHashUniqueIndex", index->getTypeName());
+    EXPECT_EQ(NUM_OF_TUPLES, index->getSize());
+    IndexCursor indexCursor(index->getTupleSchema());
+
+    TableTuple tuple(table->schema());
+    vector<ValueType> keyColumnTypes(2, VALUE_TYPE_BIGINT);
+    vector<int32_t>keyColumnLengths(2, NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+    vector<bool> keyColumnAllowNull(2, true);
+    TupleSchema* keySchema =
+        TupleSchema::createTupleSchemaForTest(keyColumnTypes,
+                                       keyColumnLengths,
+                                       keyColumnAllowNull);
+    TableTuple searchkey(keySchema);
+    searchkey.move(new char[searchkey.tupleLength()]);
+
+    searchkey.setNValue(0, ValueFactory::getBigIntValue(static_cast<int64_t>(550)));
+    searchkey.setNValue(1, ValueFactory::getBigIntValue(static_cast<int64_t>(2)));
+    EXPECT_TRUE(index->moveToKey(&searchkey, indexCursor));
+    tuple = index->nextValueAtKey(indexCursor);
+    EXPECT_FALSE(tuple.isNullTuple());
+    EXPECT_TRUE(ValueFactory::getBigIntValue(50).op_equals(tuple.getNValue(0)).isTrue());
+    EXPECT_TRUE(index->nextValueAtKey(indexCursor).isNullTuple());
+    EXPECT_TRUE(index->exists(&tuple));
+
+    searchkey.setNValue(1, ValueFactory::getBigIntValue(static_cast<int64_t>(1)));
+    EXPECT_FALSE(index->moveToKey(&searchkey, indexCursor));
+    EXPECT_FALSE(index->hasKey(&searchkey));
+
+    // Removing most of the entries shrinks the table without losing the rest.
+    TableIterator iterator = table->iterator();
+    int deleted = 0;
+    while (iterator.next(tuple)) {
+        if (ValuePeeker::peekAsBigInt(tuple.getNValue(0)) % 10 != 0) {
+            EXPECT_TRUE(index->deleteEntry(&tuple));
+            ++deleted;
+        }
+    }
+    EXPECT_EQ(NUM_OF_TUPLES - deleted, index->getSize());
+    iterator = table->iterator();
+    while (iterator.next(tuple)) {
+        EXPECT_EQ(ValuePeeker::peekAsBigInt(tuple.getNValue(0)) % 10 == 0, index->exists(&tuple));
+    }
+
+    TupleSchema::freeTupleSchema(keySchema);
+    delete[] searchkey.address();
+
+    // Indexes the open addressing table doesn't cover are plain hash indexes.
+    vector<int> columns(1, 0);
+    TableIndexScheme multiScheme("ixo_multi", OPEN_HASH_TABLE_INDEX,
+                                 columns, TableIndex::simplyIndexColumns(),
+                                 false, false, table->schema());
+    TableIndex* multiIndex = TableIndexFactory::getInstance(multiScheme);
+    EXPECT_EQ("CompactingHashMultiMapIndex", multiIndex->getTypeName());
+    delete multiIndex;
+
+    vector<int> wideColumns;
+    wideColumns.push_back(0);
+    wideColumns.push_back(1);
+    wideColumns.push_back(2);
+    TableIndexScheme wideScheme("ixo_wide", OPEN_HASH_TABLE_INDEX,
+                                wideColumns, TableIndex::simplyIndexColumns(),
+                                true, false, table->schema());
+    TableIndex* wideIndex = TableIndexFactory::getInstance(wideScheme);
+    EXPECT_EQ("CompactingHashUniqueIndex", wideIndex->getTypeName());
+    delete wideIndex;
+}
+
+TEST_F(IndexTest, BTree) {
+    vector<int> ixm_column_indices;
+    vector<ValueType> ixm_column_types;
+    ixm_column_indices.push_back(4);
+    ixm_column_indices.push_back(2);
+    ixm_column_types.push_back(VALUE_TYPE_BIGINT);
+    ixm_column_types.push_back(VALUE_TYPE_BIGINT);
+    init("ixt1",
+         BTREE_INDEX,
+         ixm_column_indices,
+         ixm_column_types,
+         true);
+
+    TableIndex* index = table->index("ixt1");
+    EXPECT_EQ(true, index != NULL);
+    EXPECT_EQ("BTreeUniqueIndex", index->getTypeName());
+    EXPECT_EQ(NUM_OF_TUPLES, index->getSize());
+    IndexCursor indexCursor(index->getTupleSchema());
+
+    TableTuple tuple(table->schema());
+    vector<ValueType> keyColumnTypes(2, VALUE_TYPE_BIGINT);
+    vector<int32_t>keyColumnLengths(2, NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+    vector<bool> keyColumnAllowNull(2, true);
+    TupleSchema* keySchema =
+        TupleSchema::createTupleSchemaForTest(keyColumnTypes,
+                                       keyColumnLengths,
+                                       keyColumnAllowNull);
+    TableTuple searchkey(keySchema);
+    searchkey.move(new char[searchkey.tupleLength()]);
+
+    searchkey.setNValue(0, ValueFactory::getBigIntValue(static_cast<int64_t>(550)));
+    searchkey.setNValue(1, ValueFactory::getBigIntValue(static_cast<int64_t>(2)));
+    EXPECT_TRUE(index->moveToKey(&searchkey, indexCursor));
+    tuple = index->nextValueAtKey(indexCursor);
+    EXPECT_FALSE(tuple.isNullTuple());
+    EXPECT_TRUE(ValueFactory::getBigIntValue(50).op_equals(tuple.getNValue(0)).isTrue());
+    EXPECT_TRUE(index->nextValueAtKey(indexCursor).isNullTuple());
+    // keys are i * 11, so 550 is the 50th
+    EXPECT_EQ(50, index->getCounterGET(&searchkey, false, indexCursor));
+    EXPECT_EQ(50, index->getCounterLET(&searchkey, false, indexCursor));
+
+    // a scan in key order from the middle
+    searchkey.setNValue(1, ValueFactory::getBigIntValue(static_cast<int64_t>(-10000000)));
+    index->moveToKeyOrGreater(&searchkey, indexCursor);
+    for (int64_t i = 50; i <= NUM_OF_TUPLES; i++) {
+        EXPECT_FALSE((tuple = index->nextValue(indexCursor)).isNullTuple());
+        EXPECT_TRUE(ValueFactory::getBigIntValue(i).op_equals(tuple.getNValue(0)).isTrue());
+    }
+    EXPECT_TRUE(index->nextValue(indexCursor).isNullTuple());
+
+    searchkey.setNValue(1, ValueFactory::getBigIntValue(static_cast<int64_t>(2)));
+    EXPECT_FALSE(index->moveToGreaterThanKey(&searchkey, indexCursor));
+    EXPECT_FALSE((tuple = index->nextValue(indexCursor)).isNullTuple());
+    EXPECT_TRUE(ValueFactory::getBigIntValue(51).op_equals(tuple.getNValue(0)).isTrue());
+
+    // Removing most of the entries keeps the rest in order.
+    TableIterator iterator = table->iterator();
+    int deleted = 0;
+    while (iterator.next(tuple)) {
+        if (ValuePeeker::peekAsBigInt(tuple.getNValue(0)) % 10 != 0) {
+            EXPECT_TRUE(index->deleteEntry(&tuple));
+            ++deleted;
+        }
+    }
+    EXPECT_EQ(NUM_OF_TUPLES - deleted, index->getSize());
+    index->moveToEnd(true, indexCursor);
+    for (int64_t i = 10; i <= NUM_OF_TUPLES; i += 10) {
+        EXPECT_FALSE((tuple = index->nextValue(indexCursor)).isNullTuple());
+        EXPECT_TRUE(ValueFactory::getBigIntValue(i).op_equals(tuple.getNValue(0)).isTrue());
+    }
+    EXPECT_TRUE(index->nextValue(indexCursor).isNullTuple());
+
+    TupleSchema::freeTupleSchema(keySchema);
+    delete[] searchkey.address();
+
+    vector<int> columns(1, 1);
+    TableIndexScheme multiScheme("ixt_multi", BTREE_INDEX,
+                                 columns, TableIndex::simplyIndexColumns(),
+                                 false, true, table->schema());
+    TableIndex* multiIndex = TableIndexFactory::getInstance(multiScheme);
+    EXPECT_EQ("BTreeMultiMapIndex", multiIndex->getTypeName());
+    iterator = table->iterator();
+    while (iterator.next(tuple)) {
+        EXPECT_TRUE(multiIndex->addEntry(&tuple));
+    }
+    EXPECT_EQ(NUM_OF_TUPLES, multiIndex->getSize());
+    TableTuple oddKey(multiIndex->getKeySchema());
+    oddKey.move(new char[oddKey.tupleLength()]);
+    oddKey.setNValue(0, ValueFactory::getBigIntValue(static_cast<int64_t>(1)));
+    EXPECT_EQ(NUM_OF_TUPLES / 2 + 1, multiIndex->getCounterGET(&oddKey, false, indexCursor));
+    EXPECT_EQ(NUM_OF_TUPLES, multiIndex->getCounterGET(&oddKey, true, indexCursor));
+    delete[] oddKey.address();
+    delete multiIndex;
+}
+
+TEST_F(IndexTest, AddEntries) {
+    vector<int> ixm_column_indices;
+    vector<ValueType> ixm_column_types;
+    ixm_column_indices.push_back(0);
+    ixm_column_types.push_back(VALUE_TYPE_BIGINT);
+    init("ixa1",
+         BALANCED_TREE_INDEX,
+         ixm_column_indices,
+         ixm_column_types,
+         true);
+
+    TableTuple tuple(table->schema());
+    vector<TableTuple> tuples;
+    TableIterator iterator = table->iterator();
+    while (iterator.next(tuple)) {
+        tuples.push_back(tuple);
+    }
+    // in an order the indexes have to sort out
+    std::reverse(tuples.begin(), tuples.begin() + NUM_OF_TUPLES / 2);
+
+    const TableIndexType types[] = { BALANCED_TREE_INDEX, BTREE_INDEX, HASH_TABLE_INDEX, OPEN_HASH_TABLE_INDEX };
+    for (int t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        vector<int> uniqueColumns(1, 0);
+        TableIndexScheme uniqueScheme("ixa_unique", types[t],
+                                      uniqueColumns, TableIndex::simplyIndexColumns(),
+                                      true, true, table->schema());
+        TableIndex* uniqueIndex = TableIndexFactory::getInstance(uniqueScheme);
+        EXPECT_TRUE(uniqueIndex->addEntries(tuples));
+        EXPECT_EQ(NUM_OF_TUPLES, uniqueIndex->getSize());
+        for (size_t i = 0; i < tuples.size(); i++) {
+            EXPECT_TRUE(uniqueIndex->exists(&tuples[i]));
+        }
+        // adding them again fails and adds none
+        vector<TableTuple> again(tuples.begin() + 10, tuples.begin() + 20);
+        EXPECT_FALSE(uniqueIndex->addEntries(again));
+        EXPECT_EQ(NUM_OF_TUPLES, uniqueIndex->getSize());
+        delete uniqueIndex;
+
+        // i % 2 repeats, so a unique index can't take the tuples and is left empty
+        vector<int> repeatingColumns(1, 1);
+        TableIndexScheme repeatingScheme("ixa_repeating", types[t],
+                                         repeatingColumns, TableIndex::simplyIndexColumns(),
+                                         true, true, table->schema());
+        TableIndex* repeatingIndex = TableIndexFactory::getInstance(repeatingScheme);
+        EXPECT_FALSE(repeatingIndex->addEntries(tuples));
+        EXPECT_EQ(0, repeatingIndex->getSize());
+        delete repeatingIndex;
+
+        TableIndexScheme multiScheme("ixa_multi", types[t],
+                                     repeatingColumns, TableIndex::simplyIndexColumns(),
+                                     false, true, table->schema());
+        TableIndex* multiIndex = TableIndexFactory::getInstance(multiScheme);
+        EXPECT_TRUE(multiIndex->addEntries(tuples));
+        EXPECT_EQ(NUM_OF_TUPLES, multiIndex->getSize());
+        for (size_t i = 0; i < tuples.size(); i++) {
+            EXPECT_TRUE(multiIndex->exists(&tuples[i]));
+        }
+        for (size_t i = 0; i < tuples.size(); i += 2) {
+            EXPECT_TRUE(multiIndex->deleteEntry(&tuples[i]));
+        }
+        EXPECT_EQ(NUM_OF_TUPLES / 2, multiIndex->getSize());
+        delete multiIndex;
+    }
+}
+
+TEST_F(IndexTest, AddIndexes) {
+    vector<int> ixm_column_indices;
+    vector<ValueType> ixm_column_types;
+    ixm_column_indices.push_back(0);
+    ixm_column_types.push_back(VALUE_TYPE_BIGINT);
+    init("ixp1",
+         BALANCED_TREE_INDEX,
+         ixm_column_indices,
+         ixm_column_types,
+         true);
+    // enough tuples to build on helper threads
+    for (int64_t i = NUM_OF_TUPLES + 1; i <= 30000; ++i) {
+        TableTuple &tuple = table->tempTuple();
+        tuple.setNValue(0, ValueFactory::getBigIntValue(i));
+        tuple.setNValue(1, ValueFactory::getBigIntValue(i % 2));
+        tuple.setNValue(2, ValueFactory::getBigIntValue(i % 3));
+        tuple.setNValue(3, ValueFactory::getBigIntValue(i + 20));
+        tuple.setNValue(4, ValueFactory::getBigIntValue(i * 11));
+        EXPECT_TRUE(table->insertTuple(tuple));
+    }
+    const size_t indexCount = table->allIndexes().size();
+
+    const TableIndexType types[] = { BALANCED_TREE_INDEX, BTREE_INDEX, HASH_TABLE_INDEX, OPEN_HASH_TABLE_INDEX };
+    vector<TableIndex*> indexes;
+    vector<TableIndex*> serialIndexes;
+    for (int t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        // unique on i, unique on i % 2 (which takes only two), and not unique on i % 3
+        for (int c = 0; c < 3; c++) {
+            vector<int> columns(1, c);
+            TableIndexScheme scheme("ixp", types[t],
+                                    columns, TableIndex::simplyIndexColumns(),
+                                    c != 2, true, table->schema());
+            indexes.push_back(TableIndexFactory::getInstance(scheme));
+            serialIndexes.push_back(TableIndexFactory::getInstance(scheme));
+        }
+    }
+    table->addIndexes(indexes);
+    EXPECT_EQ(indexCount + indexes.size(), table->allIndexes().size());
+
+    // each index is as if it had been added alone
+    TableTuple tuple(table->schema());
+    for (size_t ii = 0; ii < indexes.size(); ii++) {
+        TableIterator iterator = table->iterator();
+        while (iterator.next(tuple)) {
+            serialIndexes[ii]->addEntry(&tuple);
+        }
+        EXPECT_EQ(serialIndexes[ii]->getSize(), indexes[ii]->getSize());
+        iterator = table->iterator();
+        while (iterator.next(tuple)) {
+            EXPECT_EQ(serialIndexes[ii]->exists(&tuple), indexes[ii]->exists(&tuple));
+        }
+        delete serialIndexes[ii];
+    }
+    EXPECT_EQ(30000, indexes[0]->getSize());
+    EXPECT_EQ(30000, indexes[2]->getSize());
+    EXPECT_EQ(2, indexes[1]->getSize());
+}
+
 int main()
 {
     return TestSuite::globalInstance()->runAll();
@@ -0,0 +1,351 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <stdint.h>
+#include <arpa/inet.h>
+#include <boost/scoped_array.hpp>
+
+#include "harness.h"
+#include "common/BlockCodec.h"
+#include "common/DefaultTupleSerializer.h"
+#include "common/TupleOutputStream.h"
+#include "common/TupleOutputStreamProcessor.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "execution/VoltDBEngine.h"
+#include "indexes/tableindex.h"
+#include "indexes/tableindexfactory.h"
+#include "storage/ColdBlockCompressor.h"
+#include "storage/persistenttable.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+#include "storage/DRTupleStream.h"
+
+using namespace std;
+using namespace voltdb;
+
+// enough rows for a few 2MB blocks
+#define NUM_OF_TUPLES 150000
+#define COLD_TICKS 3
+
+class ColdBlockCompressorTest : public Test {
+public:
+    ColdBlockCompressorTest() {
+        m_engine = new VoltDBEngine();
+        int partitionCount = 1;
+        m_engine->initialize(1,1, 0, 0, "", DEFAULT_TEMP_TABLE_MEMORY);
+        m_engine->updateHashinator(HASHINATOR_LEGACY, (char*)&partitionCount, NULL, 0);
+
+        vector<string> columnNames;
+        columnNames.push_back("id");
+        columnNames.push_back("grp");
+        columnNames.push_back("name");
+        vector<ValueType> columnTypes;
+        columnTypes.push_back(VALUE_TYPE_BIGINT);
+        columnTypes.push_back(VALUE_TYPE_INTEGER);
+        columnTypes.push_back(VALUE_TYPE_VARCHAR);
+        vector<int32_t> columnLengths;
+        columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+        columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_INTEGER));
+        columnLengths.push_back(12);
+        vector<bool> columnAllowNull(3, true);
+        m_tableSchema = TupleSchema::createTupleSchemaForTest(columnTypes, columnLengths, columnAllowNull);
+        m_table = dynamic_cast<PersistentTable*>(
+            TableFactory::getPersistentTable(0, "Foo", m_tableSchema, columnNames, signature, &drStream, false, 0));
+
+        vector<int> keyColumns(1, 0);
+        TableIndexScheme scheme("primaryKeyIndex", BALANCED_TREE_INDEX, keyColumns,
+                                TableIndex::simplyIndexColumns(), true, true, m_tableSchema);
+        TableIndex *pkeyIndex = TableIndexFactory::getInstance(scheme);
+        m_table->addIndex(pkeyIndex);
+        m_table->setPrimaryKeyIndex(pkeyIndex);
+
+        m_engine->setUndoToken(INT64_MIN + 1);
+        m_nextUndoToken = INT64_MIN + 2;
+        m_statsBefore = ColdBlockCompressor::getStats();
+    }
+
+    ~ColdBlockCompressorTest() {
+        delete m_engine;
+        delete m_table;
+    }
+
+    static string nameOf(int64_t id) {
+        static const char *names[] = { "red", "green", "blue", "cyan" };
+        return names[id % 4];
+    }
+
+    void beginUndo() {
+        m_engine->setUndoToken(m_nextUndoToken);
+        m_engine->updateExecutorContextUndoQuantumForTest();
+    }
+
+    void releaseUndo() {
+        m_engine->releaseUndoToken(m_nextUndoToken++);
+    }
+
+    void insertTuples(int64_t first, int64_t count) {
+        beginUndo();
+        TableTuple &tuple = m_table->tempTuple();
+        for (int64_t id = first; id < first + count; id++) {
+            tuple.setNValue(0, ValueFactory::getBigIntValue(id));
+            tuple.setNValue(1, ValueFactory::getIntegerValue(static_cast<int32_t>(id % 10)));
+            NValue name = ValueFactory::getStringValue(nameOf(id));
+            tuple.setNValue(2, name);
+            m_table->insertTuple(tuple);
+            name.free();
+        }
+        releaseUndo();
+    }
+
+    void tick(int ticks) {
+        for (int ii = 0; ii < ticks; ii++) {
+            m_table->compressColdBlocks(COLD_TICKS);
+        }
+    }
+
+    /** Counters since the test started */
+    ColdBlockCompressor::Stats stats() {
+        ColdBlockCompressor::Stats now = ColdBlockCompressor::getStats();
+        now.compressions -= m_statsBefore.compressions;
+        now.decompressions -= m_statsBefore.decompressions;
+        now.rejections -= m_statsBefore.rejections;
+        now.residentHits -= m_statsBefore.residentHits;
+        return now;
+    }
+
+    TableTuple lookup(int64_t id) {
+        TableIndex *index = m_table->primaryKeyIndex();
+        TableTuple key(index->getKeySchema());
+        boost::scoped_array<char> backingStore(new char[index->getKeySchema()->tupleLength()]);
+        key.moveNoHeader(backingStore.get());
+        key.setNValue(0, ValueFactory::getBigIntValue(id));
+        IndexCursor cursor(index->getTupleSchema());
+        if (!index->moveToKey(&key, cursor)) {
+            return TableTuple();
+        }
+        return index->nextValueAtKey(cursor);
+    }
+
+    void verifyRow(const TableTuple &tuple, int64_t id) {
+        ASSERT_FALSE(tuple.isNullTuple());
+        EXPECT_EQ(id, ValuePeeker::peekAsBigInt(tuple.getNValue(0)));
+        EXPECT_EQ(id % 10, ValuePeeker::peekAsInteger(tuple.getNValue(1)));
+        EXPECT_EQ(nameOf(id), ValuePeeker::peekStringCopy_withoutNull(tuple.getNValue(2)));
+    }
+
+    /** Scan the table, checking every row, and return how many there are */
+    int64_t verifyRows() {
+        TableTuple tuple(m_tableSchema);
+        TableIterator iterator = m_table->iterator();
+        int64_t count = 0;
+        while (iterator.next(tuple)) {
+            verifyRow(tuple, ValuePeeker::peekAsBigInt(tuple.getNValue(0)));
+            ++count;
+        }
+        return count;
+    }
+
+    VoltDBEngine *m_engine;
+    TupleSchema *m_tableSchema;
+    PersistentTable *m_table;
+    MockDRTupleStream drStream;
+    int64_t m_nextUndoToken;
+    ColdBlockCompressor::Stats m_statsBefore;
+    char signature[20];
+};
+
+TEST_F(ColdBlockCompressorTest, CodecRoundTrip) {
+    vector<char> source(100000);
+    for (size_t ii = 0; ii < source.size(); ii++) {
+        // runs of repeats, then noise
+        source[ii] = static_cast<char>(ii < 60000 ? (ii / 7) % 13 : rand());
+    }
+    vector<char> compressed(BlockCodec::compressBound(source.size()));
+    size_t compressedSize = BlockCodec::compress(&source[0], source.size(), &compressed[0], compressed.size());
+    ASSERT_TRUE(compressedSize > 0);
+    EXPECT_TRUE(compressedSize < source.size());
+
+    vector<char> target(source.size());
+    ASSERT_TRUE(BlockCodec::decompress(&compressed[0], compressedSize, &target[0], target.size()));
+    EXPECT_TRUE(source == target);
+
+    // Cut short, or expected to be longer, it is refused.
+    EXPECT_FALSE(BlockCodec::decompress(&compressed[0], compressedSize / 2, &target[0], target.size()));
+    target.push_back(0);
+    EXPECT_FALSE(BlockCodec::decompress(&compressed[0], compressedSize, &target[0], target.size()));
+
+    // Too little room to compress into is reported, not overrun.
+    EXPECT_EQ(0, BlockCodec::compress(&source[0], source.size(), &compressed[0], 100));
+
+    // Inputs too short to hold a match are all literals.
+    const char tiny[] = "abcabcab";
+    compressedSize = BlockCodec::compress(tiny, sizeof(tiny), &compressed[0], compressed.size());
+    ASSERT_TRUE(compressedSize > 0);
+    ASSERT_TRUE(BlockCodec::decompress(&compressed[0], compressedSize, &target[0], sizeof(tiny)));
+    EXPECT_EQ(0, ::memcmp(tiny, &target[0], sizeof(tiny)));
+}
+
+TEST_F(ColdBlockCompressorTest, ScanBringsBlocksBack) {
+    insertTuples(0, NUM_OF_TUPLES);
+    const int64_t blockCount = static_cast<int64_t>(m_table->allocatedBlockCount());
+    ASSERT_TRUE(blockCount > 1);
+
+    // Not yet cold.
+    tick(COLD_TICKS - 1);
+    EXPECT_EQ(0, stats().compressions);
+    tick(1);
+    ColdBlockCompressor::Stats compressed = stats();
+    EXPECT_EQ(blockCount, compressed.compressions);
+    EXPECT_EQ(blockCount, compressed.compressedBlocks);
+    EXPECT_TRUE(compressed.compressedBytes * 2 < compressed.uncompressedBytes);
+    EXPECT_EQ(NUM_OF_TUPLES * m_table->getTupleLength(), compressed.uncompressedBytes);
+    // As the table stats report them
+    int32_t tableCompressedBlocks;
+    int64_t tableCompressedBytes;
+    m_table->compressedMemory(tableCompressedBlocks, tableCompressedBytes);
+    EXPECT_EQ(blockCount, tableCompressedBlocks);
+    EXPECT_EQ(compressed.compressedBytes, tableCompressedBytes);
+
+    EXPECT_EQ(NUM_OF_TUPLES, verifyRows());
+    ColdBlockCompressor::Stats scanned = stats();
+    EXPECT_EQ(blockCount, scanned.decompressions);
+    EXPECT_EQ(0, scanned.compressedBlocks);
+    EXPECT_EQ(0, scanned.compressedBytes);
+    m_table->compressedMemory(tableCompressedBlocks, tableCompressedBytes);
+    EXPECT_EQ(0, tableCompressedBlocks);
+    EXPECT_EQ(0, tableCompressedBytes);
+
+    // Brought back once, the blocks wait twice as long to be compressed again.
+    tick(COLD_TICKS);
+    EXPECT_EQ(blockCount, stats().compressions);
+    tick(COLD_TICKS);
+    EXPECT_EQ(2 * blockCount, stats().compressions);
+
+    // A second scan finds them all resident.
+    EXPECT_EQ(NUM_OF_TUPLES, verifyRows());
+    EXPECT_EQ(NUM_OF_TUPLES, verifyRows());
+    tick(1);
+    ColdBlockCompressor::Stats rescanned = stats();
+    EXPECT_EQ(2 * blockCount, rescanned.decompressions);
+    // The inserts hit the blocks before they were first compressed.
+    rescanned.residentHits -= compressed.residentHits;
+    EXPECT_EQ(blockCount, rescanned.residentHits);
+    EXPECT_TRUE(rescanned.hitRate() > 0.3 && rescanned.hitRate() < 0.4);
+}
+
+TEST_F(ColdBlockCompressorTest, IndexLookupBringsItsBlockBack) {
+    insertTuples(0, NUM_OF_TUPLES);
+    tick(COLD_TICKS);
+    const int64_t blockCount = stats().compressedBlocks;
+    ASSERT_TRUE(blockCount > 1);
+
+    verifyRow(lookup(NUM_OF_TUPLES / 2), NUM_OF_TUPLES / 2);
+    EXPECT_EQ(1, stats().decompressions);
+    EXPECT_EQ(blockCount - 1, stats().compressedBlocks);
+    verifyRow(lookup(NUM_OF_TUPLES / 2 + 1), NUM_OF_TUPLES / 2 + 1);
+    EXPECT_EQ(1, stats().decompressions);
+
+    EXPECT_TRUE(lookup(NUM_OF_TUPLES).isNullTuple());
+    verifyRow(lookup(0), 0);
+    verifyRow(lookup(NUM_OF_TUPLES - 1), NUM_OF_TUPLES - 1);
+}
+
+TEST_F(ColdBlockCompressorTest, InsertDeleteAndCompact) {
+    insertTuples(0, NUM_OF_TUPLES);
+
+    // Leave holes in every block, without an undo quantum whose release
+    // would compact them away before they go cold.
+    for (int64_t id = 0; id < NUM_OF_TUPLES; id += 2) {
+        TableTuple tuple = lookup(id);
+        m_table->deleteTuple(tuple, false);
+    }
+    tick(COLD_TICKS);
+    ASSERT_TRUE(stats().compressedBlocks > 1);
+
+    // New rows go into a compressed block's free slots.
+    insertTuples(NUM_OF_TUPLES, 10);
+    EXPECT_EQ(1, stats().decompressions);
+    for (int64_t id = NUM_OF_TUPLES; id < NUM_OF_TUPLES + 10; id++) {
+        verifyRow(lookup(id), id);
+    }
+
+    // Compaction merges the compressed blocks.
+    tick(2 * COLD_TICKS);
+    ASSERT_TRUE(stats().compressedBlocks > 1);
+    const size_t blocksBefore = m_table->allocatedBlockCount();
+    m_table->doIdleCompaction();
+    EXPECT_TRUE(m_table->allocatedBlockCount() < blocksBefore);
+
+    EXPECT_EQ(NUM_OF_TUPLES / 2 + 10, verifyRows());
+    for (int64_t id = 1; id < NUM_OF_TUPLES; id += 2) {
+        verifyRow(lookup(id), id);
+    }
+    EXPECT_TRUE(lookup(0).isNullTuple());
+}
+
+TEST_F(ColdBlockCompressorTest, SnapshotReadsCompressedBlocks) {
+    insertTuples(0, NUM_OF_TUPLES);
+    tick(COLD_TICKS);
+    const int64_t blockCount = stats().compressedBlocks;
+    ASSERT_TRUE(blockCount > 1);
+
+    DefaultTupleSerializer serializer;
+    char config[4];
+    ::memset(config, 0, 4);
+    ReferenceSerializeInputBE input(config, 4);
+    ASSERT_TRUE(m_table->activateStream(serializer, TABLE_STREAM_SNAPSHOT, 0, 0, input));
+
+    int64_t streamed = 0;
+    boost::scoped_array<char> buffer(new char[128 * 1024]);
+    while (true) {
+        TupleOutputStreamProcessor outputStreams(buffer.get(), 128 * 1024);
+        std::vector<int> retPositions;
+        m_table->streamMore(outputStreams, TABLE_STREAM_SNAPSHOT, retPositions);
+        if (outputStreams.at(0).position() == 0) {
+            break;
+        }
+        // partition id, then row count
+        streamed += ntohl(*reinterpret_cast<const int32_t*>(buffer.get() + sizeof(int32_t)));
+        // Blocks aren't compressed while the table is being streamed.
+        tick(COLD_TICKS);
+        EXPECT_EQ(blockCount, stats().compressions);
+    }
+    EXPECT_EQ(NUM_OF_TUPLES, streamed);
+    EXPECT_EQ(blockCount, stats().decompressions);
+
+    // Once the snapshot is done they go cold again.
+    tick(2 * COLD_TICKS);
+    EXPECT_EQ(2 * blockCount, stats().compressions);
+    EXPECT_EQ(NUM_OF_TUPLES, verifyRows());
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -42,6 +42,7 @@
 
 #include <vector>
 #include <string>
+#include <sstream>
 #include <stdint.h>
 #include <boost/scoped_array.hpp>
 #include <boost/foreach.hpp>
@@ -114,6 +115,7 @@ public:
         m_undoToken = 0;
 
         m_tableId = 0;
+        m_table = NULL;
     }
 
     ~CompactionTest() {
@@ -257,6 +259,42 @@ public:
         }
     }
 
+    /*
+     * Load a catalog holding table Foo with the columns of m_tableSchemaTypes,
+     * so that the engine ticks it, and return the engine's table.
+     */
+    PersistentTable* loadCatalogTable() {
+        std::ostringstream catalog;
+        catalog << "add / clusters cluster\n"
+                << "add /clusters[cluster] databases database\n"
+                << "add /clusters[cluster]/databases[database] programs program\n"
+                << "add /clusters[cluster]/databases[database] tables Foo\n"
+                << "set /clusters[cluster]/databases[database]/tables[Foo] type 0\n"
+                << "set /clusters[cluster]/databases[database]/tables[Foo] isreplicated false\n"
+                << "set /clusters[cluster]/databases[database]/tables[Foo] partitioncolumn 0\n"
+                << "set /clusters[cluster]/databases[database]/tables[Foo] estimatedtuplecount 0\n"
+                << "set /clusters[cluster]/databases[database]/tables[Foo] tuplelimit 2147483647\n";
+        for (int ii = 0; ii < m_tableSchemaTypes.size(); ii++) {
+            const std::string column = "/clusters[cluster]/databases[database]/tables[Foo]/columns[C" +
+                    m_columnNames[ii] + "]";
+            catalog << "add /clusters[cluster]/databases[database]/tables[Foo] columns C" << m_columnNames[ii] << "\n"
+                    << "set " << column << " index " << ii << "\n"
+                    << "set " << column << " type " << m_tableSchemaTypes[ii] << "\n"
+                    << "set " << column << " size 0\n"
+                    << "set " << column << " nullable " << (ii < 2 ? "false" : "true") << "\n"
+                    << "set " << column << " name \"C" << m_columnNames[ii] << "\"\n";
+        }
+        if ( ! m_engine->loadCatalog(-2, catalog.str())) {
+            return NULL;
+        }
+        return dynamic_cast<PersistentTable*>(m_engine->getTable("Foo"));
+    }
+
+    void beginUndoQuantum() {
+        m_engine->setUndoToken(++m_undoToken);
+        m_engine->updateExecutorContextUndoQuantumForTest();
+    }
+
     voltdb::VoltDBEngine *m_engine;
     voltdb::TupleSchema *m_tableSchema;
     voltdb::PersistentTable *m_table;
@@ -599,6 +637,129 @@ TEST_F(CompactionTest, TestENG897) {
     m_table->doIdleCompaction();
     //m_table->printBucketInfo();
 }
+
+/*
+ * A forced compaction with a budget stops after each block merge and is
+ * resumed by later calls until the compaction predicate is satisfied.
+ */
+TEST_F(CompactionTest, IncrementalCompaction) {
+    initTable();
+    int tupleCount = 322630;
+    addRandomUniqueTuples( m_table, tupleCount);
+    ASSERT_EQ(10, m_table->allocatedBlockCount());
+
+    voltdb::TableIndex *pkeyIndex = m_table->primaryKeyIndex();
+    TableTuple key(pkeyIndex->getKeySchema());
+    boost::scoped_array<char> backingStore(new char[pkeyIndex->getKeySchema()->tupleLength()]);
+    key.moveNoHeader(backingStore.get());
+    IndexCursor indexCursor(pkeyIndex->getTupleSchema());
+
+    for (int ii = 0; ii < tupleCount; ii += 2) {
+        key.setNValue(0, ValueFactory::getIntegerValue(ii));
+        ASSERT_TRUE(pkeyIndex->moveToKey(&key, indexCursor));
+        TableTuple tuple = pkeyIndex->nextValueAtKey(indexCursor);
+        m_table->deleteTuple(tuple, true);
+    }
+    ASSERT_EQ(0, m_table->compactedTupleCount());
+    const int64_t pending = m_table->pendingCompactionTupleCount();
+    ASSERT_TRUE(pending > 0);
+
+    m_table->setCompactionBudget(0);
+    m_table->doIncrementalCompaction();
+    ASSERT_TRUE(m_table->compactedTupleCount() > 0);
+    ASSERT_TRUE(m_table->pendingCompactionTupleCount() > 0);
+    ASSERT_TRUE(m_table->pendingCompactionTupleCount() < pending);
+    ASSERT_EQ(9, m_table->allocatedBlockCount());
+
+    int calls = 1;
+    while (m_table->pendingCompactionTupleCount() > 0) {
+        m_table->doIncrementalCompaction();
+        ASSERT_TRUE(++calls < 10);
+    }
+    ASSERT_TRUE(calls > 1);
+    ASSERT_TRUE(m_table->allocatedBlockCount() < 9);
+    ASSERT_EQ(tupleCount / 2, m_table->activeTupleCount());
+    ASSERT_TRUE(m_table->compactionStallMicros() >= 0);
+
+    // Tuples that moved are still found through the index
+    for (int ii = 1; ii < tupleCount; ii += 2) {
+        key.setNValue(0, ValueFactory::getIntegerValue(ii));
+        ASSERT_TRUE(pkeyIndex->moveToKey(&key, indexCursor));
+        TableTuple tuple = pkeyIndex->nextValueAtKey(indexCursor);
+        ASSERT_EQ(ii, ValuePeeker::peekAsInteger(tuple.getNValue(0)));
+    }
+}
+
+/*
+ * Tick leaves an unfinished compaction alone while an undo quantum is open,
+ * because the quantum's undo actions hold on to the addresses of the tuples
+ * compaction would move. Rolling the quantum back restores the table, and the
+ * next tick after it resumes the compaction.
+ */
+TEST_F(CompactionTest, NoTickCompactionWithOpenUndoQuantum) {
+    PersistentTable *table = loadCatalogTable();
+    ASSERT_TRUE(table != NULL);
+    int tupleCount = 322630;
+
+    beginUndoQuantum();
+    addRandomUniqueTuples(table, tupleCount);
+    m_engine->releaseUndoToken(m_undoToken);
+    ASSERT_EQ(10, table->allocatedBlockCount());
+
+    // Delete every other tuple, leaving most of the compaction to later ticks
+    std::vector<char*> evenTuples;
+    TableTuple tuple(table->schema());
+    TableIterator iterator = table->iterator();
+    while (iterator.next(tuple)) {
+        if (ValuePeeker::peekAsInteger(tuple.getNValue(0)) % 2 == 0) {
+            evenTuples.push_back(tuple.address());
+        }
+    }
+    table->setCompactionBudget(0);
+    beginUndoQuantum();
+    BOOST_FOREACH(char *address, evenTuples) {
+        tuple.move(address);
+        table->deleteTuple(tuple, true);
+    }
+    m_engine->releaseUndoToken(m_undoToken);
+    ASSERT_TRUE(table->pendingCompactionTupleCount() > 0);
+    const int64_t compacted = table->compactedTupleCount();
+
+    // Update and insert in a quantum that stays open over the tick. Unlike
+    // deletes, these leave the compaction predicate alone.
+    std::vector<char*> oddTuples;
+    iterator = table->iterator();
+    while (iterator.next(tuple)) {
+        oddTuples.push_back(tuple.address());
+    }
+    beginUndoQuantum();
+    TableTuple tempTuple = table->tempTuple();
+    for (int ii = 0; ii < oddTuples.size(); ii += 3) {
+        tuple.move(oddTuples[ii]);
+        tempTuple.copy(tuple);
+        tempTuple.setNValue(1, ValueFactory::getIntegerValue(-1));
+        table->updateTuple(tuple, tempTuple);
+    }
+    addRandomUniqueTuples(table, 1000);
+    m_engine->tick(0, 0);
+    ASSERT_EQ(compacted, table->compactedTupleCount());
+    m_engine->undoUndoToken(m_undoToken);
+
+    ASSERT_EQ(tupleCount / 2, table->activeTupleCount());
+    stx::btree_set<int32_t> pkeys;
+    iterator = table->iterator();
+    while (iterator.next(tuple)) {
+        const int32_t pkey = ValuePeeker::peekAsInteger(tuple.getNValue(0));
+        ASSERT_EQ(1, pkey % 2);
+        ASSERT_TRUE(ValuePeeker::peekAsInteger(tuple.getNValue(1)) != -1);
+        ASSERT_TRUE(pkeys.insert(pkey).second);
+    }
+    ASSERT_EQ(tupleCount / 2, pkeys.size());
+
+    // With no quantum open the tick compacts again
+    m_engine->tick(0, 0);
+    ASSERT_TRUE(table->compactedTupleCount() > compacted);
+}
 #endif
 int main() {
     return TestSuite::globalInstance()->runAll();
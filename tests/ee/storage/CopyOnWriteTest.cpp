@@ -1584,6 +1584,8 @@ public:
 
     virtual TableStreamerContextPtr findStreamContext(TableStreamType streamType) { return TableStreamerContextPtr(); }
 
+    virtual bool hasActiveStreams() const { return false; }
+
     virtual bool notifyTupleInsert(TableTuple &tuple) { return false; }
 
     virtual bool notifyTupleUpdate(TableTuple &tuple) { return false; }
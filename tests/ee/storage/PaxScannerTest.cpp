@@ -0,0 +1,196 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#include "harness.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "execution/VoltDBEngine.h"
+#include "storage/persistenttable.h"
+#include "storage/PaxScanner.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+#include "storage/DRTupleStream.h"
+
+using namespace std;
+using namespace voltdb;
+
+#define NUM_OF_COLUMNS 8
+#define NUM_OF_TUPLES 50000
+
+class PaxScannerTest : public Test {
+public:
+    PaxScannerTest() {
+        m_engine = new VoltDBEngine();
+        int partitionCount = 1;
+        m_engine->initialize(1,1, 0, 0, "", DEFAULT_TEMP_TABLE_MEMORY);
+        m_engine->updateHashinator(HASHINATOR_LEGACY, (char*)&partitionCount, NULL, 0);
+
+        vector<string> columnNames;
+        vector<ValueType> columnTypes;
+        vector<int32_t> columnLengths;
+        vector<bool> columnAllowNull;
+        for (int ii = 0; ii < NUM_OF_COLUMNS; ii++) {
+            char buffer[32];
+            snprintf(buffer, 32, "column%02d", ii);
+            columnNames.push_back(buffer);
+            columnTypes.push_back(VALUE_TYPE_BIGINT);
+            columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+            columnAllowNull.push_back(false);
+        }
+        m_tableSchema = TupleSchema::createTupleSchemaForTest(columnTypes, columnLengths, columnAllowNull);
+        m_table = dynamic_cast<PersistentTable*>(
+            TableFactory::getPersistentTable(0, "Foo", m_tableSchema, columnNames, signature));
+        m_table->setPaxLayout(true);
+
+        // column 1 and 5 are scanned
+        m_columns.push_back(1);
+        m_columns.push_back(5);
+    }
+
+    ~PaxScannerTest() {
+        delete m_engine;
+        delete m_table;
+    }
+
+    void insertTuple(int64_t key) {
+        TableTuple &tuple = m_table->tempTuple();
+        for (int ii = 0; ii < NUM_OF_COLUMNS; ii++) {
+            tuple.setNValue(ii, ValueFactory::getBigIntValue(key * NUM_OF_COLUMNS + ii));
+        }
+        m_table->insertTuple(tuple);
+    }
+
+    /*
+     * Scan the table and check that the mini-pages agree with the rows.
+     * Return the number of visible tuples.
+     */
+    int verifyScan() {
+        PaxScanner scanner(*m_table, m_columns);
+        TableTuple scratch(m_tableSchema);
+        char scratchStorage[NUM_OF_COLUMNS * sizeof(int64_t) + TUPLE_HEADER_SIZE];
+        scratch.move(scratchStorage);
+        TableTuple tuple(m_tableSchema);
+        int visible = 0;
+        while (scanner.next(scratch)) {
+            scanner.moveToRow(tuple);
+            // free slots are skipped
+            EXPECT_TRUE(tuple.isActive());
+            if (tuple.isPendingDelete() || tuple.isPendingDeleteOnUndoRelease()) {
+                continue;
+            }
+            ++visible;
+            for (int ii = 0; ii < m_columns.size(); ii++) {
+                EXPECT_EQ(ValuePeeker::peekAsBigInt(tuple.getNValue(m_columns[ii])),
+                          ValuePeeker::peekAsBigInt(scratch.getNValue(m_columns[ii])));
+            }
+        }
+        return visible;
+    }
+
+    VoltDBEngine *m_engine;
+    TupleSchema *m_tableSchema;
+    PersistentTable *m_table;
+    vector<int> m_columns;
+    char signature[20];
+};
+
+TEST_F(PaxScannerTest, MiniPagesFollowChanges) {
+    for (int64_t ii = 0; ii < NUM_OF_TUPLES; ii++) {
+        insertTuple(ii);
+    }
+    ASSERT_TRUE(m_table->allocatedBlockCount() > 1);
+    EXPECT_EQ(NUM_OF_TUPLES, verifyScan());
+
+    // appends after the mini-pages were built
+    for (int64_t ii = NUM_OF_TUPLES; ii < NUM_OF_TUPLES + 100; ii++) {
+        insertTuple(ii);
+    }
+    EXPECT_EQ(NUM_OF_TUPLES + 100, verifyScan());
+
+    // updates in place, deletes and inserts into the freed slots
+    m_engine->setUndoToken(1);
+    m_engine->updateExecutorContextUndoQuantumForTest();
+    int deleted = 0;
+    TableTuple tuple(m_tableSchema);
+    TableIterator iterator = m_table->iterator();
+    while (iterator.next(tuple)) {
+        int64_t key = ValuePeeker::peekAsBigInt(tuple.getNValue(0)) / NUM_OF_COLUMNS;
+        if (key % 5 == 0) {
+            m_table->deleteTuple(tuple, true);
+            ++deleted;
+        }
+        else if (key % 7 == 0) {
+            TableTuple &newValues = m_table->tempTuple();
+            newValues.copy(tuple);
+            newValues.setNValue(5, ValueFactory::getBigIntValue(-key));
+            m_table->updateTuple(tuple, newValues);
+        }
+    }
+    m_engine->releaseUndoToken(1);
+    EXPECT_EQ(NUM_OF_TUPLES + 100 - deleted, verifyScan());
+    m_engine->setUndoToken(2);
+    m_engine->updateExecutorContextUndoQuantumForTest();
+    for (int64_t ii = 0; ii < 1000; ii++) {
+        insertTuple(NUM_OF_TUPLES + 100 + ii);
+    }
+    m_engine->releaseUndoToken(2);
+    EXPECT_EQ(NUM_OF_TUPLES + 1100 - deleted, verifyScan());
+
+    // an undone update puts the old values back in place
+    m_engine->setUndoToken(3);
+    m_engine->updateExecutorContextUndoQuantumForTest();
+    iterator = m_table->iterator();
+    while (iterator.next(tuple)) {
+        TableTuple &newValues = m_table->tempTuple();
+        newValues.copy(tuple);
+        newValues.setNValue(1, ValueFactory::getBigIntValue(0));
+        m_table->updateTuple(tuple, newValues);
+    }
+    EXPECT_EQ(NUM_OF_TUPLES + 1100 - deleted, verifyScan());
+    m_engine->undoUndoToken(3);
+    EXPECT_EQ(NUM_OF_TUPLES + 1100 - deleted, verifyScan());
+}
+
+TEST_F(PaxScannerTest, MiniPagesCountAsTableMemory) {
+    for (int64_t ii = 0; ii < NUM_OF_TUPLES; ii++) {
+        insertTuple(ii);
+    }
+    const int64_t blockMemory = m_table->allocatedBlockCount() * m_table->getTableAllocationSize();
+    EXPECT_EQ(blockMemory, m_table->allocatedTupleMemory());
+    EXPECT_EQ(NUM_OF_TUPLES, verifyScan());
+    // a mini-page of each scanned column in each block
+    const int64_t miniPageMemory =
+        m_table->allocatedTupleCount() * static_cast<int64_t>(m_columns.size() * sizeof(int64_t));
+    EXPECT_EQ(blockMemory + miniPageMemory, m_table->allocatedTupleMemory());
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,293 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <stdint.h>
+
+#include "harness.h"
+#include "common/TupleSchema.h"
+#include "common/types.h"
+#include "common/NValue.hpp"
+#include "common/StringRef.h"
+#include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "execution/VoltDBEngine.h"
+#include "expressions/constantvalueexpression.h"
+#include "expressions/expressionutil.h"
+#include "expressions/fusedpredicateexpression.h"
+#include "expressions/tuplevalueexpression.h"
+#include "indexes/tableindex.h"
+#include "indexes/tableindexfactory.h"
+#include "storage/persistenttable.h"
+#include "storage/StringDictionary.h"
+#include "storage/tablefactory.h"
+#include "storage/tableiterator.h"
+#include "storage/DRTupleStream.h"
+
+using namespace std;
+using namespace voltdb;
+
+#define NUM_OF_TUPLES 300
+#define NUM_OF_STRINGS 3
+
+class StringDictionaryTest : public Test {
+public:
+    StringDictionaryTest() {
+        m_engine = new VoltDBEngine();
+        int partitionCount = 1;
+        m_engine->initialize(1,1, 0, 0, "", DEFAULT_TEMP_TABLE_MEMORY);
+        m_engine->updateHashinator(HASHINATOR_LEGACY, (char*)&partitionCount, NULL, 0);
+
+        vector<string> columnNames;
+        columnNames.push_back("id");
+        columnNames.push_back("name");
+        vector<ValueType> columnTypes;
+        columnTypes.push_back(VALUE_TYPE_BIGINT);
+        columnTypes.push_back(VALUE_TYPE_VARCHAR);
+        vector<int32_t> columnLengths;
+        columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+        columnLengths.push_back(100);
+        vector<bool> columnAllowNull(2, true);
+        m_tableSchema = TupleSchema::createTupleSchemaForTest(columnTypes, columnLengths, columnAllowNull);
+        m_table = dynamic_cast<PersistentTable*>(
+            TableFactory::getPersistentTable(0, "Foo", m_tableSchema, columnNames, signature, &drStream, false, 0));
+
+        vector<int> keyColumns(1, 0);
+        TableIndexScheme scheme("primaryKeyIndex", BALANCED_TREE_INDEX, keyColumns,
+                                TableIndex::simplyIndexColumns(), true, true, m_tableSchema);
+        TableIndex *pkeyIndex = TableIndexFactory::getInstance(scheme);
+        m_table->addIndex(pkeyIndex);
+        m_table->setPrimaryKeyIndex(pkeyIndex);
+
+        m_engine->setUndoToken(INT64_MIN + 1);
+        m_nextUndoToken = INT64_MIN + 2;
+    }
+
+    ~StringDictionaryTest() {
+        delete m_engine;
+        delete m_table;
+    }
+
+    static string nameOf(int64_t id) {
+        char buffer[64];
+        snprintf(buffer, 64, "a string long enough to be stored apart from the row %d",
+                 static_cast<int>(id % NUM_OF_STRINGS));
+        return buffer;
+    }
+
+    void beginUndo() {
+        m_engine->setUndoToken(m_nextUndoToken);
+        m_engine->updateExecutorContextUndoQuantumForTest();
+    }
+
+    void releaseUndo() {
+        m_engine->releaseUndoToken(m_nextUndoToken++);
+    }
+
+    void undoUndo() {
+        m_engine->undoUndoToken(m_nextUndoToken++);
+    }
+
+    void insertTuples() {
+        beginUndo();
+        TableTuple &tuple = m_table->tempTuple();
+        for (int64_t id = 0; id < NUM_OF_TUPLES; id++) {
+            tuple.setNValue(0, ValueFactory::getBigIntValue(id));
+            NValue name = ValueFactory::getStringValue(nameOf(id));
+            tuple.setNValue(1, name);
+            m_table->insertTuple(tuple);
+            name.free();
+        }
+        releaseUndo();
+    }
+
+    TableTuple findRow(int64_t id) {
+        TableTuple tuple(m_tableSchema);
+        TableIterator iterator = m_table->iterator();
+        while (iterator.next(tuple)) {
+            if (ValuePeeker::peekAsBigInt(tuple.getNValue(0)) == id) {
+                return tuple;
+            }
+        }
+        return TableTuple();
+    }
+
+    const void *stringOf(const TableTuple &tuple) {
+        return ValuePeeker::peekObjectValue_withoutNull(tuple.getNValue(1));
+    }
+
+    int64_t sharedStringsSize() {
+        int64_t bytes = 0;
+        for (int64_t id = 0; id < NUM_OF_STRINGS; id++) {
+            bytes += StringRef::computeStringMemoryUsed(nameOf(id).size());
+        }
+        return bytes;
+    }
+
+    void verifyRows() {
+        TableTuple tuple(m_tableSchema);
+        TableIterator iterator = m_table->iterator();
+        int count = 0;
+        while (iterator.next(tuple)) {
+            const int64_t id = ValuePeeker::peekAsBigInt(tuple.getNValue(0));
+            const string expected = nameOf(id);
+            EXPECT_EQ(expected, string(static_cast<const char*>(stringOf(tuple)),
+                                       ValuePeeker::peekObjectLength_withoutNull(tuple.getNValue(1))));
+            ++count;
+        }
+        EXPECT_EQ(NUM_OF_TUPLES, count);
+    }
+
+    VoltDBEngine *m_engine;
+    TupleSchema *m_tableSchema;
+    PersistentTable *m_table;
+    MockDRTupleStream drStream;
+    int64_t m_nextUndoToken;
+    char signature[20];
+};
+
+TEST_F(StringDictionaryTest, RowsShareStrings) {
+    m_table->setDictionaryEncodedColumns(vector<int>(1, 1));
+    ASSERT_EQ(2, m_table->stringDictionaries().size());
+    EXPECT_TRUE(m_table->stringDictionaries()[0] == NULL);
+    const StringDictionary *dictionary = m_table->stringDictionaries()[1];
+    ASSERT_TRUE(dictionary != NULL);
+
+    insertTuples();
+    verifyRows();
+    EXPECT_EQ(NUM_OF_STRINGS, dictionary->size());
+    EXPECT_EQ(sharedStringsSize(), m_table->nonInlinedMemorySize());
+    EXPECT_EQ(stringOf(findRow(0)), stringOf(findRow(NUM_OF_STRINGS)));
+    EXPECT_NE(stringOf(findRow(0)), stringOf(findRow(1)));
+
+    // The strings go with the last rows holding them.
+    beginUndo();
+    for (int64_t id = 0; id < NUM_OF_TUPLES; id += NUM_OF_STRINGS) {
+        TableTuple tuple = findRow(id);
+        m_table->deleteTuple(tuple, true);
+    }
+    releaseUndo();
+    EXPECT_EQ(NUM_OF_STRINGS - 1, dictionary->size());
+    EXPECT_TRUE(dictionary->find(nameOf(0).c_str(), static_cast<int32_t>(nameOf(0).size())) == NULL);
+}
+
+TEST_F(StringDictionaryTest, UpdateAndUndo) {
+    m_table->setDictionaryEncodedColumns(vector<int>(1, 1));
+    const StringDictionary *dictionary = m_table->stringDictionaries()[1];
+    insertTuples();
+    const char *shared0 = dictionary->find(nameOf(0).c_str(), static_cast<int32_t>(nameOf(0).size()));
+    const char *shared1 = dictionary->find(nameOf(1).c_str(), static_cast<int32_t>(nameOf(1).size()));
+    ASSERT_TRUE(shared0 != NULL && shared1 != NULL);
+    const int64_t references = dictionary->referenceCount(shared0);
+
+    // Row 0 takes the string of row 1, which it already shares.
+    beginUndo();
+    TableTuple target = findRow(0);
+    TableTuple &source = m_table->tempTuple();
+    source.copy(target);
+    NValue name = ValueFactory::getStringValue(nameOf(1));
+    source.setNValue(1, name);
+    m_table->updateTuple(target, source);
+    name.free();
+    EXPECT_EQ(stringOf(findRow(1)), stringOf(findRow(0)));
+    EXPECT_EQ(references + 1, dictionary->referenceCount(shared1));
+    undoUndo();
+    verifyRows();
+    EXPECT_EQ(references, dictionary->referenceCount(shared0));
+    EXPECT_EQ(references, dictionary->referenceCount(shared1));
+
+    // A new string gets into the dictionary, and the old one is released with the update.
+    beginUndo();
+    target = findRow(0);
+    source.copy(target);
+    name = ValueFactory::getStringValue("a string no other row has, which is long enough too");
+    source.setNValue(1, name);
+    m_table->updateTuple(target, source);
+    name.free();
+    releaseUndo();
+    EXPECT_EQ(NUM_OF_STRINGS + 1, dictionary->size());
+    EXPECT_EQ(references - 1, dictionary->referenceCount(shared0));
+}
+
+TEST_F(StringDictionaryTest, EncodeExistingRows) {
+    insertTuples();
+    const int64_t unencodedSize = m_table->nonInlinedMemorySize();
+    EXPECT_NE(stringOf(findRow(0)), stringOf(findRow(NUM_OF_STRINGS)));
+
+    m_table->setDictionaryEncodedColumns(vector<int>(1, 1));
+    verifyRows();
+    EXPECT_EQ(NUM_OF_STRINGS, m_table->stringDictionaries()[1]->size());
+    EXPECT_EQ(sharedStringsSize(), m_table->nonInlinedMemorySize());
+    EXPECT_EQ(stringOf(findRow(0)), stringOf(findRow(NUM_OF_STRINGS)));
+
+    // Columns that can't be encoded are left alone.
+    vector<int> columns;
+    columns.push_back(0);
+    m_table->setDictionaryEncodedColumns(columns);
+    EXPECT_TRUE(m_table->stringDictionaries().empty());
+    verifyRows();
+    EXPECT_EQ(unencodedSize, m_table->nonInlinedMemorySize());
+}
+
+TEST_F(StringDictionaryTest, FusedPredicate) {
+    m_table->setDictionaryEncodedColumns(vector<int>(1, 1));
+    insertTuples();
+
+    // name = '<the string of row 1>'
+    auto_ptr<AbstractExpression> generic(ExpressionUtil::comparisonFactory(
+        EXPRESSION_TYPE_COMPARE_EQUAL, new TupleValueExpression(0, 1),
+        new ConstantValueExpression(ValueFactory::getStringValue(nameOf(1)))));
+    auto_ptr<FusedPredicateExpression> fused(
+        FusedPredicateExpression::specialize(generic.get(), m_tableSchema, &m_table->stringDictionaries()));
+    ASSERT_TRUE(fused.get() != NULL);
+    fused->bindDictionaries(m_table->stringDictionaries());
+
+    TableTuple tuple(m_tableSchema);
+    TableIterator iterator = m_table->iterator();
+    int matches = 0;
+    while (iterator.next(tuple)) {
+        const bool expected = generic->eval(&tuple, NULL).isTrue();
+        EXPECT_EQ(expected, fused->eval(&tuple, NULL).isTrue());
+        matches += expected ? 1 : 0;
+    }
+    EXPECT_EQ(NUM_OF_TUPLES / NUM_OF_STRINGS, matches);
+
+    // A string no row holds matches nothing.
+    auto_ptr<AbstractExpression> absent(ExpressionUtil::comparisonFactory(
+        EXPRESSION_TYPE_COMPARE_EQUAL, new TupleValueExpression(0, 1),
+        new ConstantValueExpression(ValueFactory::getStringValue("no row holds this string"))));
+    fused.reset(FusedPredicateExpression::specialize(absent.get(), m_tableSchema, &m_table->stringDictionaries()));
+    ASSERT_TRUE(fused.get() != NULL);
+    fused->bindDictionaries(m_table->stringDictionaries());
+    TableTuple row = findRow(0);
+    EXPECT_FALSE(fused->eval(&row, NULL).isTrue());
+
+    // Without the dictionaries, a varchar column is not specialized.
+    EXPECT_TRUE(FusedPredicateExpression::specialize(generic.get(), m_tableSchema) == NULL);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
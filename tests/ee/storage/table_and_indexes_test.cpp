@@ -32,6 +32,8 @@
 #include "common/types.h"
 #include "common/NValue.hpp"
 #include "common/ValueFactory.hpp"
+#include "common/ValuePeeker.hpp"
+#include "common/serializeio.h"
 #include "common/tabletuple.h"
 #include "storage/BinaryLogSink.h"
 #include "storage/persistenttable.h"
@@ -574,6 +576,77 @@ TEST_F(TableAndIndexTest, BigTest) {
     }
 }
 
+/*
+ * Check that loading a table indexes all the tuples and sets aside the ones
+ * that violate a unique index
+ */
+TEST_F(TableAndIndexTest, LoadTest) {
+    NValue name = ValueFactory::getStringValue("BA");
+    TableTuple *temp_tuple = &districtTempTable->tempTuple();
+    // 100 districts, then 10 that repeat the keys of earlier ones
+    for (int i = 0; i < 110; i++) {
+        temp_tuple->setNValue(0, ValueFactory::getTinyIntValue(static_cast<int8_t>(i % 100)));
+        temp_tuple->setNValue(1, ValueFactory::getTinyIntValue(static_cast<int8_t>(3)));
+        for (int col = 2; col < 8; col++) {
+            temp_tuple->setNValue(col, name);
+        }
+        temp_tuple->setNValue(8, ValueFactory::getDoubleValue(static_cast<double>(.0825)));
+        temp_tuple->setNValue(9, ValueFactory::getDoubleValue(static_cast<double>(15241.45)));
+        temp_tuple->setNValue(10, ValueFactory::getIntegerValue(static_cast<int32_t>(i)));
+        districtTempTable->insertTupleNonVirtual(*temp_tuple);
+    }
+    CopySerializeOutput serialize_out;
+    districtTempTable->serializeTo(serialize_out);
+    districtTempTable->deleteAllTuplesNonVirtual(true);
+
+    ReferenceSerializeInputBE serialize_in(serialize_out.data() + sizeof(int32_t),
+                                           serialize_out.size() - sizeof(int32_t));
+    char violations[1024 * 16];
+    ReferenceSerializeOutput violationOutput(violations, sizeof(violations));
+    districtTable->loadTuplesFrom(serialize_in, NULL, &violationOutput);
+
+    // the first of each key is kept
+    EXPECT_EQ(100, districtTable->activeTupleCount());
+    EXPECT_EQ(100, districtTable->primaryKeyIndex()->getSize());
+    TableTuple tuple(districtTable->schema());
+    TableIterator iterator = districtTable->iterator();
+    while (iterator.next(tuple)) {
+        EXPECT_TRUE(ValuePeeker::peekAsInteger(tuple.getNValue(10)) < 100);
+        EXPECT_TRUE(districtTable->primaryKeyIndex()->exists(&tuple));
+    }
+
+    // the others come back as a table
+    ReferenceSerializeInputBE violation_in(violations + sizeof(int32_t),
+                                           violationOutput.position() - sizeof(int32_t));
+    districtTempTable->loadTuplesFrom(violation_in, NULL);
+    EXPECT_EQ(10, districtTempTable->activeTupleCount());
+    iterator = districtTempTable->iterator();
+    while (iterator.next(tuple)) {
+        EXPECT_TRUE(ValuePeeker::peekAsInteger(tuple.getNValue(10)) >= 100);
+    }
+    districtTempTable->deleteAllTuplesNonVirtual(true);
+
+    // new keys all go in
+    for (int i = 100; i < 120; i++) {
+        temp_tuple->setNValue(0, ValueFactory::getTinyIntValue(static_cast<int8_t>(i)));
+        temp_tuple->setNValue(10, ValueFactory::getIntegerValue(static_cast<int32_t>(i)));
+        districtTempTable->insertTupleNonVirtual(*temp_tuple);
+    }
+    CopySerializeOutput more_out;
+    districtTempTable->serializeTo(more_out);
+    districtTempTable->deleteAllTuplesNonVirtual(true);
+    ReferenceSerializeInputBE more_in(more_out.data() + sizeof(int32_t), more_out.size() - sizeof(int32_t));
+    districtTable->loadTuplesFrom(more_in, NULL, NULL);
+    EXPECT_EQ(120, districtTable->activeTupleCount());
+    EXPECT_EQ(120, districtTable->primaryKeyIndex()->getSize());
+    iterator = districtTable->iterator();
+    while (iterator.next(tuple)) {
+        EXPECT_TRUE(districtTable->primaryKeyIndex()->exists(&tuple));
+    }
+
+    name.free();
+}
+
 int main() {
     return TestSuite::globalInstance()->runAll();
 }
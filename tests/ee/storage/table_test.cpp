@@ -51,6 +51,7 @@
 
 #include <cstdlib>
 #include <ctime>
+#include <sstream>
 #include <string>
 #include "harness.h"
 #include "common/common.h"
@@ -61,6 +62,7 @@
 #include "common/ThreadLocalPool.h"
 #include "common/TupleSchema.h"
 #include "common/tabletuple.h"
+#include "execution/VoltDBEngine.h"
 #include "storage/table.h"
 #include "storage/temptable.h"
 #include "storage/persistenttable.h"
@@ -296,6 +298,117 @@ TEST_F(TableTest, TupleUpdate) {
 //     EXPECT_TRUE(threw);
 // }
 
+TEST_F(TableTest, TempTableSpill) {
+    //
+    // Fill a spillable temp table past the memory limit and make sure
+    // that every tuple comes back, in order, from the blocks on disk
+    //
+    stupidunit::ChTempDir spillDir;
+    TempTableLimits spillLimits(1024 * 1024);
+    spillLimits.setSpillDirectory(spillDir.name());
+    const int tupleCount = 100000;
+    TempTable* spill_table = TableFactory::getCopiedTempTable(1000, "test_spill_table",
+                                                              m_table, &spillLimits);
+    spill_table->enableSpill();
+
+    TableTuple &temp_tuple = spill_table->tempTuple();
+    for (int ii = 0; ii < tupleCount; ii++) {
+        tableutil::setRandomTupleValues(spill_table, &temp_tuple);
+        temp_tuple.setNValue(0, ValueFactory::getBigIntValue(ii));
+        spill_table->insertTempTuple(temp_tuple);
+        EXPECT_TRUE(spillLimits.getAllocated() <= 1024 * 1024);
+    }
+    EXPECT_TRUE(spill_table->hasSpilledBlocks());
+    ASSERT_EQ(tupleCount, spill_table->activeTupleCount());
+
+    int64_t expected = 0;
+    TableIterator iterator = spill_table->iterator();
+    TableTuple tuple(spill_table->schema());
+    while (iterator.next(tuple)) {
+        EXPECT_EQ(expected, ValuePeeker::peekAsBigInt(tuple.getNValue(0)));
+        expected++;
+    }
+    EXPECT_EQ(tupleCount, expected);
+
+    spill_table->deleteAllTuples(true);
+    EXPECT_FALSE(spill_table->hasSpilledBlocks());
+    spill_table->freeAllBlocks();
+    EXPECT_EQ(0, spillLimits.getAllocated());
+    delete spill_table;
+}
+
+TEST_F(TableTest, TempTableSpillStrings) {
+    //
+    // The uninlined strings of the spilled blocks are written with their
+    // rows and read back into the temp string pool of the fragment
+    //
+    VoltDBEngine engine;
+    int partitionCount = 1;
+    engine.initialize(1, 1, 0, 0, "", DEFAULT_TEMP_TABLE_MEMORY);
+    engine.updateHashinator(HASHINATOR_LEGACY, (char*)&partitionCount, NULL, 0);
+
+    vector<ValueType> columnTypes;
+    vector<int32_t> columnLengths;
+    vector<bool> columnAllowNull;
+    vector<string> columnNames;
+    columnTypes.push_back(VALUE_TYPE_BIGINT);
+    columnLengths.push_back(NValue::getTupleStorageSize(VALUE_TYPE_BIGINT));
+    columnAllowNull.push_back(false);
+    columnNames.push_back("ID");
+    columnTypes.push_back(VALUE_TYPE_VARCHAR);
+    columnLengths.push_back(200);
+    columnAllowNull.push_back(true);
+    columnNames.push_back("NAME");
+    TupleSchema *schema = TupleSchema::createTupleSchemaForTest(columnTypes, columnLengths, columnAllowNull);
+
+    stupidunit::ChTempDir spillDir;
+    TempTableLimits spillLimits(256 * 1024);
+    spillLimits.setSpillDirectory(spillDir.name());
+    TempTable* spill_table = TableFactory::getTempTable(1000, "test_spill_strings", schema,
+                                                        columnNames, &spillLimits);
+    spill_table->enableSpill();
+
+    const int tupleCount = 20000;
+    TableTuple &temp_tuple = spill_table->tempTuple();
+    for (int ii = 0; ii < tupleCount; ii++) {
+        temp_tuple.setNValue(0, ValueFactory::getBigIntValue(ii));
+        if (ii % 7 == 0) {
+            temp_tuple.setNValue(1, NValue::getNullValue(VALUE_TYPE_VARCHAR));
+        }
+        else {
+            ostringstream name;
+            name << "name-" << ii;
+            temp_tuple.setNValue(1, ValueFactory::getTempStringValue(name.str()));
+        }
+        spill_table->insertTempTuple(temp_tuple);
+    }
+    EXPECT_TRUE(spill_table->hasSpilledBlocks());
+    ASSERT_EQ(tupleCount, spill_table->activeTupleCount());
+
+    int64_t expected = 0;
+    TableIterator iterator = spill_table->iterator();
+    TableTuple tuple(spill_table->schema());
+    while (iterator.next(tuple)) {
+        EXPECT_EQ(expected, ValuePeeker::peekAsBigInt(tuple.getNValue(0)));
+        NValue name = tuple.getNValue(1);
+        if (expected % 7 == 0) {
+            EXPECT_TRUE(name.isNull());
+        }
+        else {
+            ostringstream expectedName;
+            expectedName << "name-" << expected;
+            ASSERT_FALSE(name.isNull());
+            EXPECT_EQ(expectedName.str(), ValuePeeker::peekStringCopy_withoutNull(name));
+        }
+        expected++;
+    }
+    EXPECT_EQ(tupleCount, expected);
+
+    spill_table->deleteAllTuples(false);
+    EXPECT_FALSE(spill_table->hasSpilledBlocks());
+    delete spill_table;
+}
+
 /* deleteTuple in TempTable is not supported for performance reason.
 TEST_F(TableTest, TupleDelete) {
     //
@@ -0,0 +1,302 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <map>
+#include <cstdlib>
+#include <vector>
+#include "harness.h"
+#include "structures/CompactingBTree.h"
+
+using namespace voltdb;
+using namespace std;
+
+class IntComparator {
+public:
+    inline int operator()(const int &lhs, const int &rhs) const {
+        if (lhs > rhs) return 1;
+        else if (lhs < rhs) return -1;
+        else return 0;
+    }
+};
+
+typedef CompactingBTree<NormalKeyValuePair<int, int>, IntComparator, true> RankedTree;
+
+class CompactingBTreeTest : public Test {
+public:
+    CompactingBTreeTest() {}
+};
+
+TEST_F(CompactingBTreeTest, Trivial) {
+    CompactingBTree<NormalKeyValuePair<int, int>, IntComparator> m(true, IntComparator());
+    CompactingBTree<NormalKeyValuePair<int, int>, IntComparator>::iterator iter;
+
+    ASSERT_TRUE(m.begin().isEnd());
+    ASSERT_TRUE(m.insert(2, 20));
+    ASSERT_TRUE(m.insert(1, 10));
+    ASSERT_TRUE(m.insert(3, 30));
+    ASSERT_FALSE(m.insert(2, 21));
+    ASSERT_TRUE(m.verify());
+    ASSERT_EQ(3, m.size());
+
+    iter = m.find(2);
+    ASSERT_FALSE(iter.isEnd());
+    ASSERT_EQ(20, iter.value());
+    iter.moveNext();
+    ASSERT_EQ(3, iter.key());
+    iter.moveNext();
+    ASSERT_TRUE(iter.isEnd());
+
+    iter = m.rbegin();
+    ASSERT_EQ(3, iter.key());
+    iter.movePrev();
+    iter.movePrev();
+    ASSERT_EQ(1, iter.key());
+    iter.movePrev();
+    ASSERT_TRUE(iter.isEnd());
+
+    ASSERT_TRUE(m.find(4).isEnd());
+    ASSERT_TRUE(m.erase(2));
+    ASSERT_FALSE(m.erase(2));
+    ASSERT_TRUE(m.verify());
+    ASSERT_EQ(2, m.size());
+    ASSERT_TRUE(m.erase(1));
+    ASSERT_TRUE(m.erase(3));
+    ASSERT_TRUE(m.verify());
+    ASSERT_TRUE(m.begin().isEnd());
+    ASSERT_EQ(0, m.bytesAllocated());
+}
+
+TEST_F(CompactingBTreeTest, Bounds) {
+    RankedTree m(false, IntComparator());
+    // 0, 2, 2, 2, 4, ... over enough leaves that the duplicates straddle them
+    const int LAST_KEY = 1330;
+    for (int i = 0; i < 1998; i++) {
+        ASSERT_TRUE(m.insert((i / 3) * 2, i));
+    }
+    ASSERT_TRUE(m.verify());
+
+    for (int key = -1; key < 1400; key++) {
+        RankedTree::iterator lower = m.lowerBound(key);
+        RankedTree::iterator upper = m.upperBound(key);
+        const int firstAtOrAbove = key < 0 ? 0 : ((key + 1) / 2) * 2;
+        const int firstAbove = key < 0 ? 0 : (key / 2 + 1) * 2;
+        if (firstAtOrAbove > LAST_KEY) {
+            ASSERT_TRUE(lower.isEnd());
+        }
+        else {
+            ASSERT_EQ(firstAtOrAbove, lower.key());
+        }
+        if (firstAbove > LAST_KEY) {
+            ASSERT_TRUE(upper.isEnd());
+        }
+        else {
+            ASSERT_EQ(firstAbove, upper.key());
+        }
+
+        std::pair<RankedTree::iterator, RankedTree::iterator> range = m.equalRange(key);
+        int count = 0;
+        for (RankedTree::iterator iter = range.first; !iter.equals(range.second); iter.moveNext()) {
+            ASSERT_EQ(key, iter.key());
+            count++;
+        }
+        const int expected = (key >= 0 && key % 2 == 0 && key <= LAST_KEY) ? 3 : 0;
+        ASSERT_EQ(expected, count);
+        if (expected > 0) {
+            ASSERT_EQ(m.find(key).value(), (key / 2) * 3);
+            ASSERT_EQ((key / 2) * 3 + 1, m.rankAsc(key));
+            ASSERT_EQ((key / 2) * 3 + 3, m.rankUpper(key));
+        }
+        else {
+            ASSERT_EQ(-1, m.rankAsc(key));
+        }
+    }
+}
+
+TEST_F(CompactingBTreeTest, RandomUnique) {
+    const int ITERATIONS = 100000;
+
+    std::map<int, int> stl;
+    RankedTree volt(true, IntComparator());
+
+    for (int i = 0; i < ITERATIONS; i++) {
+        // phases that mostly insert then mostly delete, to split and merge nodes
+        const bool insert = (rand() % 8) < (((i / 10000) % 2 == 0) ? 6 : 2);
+        const int value = rand() % 20000;
+        if (insert) {
+            bool stlInserted = stl.insert(pair<int, int>(value, i)).second;
+            ASSERT_EQ(stlInserted, volt.insert(value, i));
+        }
+        else {
+            std::map<int, int>::iterator stlIter = stl.lower_bound(value);
+            RankedTree::iterator voltIter = volt.lowerBound(value);
+            ASSERT_EQ(stlIter == stl.end(), voltIter.isEnd());
+            if (stlIter != stl.end()) {
+                ASSERT_EQ(stlIter->first, voltIter.key());
+                ASSERT_EQ(stlIter->second, voltIter.value());
+                stl.erase(stlIter);
+                ASSERT_TRUE(volt.erase(voltIter));
+            }
+        }
+        ASSERT_EQ(stl.size(), volt.size());
+        if (i % 5000 == 0) {
+            ASSERT_TRUE(volt.verify());
+        }
+    }
+    ASSERT_TRUE(volt.verify());
+
+    // ranks follow the key order
+    int64_t rank = 1;
+    std::map<int, int>::iterator stlIter = stl.begin();
+    for (RankedTree::iterator iter = volt.begin(); !iter.isEnd(); iter.moveNext(), stlIter++, rank++) {
+        ASSERT_EQ(stlIter->first, iter.key());
+        ASSERT_EQ(rank, volt.rankAsc(iter.key()));
+        ASSERT_TRUE(volt.findRank(rank).equals(iter));
+    }
+    ASSERT_TRUE(stlIter == stl.end());
+    ASSERT_TRUE(volt.findRank(rank).isEnd());
+}
+
+TEST_F(CompactingBTreeTest, RandomMulti) {
+    const int ITERATIONS = 100000;
+
+    std::multimap<int, int> stl;
+    RankedTree volt(false, IntComparator());
+
+    for (int i = 0; i < ITERATIONS; i++) {
+        const bool insert = (rand() % 8) < (((i / 10000) % 2 == 0) ? 6 : 2);
+        const int value = rand() % 2000;
+        if (insert) {
+            stl.insert(pair<int, int>(value, i));
+            ASSERT_TRUE(volt.insert(value, i));
+        }
+        else {
+            std::multimap<int, int>::iterator stlIter = stl.find(value);
+            ASSERT_EQ(stlIter == stl.end(), volt.find(value).isEnd());
+            if (stlIter != stl.end()) {
+                // both erase the oldest entry with the key
+                ASSERT_EQ(stlIter->second, volt.find(value).value());
+                stl.erase(stlIter);
+                ASSERT_TRUE(volt.erase(value));
+            }
+        }
+        ASSERT_EQ(stl.size(), volt.size());
+        if (i % 5000 == 0) {
+            ASSERT_TRUE(volt.verify());
+        }
+    }
+    ASSERT_TRUE(volt.verify());
+
+    std::multimap<int, int>::reverse_iterator stlIter = stl.rbegin();
+    for (RankedTree::iterator iter = volt.rbegin(); !iter.isEnd(); iter.movePrev(), stlIter++) {
+        ASSERT_EQ(stlIter->first, iter.key());
+    }
+    ASSERT_TRUE(stlIter == stl.rend());
+}
+
+TEST_F(CompactingBTreeTest, ShrinkAfterDeletes) {
+    const int ITERATIONS = 100000;
+
+    RankedTree volt(true, IntComparator());
+    for (int i = 0; i < ITERATIONS; i++) {
+        ASSERT_TRUE(volt.insert(i, i));
+    }
+    const size_t fullSize = volt.bytesAllocated();
+
+    // deleting keeps the remaining nodes packed and gives back the rest
+    for (int i = 0; i < ITERATIONS; i++) {
+        if (i % 10 != 0) {
+            ASSERT_TRUE(volt.erase(i));
+        }
+    }
+    ASSERT_TRUE(volt.verify());
+    ASSERT_EQ(ITERATIONS / 10, volt.size());
+    ASSERT_TRUE(volt.bytesAllocated() < fullSize / 2);
+    for (int i = 0; i < ITERATIONS; i += 10) {
+        ASSERT_EQ(i, volt.find(i).value());
+    }
+    for (int i = 0; i < ITERATIONS; i += 10) {
+        ASSERT_TRUE(volt.erase(i));
+    }
+    ASSERT_TRUE(volt.verify());
+    ASSERT_EQ(0, volt.bytesAllocated());
+}
+
+TEST_F(CompactingBTreeTest, InsertSorted) {
+    typedef NormalKeyValuePair<int, int> Pair;
+
+    // sizes around full leaves and inner nodes
+    const int SIZES[] = { 1, 2, 3, 30, 31, 32, 33, 100, 1023, 1024, 1025, 5000, 100000 };
+    for (int s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); s++) {
+        std::vector<Pair> pairs(SIZES[s]);
+        std::vector<const Pair*> sorted;
+        for (int i = 0; i < SIZES[s]; i++) {
+            pairs[i].setKey(i * 2);
+            pairs[i].setValue(i);
+            sorted.push_back(&pairs[i]);
+        }
+
+        RankedTree volt(true, IntComparator());
+        ASSERT_TRUE(volt.insertSorted(sorted.begin(), sorted.end()));
+        ASSERT_EQ(SIZES[s], volt.size());
+        ASSERT_TRUE(volt.verify());
+        int i = 0;
+        for (RankedTree::iterator iter = volt.begin(); !iter.isEnd(); iter.moveNext(), i++) {
+            ASSERT_EQ(i * 2, iter.key());
+            ASSERT_EQ(i, iter.value());
+            ASSERT_EQ(i + 1, volt.rankAsc(i * 2));
+        }
+        ASSERT_EQ(SIZES[s], i);
+
+        // the built tree takes further updates
+        for (i = 0; i < SIZES[s]; i += 3) {
+            ASSERT_TRUE(volt.insert(i * 2 + 1, i));
+            ASSERT_TRUE(volt.erase(i * 2));
+        }
+        ASSERT_TRUE(volt.verify());
+
+        // a batch with a key already there leaves the tree as it was
+        const int64_t size = volt.size();
+        if (SIZES[s] > 3) {
+            std::vector<const Pair*> clashing(sorted.begin(), sorted.begin() + 2);
+            ASSERT_FALSE(volt.insertSorted(clashing.begin(), clashing.end()));
+            ASSERT_EQ(size, volt.size());
+            ASSERT_TRUE(volt.find(0).isEnd());
+            ASSERT_TRUE(volt.verify());
+        }
+    }
+
+    // a unique tree takes no duplicates, even when empty
+    std::vector<Pair> pairs(3);
+    std::vector<const Pair*> sorted;
+    for (int i = 0; i < 3; i++) {
+        pairs[i].setKey(i / 2);
+        pairs[i].setValue(i);
+        sorted.push_back(&pairs[i]);
+    }
+    RankedTree unique(true, IntComparator());
+    ASSERT_FALSE(unique.insertSorted(sorted.begin(), sorted.end()));
+    ASSERT_EQ(0, unique.size());
+    RankedTree multi(false, IntComparator());
+    ASSERT_TRUE(multi.insertSorted(sorted.begin(), sorted.end()));
+    ASSERT_EQ(3, multi.size());
+    ASSERT_TRUE(multi.verify());
+    ASSERT_EQ(0, multi.find(0).value());
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -301,6 +301,52 @@ TEST_F(CompactingHashTest, ShrinkAndGrowMulti) {
     volt.verify();
 }
 
+TEST_F(CompactingHashTest, IncrementalResize) {
+    const uint64_t ITERATIONS = 300000;
+
+    voltdb::CompactingHashTable<uint64_t,uint64_t> volt(true);
+    voltdb::CompactingHashTable<uint64_t,uint64_t>::iterator voltIter;
+    bool sawResize = false;
+
+    // Keys with many low zero bits, which all landed in a handful of buckets
+    // with the identity hash and a power of two sized table if it masked them.
+    for (uint64_t i = 0; i < ITERATIONS; i++) {
+        ASSERT_TRUE(volt.insert(i << 20, i));
+        if (volt.isResizing()) {
+            sawResize = true;
+            // Keys are found whether or not their bucket has moved yet.
+            voltIter = volt.find(0);
+            ASSERT_FALSE(voltIter.isEnd());
+            voltIter = volt.find((i / 2) << 20);
+            ASSERT_FALSE(voltIter.isEnd());
+            ASSERT_EQ(i / 2, voltIter.value());
+            ASSERT_FALSE(volt.insert((i / 3) << 20, i));
+        }
+        if (i % 10007 == 0) {
+            ASSERT_TRUE(volt.verify());
+        }
+    }
+    ASSERT_TRUE(sawResize);
+    ASSERT_TRUE(volt.verify());
+
+    for (uint64_t i = 0; i < ITERATIONS; i += 2) {
+        ASSERT_TRUE(volt.erase(i << 20));
+        if (volt.isResizing()) {
+            voltIter = volt.find((ITERATIONS - 1) << 20);
+            ASSERT_FALSE(voltIter.isEnd());
+        }
+        if (i % 10007 == 0) {
+            ASSERT_TRUE(volt.verify());
+        }
+    }
+    for (uint64_t i = 0; i < ITERATIONS; i++) {
+        voltIter = volt.find(i << 20);
+        ASSERT_EQ(i % 2 == 0, voltIter.isEnd());
+    }
+    ASSERT_TRUE(volt.verify());
+    ASSERT_EQ(ITERATIONS / 2, volt.size());
+}
+
 TEST_F(CompactingHashTest, Benchmark) {
     const int ITERATIONS = 10000;
 
@@ -755,6 +755,71 @@ TEST_F(CompactingMapTest, RandomMulti) {
     // std::cout << "UpperBounds: " << upperBounds << " ub greatest chain: " << ub_greatestChain << std::endl;
 }
 
+TEST_F(CompactingMapTest, InsertSorted) {
+    typedef voltdb::CompactingMap<NormalKeyValuePair<int, int>, IntComparator, true> RankedMap;
+    typedef NormalKeyValuePair<int, int> Pair;
+
+    // sizes around full and partly full trees
+    const int SIZES[] = { 1, 2, 3, 6, 7, 8, 100, 1023, 1024, 1025, 5000 };
+    for (int s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); s++) {
+        std::vector<Pair> pairs(SIZES[s]);
+        std::vector<const Pair*> sorted;
+        for (int i = 0; i < SIZES[s]; i++) {
+            pairs[i].setKey(i * 2);
+            pairs[i].setValue(i);
+            sorted.push_back(&pairs[i]);
+        }
+
+        RankedMap volt(true, IntComparator());
+        ASSERT_TRUE(volt.insertSorted(sorted.begin(), sorted.end()));
+        ASSERT_EQ(SIZES[s], volt.size());
+        ASSERT_TRUE(volt.verify());
+        ASSERT_TRUE(volt.verifyRank());
+        int i = 0;
+        for (RankedMap::iterator iter = volt.begin(); !iter.isEnd(); iter.moveNext(), i++) {
+            ASSERT_EQ(i * 2, iter.key());
+            ASSERT_EQ(i, iter.value());
+            ASSERT_EQ(i + 1, volt.rankAsc(i * 2));
+        }
+        ASSERT_EQ(SIZES[s], i);
+
+        // the built tree takes further updates
+        for (i = 0; i < SIZES[s]; i += 3) {
+            ASSERT_TRUE(volt.insert(i * 2 + 1, i));
+            ASSERT_TRUE(volt.erase(i * 2));
+        }
+        ASSERT_TRUE(volt.verify());
+        ASSERT_TRUE(volt.verifyRank());
+
+        // a batch with a key already there leaves the map as it was
+        const int64_t size = volt.size();
+        std::vector<const Pair*> clashing(sorted.begin(), sorted.begin() + 2);
+        if (SIZES[s] > 3) {
+            ASSERT_FALSE(volt.insertSorted(clashing.begin(), clashing.end()));
+            ASSERT_EQ(size, volt.size());
+            ASSERT_TRUE(volt.find(0).isEnd());
+            ASSERT_TRUE(volt.verify());
+        }
+    }
+
+    // a unique map takes no duplicates, even when empty
+    std::vector<Pair> pairs(3);
+    std::vector<const Pair*> sorted;
+    for (int i = 0; i < 3; i++) {
+        pairs[i].setKey(i / 2);
+        pairs[i].setValue(i);
+        sorted.push_back(&pairs[i]);
+    }
+    RankedMap unique(true, IntComparator());
+    ASSERT_FALSE(unique.insertSorted(sorted.begin(), sorted.end()));
+    ASSERT_EQ(0, unique.size());
+    RankedMap multi(false, IntComparator());
+    ASSERT_TRUE(multi.insertSorted(sorted.begin(), sorted.end()));
+    ASSERT_EQ(3, multi.size());
+    ASSERT_TRUE(multi.verify());
+    ASSERT_EQ(0, multi.find(0).value());
+}
+
 // ENG-1057
 //
 // I have commented this out intentionally.  It demonstrates that the
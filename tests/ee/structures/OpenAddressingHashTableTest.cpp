@@ -0,0 +1,131 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <boost/unordered_map.hpp>
+#include "harness.h"
+#include "structures/OpenAddressingHashTable.h"
+
+using namespace voltdb;
+using namespace std;
+
+class OpenAddressingHashTableTest : public Test {
+public:
+    OpenAddressingHashTableTest() {}
+};
+
+TEST_F(OpenAddressingHashTableTest, Trivial) {
+    OpenAddressingHashTable<uint64_t,uint64_t> m;
+    OpenAddressingHashTable<uint64_t,uint64_t>::iterator iter;
+
+    ASSERT_TRUE(m.insert(2, 20));
+    ASSERT_TRUE(m.insert(1, 10));
+    ASSERT_TRUE(m.insert(3, 30));
+    ASSERT_FALSE(m.insert(2, 21));
+    ASSERT_TRUE(m.verify());
+    ASSERT_EQ(3, m.size());
+
+    iter = m.find(2);
+    ASSERT_FALSE(iter.isEnd());
+    ASSERT_EQ(2, iter.key());
+    ASSERT_EQ(20, iter.value());
+    iter.setValue(22);
+    iter.moveNext();
+    ASSERT_TRUE(iter.isEnd());
+    ASSERT_EQ(22, m.find(2).value());
+
+    ASSERT_TRUE(m.find(4).isEnd());
+    ASSERT_TRUE(m.erase(2));
+    ASSERT_FALSE(m.erase(2));
+    ASSERT_TRUE(m.find(2).isEnd());
+    ASSERT_FALSE(m.find(3).isEnd());
+    ASSERT_TRUE(m.verify());
+    ASSERT_EQ(2, m.size());
+}
+
+TEST_F(OpenAddressingHashTableTest, Fuzz) {
+    const int ITERATIONS = 200000;
+
+    boost::unordered_map<int64_t,int64_t> stl;
+    OpenAddressingHashTable<int64_t,int64_t> volt;
+
+    for (int i = 0; i < ITERATIONS; i++) {
+        // phases that mostly insert then mostly delete, to grow, shrink and
+        // leave deleted slots behind
+        const bool insert = (rand() % 8) < (((i / 20000) % 2 == 0) ? 6 : 2);
+        const int64_t value = rand() % 50000;
+        if (insert) {
+            bool stlInserted = stl.insert(pair<int64_t,int64_t>(value, i)).second;
+            ASSERT_EQ(stlInserted, volt.insert(value, i));
+        }
+        else {
+            boost::unordered_map<int64_t,int64_t>::iterator stlIter = stl.find(value);
+            OpenAddressingHashTable<int64_t,int64_t>::iterator voltIter = volt.find(value);
+            ASSERT_EQ(stlIter == stl.end(), voltIter.isEnd());
+            if (stlIter != stl.end()) {
+                ASSERT_EQ(stlIter->second, voltIter.value());
+                stl.erase(stlIter);
+                ASSERT_TRUE(volt.erase(voltIter));
+            }
+        }
+        ASSERT_EQ(stl.size(), volt.size());
+        if (i % 10000 == 0) {
+            ASSERT_TRUE(volt.verify());
+        }
+    }
+    ASSERT_TRUE(volt.verify());
+}
+
+TEST_F(OpenAddressingHashTableTest, ShrinkAndGrow) {
+    const uint64_t ITERATIONS = 100000;
+
+    OpenAddressingHashTable<uint64_t,uint64_t> volt;
+    const size_t emptySize = volt.bytesAllocated();
+
+    // keys that share their low bits
+    for (uint64_t i = 0; i < ITERATIONS; i++) {
+        ASSERT_TRUE(volt.insert(i << 32, i));
+    }
+    ASSERT_TRUE(volt.verify());
+    ASSERT_TRUE(volt.bytesAllocated() > emptySize);
+    for (uint64_t i = 0; i < ITERATIONS; i++) {
+        ASSERT_EQ(i, volt.find(i << 32).value());
+    }
+
+    // removing entries gives the memory back
+    for (uint64_t i = 0; i < ITERATIONS; i++) {
+        ASSERT_TRUE(volt.erase(i << 32));
+    }
+    ASSERT_TRUE(volt.verify());
+    ASSERT_EQ(0, volt.size());
+    ASSERT_EQ(emptySize, volt.bytesAllocated());
+
+    // Churn at a steady size keeps reusing or dropping the deleted slots
+    for (uint64_t i = 0; i < ITERATIONS; i++) {
+        ASSERT_TRUE(volt.insert(i, i));
+        if (i >= 300) {
+            ASSERT_TRUE(volt.erase(i - 300));
+        }
+    }
+    ASSERT_TRUE(volt.verify());
+    ASSERT_EQ(300, volt.size());
+    ASSERT_EQ(emptySize, volt.bytesAllocated());
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,124 @@
+/* This file is part of VoltDB.
+ * Copyright (C) 2008-2014 VoltDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with VoltDB.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <boost/unordered_set.hpp>
+#include "harness.h"
+#include "common/NValue.hpp"
+#include "common/ValueFactory.hpp"
+#include "structures/PoolBackedHashSet.h"
+
+using namespace voltdb;
+using namespace std;
+
+class PoolBackedHashSetTest : public Test {
+public:
+    PoolBackedHashSetTest() {}
+};
+
+TEST_F(PoolBackedHashSetTest, Trivial) {
+    Pool pool;
+    PoolBackedHashSet<int64_t> s(&pool);
+
+    ASSERT_EQ(0, s.size());
+    ASSERT_EQ(0, s.bytesAllocated());
+    ASSERT_TRUE(s.find(2) == NULL);
+
+    pair<int64_t*, bool> result = s.insert(2);
+    ASSERT_TRUE(result.second);
+    ASSERT_EQ(2, *result.first);
+    ASSERT_TRUE(s.insert(1).second);
+    ASSERT_TRUE(s.insert(3).second);
+    result = s.insert(2);
+    ASSERT_FALSE(result.second);
+    ASSERT_EQ(2, *result.first);
+    ASSERT_EQ(3, s.size());
+
+    ASSERT_TRUE(s.find(2) != NULL);
+    ASSERT_EQ(2, *s.find(2));
+    ASSERT_TRUE(s.find(4) == NULL);
+}
+
+TEST_F(PoolBackedHashSetTest, ClearKeepsSlots) {
+    Pool pool;
+    PoolBackedHashSet<int64_t> s(&pool);
+    for (int64_t i = 0; i < 10000; i++) {
+        ASSERT_TRUE(s.insert(i).second);
+    }
+    const size_t bytes = s.bytesAllocated();
+    const int64_t poolBytes = pool.getAllocatedMemory();
+
+    s.clear();
+    ASSERT_EQ(0, s.size());
+    ASSERT_TRUE(s.find(5) == NULL);
+
+    // refilling to the same size takes no more memory
+    for (int64_t i = 10000; i < 20000; i++) {
+        ASSERT_TRUE(s.insert(i).second);
+    }
+    ASSERT_EQ(10000, s.size());
+    ASSERT_EQ(bytes, s.bytesAllocated());
+    ASSERT_EQ(poolBytes, pool.getAllocatedMemory());
+    ASSERT_TRUE(s.find(5) == NULL);
+    ASSERT_TRUE(s.find(15000) != NULL);
+}
+
+TEST_F(PoolBackedHashSetTest, NValues) {
+    Pool pool;
+    PoolBackedHashSet<NValue, NValue::hash, NValue::equal_to> s(&pool);
+
+    ASSERT_TRUE(s.insert(ValueFactory::getIntegerValue(7)).second);
+    // equal values of different types are one value
+    ASSERT_FALSE(s.insert(ValueFactory::getBigIntValue(7)).second);
+    ASSERT_TRUE(s.insert(ValueFactory::getBigIntValue(8)).second);
+
+    NValue first = ValueFactory::getStringValue("abc", &pool);
+    NValue second = ValueFactory::getStringValue("abc", &pool);
+    NValue other = ValueFactory::getStringValue("abd", &pool);
+    ASSERT_TRUE(s.insert(first).second);
+    ASSERT_FALSE(s.insert(second).second);
+    ASSERT_TRUE(s.insert(other).second);
+    ASSERT_EQ(4, s.size());
+}
+
+TEST_F(PoolBackedHashSetTest, Fuzz) {
+    const int ITERATIONS = 200000;
+
+    Pool pool;
+    boost::unordered_set<int64_t> stl;
+    PoolBackedHashSet<int64_t> volt(&pool);
+
+    for (int i = 0; i < ITERATIONS; i++) {
+        if (i % 50000 == 0) {
+            stl.clear();
+            volt.clear();
+        }
+        const int64_t value = rand() % 30000;
+        if (rand() % 2 == 0) {
+            bool stlInserted = stl.insert(value).second;
+            ASSERT_EQ(stlInserted, volt.insert(value).second);
+        }
+        else {
+            ASSERT_EQ(stl.find(value) == stl.end(), volt.find(value) == NULL);
+        }
+        ASSERT_EQ(stl.size(), volt.size());
+    }
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -54,7 +54,7 @@ public class TestEmptySchema extends RegressionSuite
 
         // Even running should be an improvement (ENG-4645), but do something just to be sure
         // Also, check to be sure we get a full schema for the table and index stats
-        ColumnInfo[] expectedSchema = new ColumnInfo[13];
+        ColumnInfo[] expectedSchema = new ColumnInfo[20];
         expectedSchema[0] = new ColumnInfo("TIMESTAMP", VoltType.BIGINT);
         expectedSchema[1] = new ColumnInfo("HOST_ID", VoltType.INTEGER);
         expectedSchema[2] = new ColumnInfo("HOSTNAME", VoltType.STRING);
@@ -68,6 +68,13 @@ public class TestEmptySchema extends RegressionSuite
         expectedSchema[10] = new ColumnInfo("STRING_DATA_MEMORY", VoltType.INTEGER);
         expectedSchema[11] = new ColumnInfo("TUPLE_LIMIT", VoltType.INTEGER);
         expectedSchema[12] = new ColumnInfo("PERCENT_FULL", VoltType.INTEGER);
+        expectedSchema[13] = new ColumnInfo("COMPACTED_TUPLE_COUNT", VoltType.BIGINT);
+        expectedSchema[14] = new ColumnInfo("COMPACTION_PENDING_TUPLE_COUNT", VoltType.BIGINT);
+        expectedSchema[15] = new ColumnInfo("COMPACTION_STALL_TIME", VoltType.BIGINT);
+        expectedSchema[16] = new ColumnInfo("HUGE_PAGE_MEMORY", VoltType.INTEGER);
+        expectedSchema[17] = new ColumnInfo("NUMA_NODE_MEMORY", VoltType.INTEGER);
+        expectedSchema[18] = new ColumnInfo("COMPRESSED_BLOCK_COUNT", VoltType.INTEGER);
+        expectedSchema[19] = new ColumnInfo("COMPRESSED_MEMORY", VoltType.INTEGER);
         VoltTable expectedTable = new VoltTable(expectedSchema);
 
         VoltTable[] results = client.callProcedure("@Statistics", "TABLE", 0).getResults();